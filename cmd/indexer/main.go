@@ -0,0 +1,147 @@
+// Command indexer builds the verse index the server loads from the verse
+// texts and either the embeddings JSON written by the notebook, streamed and
+// parsed in parallel, or embeddings generated through the API for only the
+// texts missing from a content-addressed embedding store.
+package main
+
+import (
+	"context"
+	"flag"
+	"log"
+	"os"
+	"time"
+
+	"versejet/internal/api"
+	"versejet/internal/index"
+)
+
+func main() {
+	textPath := flag.String("text", "verses-1769.json", "verse texts by reference (empty uses the embeddings' cleaned text)")
+	embeddingsPath := flag.String("embeddings", "VersejetKJV_recreated.json", "verse embedding records")
+	outputPath := flag.String("output", "data/bible-index.gob", "where to write the verse index")
+	workers := flag.Int("workers", 0, "parallel parsers (0 = one per CPU)")
+	normalize := flag.Bool("normalize", true, "scale embeddings to unit length")
+	related := flag.Int("related", 0, "also precompute this many related verses per verse (see cmd/related)")
+	generate := flag.Bool("generate", false, "embed -text through the API (OPENAI_API_KEY) instead of reading -embeddings")
+	storePath := flag.String("store", "", "content-addressed embedding store; required by -generate, seeded from -embeddings otherwise")
+	model := flag.String("model", getEnv("EMBEDDING_MODEL", "text-embedding-3-small"), "embedding model, part of every store key")
+	batchSize := flag.Int("batch", api.DefaultStoreBatch, "texts per embedding request")
+	concurrency := flag.Int("concurrency", api.DefaultStoreConcurrency, "embedding requests in flight")
+	format := flag.String("format", index.FormatColumnar, "index layout to write: columnar or gob")
+	verbose := flag.Bool("verbose", false, "log each stage")
+	flag.Parse()
+
+	logger := log.New(os.Stdout, "[INDEXER] ", log.LstdFlags)
+	start := time.Now()
+
+	var texts map[string]string
+	if *textPath != "" {
+		file, err := os.Open(*textPath)
+		if err != nil {
+			logger.Fatalf("❌ Failed to open verse texts: %v", err)
+		}
+		texts, err = index.ReadVerseTexts(file)
+		file.Close()
+		if err != nil {
+			logger.Fatalf("❌ Failed to read verse texts: %v", err)
+		}
+		if *verbose {
+			logger.Printf("📖 Read %d verse texts from %s", len(texts), *textPath)
+		}
+	}
+
+	var store *api.EmbeddingStore
+	if *storePath != "" {
+		var err error
+		if store, err = api.OpenEmbeddingStore(*storePath, *model); err != nil {
+			logger.Fatalf("❌ Failed to open embedding store: %v", err)
+		}
+		defer store.Close()
+		logger.Printf("🗄️ Opened embedding store %s with %d embeddings", *storePath, store.Len())
+	}
+
+	var verseIndex *index.VerseIndex
+	if *generate {
+		verseIndex = generateIndex(logger, texts, store, *model, *batchSize, *concurrency, *normalize)
+	} else {
+		verseIndex = ingestIndex(logger, texts, *embeddingsPath, *workers, *normalize)
+		if store != nil {
+			// Later -generate runs then embed only what changed
+			verseTexts := make([]string, len(verseIndex.Verses))
+			embeddings := make([][]float32, len(verseIndex.Verses))
+			for i, verse := range verseIndex.Verses {
+				verseTexts[i], embeddings[i] = verse.Text, verse.Embedding
+			}
+			if err := store.Put(verseTexts, embeddings); err != nil {
+				logger.Fatalf("❌ Failed to seed embedding store: %v", err)
+			}
+			logger.Printf("🗄️ Embedding store now holds %d embeddings", store.Len())
+		}
+	}
+
+	if *related > 0 {
+		relatedStart := time.Now()
+		if err := verseIndex.BuildRelated(*related, *workers); err != nil {
+			logger.Fatalf("❌ Failed to build related verses: %v", err)
+		}
+		if *verbose {
+			logger.Printf("🔗 Computed top %d related verses in %v", *related, time.Since(relatedStart))
+		}
+	}
+
+	if err := verseIndex.Save(*outputPath, *format); err != nil {
+		logger.Fatalf("❌ Failed to save verse index: %v", err)
+	}
+	logger.Printf("💾 Saved index to %s in %v", *outputPath, time.Since(start))
+}
+
+// ingestIndex builds the index from the embeddings JSON
+func ingestIndex(logger *log.Logger, texts map[string]string, embeddingsPath string, workers int, normalize bool) *index.VerseIndex {
+	file, err := os.Open(embeddingsPath)
+	if err != nil {
+		logger.Fatalf("❌ Failed to open embeddings: %v", err)
+	}
+	defer file.Close()
+	parseStart := time.Now()
+	verseIndex, err := index.IngestEmbeddings(file, index.IngestOptions{Texts: texts, Workers: workers, Normalize: normalize})
+	if err != nil {
+		logger.Fatalf("❌ Failed to ingest embeddings: %v", err)
+	}
+	logger.Printf("📚 Ingested %d verses of %d dimensions in %v", len(verseIndex.Verses), verseIndex.Dimension(), time.Since(parseStart))
+	return verseIndex
+}
+
+// generateIndex builds the index from the verse texts, generating the
+// embeddings the store lacks
+func generateIndex(logger *log.Logger, texts map[string]string, store *api.EmbeddingStore, model string, batchSize, concurrency int, normalize bool) *index.VerseIndex {
+	if texts == nil || store == nil {
+		logger.Fatalf("❌ -generate needs -text and -store")
+	}
+	apiKey := os.Getenv("OPENAI_API_KEY")
+	if apiKey == "" {
+		logger.Fatalf("❌ OPENAI_API_KEY is required to generate embeddings")
+	}
+	generator := api.NewOpenAIEmbeddingGenerator(apiKey, model)
+
+	generateStart := time.Now()
+	verseIndex, err := index.IngestTexts(texts, func(verseTexts []string) ([][]float32, error) {
+		embeddings, generated, err := store.Embed(context.Background(), generator, verseTexts, batchSize, concurrency,
+			func(done, total int) { logger.Printf("⏳ Embedded %d/%d new texts", done, total) })
+		if err == nil {
+			logger.Printf("🧮 Generated %d embeddings, reused %d from the store", generated, len(verseTexts)-generated)
+		}
+		return embeddings, err
+	}, normalize)
+	if err != nil {
+		logger.Fatalf("❌ Failed to build index from texts: %v", err)
+	}
+	logger.Printf("📚 Built %d verses of %d dimensions in %v", len(verseIndex.Verses), verseIndex.Dimension(), time.Since(generateStart))
+	return verseIndex
+}
+
+func getEnv(key, defaultValue string) string {
+	if value := os.Getenv(key); value != "" {
+		return value
+	}
+	return defaultValue
+}
@@ -0,0 +1,41 @@
+// Command partition splits a verse index into shard indexes of whole books,
+// each served by its own process behind a coordinator (see SHARDS).
+package main
+
+import (
+	"flag"
+	"fmt"
+	"log"
+	"os"
+
+	"versejet/internal/index"
+)
+
+func main() {
+	indexPath := flag.String("index", "data/bible-index.gob", "verse index to read")
+	shards := flag.Int("n", 2, "number of shards")
+	outputPattern := flag.String("output", "data/shard-%d.gob", "where to write shard i (a printf pattern)")
+	format := flag.String("format", index.FormatColumnar, "index layout to write: columnar or gob")
+	flag.Parse()
+
+	logger := log.New(os.Stdout, "[PARTITION] ", log.LstdFlags)
+
+	verseIndex, err := index.Load(*indexPath)
+	if err != nil {
+		logger.Fatalf("❌ Failed to load verse index: %v", err)
+	}
+	logger.Printf("📚 Loaded %d verses", len(verseIndex.Verses))
+
+	parts, err := verseIndex.Partition(*shards)
+	if err != nil {
+		logger.Fatalf("❌ Failed to partition index: %v", err)
+	}
+	for i, part := range parts {
+		path := fmt.Sprintf(*outputPattern, i)
+		if err := part.Save(path, *format); err != nil {
+			logger.Fatalf("❌ Failed to save shard %d: %v", i, err)
+		}
+		logger.Printf("💾 Saved shard %d (%s to %s, %d verses) to %s", i,
+			part.Verses[0].Ref, part.Verses[len(part.Verses)-1].Ref, len(part.Verses), path)
+	}
+}
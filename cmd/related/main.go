@@ -0,0 +1,43 @@
+// Command related precomputes each verse's nearest neighbors and stores the
+// table in the verse index, where the server's /related endpoint reads it.
+package main
+
+import (
+	"flag"
+	"log"
+	"os"
+	"time"
+
+	"versejet/internal/index"
+)
+
+func main() {
+	indexPath := flag.String("index", "data/bible-index.gob", "verse index to read")
+	outputPath := flag.String("output", "", "where to write the index (defaults to -index)")
+	topN := flag.Int("n", 20, "related verses kept per verse")
+	workers := flag.Int("workers", 0, "parallel workers (0 = one per CPU)")
+	format := flag.String("format", index.FormatColumnar, "index layout to write: columnar or gob")
+	flag.Parse()
+	if *outputPath == "" {
+		*outputPath = *indexPath
+	}
+
+	logger := log.New(os.Stdout, "[RELATED] ", log.LstdFlags)
+
+	verseIndex, err := index.Load(*indexPath)
+	if err != nil {
+		logger.Fatalf("❌ Failed to load verse index: %v", err)
+	}
+	logger.Printf("📚 Loaded %d verses", len(verseIndex.Verses))
+
+	start := time.Now()
+	if err := verseIndex.BuildRelated(*topN, *workers); err != nil {
+		logger.Fatalf("❌ Failed to build related verses: %v", err)
+	}
+	logger.Printf("✅ Computed top %d related verses in %v", *topN, time.Since(start))
+
+	if err := verseIndex.Save(*outputPath, *format); err != nil {
+		logger.Fatalf("❌ Failed to save verse index: %v", err)
+	}
+	logger.Printf("💾 Saved index with related verses to %s", *outputPath)
+}
@@ -0,0 +1,210 @@
+package api
+
+import (
+	"bytes"
+	"context"
+	"fmt"
+	"io"
+	"net"
+	"net/http"
+	"sort"
+	"strconv"
+	"strings"
+	"sync"
+	"time"
+)
+
+// Shard defaults
+const (
+	DefaultShardTimeout = 2 * time.Second
+
+	// maxShardResponseBytes bounds a shard response: 50 results with the
+	// longest context windows stay well below it
+	maxShardResponseBytes = 16 << 20
+)
+
+// ShardCoordinator fans vector queries out to shard processes, each serving
+// a partition of the verses from its own index, and merges their top k by
+// score. Shards are addressed as "http://host:port" or, on the same machine,
+// "unix:/path/to.sock".
+type ShardCoordinator struct {
+	shards       []shardClient
+	timeout      time.Duration // per shard, within the query deadline
+	allowPartial bool          // answer from the shards that did respond
+}
+
+type shardClient struct {
+	address string
+	url     string
+	client  *http.Client
+}
+
+// NewShardCoordinator creates a coordinator for the shards at addresses.
+// With allowPartial, a query is answered from the shards that responded
+// within timeout; otherwise any failed shard fails the query.
+func NewShardCoordinator(addresses []string, timeout time.Duration, allowPartial bool) (*ShardCoordinator, error) {
+	if len(addresses) == 0 {
+		return nil, fmt.Errorf("no shards given")
+	}
+	if timeout <= 0 {
+		timeout = DefaultShardTimeout
+	}
+	c := &ShardCoordinator{timeout: timeout, allowPartial: allowPartial}
+	pooled := NewPooledHTTPClient(DefaultMaxConnsPerHost)
+	for _, address := range addresses {
+		shard := shardClient{address: address, client: pooled}
+		switch {
+		case strings.HasPrefix(address, "unix:"):
+			path := strings.TrimPrefix(address, "unix:")
+			if path == "" {
+				return nil, fmt.Errorf("shard %q has no socket path", address)
+			}
+			transport := pooled.Transport.(*http.Transport).Clone()
+			transport.Proxy = nil
+			transport.DialContext = func(ctx context.Context, _, _ string) (net.Conn, error) {
+				var dialer net.Dialer
+				return dialer.DialContext(ctx, "unix", path)
+			}
+			shard.client = &http.Client{Transport: transport}
+			shard.url = "http://shard" + shardSearchPath
+		case strings.HasPrefix(address, "http://"), strings.HasPrefix(address, "https://"):
+			shard.url = strings.TrimSuffix(address, "/") + shardSearchPath
+		default:
+			return nil, fmt.Errorf("shard %q must start with http://, https:// or unix:", address)
+		}
+		c.shards = append(c.shards, shard)
+	}
+	return c, nil
+}
+
+// Shards reports the number of shards
+func (c *ShardCoordinator) Shards() int {
+	return len(c.shards)
+}
+
+// search queries every shard at once and returns the k best hits, best
+// first, with the errors of shards that failed. It fails if every shard
+// does, or any shard does when partial results are not allowed.
+func (c *ShardCoordinator) search(ctx context.Context, embedding []float32, k, window int) ([]shardHit, []error, error) {
+	request := appendShardRequest(nil, k, window, embedding)
+	hits := make([][]shardHit, len(c.shards))
+	errs := make([]error, len(c.shards))
+	var wg sync.WaitGroup
+	for i := range c.shards {
+		wg.Add(1)
+		go func(i int) {
+			defer wg.Done()
+			shardCtx, cancel := context.WithTimeout(ctx, c.timeout)
+			defer cancel()
+			hits[i], errs[i] = c.shards[i].search(shardCtx, request, i)
+		}(i)
+	}
+	wg.Wait()
+
+	var merged []shardHit
+	var failures []error
+	for i := range c.shards {
+		if errs[i] != nil {
+			failures = append(failures, fmt.Errorf("shard %s: %w", c.shards[i].address, errs[i]))
+			continue
+		}
+		merged = append(merged, hits[i]...)
+	}
+	if len(failures) == len(c.shards) || len(failures) > 0 && !c.allowPartial {
+		return nil, failures, failures[0]
+	}
+
+	// Ties keep shard order, matching the row order of an unsharded index
+	sort.Slice(merged, func(i, j int) bool {
+		a, b := &merged[i], &merged[j]
+		if a.score != b.score {
+			return a.score > b.score
+		}
+		if a.shard != b.shard {
+			return a.shard < b.shard
+		}
+		return a.rank < b.rank
+	})
+	return merged[:min(k, len(merged))], failures, nil
+}
+
+func (s *shardClient) search(ctx context.Context, request []byte, shard int) ([]shardHit, error) {
+	httpReq, err := http.NewRequestWithContext(ctx, http.MethodPost, s.url, bytes.NewReader(request))
+	if err != nil {
+		return nil, err
+	}
+	httpReq.Header.Set("Content-Type", shardContentType)
+	resp, err := s.client.Do(httpReq)
+	if err != nil {
+		return nil, err
+	}
+	defer resp.Body.Close()
+	if resp.StatusCode != http.StatusOK {
+		return nil, fmt.Errorf("status %d", resp.StatusCode)
+	}
+	body, err := io.ReadAll(io.LimitReader(resp.Body, maxShardResponseBytes))
+	if err != nil {
+		return nil, err
+	}
+	return decodeShardResponse(body, shard)
+}
+
+// SetShardCoordinator turns the handler into a coordinator: /query ranks
+// verses by embedding similarity across the shards instead of a local index
+func (h *Handler) SetShardCoordinator(coordinator *ShardCoordinator) {
+	h.shards = coordinator
+}
+
+// shardedQuery answers a query from the shards. Options that need every
+// verse in one index (facets, pagination, passages, multi-vector examples)
+// are not available, and lexical, hybrid and diversified ranking fall back
+// to embedding similarity.
+func (h *Handler) shardedQuery(w http.ResponseWriter, r *http.Request, req *QueryRequest, queryEmbedding []float32) {
+	if req.Facets || req.Paginate || req.PassageVerses != 0 || len(req.Examples) > 0 {
+		h.sendError(w, "Facets, pagination, passages and examples are not available across shards", http.StatusBadRequest)
+		return
+	}
+	startTime := time.Now()
+	ctx, cancel := h.queryContext(r)
+	defer cancel()
+	queryEmbedding, embeddingTime, err := h.embedQuery(ctx, req, queryEmbedding)
+	if err != nil {
+		h.sendQueryError(w, err)
+		return
+	}
+
+	searchStart := time.Now()
+	hits, failures, err := h.shards.search(ctx, queryEmbedding, req.K, h.contextWindow(req.ContextVerses))
+	for _, failure := range failures {
+		h.logger.Printf("⚠️ %v", failure)
+	}
+	if err != nil {
+		h.sendError(w, "Search failed", http.StatusBadGateway)
+		return
+	}
+	h.logger.Printf("🧩 Merged %d results from %d/%d shards in %v (embedding: %v, total: %v)",
+		len(hits), h.shards.Shards()-len(failures), h.shards.Shards(), time.Since(searchStart), embeddingTime, time.Since(startTime))
+	writePooled(w, func(buf []byte) []byte {
+		return appendShardedResponse(buf, req.Query, hits, len(failures) > 0)
+	})
+}
+
+// appendShardedResponse appends a QueryResponse built from the shards'
+// pre-rendered results
+func appendShardedResponse(buf []byte, query string, hits []shardHit, partial bool) []byte {
+	buf = append(buf, `{"results":[`...)
+	for i := range hits {
+		if i > 0 {
+			buf = append(buf, ',')
+		}
+		buf = append(buf, hits[i].result...)
+	}
+	buf = append(buf, `],"query":`...)
+	buf = appendJSONString(buf, query)
+	buf = append(buf, `,"count":`...)
+	buf = strconv.AppendInt(buf, int64(len(hits)), 10)
+	if partial {
+		buf = append(buf, `,"partial":true`...)
+	}
+	return append(buf, "}\n"...)
+}
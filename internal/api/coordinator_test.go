@@ -0,0 +1,174 @@
+package api
+
+import (
+	"context"
+	"encoding/json"
+	"fmt"
+	"log"
+	"math/rand"
+	"net"
+	"net/http"
+	"net/http/httptest"
+	"os"
+	"path/filepath"
+	"reflect"
+	"strings"
+	"testing"
+	"time"
+
+	"versejet/internal/index"
+)
+
+func TestShardProtocol_RoundTrip(t *testing.T) {
+	request := appendShardRequest(nil, 7, 3, []float32{0.5, -1, 2})
+	k, window, embedding, err := decodeShardRequest(request)
+	if err != nil || k != 7 || window != 3 || !reflect.DeepEqual(embedding, []float32{0.5, -1, 2}) {
+		t.Fatalf("Round trip gave k=%d window=%d %v, %v", k, window, embedding, err)
+	}
+	for _, body := range [][]byte{nil, []byte("VJS2"), request[:len(request)-1], append(request, 0)} {
+		if _, _, _, err := decodeShardRequest(body); err == nil {
+			t.Errorf("Expected %d byte request to be rejected", len(body))
+		}
+	}
+	if _, err := decodeShardResponse([]byte("VJS1\x01\x00\x00\x00"), 0); err == nil {
+		t.Error("Expected a truncated response to be rejected")
+	}
+}
+
+// shardTestIndex builds books of verses with random embeddings
+func shardTestIndex(rng *rand.Rand, books, verses, dim int) *index.VerseIndex {
+	verseIndex := index.NewVerseIndex()
+	for book := 0; book < books; book++ {
+		for verse := 1; verse <= verses; verse++ {
+			embedding := make([]float32, dim)
+			for d := range embedding {
+				embedding[d] = float32(rng.NormFloat64())
+			}
+			verseIndex.AddVerse(index.Verse{
+				ID:        fmt.Sprintf("B%d.1.%d", book, verse),
+				Ref:       fmt.Sprintf("Book %d 1:%d", book, verse),
+				Text:      fmt.Sprintf("Verse %d of book %d.", verse, book),
+				Embedding: embedding,
+			})
+		}
+	}
+	return verseIndex
+}
+
+func newTestHandler(verseIndex *index.VerseIndex) *Handler {
+	return NewHandlerWithGenerator(verseIndex, &MockEmbeddingGenerator{shouldFail: true}, log.New(os.Stdout, "[TEST] ", 0))
+}
+
+func TestShardCoordinator_MatchesUnshardedSearch(t *testing.T) {
+	const dim = 16
+	rng := rand.New(rand.NewSource(1))
+	full := shardTestIndex(rng, 6, 40, dim)
+	parts, err := full.Partition(3)
+	if err != nil {
+		t.Fatalf("Partition failed: %v", err)
+	}
+
+	// Two shards over TCP, one over a unix socket
+	var addresses []string
+	for i, part := range parts {
+		mux := http.NewServeMux()
+		mux.HandleFunc(shardSearchPath, newTestHandler(part).HandleShardSearch)
+		server := httptest.NewUnstartedServer(mux)
+		if i == 2 {
+			socket := filepath.Join(t.TempDir(), "shard.sock")
+			listener, err := net.Listen("unix", socket)
+			if err != nil {
+				t.Fatalf("Failed to listen on %s: %v", socket, err)
+			}
+			server.Listener.Close()
+			server.Listener = listener
+			addresses = append(addresses, "unix:"+socket)
+		}
+		server.Start()
+		defer server.Close()
+		if i != 2 {
+			addresses = append(addresses, server.URL)
+		}
+	}
+
+	coordinator, err := NewShardCoordinator(addresses, time.Second, true)
+	if err != nil {
+		t.Fatalf("NewShardCoordinator failed: %v", err)
+	}
+	sharded := newTestHandler(index.NewVerseIndex())
+	sharded.SetShardCoordinator(coordinator)
+	// A coordinator merges by score and does not rerank for diversity
+	unsharded := newTestHandler(full)
+	unsharded.SetDiversity(1, index.DefaultChapterPenalty)
+
+	post := func(handler *Handler, body string) (int, QueryResponse) {
+		w := httptest.NewRecorder()
+		handler.HandleQuery(w, httptest.NewRequest(http.MethodPost, "/query", strings.NewReader(body)))
+		var response QueryResponse
+		json.NewDecoder(w.Body).Decode(&response)
+		return w.Code, response
+	}
+
+	for trial := 0; trial < 5; trial++ {
+		// Near a stored verse so there are matches above the threshold
+		query := append([]float32(nil), full.Verses[rng.Intn(len(full.Verses))].Embedding...)
+		for d := range query {
+			query[d] += 0.3 * float32(rng.NormFloat64())
+		}
+		body := fmt.Sprintf(`{"embedding": %q, "k": 10, "context_verses": 2}`, EncodeEmbedding(query))
+		code, got := post(sharded, body)
+		_, expected := post(unsharded, body)
+		if code != http.StatusOK || got.Partial {
+			t.Fatalf("Expected a complete sharded response, got %d %+v", code, got)
+		}
+		if len(expected.Results) == 0 || !reflect.DeepEqual(got.Results, expected.Results) {
+			t.Errorf("trial %d: sharded results differ\n got %+v\nwant %+v", trial, got.Results, expected.Results)
+		}
+	}
+
+	if code, _ := post(sharded, fmt.Sprintf(`{"embedding": %q, "facets": true}`, EncodeEmbedding(make([]float32, dim)))); code != http.StatusBadRequest {
+		t.Errorf("Expected facets to be refused across shards, got %d", code)
+	}
+}
+
+func TestShardCoordinator_PartialResults(t *testing.T) {
+	rng := rand.New(rand.NewSource(2))
+	verseIndex := shardTestIndex(rng, 1, 20, 8)
+	healthy := httptest.NewServer(http.HandlerFunc(newTestHandler(verseIndex).HandleShardSearch))
+	defer healthy.Close()
+	slow := httptest.NewServer(http.HandlerFunc(func(w http.ResponseWriter, r *http.Request) {
+		select {
+		case <-r.Context().Done():
+		case <-time.After(2 * time.Second):
+		}
+	}))
+	defer slow.Close()
+
+	query := verseIndex.Verses[0].Embedding
+	addresses := []string{healthy.URL, slow.URL}
+	partial, _ := NewShardCoordinator(addresses, 50*time.Millisecond, true)
+	hits, failures, err := partial.search(context.Background(), query, 5, 0)
+	if err != nil || len(failures) != 1 || len(hits) == 0 {
+		t.Fatalf("Expected results from the healthy shard, got %d hits, %v, %v", len(hits), failures, err)
+	}
+
+	strict, _ := NewShardCoordinator(addresses, 50*time.Millisecond, false)
+	if _, _, err := strict.search(context.Background(), query, 5, 0); err == nil {
+		t.Error("Expected a missed shard deadline to fail the query without partial results")
+	}
+
+	handler := newTestHandler(index.NewVerseIndex())
+	handler.SetShardCoordinator(partial)
+	w := httptest.NewRecorder()
+	handler.HandleQuery(w, httptest.NewRequest(http.MethodPost, "/query",
+		strings.NewReader(fmt.Sprintf(`{"embedding": %q}`, EncodeEmbedding(query)))))
+	var response QueryResponse
+	json.NewDecoder(w.Body).Decode(&response)
+	if w.Code != http.StatusOK || !response.Partial || response.Results[0].Ref != "Book 0 1:1" {
+		t.Errorf("Expected partial results led by the query verse, got %d %+v", w.Code, response)
+	}
+
+	if _, err := NewShardCoordinator([]string{"shard:9000"}, 0, true); err == nil {
+		t.Error("Expected an address without a scheme to be rejected")
+	}
+}
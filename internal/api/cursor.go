@@ -0,0 +1,217 @@
+package api
+
+import (
+	"container/list"
+	"crypto/rand"
+	"encoding/hex"
+	"net/http"
+	"sync"
+	"time"
+
+	"versejet/internal/index"
+)
+
+// CursorPages is how many pages of the first page's size a cursor keeps;
+// later pages end there
+const CursorPages = 10
+
+// DefaultCursorCacheBytes bounds the matches held by all open cursors
+const DefaultCursorCacheBytes = 16 << 20
+
+// CursorCache keeps open search cursors under opaque tokens so later pages
+// of a query resume its ranking instead of recomputing it. The least
+// recently used cursors are dropped when the cache holds more than its
+// capacity or its bytes of matches.
+type CursorCache struct {
+	mu       sync.Mutex
+	capacity int
+	maxBytes int
+	bytes    int
+	order    *list.List // of *cursorEntry, most recently used first
+	byToken  map[string]*list.Element
+}
+
+type cursorEntry struct {
+	token     string
+	query     string
+	fragments *verseFragments // of the corpus the cursor ranks
+	cursor    *index.SearchCursor
+	bytes     int
+}
+
+// NewCursorCache creates a cache holding up to capacity open cursors and
+// maxBytes of their matches, DefaultCursorCacheBytes if not positive
+func NewCursorCache(capacity, maxBytes int) *CursorCache {
+	if capacity <= 0 {
+		capacity = 1
+	}
+	if maxBytes <= 0 {
+		maxBytes = DefaultCursorCacheBytes
+	}
+	return &CursorCache{
+		capacity: capacity,
+		maxBytes: maxBytes,
+		order:    list.New(),
+		byToken:  make(map[string]*list.Element),
+	}
+}
+
+// Add stores a cursor over the corpus described by fragments and returns its
+// token
+func (c *CursorCache) Add(query string, fragments *verseFragments, cursor *index.SearchCursor) (string, error) {
+	var raw [16]byte
+	if _, err := rand.Read(raw[:]); err != nil {
+		return "", err
+	}
+	token := hex.EncodeToString(raw[:])
+
+	entry := &cursorEntry{token: token, query: query, fragments: fragments, cursor: cursor, bytes: cursor.Bytes()}
+	c.mu.Lock()
+	defer c.mu.Unlock()
+	for c.order.Len() > 0 && (c.order.Len() >= c.capacity || c.bytes+entry.bytes > c.maxBytes) {
+		c.removeLocked(c.order.Back())
+	}
+	c.byToken[token] = c.order.PushFront(entry)
+	c.bytes += entry.bytes
+	return token, nil
+}
+
+func (c *CursorCache) removeLocked(element *list.Element) {
+	entry := element.Value.(*cursorEntry)
+	c.order.Remove(element)
+	delete(c.byToken, entry.token)
+	c.bytes -= entry.bytes
+}
+
+// Get returns the cursor for a token with the query and corpus it was
+// opened for
+func (c *CursorCache) Get(token string) (*index.SearchCursor, string, *verseFragments, bool) {
+	c.mu.Lock()
+	defer c.mu.Unlock()
+	element, ok := c.byToken[token]
+	if !ok {
+		return nil, "", nil, false
+	}
+	c.order.MoveToFront(element)
+	entry := element.Value.(*cursorEntry)
+	return entry.cursor, entry.query, entry.fragments, true
+}
+
+// Remove drops a cursor, e.g. once it is exhausted
+func (c *CursorCache) Remove(token string) {
+	c.mu.Lock()
+	defer c.mu.Unlock()
+	if element, ok := c.byToken[token]; ok {
+		c.removeLocked(element)
+	}
+}
+
+// Invalidate drops every cursor, e.g. after the verse index is reloaded
+func (c *CursorCache) Invalidate() {
+	c.mu.Lock()
+	defer c.mu.Unlock()
+	c.order.Init()
+	clear(c.byToken)
+	c.bytes = 0
+}
+
+// Len reports the number of open cursors
+func (c *CursorCache) Len() int {
+	c.mu.Lock()
+	defer c.mu.Unlock()
+	return c.order.Len()
+}
+
+// Bytes reports the memory open cursors hold for their matches
+func (c *CursorCache) Bytes() int {
+	c.mu.Lock()
+	defer c.mu.Unlock()
+	return c.bytes
+}
+
+// SetCursorCache enables paginated queries
+func (h *Handler) SetCursorCache(cache *CursorCache) {
+	h.cursors = cache
+}
+
+// paginatedQuery answers the first page of a paginated query: every verse
+// is scored once and the next CursorPages-1 pages of the ranking are kept
+// under a cursor token. Pages rank by embedding similarity alone, so they
+// are not coalesced, cached or diversified.
+func (h *Handler) paginatedQuery(w http.ResponseWriter, r *http.Request, req *QueryRequest, queryEmbedding []float32) {
+	if h.cursors == nil {
+		h.sendError(w, "Pagination is disabled", http.StatusBadRequest)
+		return
+	}
+	ctx, cancel := h.queryContext(r)
+	defer cancel()
+	queryEmbedding, embeddingTime, err := h.embedQuery(ctx, req, queryEmbedding)
+	if err != nil {
+		h.sendQueryError(w, err)
+		return
+	}
+
+	searchStart := time.Now()
+	var cursor *index.SearchCursor
+	if writable := h.writableFor(req.fragments); writable != nil {
+		cursor, err = writable.OpenCursor(queryEmbedding, pageSize(req.K)*CursorPages)
+	} else {
+		cursor, err = req.fragments.verseIndex.OpenCursor(queryEmbedding, pageSize(req.K)*CursorPages)
+	}
+	if err != nil {
+		h.logger.Printf("❌ Search failed: %v", err)
+		h.sendError(w, "Search failed", http.StatusInternalServerError)
+		return
+	}
+	h.logger.Printf("📑 Opened cursor over %d matches in %v (embedding: %v)", cursor.Remaining(), time.Since(searchStart), embeddingTime)
+	h.sendPage(w, "", req.Query, cursor, req)
+}
+
+// continueCursor answers a later page of a paginated query
+func (h *Handler) continueCursor(w http.ResponseWriter, req *QueryRequest) {
+	if h.cursors == nil {
+		h.sendError(w, "Pagination is disabled", http.StatusBadRequest)
+		return
+	}
+	cursor, query, fragments, ok := h.cursors.Get(req.Cursor)
+	if !ok {
+		h.sendError(w, "Cursor expired or unknown", http.StatusNotFound)
+		return
+	}
+	req.fragments = fragments
+	h.sendPage(w, req.Cursor, query, cursor, req)
+}
+
+// sendPage writes the next req.K results of a cursor over the request's
+// corpus, with a token for the page after when matches remain
+func (h *Handler) sendPage(w http.ResponseWriter, token, query string, cursor *index.SearchCursor, req *QueryRequest) {
+	results, err := cursor.Next(pageSize(req.K))
+	if err != nil {
+		h.sendError(w, "Search failed", http.StatusInternalServerError)
+		return
+	}
+
+	switch {
+	case cursor.Remaining() == 0:
+		if token != "" {
+			h.cursors.Remove(token)
+		}
+		token = ""
+	case token == "":
+		if token, err = h.cursors.Add(query, req.fragments, cursor); err != nil {
+			h.logger.Printf("❌ Failed to create cursor token: %v", err)
+			h.sendError(w, "Failed to create cursor", http.StatusInternalServerError)
+			return
+		}
+	}
+	h.logger.Printf("📄 Served %d results (%d so far, %d remaining)", len(results), cursor.Returned(), cursor.Remaining())
+	writeQueryResponse(w, req.fragments, query, results, nil, token, h.contextWindow(req.ContextVerses))
+}
+
+// pageSize clamps a request's k to a page of 1 to 50 results, 20 by default
+func pageSize(k int) int {
+	if k <= 0 {
+		return 20
+	}
+	return min(k, 50)
+}
@@ -0,0 +1,77 @@
+package api
+
+import (
+	"fmt"
+	"testing"
+
+	"versejet/internal/index"
+)
+
+func TestCursorCache_EvictsLeastRecentlyUsed(t *testing.T) {
+	cache := NewCursorCache(2, 0)
+	cursor := &index.SearchCursor{}
+
+	first, err := cache.Add("first", nil, cursor)
+	if err != nil {
+		t.Fatalf("Add failed: %v", err)
+	}
+	second, _ := cache.Add("second", nil, cursor)
+	if first == second || len(first) != 32 {
+		t.Fatalf("Expected distinct 32-character tokens, got %q and %q", first, second)
+	}
+
+	// Touch the first so the second is the oldest
+	if _, query, _, ok := cache.Get(first); !ok || query != "first" {
+		t.Fatalf("Expected the first cursor, got %q, %v", query, ok)
+	}
+	third, _ := cache.Add("third", nil, cursor)
+	if _, _, _, ok := cache.Get(second); ok {
+		t.Error("Expected the least recently used cursor to be evicted")
+	}
+	if _, _, _, ok := cache.Get(first); !ok {
+		t.Error("Expected the recently used cursor to be kept")
+	}
+
+	cache.Remove(third)
+	if cache.Len() != 1 {
+		t.Errorf("Expected 1 cursor after Remove, got %d", cache.Len())
+	}
+	cache.Invalidate()
+	if _, _, _, ok := cache.Get(first); ok || cache.Len() != 0 {
+		t.Error("Expected Invalidate to drop every cursor")
+	}
+}
+
+func TestCursorCache_BoundsBytes(t *testing.T) {
+	verseIndex := index.NewVerseIndex()
+	for i := 0; i < 40; i++ {
+		verseIndex.AddVerse(index.Verse{ID: fmt.Sprintf("B.1.%d", i+1), Embedding: []float32{1, float32(i) / 100}})
+	}
+	open := func() *index.SearchCursor {
+		cursor, err := verseIndex.OpenCursor([]float32{1, 0}, 40)
+		if err != nil {
+			t.Fatalf("OpenCursor failed: %v", err)
+		}
+		return cursor
+	}
+	size := open().Bytes()
+	if size == 0 {
+		t.Fatal("Expected a cursor over matches to hold memory")
+	}
+
+	// Room for two cursors by bytes, though ten by count
+	cache := NewCursorCache(10, 2*size)
+	first, _ := cache.Add("first", nil, open())
+	cache.Add("second", nil, open())
+	cache.Add("third", nil, open())
+	if cache.Len() != 2 || cache.Bytes() != 2*size {
+		t.Errorf("Expected 2 cursors in %d bytes, got %d in %d", 2*size, cache.Len(), cache.Bytes())
+	}
+	if _, _, _, ok := cache.Get(first); ok {
+		t.Error("Expected the oldest cursor to make room")
+	}
+	cache.Invalidate()
+	if cache.Bytes() != 0 {
+		t.Errorf("Expected no bytes after Invalidate, got %d", cache.Bytes())
+	}
+}
@@ -0,0 +1,42 @@
+package api
+
+import (
+	"fmt"
+
+	"versejet/internal/index"
+)
+
+// SetDiversity sets the default maximal-marginal-relevance trade-off for
+// verse results (1 ranks by relevance alone) and the extra penalty for a
+// result from a chapter already shown
+func (h *Handler) SetDiversity(lambda, chapterPenalty float32) error {
+	if lambda < 0 || lambda > 1 {
+		return fmt.Errorf("lambda must be between 0 and 1, got %g", lambda)
+	}
+	if chapterPenalty < 0 {
+		return fmt.Errorf("chapter penalty cannot be negative, got %g", chapterPenalty)
+	}
+	h.mmrLambda = lambda
+	h.chapterPenalty = chapterPenalty
+	return nil
+}
+
+// mmrLambdaFor resolves a request's mmr_lambda against the default
+func (h *Handler) mmrLambdaFor(req *QueryRequest) float32 {
+	if req.MMRLambda != nil {
+		return *req.MMRLambda
+	}
+	return h.mmrLambda
+}
+
+// diversifiedSearch draws a pool of the best verses and reranks it by
+// maximal marginal relevance, so consecutive verses of one chapter (whose
+// embeddings are nearly the same) do not crowd out other passages
+func (h *Handler) diversifiedSearch(req *QueryRequest, queryEmbedding []float32, lambda float32) ([]index.SearchResult, *index.Facets, error) {
+	pool, facets, err := h.searchVerses(req, queryEmbedding, index.MMRCandidates)
+	if err != nil {
+		return nil, nil, err
+	}
+	results, err := req.fragments.verseIndex.Diversify(pool, req.K, lambda, h.chapterPenalty)
+	return results, facets, err
+}
@@ -0,0 +1,231 @@
+package api
+
+import (
+	"context"
+	"errors"
+	"net/http"
+	"sync"
+	"time"
+)
+
+// ErrBatcherClosed is returned for requests submitted after Close
+var ErrBatcherClosed = errors.New("embedding batcher is closed")
+
+// BatchingConfig bounds how requests are grouped into upstream calls
+type BatchingConfig struct {
+	Window      time.Duration // how long the first request in a batch waits for company
+	MaxBatch    int           // maximum texts per upstream call
+	MaxTokens   int           // estimated token budget per upstream call
+	MaxInFlight int           // concurrent upstream calls
+}
+
+// DefaultBatchingConfig returns limits well inside the embeddings API's
+// per-request caps (2048 inputs, 300k tokens)
+func DefaultBatchingConfig() BatchingConfig {
+	return BatchingConfig{
+		Window:      5 * time.Millisecond,
+		MaxBatch:    64,
+		MaxTokens:   32000,
+		MaxInFlight: 8,
+	}
+}
+
+// BatchingEmbeddingGenerator collects concurrent GenerateEmbedding calls over
+// a short window and sends them upstream as one batched request, then hands
+// each caller its own embedding.
+type BatchingEmbeddingGenerator struct {
+	next     BatchEmbeddingGenerator
+	config   BatchingConfig
+	requests chan *batchRequest
+	slots    chan struct{}
+
+	closeOnce sync.Once
+	closed    chan struct{}
+	done      chan struct{}
+	inflight  sync.WaitGroup
+}
+
+type batchRequest struct {
+	text     string
+	tokens   int
+	deadline time.Time
+	result   chan batchResult
+}
+
+type batchResult struct {
+	embedding []float32
+	err       error
+}
+
+// NewBatchingEmbeddingGenerator starts a batcher in front of next
+func NewBatchingEmbeddingGenerator(next BatchEmbeddingGenerator, config BatchingConfig) *BatchingEmbeddingGenerator {
+	defaults := DefaultBatchingConfig()
+	if config.Window <= 0 {
+		config.Window = defaults.Window
+	}
+	if config.MaxBatch <= 0 {
+		config.MaxBatch = defaults.MaxBatch
+	}
+	if config.MaxTokens <= 0 {
+		config.MaxTokens = defaults.MaxTokens
+	}
+	if config.MaxInFlight <= 0 {
+		config.MaxInFlight = defaults.MaxInFlight
+	}
+
+	b := &BatchingEmbeddingGenerator{
+		next:     next,
+		config:   config,
+		requests: make(chan *batchRequest),
+		slots:    make(chan struct{}, config.MaxInFlight),
+		closed:   make(chan struct{}),
+		done:     make(chan struct{}),
+	}
+	go b.run()
+	return b
+}
+
+// GenerateEmbedding queues text for the next batch and waits for its embedding
+func (b *BatchingEmbeddingGenerator) GenerateEmbedding(text string) ([]float32, error) {
+	return b.GenerateEmbeddingContext(context.Background(), text)
+}
+
+// GenerateEmbeddingContext queues text for the next batch and waits for its
+// embedding until ctx is done
+func (b *BatchingEmbeddingGenerator) GenerateEmbeddingContext(ctx context.Context, text string) ([]float32, error) {
+	req := &batchRequest{
+		text:   text,
+		tokens: estimateTokens(text),
+		result: make(chan batchResult, 1),
+	}
+	req.deadline, _ = ctx.Deadline()
+	select {
+	case b.requests <- req:
+	case <-b.closed:
+		return nil, ErrBatcherClosed
+	case <-ctx.Done():
+		return nil, ctx.Err()
+	}
+	select {
+	case res := <-req.result:
+		return res.embedding, res.err
+	case <-ctx.Done():
+		return nil, ctx.Err()
+	}
+}
+
+// Close stops accepting requests after flushing the pending batch, and
+// returns once every batch sent upstream has been answered
+func (b *BatchingEmbeddingGenerator) Close() {
+	b.closeOnce.Do(func() {
+		close(b.closed)
+		<-b.done
+		b.inflight.Wait()
+	})
+}
+
+func (b *BatchingEmbeddingGenerator) run() {
+	defer close(b.done)
+
+	var carry *batchRequest
+	for {
+		first := carry
+		carry = nil
+		if first == nil {
+			select {
+			case first = <-b.requests:
+			case <-b.closed:
+				return
+			}
+		}
+
+		batch := []*batchRequest{first}
+		tokens := first.tokens
+		timer := time.NewTimer(b.config.Window)
+	collect:
+		for len(batch) < b.config.MaxBatch {
+			select {
+			case req := <-b.requests:
+				if tokens+req.tokens > b.config.MaxTokens {
+					// Over budget: this request opens the next batch.
+					carry = req
+					break collect
+				}
+				batch = append(batch, req)
+				tokens += req.tokens
+			case <-timer.C:
+				break collect
+			case <-b.closed:
+				break collect
+			}
+		}
+		timer.Stop()
+
+		b.slots <- struct{}{}
+		b.inflight.Add(1)
+		go b.dispatch(batch)
+	}
+}
+
+func (b *BatchingEmbeddingGenerator) dispatch(batch []*batchRequest) {
+	defer b.inflight.Done()
+	defer func() { <-b.slots }()
+
+	// The batch runs until the latest member deadline so no waiting caller
+	// is cut short by an earlier one.
+	texts := make([]string, len(batch))
+	var deadline time.Time
+	bounded := true
+	for i, req := range batch {
+		texts[i] = req.text
+		if req.deadline.IsZero() {
+			bounded = false
+		} else if req.deadline.After(deadline) {
+			deadline = req.deadline
+		}
+	}
+	ctx := context.Background()
+	if bounded {
+		var cancel context.CancelFunc
+		ctx, cancel = context.WithDeadline(ctx, deadline)
+		defer cancel()
+	}
+	b.embed(ctx, batch, texts)
+}
+
+// embed answers the batch with one upstream call. If the call rejects an
+// input, the halves are sent again on their own until only the inputs at
+// fault fail, so a bad query does not fail the others that shared its window.
+func (b *BatchingEmbeddingGenerator) embed(ctx context.Context, batch []*batchRequest, texts []string) {
+	embeddings, err := generateEmbeddings(ctx, b.next, texts)
+	if err != nil && len(batch) > 1 && rejectedInput(err) && ctx.Err() == nil {
+		half := len(batch) / 2
+		b.embed(ctx, batch[:half], texts[:half])
+		b.embed(ctx, batch[half:], texts[half:])
+		return
+	}
+	for i, req := range batch {
+		if err != nil {
+			req.result <- batchResult{err: err}
+			continue
+		}
+		req.result <- batchResult{embedding: embeddings[i]}
+	}
+}
+
+// rejectedInput reports whether an upstream call failed on what it was sent,
+// such as an input over the model's token limit, rather than on the key,
+// the rate limit or the backend, which would fail every input alike
+func rejectedInput(err error) bool {
+	switch embeddingErrorStatus(err) {
+	case http.StatusBadRequest, http.StatusRequestEntityTooLarge, http.StatusUnprocessableEntity:
+		return true
+	}
+	return false
+}
+
+// estimateTokens approximates the token count of English text (~4 bytes
+// per token), rounding up so short inputs still count
+func estimateTokens(text string) int {
+	return len(text)/4 + 1
+}
@@ -0,0 +1,271 @@
+package api
+
+import (
+	"encoding/json"
+	"fmt"
+	"net/http"
+	"net/http/httptest"
+	"sync"
+	"testing"
+	"time"
+
+	"github.com/sashabaranov/go-openai"
+)
+
+// fakeEmbeddingServer is a local stand-in for the OpenAI embeddings endpoint.
+// Each returned embedding encodes its input length so callers can verify
+// results were demultiplexed correctly.
+type fakeEmbeddingServer struct {
+	*httptest.Server
+	mu         sync.Mutex
+	batchSizes []int
+	// delay, when set, holds the response to the numbered call (from 0)
+	delay func(call int) time.Duration
+	// status, when set and not 200, fails the numbered call with that status
+	status func(call int) int
+	// rejects, when set, fails with 400 any call carrying an input it matches
+	rejects func(input string) bool
+}
+
+func newFakeEmbeddingServer(t *testing.T) *fakeEmbeddingServer {
+	fake := &fakeEmbeddingServer{}
+	fake.Server = httptest.NewServer(http.HandlerFunc(func(w http.ResponseWriter, r *http.Request) {
+		var req struct {
+			Input []string `json:"input"`
+		}
+		if err := json.NewDecoder(r.Body).Decode(&req); err != nil {
+			http.Error(w, err.Error(), http.StatusBadRequest)
+			return
+		}
+
+		fake.mu.Lock()
+		call := len(fake.batchSizes)
+		fake.batchSizes = append(fake.batchSizes, len(req.Input))
+		delay, status, rejects := fake.delay, fake.status, fake.rejects
+		fake.mu.Unlock()
+
+		if rejects != nil {
+			for _, input := range req.Input {
+				if rejects(input) {
+					w.Header().Set("Content-Type", "application/json")
+					w.WriteHeader(http.StatusBadRequest)
+					fmt.Fprintf(w, `{"error":{"message":"input %q rejected","type":"invalid_request_error"}}`, input)
+					return
+				}
+			}
+		}
+
+		if status != nil && status(call) != http.StatusOK {
+			w.Header().Set("Content-Type", "application/json")
+			w.WriteHeader(status(call))
+			fmt.Fprintf(w, `{"error":{"message":"status %d","type":"test_error"}}`, status(call))
+			return
+		}
+
+		if delay != nil {
+			select {
+			case <-time.After(delay(call)):
+			case <-r.Context().Done():
+				return
+			}
+		}
+
+		resp := openai.EmbeddingResponse{Object: "list"}
+		// Reply in reverse order to exercise index-based demultiplexing.
+		for i := len(req.Input) - 1; i >= 0; i-- {
+			resp.Data = append(resp.Data, openai.Embedding{
+				Object:    "embedding",
+				Index:     i,
+				Embedding: []float32{float32(len(req.Input[i])), 1, 0},
+			})
+		}
+		w.Header().Set("Content-Type", "application/json")
+		json.NewEncoder(w).Encode(resp)
+	}))
+	t.Cleanup(fake.Close)
+	return fake
+}
+
+func (f *fakeEmbeddingServer) calls() []int {
+	f.mu.Lock()
+	defer f.mu.Unlock()
+	return append([]int(nil), f.batchSizes...)
+}
+
+func (f *fakeEmbeddingServer) generator() *OpenAIEmbeddingGenerator {
+	config := openai.DefaultConfig("test-key")
+	config.BaseURL = f.URL + "/v1"
+	return NewOpenAIEmbeddingGeneratorWithConfig(config, "text-embedding-3-small")
+}
+
+func generateConcurrently(t *testing.T, gen EmbeddingGenerator, texts []string) [][]float32 {
+	t.Helper()
+	results := make([][]float32, len(texts))
+	errs := make([]error, len(texts))
+	var wg sync.WaitGroup
+	for i, text := range texts {
+		wg.Add(1)
+		go func(i int, text string) {
+			defer wg.Done()
+			results[i], errs[i] = gen.GenerateEmbedding(text)
+		}(i, text)
+	}
+	wg.Wait()
+	for i, err := range errs {
+		if err != nil {
+			t.Fatalf("Request %d failed: %v", i, err)
+		}
+	}
+	return results
+}
+
+func TestBatchingEmbeddingGenerator_CombinesConcurrentRequests(t *testing.T) {
+	server := newFakeEmbeddingServer(t)
+	batcher := NewBatchingEmbeddingGenerator(server.generator(), BatchingConfig{
+		Window:   200 * time.Millisecond,
+		MaxBatch: 64,
+	})
+	defer batcher.Close()
+
+	texts := []string{"a", "bb", "ccc", "dddd", "eeeee", "ffffff", "ggggggg", "hhhhhhhh"}
+	results := generateConcurrently(t, batcher, texts)
+
+	if calls := server.calls(); len(calls) != 1 || calls[0] != len(texts) {
+		t.Errorf("Expected one upstream call with %d inputs, got %v", len(texts), calls)
+	}
+	for i, text := range texts {
+		if results[i][0] != float32(len(text)) {
+			t.Errorf("Result %d routed to the wrong caller: expected %d, got %v", i, len(text), results[i][0])
+		}
+	}
+}
+
+func TestBatchingEmbeddingGenerator_RespectsLimits(t *testing.T) {
+	server := newFakeEmbeddingServer(t)
+	batcher := NewBatchingEmbeddingGenerator(server.generator(), BatchingConfig{
+		Window:   200 * time.Millisecond,
+		MaxBatch: 3,
+	})
+	defer batcher.Close()
+
+	texts := []string{"a", "b", "c", "d", "e", "f", "g"}
+	generateConcurrently(t, batcher, texts)
+
+	total := 0
+	for _, size := range server.calls() {
+		if size > 3 {
+			t.Errorf("Expected batches of at most 3, got %d", size)
+		}
+		total += size
+	}
+	if total != len(texts) {
+		t.Errorf("Expected %d texts sent upstream, got %d", len(texts), total)
+	}
+
+	tokenServer := newFakeEmbeddingServer(t)
+	tokenBatcher := NewBatchingEmbeddingGenerator(tokenServer.generator(), BatchingConfig{
+		Window:    200 * time.Millisecond,
+		MaxBatch:  64,
+		MaxTokens: estimateTokens("0123456789abcdef") * 2,
+	})
+	defer tokenBatcher.Close()
+
+	long := []string{"0123456789abcdef", "0123456789abcdeg", "0123456789abcdeh", "0123456789abcdei"}
+	generateConcurrently(t, tokenBatcher, long)
+	for _, size := range tokenServer.calls() {
+		if size > 2 {
+			t.Errorf("Expected token budget to cap batches at 2 inputs, got %d", size)
+		}
+	}
+}
+
+func TestBatchingEmbeddingGenerator_Closed(t *testing.T) {
+	server := newFakeEmbeddingServer(t)
+	batcher := NewBatchingEmbeddingGenerator(server.generator(), DefaultBatchingConfig())
+	batcher.Close()
+
+	if _, err := batcher.GenerateEmbedding("late"); err != ErrBatcherClosed {
+		t.Errorf("Expected ErrBatcherClosed, got %v", err)
+	}
+}
+
+func TestBatchingEmbeddingGenerator_IsolatesRejectedInputs(t *testing.T) {
+	server := newFakeEmbeddingServer(t)
+	server.rejects = func(input string) bool { return input == "bad" }
+	batcher := NewBatchingEmbeddingGenerator(server.generator(), BatchingConfig{
+		Window:   200 * time.Millisecond,
+		MaxBatch: 64,
+	})
+	defer batcher.Close()
+
+	texts := []string{"a", "bb", "bad", "dddd", "eeeee", "ffffff"}
+	errs := make([]error, len(texts))
+	results := make([][]float32, len(texts))
+	var wg sync.WaitGroup
+	for i, text := range texts {
+		wg.Add(1)
+		go func(i int, text string) {
+			defer wg.Done()
+			results[i], errs[i] = batcher.GenerateEmbedding(text)
+		}(i, text)
+	}
+	wg.Wait()
+
+	for i, text := range texts {
+		switch {
+		case text == "bad" && errs[i] == nil:
+			t.Error("Expected the rejected input to fail")
+		case text != "bad" && errs[i] != nil:
+			t.Errorf("Expected %q to succeed beside a rejected input, got %v", text, errs[i])
+		case text != "bad" && results[i][0] != float32(len(text)):
+			t.Errorf("Result %d routed to the wrong caller: got %v", i, results[i][0])
+		}
+	}
+
+	// Other client errors fail every input alike and are not split up
+	server.mu.Lock()
+	server.rejects = nil
+	server.status = func(int) int { return http.StatusUnauthorized }
+	server.mu.Unlock()
+	before := len(server.calls())
+	generated := make(chan error, 2)
+	for _, text := range []string{"x", "y"} {
+		go func(text string) {
+			_, err := batcher.GenerateEmbedding(text)
+			generated <- err
+		}(text)
+	}
+	for i := 0; i < 2; i++ {
+		if err := <-generated; err == nil {
+			t.Error("Expected an unauthorized call to fail")
+		}
+	}
+	if calls := len(server.calls()) - before; calls != 1 {
+		t.Errorf("Expected one upstream call for an unauthorized batch, got %d", calls)
+	}
+}
+
+func TestBatchingEmbeddingGenerator_CloseWaitsForInFlightBatches(t *testing.T) {
+	server := newFakeEmbeddingServer(t)
+	server.delay = func(int) time.Duration { return 300 * time.Millisecond }
+	batcher := NewBatchingEmbeddingGenerator(server.generator(), BatchingConfig{Window: time.Millisecond})
+
+	generated := make(chan error, 1)
+	go func() {
+		_, err := batcher.GenerateEmbedding("in flight")
+		generated <- err
+	}()
+	for len(server.calls()) == 0 {
+		time.Sleep(time.Millisecond)
+	}
+
+	batcher.Close()
+	select {
+	case err := <-generated:
+		if err != nil {
+			t.Errorf("Expected the in-flight request to succeed, got %v", err)
+		}
+	case <-time.After(100 * time.Millisecond):
+		t.Error("Expected Close to wait for the in-flight batch")
+	}
+}
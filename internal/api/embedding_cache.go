@@ -0,0 +1,445 @@
+package api
+
+import (
+	"context"
+	"crypto/sha256"
+	"encoding/binary"
+	"errors"
+	"fmt"
+	"hash/fnv"
+	"math"
+	"os"
+	"strings"
+	"sync"
+	"sync/atomic"
+
+	"versejet/internal/mmap"
+)
+
+const (
+	embeddingCacheShards = 16
+
+	// Slot layout: 2-byte key length, 2 reserved bytes, fixed key area, then
+	// the embedding as little-endian float32 values.
+	embeddingCacheKeyBytes   = 252
+	embeddingCacheSlotHeader = 4 + embeddingCacheKeyBytes
+
+	embeddingCacheHeaderSize = 64
+	embeddingCacheMagic      = "VJEMBC01"
+)
+
+// NormalizeQuery canonicalizes query text for cache and coalescing keys:
+// case-folded with runs of whitespace collapsed to a single space.
+func NormalizeQuery(text string) string {
+	return strings.ToLower(strings.Join(strings.Fields(text), " "))
+}
+
+// CachedEmbeddingGenerator serves repeated queries from a sharded, bounded
+// LRU cache in front of another EmbeddingGenerator. Embeddings live in a
+// single fixed-slot slab which can be backed by a memory-mapped file so the
+// cache survives restarts.
+type CachedEmbeddingGenerator struct {
+	next  EmbeddingGenerator
+	model string
+	path  string
+
+	slotsPerShard int
+	shards        [embeddingCacheShards]embeddingCacheShard
+
+	// slab is created lazily once the embedding dimension is known.
+	slabMu   sync.RWMutex
+	slab     []byte
+	mapped   *mmap.File
+	dim      int
+	slotSize int
+
+	hits    atomic.Uint64
+	misses  atomic.Uint64
+	skipped atomic.Uint64
+}
+
+// embeddingCacheShard tracks key ownership and LRU order for a fixed range of
+// slab slots. Links are slot-local indexes so the shard allocates nothing per
+// entry beyond the map key.
+type embeddingCacheShard struct {
+	mu    sync.Mutex
+	slots map[string]int32
+	keys  []string
+	prev  []int32
+	next  []int32
+	head  int32
+	tail  int32
+	used  int32
+}
+
+// NewCachedEmbeddingGenerator wraps next with a cache holding up to capacity
+// embeddings for the given model. When path is non-empty the slab is mapped
+// from that file; an existing file with a matching layout is reloaded.
+func NewCachedEmbeddingGenerator(next EmbeddingGenerator, model string, capacity int, path string) (*CachedEmbeddingGenerator, error) {
+	if next == nil {
+		return nil, errors.New("embedding cache requires an underlying generator")
+	}
+	if capacity <= 0 {
+		return nil, fmt.Errorf("embedding cache capacity must be positive, got %d", capacity)
+	}
+
+	c := &CachedEmbeddingGenerator{
+		next:          next,
+		model:         model,
+		path:          path,
+		slotsPerShard: (capacity + embeddingCacheShards - 1) / embeddingCacheShards,
+	}
+	for i := range c.shards {
+		c.shards[i].reset(c.slotsPerShard)
+	}
+
+	if path != "" {
+		if err := c.reload(); err != nil {
+			return nil, err
+		}
+	}
+	return c, nil
+}
+
+// GenerateEmbedding returns the cached embedding for text or computes and
+// stores it on a miss.
+func (c *CachedEmbeddingGenerator) GenerateEmbedding(text string) ([]float32, error) {
+	return c.GenerateEmbeddingContext(context.Background(), text)
+}
+
+// GenerateEmbeddingContext is GenerateEmbedding with misses bounded by ctx.
+func (c *CachedEmbeddingGenerator) GenerateEmbeddingContext(ctx context.Context, text string) ([]float32, error) {
+	key := c.cacheKey(text)
+	if embedding, ok := c.get(key); ok {
+		c.hits.Add(1)
+		return embedding, nil
+	}
+	c.misses.Add(1)
+
+	embedding, err := generateEmbedding(ctx, c.next, text)
+	if err != nil {
+		return nil, err
+	}
+	c.put(key, embedding)
+	return embedding, nil
+}
+
+// Stats reports cache hits and misses since startup, and how many
+// embeddings could not be stored.
+func (c *CachedEmbeddingGenerator) Stats() (hits, misses, skipped uint64) {
+	return c.hits.Load(), c.misses.Load(), c.skipped.Load()
+}
+
+// Len returns the number of cached embeddings.
+func (c *CachedEmbeddingGenerator) Len() int {
+	total := 0
+	for i := range c.shards {
+		s := &c.shards[i]
+		s.mu.Lock()
+		total += len(s.slots)
+		s.mu.Unlock()
+	}
+	return total
+}
+
+// Close flushes a file-backed cache to disk and releases the mapping.
+func (c *CachedEmbeddingGenerator) Close() error {
+	c.slabMu.Lock()
+	defer c.slabMu.Unlock()
+	if c.mapped == nil {
+		return nil
+	}
+	err := c.mapped.Close()
+	c.mapped = nil
+	c.slab = nil
+	return err
+}
+
+// cacheKey identifies text under the model. Text too long for a slot's key
+// area is keyed by its SHA-256 instead, after a 0xff byte that NormalizeQuery
+// never produces, so a digest key cannot equal the key of any query.
+func (c *CachedEmbeddingGenerator) cacheKey(text string) string {
+	normalized := NormalizeQuery(text)
+	key := c.model + "\x00" + normalized
+	if len(key) <= embeddingCacheKeyBytes {
+		return key
+	}
+	digest := sha256.Sum256([]byte(normalized))
+	return c.model + "\x00\xff" + string(digest[:])
+}
+
+func (c *CachedEmbeddingGenerator) shardFor(key string) (int, *embeddingCacheShard) {
+	h := fnv.New32a()
+	h.Write([]byte(key))
+	idx := int(h.Sum32() % embeddingCacheShards)
+	return idx, &c.shards[idx]
+}
+
+func (c *CachedEmbeddingGenerator) get(key string) ([]float32, bool) {
+	shardIdx, shard := c.shardFor(key)
+
+	c.slabMu.RLock()
+	defer c.slabMu.RUnlock()
+	if c.slab == nil {
+		return nil, false
+	}
+
+	shard.mu.Lock()
+	defer shard.mu.Unlock()
+	local, ok := shard.slots[key]
+	if !ok {
+		return nil, false
+	}
+	shard.touch(local)
+	return c.readSlot(c.slotOffset(shardIdx, local)), true
+}
+
+func (c *CachedEmbeddingGenerator) put(key string, embedding []float32) {
+	if len(key) > embeddingCacheKeyBytes || len(embedding) == 0 {
+		c.skipped.Add(1)
+		return
+	}
+	if err := c.ensureSlab(len(embedding)); err != nil || len(embedding) != c.dim {
+		c.skipped.Add(1)
+		return
+	}
+	shardIdx, shard := c.shardFor(key)
+
+	c.slabMu.RLock()
+	defer c.slabMu.RUnlock()
+	if c.slab == nil {
+		c.skipped.Add(1)
+		return
+	}
+
+	shard.mu.Lock()
+	defer shard.mu.Unlock()
+	local, ok := shard.slots[key]
+	if !ok {
+		local = shard.acquire()
+		shard.slots[key] = local
+		shard.keys[local] = key
+	}
+	shard.touch(local)
+	c.writeSlot(c.slotOffset(shardIdx, local), key, embedding)
+}
+
+func (c *CachedEmbeddingGenerator) slotOffset(shardIdx int, local int32) int {
+	slot := shardIdx*c.slotsPerShard + int(local)
+	return embeddingCacheHeaderSize + slot*c.slotSize
+}
+
+func (c *CachedEmbeddingGenerator) readSlot(offset int) []float32 {
+	data := c.slab[offset+embeddingCacheSlotHeader : offset+c.slotSize]
+	embedding := make([]float32, c.dim)
+	for i := range embedding {
+		embedding[i] = math.Float32frombits(binary.LittleEndian.Uint32(data[i*4:]))
+	}
+	return embedding
+}
+
+// writeSlot clears the key length before rewriting the slot and publishes it
+// last, so an interrupted write leaves an empty slot rather than a torn entry.
+func (c *CachedEmbeddingGenerator) writeSlot(offset int, key string, embedding []float32) {
+	slot := c.slab[offset : offset+c.slotSize]
+	binary.LittleEndian.PutUint16(slot[0:2], 0)
+	copy(slot[4:4+embeddingCacheKeyBytes], key)
+	data := slot[embeddingCacheSlotHeader:]
+	for i, v := range embedding {
+		binary.LittleEndian.PutUint32(data[i*4:], math.Float32bits(v))
+	}
+	binary.LittleEndian.PutUint16(slot[0:2], uint16(len(key)))
+}
+
+// ensureSlab allocates the slab for dim-sized embeddings on first use.
+func (c *CachedEmbeddingGenerator) ensureSlab(dim int) error {
+	c.slabMu.RLock()
+	ready := c.slab != nil
+	c.slabMu.RUnlock()
+	if ready {
+		return nil
+	}
+
+	c.slabMu.Lock()
+	defer c.slabMu.Unlock()
+	if c.slab != nil {
+		return nil
+	}
+	return c.allocate(dim, false)
+}
+
+// allocate sizes the slab for dim and, for file-backed caches, maps it. When
+// keep is false any existing file contents are discarded. Callers hold slabMu.
+func (c *CachedEmbeddingGenerator) allocate(dim int, keep bool) error {
+	c.dim = dim
+	c.slotSize = embeddingCacheSlotHeader + dim*4
+	size := embeddingCacheHeaderSize + embeddingCacheShards*c.slotsPerShard*c.slotSize
+
+	if c.path == "" {
+		c.slab = make([]byte, size)
+		c.writeHeader()
+		return nil
+	}
+
+	if !keep {
+		// Start from an empty file so a stale layout never leaks into the new slab.
+		os.Remove(c.path)
+	}
+	mapped, err := mmap.Open(c.path, size, true)
+	if err != nil {
+		return err
+	}
+	c.mapped = mapped
+	c.slab = mapped.Bytes()
+	if !keep {
+		c.writeHeader()
+	}
+	return nil
+}
+
+func (c *CachedEmbeddingGenerator) writeHeader() {
+	copy(c.slab[0:8], embeddingCacheMagic)
+	binary.LittleEndian.PutUint32(c.slab[8:], uint32(c.dim))
+	binary.LittleEndian.PutUint32(c.slab[12:], embeddingCacheShards)
+	binary.LittleEndian.PutUint32(c.slab[16:], uint32(c.slotsPerShard))
+	binary.LittleEndian.PutUint32(c.slab[20:], embeddingCacheKeyBytes)
+}
+
+// reload maps an existing cache file and rebuilds the shard indexes from its
+// occupied slots. Files with a different layout are ignored and replaced on
+// first insert.
+func (c *CachedEmbeddingGenerator) reload() error {
+	existing, err := mmap.Open(c.path, 0, false)
+	if err != nil {
+		// Missing or empty file: the slab is created on first insert, so only
+		// check now that the location is writable.
+		file, createErr := os.OpenFile(c.path, os.O_RDWR|os.O_CREATE, 0644)
+		if createErr != nil {
+			return fmt.Errorf("embedding cache file is not writable: %w", createErr)
+		}
+		return file.Close()
+	}
+	header := existing.Bytes()
+	valid := len(header) >= embeddingCacheHeaderSize &&
+		string(header[0:8]) == embeddingCacheMagic &&
+		binary.LittleEndian.Uint32(header[12:]) == embeddingCacheShards &&
+		binary.LittleEndian.Uint32(header[16:]) == uint32(c.slotsPerShard) &&
+		binary.LittleEndian.Uint32(header[20:]) == embeddingCacheKeyBytes
+	dim := int(binary.LittleEndian.Uint32(header[8:]))
+	existing.Close()
+	if !valid || dim <= 0 {
+		return nil
+	}
+
+	c.slabMu.Lock()
+	defer c.slabMu.Unlock()
+	if err := c.allocate(dim, true); err != nil {
+		return err
+	}
+
+	prefix := c.model + "\x00"
+	for shardIdx := range c.shards {
+		shard := &c.shards[shardIdx]
+		for local := 0; local < c.slotsPerShard; local++ {
+			offset := c.slotOffset(shardIdx, int32(local))
+			keyLen := int(binary.LittleEndian.Uint16(c.slab[offset:]))
+			if keyLen == 0 || keyLen > embeddingCacheKeyBytes {
+				continue
+			}
+			key := string(c.slab[offset+4 : offset+4+keyLen])
+			if !strings.HasPrefix(key, prefix) {
+				// Entries from another model are left in place to be overwritten.
+				continue
+			}
+			shard.restore(key, int32(local))
+		}
+	}
+	return nil
+}
+
+func (s *embeddingCacheShard) reset(capacity int) {
+	s.slots = make(map[string]int32, capacity)
+	s.keys = make([]string, capacity)
+	s.prev = make([]int32, capacity)
+	s.next = make([]int32, capacity)
+	s.head, s.tail = -1, -1
+	s.used = 0
+}
+
+// acquire returns a free slot, evicting the least recently used entry when
+// the shard is full.
+func (s *embeddingCacheShard) acquire() int32 {
+	if int(s.used) < len(s.keys) {
+		local := s.used
+		s.used++
+		s.pushFront(local)
+		return local
+	}
+	local := s.tail
+	delete(s.slots, s.keys[local])
+	s.keys[local] = ""
+	return local
+}
+
+// restore re-inserts a slot recovered from disk at the front of the LRU.
+func (s *embeddingCacheShard) restore(key string, local int32) {
+	if int(local) >= int(s.used) {
+		// Slots below local that were empty stay unlinked and are skipped by
+		// acquire; make them reachable by linking them as free tail entries.
+		for free := s.used; free < local; free++ {
+			s.pushBack(free)
+		}
+		s.used = local + 1
+		s.pushFront(local)
+	} else {
+		s.touch(local)
+	}
+	s.slots[key] = local
+	s.keys[local] = key
+}
+
+func (s *embeddingCacheShard) touch(local int32) {
+	if s.head == local {
+		return
+	}
+	s.unlink(local)
+	s.pushFront(local)
+}
+
+func (s *embeddingCacheShard) unlink(local int32) {
+	p, n := s.prev[local], s.next[local]
+	if p >= 0 {
+		s.next[p] = n
+	} else {
+		s.head = n
+	}
+	if n >= 0 {
+		s.prev[n] = p
+	} else {
+		s.tail = p
+	}
+}
+
+func (s *embeddingCacheShard) pushFront(local int32) {
+	s.prev[local] = -1
+	s.next[local] = s.head
+	if s.head >= 0 {
+		s.prev[s.head] = local
+	}
+	s.head = local
+	if s.tail < 0 {
+		s.tail = local
+	}
+}
+
+func (s *embeddingCacheShard) pushBack(local int32) {
+	s.next[local] = -1
+	s.prev[local] = s.tail
+	if s.tail >= 0 {
+		s.next[s.tail] = local
+	}
+	s.tail = local
+	if s.head < 0 {
+		s.head = local
+	}
+}
@@ -0,0 +1,177 @@
+package api
+
+import (
+	"path/filepath"
+	"reflect"
+	"strings"
+	"sync/atomic"
+	"testing"
+)
+
+// countingEmbeddingGenerator returns a deterministic embedding per text and
+// counts how often it is called.
+type countingEmbeddingGenerator struct {
+	calls atomic.Int64
+}
+
+func (g *countingEmbeddingGenerator) GenerateEmbedding(text string) ([]float32, error) {
+	g.calls.Add(1)
+	embedding := make([]float32, 8)
+	for i := range embedding {
+		embedding[i] = float32(len(text)+i) / 10
+	}
+	return embedding, nil
+}
+
+func TestNormalizeQuery(t *testing.T) {
+	tests := map[string]string{
+		"God is love":         "god is love",
+		"  God   is\tlove \n": "god is love",
+		"JOHN 3:16":           "john 3:16",
+		"":                    "",
+	}
+	for input, expected := range tests {
+		if got := NormalizeQuery(input); got != expected {
+			t.Errorf("NormalizeQuery(%q): expected %q, got %q", input, expected, got)
+		}
+	}
+}
+
+func TestCachedEmbeddingGenerator_Hit(t *testing.T) {
+	underlying := &countingEmbeddingGenerator{}
+	cache, err := NewCachedEmbeddingGenerator(underlying, "test-model", 64, "")
+	if err != nil {
+		t.Fatalf("Failed to create cache: %v", err)
+	}
+
+	first, err := cache.GenerateEmbedding("God is love")
+	if err != nil {
+		t.Fatalf("Expected no error, got %v", err)
+	}
+	second, err := cache.GenerateEmbedding("  god IS   love")
+	if err != nil {
+		t.Fatalf("Expected no error, got %v", err)
+	}
+
+	if underlying.calls.Load() != 1 {
+		t.Errorf("Expected 1 underlying call, got %d", underlying.calls.Load())
+	}
+	if !reflect.DeepEqual(first, second) {
+		t.Error("Expected cached embedding to match the original")
+	}
+	hits, misses, skipped := cache.Stats()
+	if hits != 1 || misses != 1 || skipped != 0 {
+		t.Errorf("Expected 1 hit, 1 miss and no skips, got %d, %d and %d", hits, misses, skipped)
+	}
+}
+
+func TestCachedEmbeddingGenerator_Eviction(t *testing.T) {
+	underlying := &countingEmbeddingGenerator{}
+	// One slot per shard.
+	cache, err := NewCachedEmbeddingGenerator(underlying, "test-model", embeddingCacheShards, "")
+	if err != nil {
+		t.Fatalf("Failed to create cache: %v", err)
+	}
+
+	queries := []string{"a", "bb", "ccc", "dddd", "eeeee", "ffffff", "ggggggg", "hhhhhhhh",
+		"iiiiiiiii", "jjjjjjjjjj", "kkkkkkkkkkk", "llllllllllll", "mmmmmmmmmmmmm",
+		"nnnnnnnnnnnnnn", "ooooooooooooooo", "pppppppppppppppp", "qqqqqqqqqqqqqqqqq"}
+	for _, q := range queries {
+		if _, err := cache.GenerateEmbedding(q); err != nil {
+			t.Fatalf("Expected no error, got %v", err)
+		}
+	}
+
+	if cache.Len() > embeddingCacheShards {
+		t.Errorf("Expected at most %d cached entries, got %d", embeddingCacheShards, cache.Len())
+	}
+}
+
+func TestCachedEmbeddingGenerator_Persistence(t *testing.T) {
+	path := filepath.Join(t.TempDir(), "embedding-cache.bin")
+
+	underlying := &countingEmbeddingGenerator{}
+	cache, err := NewCachedEmbeddingGenerator(underlying, "test-model", 32, path)
+	if err != nil {
+		t.Fatalf("Failed to create cache: %v", err)
+	}
+	original, _ := cache.GenerateEmbedding("The LORD is my shepherd")
+	cache.GenerateEmbedding("Jesus wept")
+	if err := cache.Close(); err != nil {
+		t.Fatalf("Failed to close cache: %v", err)
+	}
+
+	reopenedUnderlying := &countingEmbeddingGenerator{}
+	reopened, err := NewCachedEmbeddingGenerator(reopenedUnderlying, "test-model", 32, path)
+	if err != nil {
+		t.Fatalf("Failed to reopen cache: %v", err)
+	}
+	defer reopened.Close()
+
+	if reopened.Len() != 2 {
+		t.Errorf("Expected 2 entries after reload, got %d", reopened.Len())
+	}
+	restored, err := reopened.GenerateEmbedding("the lord is my shepherd")
+	if err != nil {
+		t.Fatalf("Expected no error, got %v", err)
+	}
+	if reopenedUnderlying.calls.Load() != 0 {
+		t.Errorf("Expected reloaded entry to be served from cache, got %d underlying calls", reopenedUnderlying.calls.Load())
+	}
+	if !reflect.DeepEqual(original, restored) {
+		t.Error("Expected reloaded embedding to match the original")
+	}
+
+	// A different model must not reuse the persisted entries.
+	otherModel, err := NewCachedEmbeddingGenerator(&countingEmbeddingGenerator{}, "other-model", 32, path)
+	if err != nil {
+		t.Fatalf("Failed to reopen cache: %v", err)
+	}
+	defer otherModel.Close()
+	if otherModel.Len() != 0 {
+		t.Errorf("Expected no entries for a different model, got %d", otherModel.Len())
+	}
+}
+
+func TestCachedEmbeddingGenerator_LongQueries(t *testing.T) {
+	path := filepath.Join(t.TempDir(), "embedding-cache.bin")
+	underlying := &countingEmbeddingGenerator{}
+	cache, err := NewCachedEmbeddingGenerator(underlying, "test-model", 32, path)
+	if err != nil {
+		t.Fatalf("Failed to create cache: %v", err)
+	}
+
+	long := strings.Repeat("blessed are the poor in spirit ", 20)
+	cache.GenerateEmbedding(long)
+	cache.GenerateEmbedding(strings.ToUpper(long))
+	// Same opening as long, so the two differ only past the key area
+	cache.GenerateEmbedding(long + "for theirs is the kingdom")
+	if calls := underlying.calls.Load(); calls != 2 {
+		t.Errorf("Expected long queries to be cached by their full text, got %d underlying calls", calls)
+	}
+	if _, _, skipped := cache.Stats(); skipped != 0 {
+		t.Errorf("Expected no skips, got %d", skipped)
+	}
+	cache.Close()
+
+	reopenedUnderlying := &countingEmbeddingGenerator{}
+	reopened, err := NewCachedEmbeddingGenerator(reopenedUnderlying, "test-model", 32, path)
+	if err != nil {
+		t.Fatalf("Failed to reopen cache: %v", err)
+	}
+	defer reopened.Close()
+	reopened.GenerateEmbedding(long)
+	if calls := reopenedUnderlying.calls.Load(); calls != 0 {
+		t.Errorf("Expected the long query to survive a reload, got %d underlying calls", calls)
+	}
+
+	// A key that does not fit even hashed is counted rather than dropped silently
+	unfit, err := NewCachedEmbeddingGenerator(&countingEmbeddingGenerator{}, strings.Repeat("m", embeddingCacheKeyBytes), 32, "")
+	if err != nil {
+		t.Fatalf("Failed to create cache: %v", err)
+	}
+	unfit.GenerateEmbedding("Jesus wept")
+	if _, _, skipped := unfit.Stats(); skipped != 1 {
+		t.Errorf("Expected 1 skip, got %d", skipped)
+	}
+}
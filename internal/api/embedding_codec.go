@@ -0,0 +1,91 @@
+package api
+
+import (
+	"encoding/base64"
+	"encoding/binary"
+	"fmt"
+	"math"
+	"strings"
+)
+
+// Supported encodings for client-supplied embeddings. Both are base64 of
+// little-endian IEEE 754 values.
+const (
+	EmbeddingFormatFP32 = "fp32"
+	EmbeddingFormatFP16 = "fp16"
+)
+
+// DecodeEmbedding decodes a base64 embedding in the given format; an empty
+// format means fp32
+func DecodeEmbedding(encoded, format string) ([]float32, error) {
+	raw, err := base64.StdEncoding.DecodeString(encoded)
+	if err != nil {
+		return nil, fmt.Errorf("embedding is not valid base64: %w", err)
+	}
+
+	switch strings.ToLower(format) {
+	case "", EmbeddingFormatFP32:
+		if len(raw) == 0 || len(raw)%4 != 0 {
+			return nil, fmt.Errorf("fp32 embedding must be a non-empty multiple of 4 bytes, got %d", len(raw))
+		}
+		embedding := make([]float32, len(raw)/4)
+		for i := range embedding {
+			embedding[i] = math.Float32frombits(binary.LittleEndian.Uint32(raw[i*4:]))
+		}
+		return checkFinite(embedding)
+	case EmbeddingFormatFP16:
+		if len(raw) == 0 || len(raw)%2 != 0 {
+			return nil, fmt.Errorf("fp16 embedding must be a non-empty multiple of 2 bytes, got %d", len(raw))
+		}
+		embedding := make([]float32, len(raw)/2)
+		for i := range embedding {
+			embedding[i] = halfToFloat32(binary.LittleEndian.Uint16(raw[i*2:]))
+		}
+		return checkFinite(embedding)
+	default:
+		return nil, fmt.Errorf("unsupported embedding format %q", format)
+	}
+}
+
+// EncodeEmbedding is the inverse of DecodeEmbedding for fp32
+func EncodeEmbedding(embedding []float32) string {
+	raw := make([]byte, len(embedding)*4)
+	for i, v := range embedding {
+		binary.LittleEndian.PutUint32(raw[i*4:], math.Float32bits(v))
+	}
+	return base64.StdEncoding.EncodeToString(raw)
+}
+
+func checkFinite(embedding []float32) ([]float32, error) {
+	for i, v := range embedding {
+		if math.IsNaN(float64(v)) || math.IsInf(float64(v), 0) {
+			return nil, fmt.Errorf("embedding value %d is not finite", i)
+		}
+	}
+	return embedding, nil
+}
+
+// halfToFloat32 widens an IEEE 754 binary16 value
+func halfToFloat32(h uint16) float32 {
+	sign := uint32(h>>15) << 31
+	exp := uint32(h>>10) & 0x1f
+	mant := uint32(h) & 0x3ff
+
+	switch {
+	case exp == 0 && mant == 0:
+		return math.Float32frombits(sign)
+	case exp == 0:
+		// Subnormal: renormalize into the float32 exponent range.
+		e := uint32(127 - 15 + 1)
+		for mant&0x400 == 0 {
+			mant <<= 1
+			e--
+		}
+		mant &= 0x3ff
+		return math.Float32frombits(sign | e<<23 | mant<<13)
+	case exp == 0x1f:
+		return math.Float32frombits(sign | 0xff<<23 | mant<<13)
+	default:
+		return math.Float32frombits(sign | (exp+127-15)<<23 | mant<<13)
+	}
+}
@@ -0,0 +1,46 @@
+package api
+
+import (
+	"encoding/base64"
+	"math"
+	"testing"
+)
+
+func TestHalfToFloat32(t *testing.T) {
+	tests := map[uint16]float32{
+		0x0000: 0,
+		0x3c00: 1,
+		0xc000: -2,
+		0x3555: 0.333251953125,
+		0x7bff: 65504,
+		0x0001: 5.960464477539063e-08, // smallest subnormal
+	}
+	for half, expected := range tests {
+		if got := halfToFloat32(half); got != expected {
+			t.Errorf("halfToFloat32(%#04x): expected %v, got %v", half, expected, got)
+		}
+	}
+	if !math.IsInf(float64(halfToFloat32(0x7c00)), 1) {
+		t.Error("Expected 0x7c00 to decode to +Inf")
+	}
+}
+
+func TestDecodeEmbedding(t *testing.T) {
+	original := []float32{0.25, -1.5, 3}
+	decoded, err := DecodeEmbedding(EncodeEmbedding(original), "")
+	if err != nil {
+		t.Fatalf("Expected no error, got %v", err)
+	}
+	for i := range original {
+		if decoded[i] != original[i] {
+			t.Errorf("Value %d: expected %v, got %v", i, original[i], decoded[i])
+		}
+	}
+
+	if _, err := DecodeEmbedding(base64.StdEncoding.EncodeToString([]byte{1, 2, 3}), "fp32"); err == nil {
+		t.Error("Expected an error for a truncated fp32 embedding")
+	}
+	if _, err := DecodeEmbedding(base64.StdEncoding.EncodeToString([]byte{0x00, 0x7c}), "fp16"); err == nil {
+		t.Error("Expected an error for a non-finite value")
+	}
+}
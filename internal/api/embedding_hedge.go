@@ -0,0 +1,288 @@
+package api
+
+import (
+	"context"
+	"errors"
+	"net"
+	"net/http"
+	"sort"
+	"sync"
+	"time"
+
+	"github.com/sashabaranov/go-openai"
+)
+
+// DefaultMaxConnsPerHost sizes the keep-alive pool to the embedding backend
+const DefaultMaxConnsPerHost = 32
+
+// NewPooledHTTPClient returns a client tuned for many small requests to a
+// single upstream: warm keep-alive connections are retained so concurrent
+// and hedged calls skip TCP and TLS setup. Timeouts are left to the
+// per-attempt contexts.
+func NewPooledHTTPClient(maxConnsPerHost int) *http.Client {
+	if maxConnsPerHost <= 0 {
+		maxConnsPerHost = DefaultMaxConnsPerHost
+	}
+	dialer := &net.Dialer{
+		Timeout:   5 * time.Second,
+		KeepAlive: 30 * time.Second,
+	}
+	transport := &http.Transport{
+		Proxy:                 http.ProxyFromEnvironment,
+		DialContext:           dialer.DialContext,
+		ForceAttemptHTTP2:     true,
+		MaxIdleConns:          maxConnsPerHost * 2,
+		MaxIdleConnsPerHost:   maxConnsPerHost,
+		MaxConnsPerHost:       maxConnsPerHost * 2,
+		IdleConnTimeout:       90 * time.Second,
+		TLSHandshakeTimeout:   5 * time.Second,
+		ExpectContinueTimeout: time.Second,
+	}
+	return &http.Client{Transport: transport}
+}
+
+// HedgingConfig controls hedged and retried embedding attempts
+type HedgingConfig struct {
+	AttemptTimeout    time.Duration // upper bound for a single upstream attempt
+	MaxAttempts       int           // total attempts per call, hedges and retries included
+	Quantile          float64       // observed latency quantile that triggers a hedge
+	MinHedgeDelay     time.Duration // floor for the hedge delay
+	InitialHedgeDelay time.Duration // delay used until enough latencies are observed
+	LatencyWindow     int           // number of recent successful latencies tracked
+}
+
+// DefaultHedgingConfig hedges at the observed p95 with up to three attempts
+func DefaultHedgingConfig() HedgingConfig {
+	return HedgingConfig{
+		AttemptTimeout:    5 * time.Second,
+		MaxAttempts:       3,
+		Quantile:          0.95,
+		MinHedgeDelay:     20 * time.Millisecond,
+		InitialHedgeDelay: 500 * time.Millisecond,
+		LatencyWindow:     256,
+	}
+}
+
+// HedgedEmbeddingGenerator cuts tail latency by firing a second upstream
+// call when the first has not returned by the observed latency quantile,
+// and retries transient failures while the caller's deadline allows. The
+// first successful attempt wins and the rest are cancelled.
+type HedgedEmbeddingGenerator struct {
+	next    ContextBatchEmbeddingGenerator
+	config  HedgingConfig
+	latency *latencyTracker
+}
+
+// NewHedgedEmbeddingGenerator wraps next with hedging and retries
+func NewHedgedEmbeddingGenerator(next ContextBatchEmbeddingGenerator, config HedgingConfig) *HedgedEmbeddingGenerator {
+	defaults := DefaultHedgingConfig()
+	if config.AttemptTimeout <= 0 {
+		config.AttemptTimeout = defaults.AttemptTimeout
+	}
+	if config.MaxAttempts <= 0 {
+		config.MaxAttempts = defaults.MaxAttempts
+	}
+	if config.Quantile <= 0 || config.Quantile >= 1 {
+		config.Quantile = defaults.Quantile
+	}
+	if config.MinHedgeDelay <= 0 {
+		config.MinHedgeDelay = defaults.MinHedgeDelay
+	}
+	if config.InitialHedgeDelay <= 0 {
+		config.InitialHedgeDelay = defaults.InitialHedgeDelay
+	}
+	if config.LatencyWindow <= 0 {
+		config.LatencyWindow = defaults.LatencyWindow
+	}
+	return &HedgedEmbeddingGenerator{
+		next:    next,
+		config:  config,
+		latency: newLatencyTracker(config.LatencyWindow),
+	}
+}
+
+// GenerateEmbedding creates an embedding with hedging, without a caller deadline
+func (h *HedgedEmbeddingGenerator) GenerateEmbedding(text string) ([]float32, error) {
+	return h.GenerateEmbeddingContext(context.Background(), text)
+}
+
+// GenerateEmbeddingContext creates an embedding with hedging within ctx
+func (h *HedgedEmbeddingGenerator) GenerateEmbeddingContext(ctx context.Context, text string) ([]float32, error) {
+	embeddings, err := h.GenerateEmbeddingsContext(ctx, []string{text})
+	if err != nil {
+		return nil, err
+	}
+	return embeddings[0], nil
+}
+
+// GenerateEmbeddings creates a batch of embeddings with hedging
+func (h *HedgedEmbeddingGenerator) GenerateEmbeddings(texts []string) ([][]float32, error) {
+	return h.GenerateEmbeddingsContext(context.Background(), texts)
+}
+
+// GenerateEmbeddingsContext creates a batch of embeddings with hedging within ctx
+func (h *HedgedEmbeddingGenerator) GenerateEmbeddingsContext(ctx context.Context, texts []string) ([][]float32, error) {
+	if _, ok := ctx.Deadline(); !ok {
+		var cancel context.CancelFunc
+		ctx, cancel = context.WithTimeout(ctx, defaultEmbeddingTimeout)
+		defer cancel()
+	}
+	// Cancelling on return stops attempts that lost the race.
+	ctx, cancel := context.WithCancel(ctx)
+	defer cancel()
+
+	type attemptResult struct {
+		embeddings [][]float32
+		err        error
+	}
+	results := make(chan attemptResult, h.config.MaxAttempts)
+	hedgeDelay := h.hedgeDelay()
+	launch := func() {
+		go func() {
+			attemptCtx, attemptCancel := context.WithTimeout(ctx, h.config.AttemptTimeout)
+			defer attemptCancel()
+			start := time.Now()
+			embeddings, err := h.next.GenerateEmbeddingsContext(attemptCtx, texts)
+			elapsed := time.Since(start)
+			// An attempt cut short only shows it would have taken longer. One
+			// that outlasted the hedge delay is a tail sample the quantile
+			// must see; a hedge cancelled early says nothing and would drag
+			// the delay down, hedging ever more.
+			if err == nil || (attemptCtx.Err() != nil && elapsed >= hedgeDelay) {
+				h.latency.observe(elapsed)
+			}
+			results <- attemptResult{embeddings: embeddings, err: err}
+		}()
+	}
+
+	launch()
+	launched, finished := 1, 0
+	hedgeTimer := time.NewTimer(hedgeDelay)
+	defer hedgeTimer.Stop()
+
+	var lastErr error
+	for finished < launched {
+		select {
+		case <-hedgeTimer.C:
+			if launched < h.config.MaxAttempts {
+				launch()
+				launched++
+				hedgeTimer.Reset(hedgeDelay)
+			}
+		case res := <-results:
+			finished++
+			if res.err == nil {
+				return res.embeddings, nil
+			}
+			lastErr = res.err
+			if !retryableEmbeddingError(res.err) {
+				return nil, res.err
+			}
+			// Retry a failed attempt right away if budget remains.
+			if launched < h.config.MaxAttempts && ctx.Err() == nil {
+				launch()
+				launched++
+			}
+		case <-ctx.Done():
+			if lastErr == nil {
+				lastErr = ctx.Err()
+			}
+			return nil, errors.Join(ctx.Err(), lastErr)
+		}
+	}
+	return nil, lastErr
+}
+
+// retryableEmbeddingError reports whether another attempt may succeed: server
+// errors and request timeouts, and failures that never got a status such as
+// deadlines and transport errors. Other client errors, rate limiting
+// included, would fail the same way again.
+func retryableEmbeddingError(err error) bool {
+	status := embeddingErrorStatus(err)
+	return status == 0 || status == http.StatusRequestTimeout || status >= http.StatusInternalServerError
+}
+
+// embeddingErrorStatus returns the HTTP status an upstream call failed
+// with, or 0 if it failed without one
+func embeddingErrorStatus(err error) int {
+	var apiErr *openai.APIError
+	var requestErr *openai.RequestError
+	switch {
+	case errors.As(err, &apiErr):
+		return apiErr.HTTPStatusCode
+	case errors.As(err, &requestErr):
+		return requestErr.HTTPStatusCode
+	}
+	return 0
+}
+
+// HedgeDelay reports the delay currently used before hedging an attempt
+func (h *HedgedEmbeddingGenerator) HedgeDelay() time.Duration {
+	return h.hedgeDelay()
+}
+
+func (h *HedgedEmbeddingGenerator) hedgeDelay() time.Duration {
+	delay, ok := h.latency.quantile(h.config.Quantile)
+	if !ok {
+		delay = h.config.InitialHedgeDelay
+	}
+	if delay < h.config.MinHedgeDelay {
+		delay = h.config.MinHedgeDelay
+	}
+	return delay
+}
+
+// latencyTracker keeps a ring of recent latencies; quantiles are computed
+// from a sorted copy and cached until new samples arrive
+type latencyTracker struct {
+	mu       sync.Mutex
+	samples  []time.Duration
+	next     int
+	filled   bool
+	dirty    bool
+	sorted   []time.Duration
+	minCount int
+}
+
+func newLatencyTracker(window int) *latencyTracker {
+	minCount := window / 8
+	if minCount < 10 {
+		minCount = 10
+	}
+	return &latencyTracker{
+		samples:  make([]time.Duration, window),
+		sorted:   make([]time.Duration, 0, window),
+		minCount: minCount,
+	}
+}
+
+func (t *latencyTracker) observe(d time.Duration) {
+	t.mu.Lock()
+	defer t.mu.Unlock()
+	t.samples[t.next] = d
+	t.next++
+	if t.next == len(t.samples) {
+		t.next = 0
+		t.filled = true
+	}
+	t.dirty = true
+}
+
+func (t *latencyTracker) quantile(q float64) (time.Duration, bool) {
+	t.mu.Lock()
+	defer t.mu.Unlock()
+	count := t.next
+	if t.filled {
+		count = len(t.samples)
+	}
+	if count < t.minCount {
+		return 0, false
+	}
+	if t.dirty {
+		t.sorted = append(t.sorted[:0], t.samples[:count]...)
+		sort.Slice(t.sorted, func(i, j int) bool { return t.sorted[i] < t.sorted[j] })
+		t.dirty = false
+	}
+	idx := int(q * float64(len(t.sorted)-1))
+	return t.sorted[idx], true
+}
@@ -0,0 +1,172 @@
+package api
+
+import (
+	"context"
+	"net/http"
+	"testing"
+	"time"
+)
+
+func TestHedgedEmbeddingGenerator_HedgesSlowAttempt(t *testing.T) {
+	server := newFakeEmbeddingServer(t)
+	server.delay = func(call int) time.Duration {
+		if call == 0 {
+			return 2 * time.Second
+		}
+		return 0
+	}
+	hedged := NewHedgedEmbeddingGenerator(server.generator(), HedgingConfig{
+		InitialHedgeDelay: 50 * time.Millisecond,
+	})
+
+	start := time.Now()
+	embedding, err := hedged.GenerateEmbedding("God is love")
+	if err != nil {
+		t.Fatalf("Expected no error, got %v", err)
+	}
+	if elapsed := time.Since(start); elapsed > time.Second {
+		t.Errorf("Expected the hedge to answer before the slow attempt, took %v", elapsed)
+	}
+	if embedding[0] != float32(len("God is love")) {
+		t.Errorf("Unexpected embedding %v", embedding)
+	}
+	if calls := server.calls(); len(calls) != 2 {
+		t.Errorf("Expected 2 upstream calls, got %d", len(calls))
+	}
+}
+
+func TestHedgedEmbeddingGenerator_RetriesTimedOutAttempt(t *testing.T) {
+	server := newFakeEmbeddingServer(t)
+	server.delay = func(call int) time.Duration {
+		if call == 0 {
+			return 2 * time.Second
+		}
+		return 0
+	}
+	// The hedge delay exceeds the attempt timeout, so the second call is a retry.
+	hedged := NewHedgedEmbeddingGenerator(server.generator(), HedgingConfig{
+		AttemptTimeout:    100 * time.Millisecond,
+		InitialHedgeDelay: time.Second,
+	})
+
+	start := time.Now()
+	if _, err := hedged.GenerateEmbedding("Jesus wept"); err != nil {
+		t.Fatalf("Expected retry to succeed, got %v", err)
+	}
+	if elapsed := time.Since(start); elapsed > time.Second {
+		t.Errorf("Expected retry after the attempt timeout, took %v", elapsed)
+	}
+	if calls := server.calls(); len(calls) != 2 {
+		t.Errorf("Expected 2 upstream calls, got %d", len(calls))
+	}
+}
+
+func TestHedgedEmbeddingGenerator_RespectsDeadline(t *testing.T) {
+	server := newFakeEmbeddingServer(t)
+	server.delay = func(int) time.Duration { return 2 * time.Second }
+	hedged := NewHedgedEmbeddingGenerator(server.generator(), HedgingConfig{
+		InitialHedgeDelay: 20 * time.Millisecond,
+	})
+
+	ctx, cancel := context.WithTimeout(context.Background(), 100*time.Millisecond)
+	defer cancel()
+
+	start := time.Now()
+	if _, err := hedged.GenerateEmbeddingContext(ctx, "In the beginning"); err == nil {
+		t.Fatal("Expected an error once the deadline passed")
+	}
+	if elapsed := time.Since(start); elapsed > 500*time.Millisecond {
+		t.Errorf("Expected to return at the deadline, took %v", elapsed)
+	}
+	if calls := server.calls(); len(calls) > 3 {
+		t.Errorf("Expected at most 3 attempts, got %d", len(calls))
+	}
+}
+
+func TestHedgedEmbeddingGenerator_RetriesOnlyTransientErrors(t *testing.T) {
+	for _, tc := range []struct {
+		status        int
+		expectedCalls int
+	}{
+		{http.StatusInternalServerError, 2},
+		{http.StatusServiceUnavailable, 2},
+		{http.StatusBadRequest, 1},
+		{http.StatusUnauthorized, 1},
+		{http.StatusTooManyRequests, 1},
+	} {
+		server := newFakeEmbeddingServer(t)
+		server.status = func(call int) int {
+			if call == 0 {
+				return tc.status
+			}
+			return http.StatusOK
+		}
+		hedged := NewHedgedEmbeddingGenerator(server.generator(), HedgingConfig{
+			InitialHedgeDelay: time.Second,
+		})
+
+		_, err := hedged.GenerateEmbedding("Jesus wept")
+		if retried := tc.expectedCalls > 1; retried != (err == nil) {
+			t.Errorf("%d: expected success %v, got %v", tc.status, retried, err)
+		}
+		if calls := server.calls(); len(calls) != tc.expectedCalls {
+			t.Errorf("%d: expected %d upstream calls, got %d", tc.status, tc.expectedCalls, len(calls))
+		}
+	}
+}
+
+func TestHedgedEmbeddingGenerator_ObservesCancelledAttempts(t *testing.T) {
+	server := newFakeEmbeddingServer(t)
+	server.delay = func(call int) time.Duration {
+		if call == 0 {
+			return 2 * time.Second
+		}
+		return 0
+	}
+	hedged := NewHedgedEmbeddingGenerator(server.generator(), HedgingConfig{
+		InitialHedgeDelay: 50 * time.Millisecond,
+	})
+	if _, err := hedged.GenerateEmbedding("God is love"); err != nil {
+		t.Fatalf("Expected no error, got %v", err)
+	}
+
+	// The slow attempt is cancelled once the hedge wins and still counts
+	deadline := time.Now().Add(time.Second)
+	for {
+		hedged.latency.mu.Lock()
+		observed := hedged.latency.next
+		hedged.latency.mu.Unlock()
+		if observed == 2 {
+			break
+		}
+		if time.Now().After(deadline) {
+			t.Fatalf("Expected the winner and the cancelled loser to be observed, got %d samples", observed)
+		}
+		time.Sleep(5 * time.Millisecond)
+	}
+}
+
+func TestHedgedEmbeddingGenerator_IgnoresHedgesCancelledEarly(t *testing.T) {
+	server := newFakeEmbeddingServer(t)
+	server.delay = func(call int) time.Duration {
+		if call == 0 {
+			return 80 * time.Millisecond
+		}
+		return 2 * time.Second
+	}
+	hedged := NewHedgedEmbeddingGenerator(server.generator(), HedgingConfig{
+		InitialHedgeDelay: 50 * time.Millisecond,
+	})
+	if _, err := hedged.GenerateEmbedding("God is love"); err != nil {
+		t.Fatalf("Expected no error, got %v", err)
+	}
+
+	// The hedge ran about 30ms before the original won; that is no latency
+	time.Sleep(100 * time.Millisecond)
+	hedged.latency.mu.Lock()
+	observed := hedged.latency.next
+	hedged.latency.mu.Unlock()
+	if observed != 1 {
+		t.Errorf("Expected only the winner to be observed, got %d samples", observed)
+	}
+}
@@ -0,0 +1,304 @@
+package api
+
+import (
+	"bufio"
+	"context"
+	"crypto/sha256"
+	"encoding/binary"
+	"errors"
+	"fmt"
+	"hash/crc32"
+	"io"
+	"math"
+	"os"
+	"slices"
+	"strings"
+	"sync"
+)
+
+const (
+	// Record layout: the 32-byte key, a uint32 dimension, the embedding as
+	// little-endian float32 values, then a CRC-32C of all of those
+	embeddingStoreMagic     = "VJEMBS02"
+	embeddingStoreKeyBytes  = sha256.Size
+	embeddingStoreRecordMin = embeddingStoreKeyBytes + 4
+	embeddingStoreMaxDim    = 1 << 16
+
+	// DefaultStoreBatch is the number of texts per upstream call when
+	// filling an embedding store, inside the API's 2048 input cap
+	DefaultStoreBatch = 512
+
+	// DefaultStoreConcurrency is the number of upstream calls in flight
+	DefaultStoreConcurrency = 4
+)
+
+// EmbeddingStore is a persistent, content-addressed embedding store for
+// index builds: embeddings are keyed by a hash of the model and the text, so
+// a rebuild only generates embeddings for texts it has not seen, whichever
+// verse or translation they belong to. The file is an append-only log, each
+// finished batch is written and synced to it, and an interrupted build
+// resumes from the last synced batch.
+type EmbeddingStore struct {
+	model string
+
+	mu      sync.RWMutex
+	entries map[[embeddingStoreKeyBytes]byte][]float32
+	file    *os.File
+	writer  *bufio.Writer
+	end     int64  // offset after the last synced record
+	record  []byte // reused to encode records
+}
+
+var embeddingStoreCRC = crc32.MakeTable(crc32.Castagnoli)
+
+// OpenEmbeddingStore opens or creates the store at path for a model. A torn
+// or corrupted record, left by an interrupted write or damaged since, is
+// dropped with everything after it.
+func OpenEmbeddingStore(path, model string) (*EmbeddingStore, error) {
+	file, err := os.OpenFile(path, os.O_RDWR|os.O_CREATE, 0644)
+	if err != nil {
+		return nil, fmt.Errorf("failed to open embedding store: %w", err)
+	}
+	s := &EmbeddingStore{
+		model:   model,
+		entries: make(map[[embeddingStoreKeyBytes]byte][]float32),
+		file:    file,
+	}
+	end, err := s.load()
+	if err == nil {
+		err = file.Truncate(end)
+	}
+	if err == nil {
+		_, err = file.Seek(end, io.SeekStart)
+	}
+	if err == nil && end == 0 {
+		if _, err = file.WriteString(embeddingStoreMagic); err == nil {
+			end = int64(len(embeddingStoreMagic))
+		}
+	}
+	if err != nil {
+		file.Close()
+		return nil, fmt.Errorf("failed to read embedding store %s: %w", path, err)
+	}
+	s.writer = bufio.NewWriterSize(file, 1<<20)
+	s.end = end
+	return s, nil
+}
+
+// load reads every complete record and returns the offset after the last
+func (s *EmbeddingStore) load() (int64, error) {
+	reader := bufio.NewReaderSize(s.file, 1<<20)
+	magic := make([]byte, len(embeddingStoreMagic))
+	if n, err := io.ReadFull(reader, magic); err != nil {
+		if n == 0 && err == io.EOF {
+			return 0, nil
+		}
+		return 0, fmt.Errorf("not an embedding store")
+	}
+	if string(magic) != embeddingStoreMagic {
+		return 0, fmt.Errorf("not an embedding store")
+	}
+
+	end := int64(len(magic))
+	header := make([]byte, embeddingStoreRecordMin)
+	var values []byte
+	for {
+		if _, err := io.ReadFull(reader, header); err != nil {
+			return end, nil
+		}
+		dim := int(binary.LittleEndian.Uint32(header[embeddingStoreKeyBytes:]))
+		if dim <= 0 || dim > embeddingStoreMaxDim {
+			return end, nil
+		}
+		if cap(values) < dim*4+4 {
+			values = make([]byte, dim*4+4)
+		}
+		values = values[:dim*4+4]
+		if _, err := io.ReadFull(reader, values); err != nil {
+			return end, nil
+		}
+		crc := crc32.Update(crc32.Checksum(header, embeddingStoreCRC), embeddingStoreCRC, values[:dim*4])
+		if crc != binary.LittleEndian.Uint32(values[dim*4:]) {
+			return end, nil
+		}
+		embedding := make([]float32, dim)
+		for i := range embedding {
+			embedding[i] = math.Float32frombits(binary.LittleEndian.Uint32(values[i*4:]))
+		}
+		s.entries[[embeddingStoreKeyBytes]byte(header)] = embedding
+		end += int64(embeddingStoreRecordMin + len(values))
+	}
+}
+
+func (s *EmbeddingStore) key(text string) [embeddingStoreKeyBytes]byte {
+	h := sha256.New()
+	h.Write([]byte(s.model))
+	h.Write([]byte{0})
+	h.Write([]byte(strings.TrimSpace(text)))
+	return [embeddingStoreKeyBytes]byte(h.Sum(nil))
+}
+
+// Get returns the stored embedding of a text
+func (s *EmbeddingStore) Get(text string) ([]float32, bool) {
+	s.mu.RLock()
+	defer s.mu.RUnlock()
+	embedding, ok := s.entries[s.key(text)]
+	return embedding, ok
+}
+
+// Len returns the number of stored embeddings, across models
+func (s *EmbeddingStore) Len() int {
+	s.mu.RLock()
+	defer s.mu.RUnlock()
+	return len(s.entries)
+}
+
+// Put stores embeddings for texts, skipping texts already stored, and
+// writes and syncs them to the file. If that fails, none of them is stored.
+func (s *EmbeddingStore) Put(texts []string, embeddings [][]float32) error {
+	if len(texts) != len(embeddings) {
+		return fmt.Errorf("%d texts but %d embeddings", len(texts), len(embeddings))
+	}
+	for _, embedding := range embeddings {
+		if len(embedding) == 0 || len(embedding) > embeddingStoreMaxDim {
+			return fmt.Errorf("embedding of %d dimensions cannot be stored", len(embedding))
+		}
+	}
+	s.mu.Lock()
+	defer s.mu.Unlock()
+	var added [][embeddingStoreKeyBytes]byte
+	written := int64(0)
+	for i, text := range texts {
+		key := s.key(text)
+		if _, ok := s.entries[key]; ok {
+			continue
+		}
+		embedding := embeddings[i]
+		record := s.record[:0]
+		record = append(record, key[:]...)
+		record = binary.LittleEndian.AppendUint32(record, uint32(len(embedding)))
+		for _, v := range embedding {
+			record = binary.LittleEndian.AppendUint32(record, math.Float32bits(v))
+		}
+		record = binary.LittleEndian.AppendUint32(record, crc32.Checksum(record, embeddingStoreCRC))
+		s.record = record
+		s.writer.Write(record)
+		written += int64(len(record))
+		s.entries[key] = embedding
+		added = append(added, key)
+	}
+	err := s.writer.Flush()
+	if err == nil {
+		err = s.file.Sync()
+	}
+	if err != nil {
+		// Cut the batch off, so later batches are not appended behind a
+		// torn record and dropped with it on the next open
+		for _, key := range added {
+			delete(s.entries, key)
+		}
+		s.writer.Reset(s.file)
+		if truncErr := s.file.Truncate(s.end); truncErr != nil {
+			err = errors.Join(err, truncErr)
+		} else if _, seekErr := s.file.Seek(s.end, io.SeekStart); seekErr != nil {
+			err = errors.Join(err, seekErr)
+		}
+		return fmt.Errorf("failed to write embedding store: %w", err)
+	}
+	s.end += written
+	return nil
+}
+
+// Close flushes the store and closes its file
+func (s *EmbeddingStore) Close() error {
+	s.mu.Lock()
+	defer s.mu.Unlock()
+	flushErr := s.writer.Flush()
+	syncErr := s.file.Sync()
+	closeErr := s.file.Close()
+	return errors.Join(flushErr, syncErr, closeErr)
+}
+
+// Embed returns the embedding of every text, generating only those not in
+// the store. Distinct missing texts are sent to gen in batches of batchSize
+// with up to concurrency calls in flight, and each batch is stored as it
+// completes, so a failed run keeps its progress. It reports how many texts
+// were generated; progress, when set, is called after each batch.
+func (s *EmbeddingStore) Embed(ctx context.Context, gen BatchEmbeddingGenerator, texts []string, batchSize, concurrency int, progress func(done, total int)) ([][]float32, int, error) {
+	if batchSize <= 0 {
+		batchSize = DefaultStoreBatch
+	}
+	if concurrency <= 0 {
+		concurrency = DefaultStoreConcurrency
+	}
+
+	var missing []string
+	seen := make(map[string]bool)
+	for _, text := range texts {
+		text = strings.TrimSpace(text)
+		if _, ok := s.Get(text); !ok && !seen[text] {
+			seen[text] = true
+			missing = append(missing, text)
+		}
+	}
+
+	ctx, cancel := context.WithCancel(ctx)
+	defer cancel()
+	batches := make(chan []string)
+	var wg sync.WaitGroup
+	var mu sync.Mutex
+	var firstErr error
+	done := 0
+	for i := 0; i < concurrency; i++ {
+		wg.Add(1)
+		go func() {
+			defer wg.Done()
+			for batch := range batches {
+				embeddings, err := generateEmbeddings(ctx, gen, batch)
+				if err == nil && len(embeddings) != len(batch) {
+					err = fmt.Errorf("expected %d embeddings, received %d", len(batch), len(embeddings))
+				}
+				if err == nil {
+					err = s.Put(batch, embeddings)
+				}
+				mu.Lock()
+				if err != nil && firstErr == nil {
+					firstErr = err
+					cancel()
+				}
+				done += len(batch)
+				if err == nil && progress != nil {
+					progress(done, len(missing))
+				}
+				mu.Unlock()
+			}
+		}()
+	}
+send:
+	for start := 0; start < len(missing); start += batchSize {
+		select {
+		case batches <- missing[start:min(start+batchSize, len(missing))]:
+		case <-ctx.Done():
+			break send
+		}
+	}
+	close(batches)
+	wg.Wait()
+	if firstErr == nil {
+		firstErr = ctx.Err()
+	}
+	if firstErr != nil {
+		return nil, 0, fmt.Errorf("embedding generation failed: %w", firstErr)
+	}
+
+	embeddings := make([][]float32, len(texts))
+	for i, text := range texts {
+		embedding, ok := s.Get(text)
+		if !ok {
+			return nil, 0, fmt.Errorf("no embedding generated for %q", text)
+		}
+		// Callers may normalize in place
+		embeddings[i] = slices.Clone(embedding)
+	}
+	return embeddings, len(missing), nil
+}
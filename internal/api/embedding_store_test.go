@@ -0,0 +1,163 @@
+package api
+
+import (
+	"context"
+	"errors"
+	"os"
+	"path/filepath"
+	"sort"
+	"testing"
+)
+
+// failingBatchGenerator embeds texts by length until its call budget runs out
+type failingBatchGenerator struct {
+	calls, budget int
+}
+
+func (g *failingBatchGenerator) GenerateEmbeddings(texts []string) ([][]float32, error) {
+	if g.calls++; g.calls > g.budget {
+		return nil, errors.New("quota exceeded")
+	}
+	embeddings := make([][]float32, len(texts))
+	for i, text := range texts {
+		embeddings[i] = []float32{float32(len(text)), 1}
+	}
+	return embeddings, nil
+}
+
+func TestEmbeddingStore_GeneratesOnlyNewTexts(t *testing.T) {
+	path := filepath.Join(t.TempDir(), "embeddings.store")
+	server := newFakeEmbeddingServer(t)
+
+	store, err := OpenEmbeddingStore(path, "text-embedding-3-small")
+	if err != nil {
+		t.Fatalf("OpenEmbeddingStore failed: %v", err)
+	}
+	texts := []string{"a", "bb", " a ", "ccc", "dddd", "bb", "eeeee"}
+	embeddings, generated, err := store.Embed(context.Background(), server.generator(), texts, 2, 2, nil)
+	if err != nil {
+		t.Fatalf("Embed failed: %v", err)
+	}
+	if generated != 5 {
+		t.Errorf("Expected 5 distinct texts to be generated, got %d", generated)
+	}
+	calls := server.calls()
+	sort.Ints(calls)
+	if len(calls) != 3 || calls[0] != 1 || calls[2] != 2 {
+		t.Errorf("Expected batches of at most 2 texts, got %v", calls)
+	}
+	for i, text := range []string{"a", "bb", "a", "ccc", "dddd", "bb", "eeeee"} {
+		if embeddings[i][0] != float32(len(text)) {
+			t.Errorf("Embedding %d belongs to another text: %v", i, embeddings[i])
+		}
+	}
+	embeddings[0][0] = 99 // callers own their copies
+	if err := store.Close(); err != nil {
+		t.Fatalf("Close failed: %v", err)
+	}
+
+	// A torn record from an interrupted write is dropped on reopen
+	file, _ := os.OpenFile(path, os.O_APPEND|os.O_WRONLY, 0644)
+	file.Write([]byte("torn record"))
+	file.Close()
+
+	reopened, err := OpenEmbeddingStore(path, "text-embedding-3-small")
+	if err != nil {
+		t.Fatalf("Reopening the store failed: %v", err)
+	}
+	defer reopened.Close()
+	if reopened.Len() != 5 {
+		t.Errorf("Expected 5 stored embeddings after reopening, got %d", reopened.Len())
+	}
+	if embedding, ok := reopened.Get("a"); !ok || embedding[0] != 1 {
+		t.Errorf("Expected the stored embedding of %q, got %v", "a", embedding)
+	}
+	_, generated, err = reopened.Embed(context.Background(), server.generator(), []string{"a", "bb", "ffffff"}, 2, 2, nil)
+	if err != nil || generated != 1 || len(server.calls()) != 4 {
+		t.Errorf("Expected one call for the one changed text, got %d generated in %v, %v", generated, server.calls(), err)
+	}
+
+	other, err := OpenEmbeddingStore(filepath.Join(t.TempDir(), "other.store"), "text-embedding-3-large")
+	if err != nil {
+		t.Fatalf("OpenEmbeddingStore failed: %v", err)
+	}
+	defer other.Close()
+	if _, ok := other.Get("a"); ok {
+		t.Error("Expected embeddings to be keyed by model")
+	}
+}
+
+func TestEmbeddingStore_KeepsProgressOnFailure(t *testing.T) {
+	path := filepath.Join(t.TempDir(), "embeddings.store")
+	store, err := OpenEmbeddingStore(path, "model")
+	if err != nil {
+		t.Fatalf("OpenEmbeddingStore failed: %v", err)
+	}
+	texts := []string{"a", "bb", "ccc", "dddd", "eeeee", "ffffff"}
+	generator := &failingBatchGenerator{budget: 2}
+	if _, _, err := store.Embed(context.Background(), generator, texts, 2, 1, nil); err == nil {
+		t.Fatal("Expected the third batch to fail the run")
+	}
+	store.Close()
+
+	resumed, err := OpenEmbeddingStore(path, "model")
+	if err != nil {
+		t.Fatalf("Reopening the store failed: %v", err)
+	}
+	defer resumed.Close()
+	if resumed.Len() != 4 {
+		t.Errorf("Expected the two finished batches to be checkpointed, got %d embeddings", resumed.Len())
+	}
+	generator.budget = generator.calls + 1
+	if _, generated, err := resumed.Embed(context.Background(), generator, texts, 2, 1, nil); err != nil || generated != 2 {
+		t.Errorf("Expected the resumed run to generate the last 2 texts, got %d, %v", generated, err)
+	}
+
+	notStore := filepath.Join(t.TempDir(), "index.gob")
+	os.WriteFile(notStore, []byte("something else"), 0644)
+	if _, err := OpenEmbeddingStore(notStore, "model"); err == nil {
+		t.Error("Expected a file of another format to be refused")
+	}
+}
+
+func TestEmbeddingStore_DropsCorruptedRecords(t *testing.T) {
+	path := filepath.Join(t.TempDir(), "embeddings.store")
+	store, err := OpenEmbeddingStore(path, "model")
+	if err != nil {
+		t.Fatalf("OpenEmbeddingStore failed: %v", err)
+	}
+	if err := store.Put([]string{"a", "bb", "ccc"}, [][]float32{{1, 1}, {2, 1}, {3, 1}}); err != nil {
+		t.Fatalf("Put failed: %v", err)
+	}
+	store.Close()
+
+	// Damage a value of the last record; its length still parses
+	data, _ := os.ReadFile(path)
+	data[len(data)-6] ^= 0x40
+	os.WriteFile(path, data, 0644)
+
+	reopened, err := OpenEmbeddingStore(path, "model")
+	if err != nil {
+		t.Fatalf("Reopening the store failed: %v", err)
+	}
+	if reopened.Len() != 2 {
+		t.Errorf("Expected the corrupted record to be dropped, got %d embeddings", reopened.Len())
+	}
+	if _, ok := reopened.Get("ccc"); ok {
+		t.Error("Expected the corrupted embedding not to be served")
+	}
+	if err := reopened.Put([]string{"ccc"}, [][]float32{{3, 1}}); err != nil {
+		t.Fatalf("Put failed: %v", err)
+	}
+	reopened.Close()
+
+	// The damaged tail was cut, so the rewritten record follows the good ones
+	again, err := OpenEmbeddingStore(path, "model")
+	if err != nil {
+		t.Fatalf("Reopening the store failed: %v", err)
+	}
+	defer again.Close()
+	if embedding, ok := again.Get("ccc"); again.Len() != 3 || !ok || embedding[0] != 3 {
+		t.Errorf("Expected 3 embeddings after rewriting the damaged one, got %d", again.Len())
+	}
+}
@@ -3,9 +3,13 @@ package api
 import (
 	"context"
 	"encoding/json"
+	"errors"
 	"fmt"
 	"log"
 	"net/http"
+	"slices"
+	"strconv"
+	"sync/atomic"
 	"time"
 
 	"versejet/internal/index"
@@ -18,27 +22,80 @@ type EmbeddingGenerator interface {
 	GenerateEmbedding(text string) ([]float32, error)
 }
 
+// ContextEmbeddingGenerator is implemented by generators that honor request
+// deadlines and cancellation
+type ContextEmbeddingGenerator interface {
+	GenerateEmbeddingContext(ctx context.Context, text string) ([]float32, error)
+}
+
+// BatchEmbeddingGenerator generates embeddings for several texts in one call
+type BatchEmbeddingGenerator interface {
+	GenerateEmbeddings(texts []string) ([][]float32, error)
+}
+
+// ContextBatchEmbeddingGenerator is the deadline-aware form of BatchEmbeddingGenerator
+type ContextBatchEmbeddingGenerator interface {
+	GenerateEmbeddingsContext(ctx context.Context, texts []string) ([][]float32, error)
+}
+
+// generateEmbedding calls the context-aware method when the generator has one
+func generateEmbedding(ctx context.Context, gen EmbeddingGenerator, text string) ([]float32, error) {
+	if cg, ok := gen.(ContextEmbeddingGenerator); ok {
+		return cg.GenerateEmbeddingContext(ctx, text)
+	}
+	return gen.GenerateEmbedding(text)
+}
+
+// generateEmbeddings calls the context-aware batch method when the generator has one
+func generateEmbeddings(ctx context.Context, gen BatchEmbeddingGenerator, texts []string) ([][]float32, error) {
+	if cg, ok := gen.(ContextBatchEmbeddingGenerator); ok {
+		return cg.GenerateEmbeddingsContext(ctx, texts)
+	}
+	return gen.GenerateEmbeddings(texts)
+}
+
+// defaultEmbeddingTimeout bounds calls made without a caller deadline
+const defaultEmbeddingTimeout = 30 * time.Second
+
 // OpenAIEmbeddingGenerator implements EmbeddingGenerator using OpenAI
 type OpenAIEmbeddingGenerator struct {
 	client *openai.Client
 	model  string
 }
 
-// NewOpenAIEmbeddingGenerator creates a new OpenAI embedding generator
+// NewOpenAIEmbeddingGenerator creates a new OpenAI embedding generator that
+// reuses keep-alive connections from a pooled HTTP client
 func NewOpenAIEmbeddingGenerator(apiKey, model string) *OpenAIEmbeddingGenerator {
+	config := openai.DefaultConfig(apiKey)
+	config.HTTPClient = NewPooledHTTPClient(DefaultMaxConnsPerHost)
+	return NewOpenAIEmbeddingGeneratorWithConfig(config, model)
+}
+
+// NewOpenAIEmbeddingGeneratorWithConfig creates an OpenAI embedding generator
+// from a client config, e.g. to target a compatible local endpoint
+func NewOpenAIEmbeddingGeneratorWithConfig(config openai.ClientConfig, model string) *OpenAIEmbeddingGenerator {
 	return &OpenAIEmbeddingGenerator{
-		client: openai.NewClient(apiKey),
+		client: openai.NewClientWithConfig(config),
 		model:  model,
 	}
 }
 
-// GenerateEmbedding creates an embedding vector for the given text
-func (g *OpenAIEmbeddingGenerator) GenerateEmbedding(text string) ([]float32, error) {
-	ctx, cancel := context.WithTimeout(context.Background(), 30*time.Second)
-	defer cancel()
+// GenerateEmbeddings creates embedding vectors for all texts in a single request
+func (g *OpenAIEmbeddingGenerator) GenerateEmbeddings(texts []string) ([][]float32, error) {
+	return g.GenerateEmbeddingsContext(context.Background(), texts)
+}
+
+// GenerateEmbeddingsContext creates embedding vectors for all texts in a
+// single request bounded by ctx
+func (g *OpenAIEmbeddingGenerator) GenerateEmbeddingsContext(ctx context.Context, texts []string) ([][]float32, error) {
+	if _, ok := ctx.Deadline(); !ok {
+		var cancel context.CancelFunc
+		ctx, cancel = context.WithTimeout(ctx, defaultEmbeddingTimeout)
+		defer cancel()
+	}
 
 	req := openai.EmbeddingRequest{
-		Input: []string{text},
+		Input: texts,
 		Model: openai.EmbeddingModel(g.model),
 	}
 
@@ -47,43 +104,144 @@ func (g *OpenAIEmbeddingGenerator) GenerateEmbedding(text string) ([]float32, er
 		return nil, fmt.Errorf("openai embedding request failed: %w", err)
 	}
 
-	if len(resp.Data) == 0 {
-		return nil, fmt.Errorf("no embedding data received")
+	if len(resp.Data) != len(texts) {
+		return nil, fmt.Errorf("expected %d embeddings, received %d", len(texts), len(resp.Data))
 	}
 
-	// Convert []float64 to []float32 for consistency
-	embedding64 := resp.Data[0].Embedding
-	embedding32 := make([]float32, len(embedding64))
-	for i, val := range embedding64 {
-		embedding32[i] = float32(val)
+	// Results carry their input position; do not rely on response order
+	embeddings := make([][]float32, len(texts))
+	for _, data := range resp.Data {
+		if data.Index < 0 || data.Index >= len(texts) {
+			return nil, fmt.Errorf("embedding index %d out of range", data.Index)
+		}
+		embedding32 := make([]float32, len(data.Embedding))
+		for i, val := range data.Embedding {
+			embedding32[i] = float32(val)
+		}
+		embeddings[data.Index] = embedding32
+	}
+	for i, embedding := range embeddings {
+		if embedding == nil {
+			return nil, fmt.Errorf("missing embedding for input %d", i)
+		}
 	}
 
-	return embedding32, nil
+	return embeddings, nil
+}
+
+// GenerateEmbedding creates an embedding vector for the given text
+func (g *OpenAIEmbeddingGenerator) GenerateEmbedding(text string) ([]float32, error) {
+	return g.GenerateEmbeddingContext(context.Background(), text)
+}
+
+// GenerateEmbeddingContext creates an embedding vector for the given text
+// within the deadline carried by ctx
+func (g *OpenAIEmbeddingGenerator) GenerateEmbeddingContext(ctx context.Context, text string) ([]float32, error) {
+	embeddings, err := g.GenerateEmbeddingsContext(ctx, []string{text})
+	if err != nil {
+		return nil, err
+	}
+	return embeddings[0], nil
 }
 
 // Handler manages API endpoints and dependencies
 type Handler struct {
-	verseIndex         *index.VerseIndex
+	verseIndex         atomic.Pointer[index.VerseIndex]
+	fragments          atomic.Pointer[verseFragments]
 	embeddingGenerator EmbeddingGenerator
+	resultCache        *SemanticResultCache
+	cursors            *CursorCache
+	corpora            *CorpusRegistry
+	defaultCorpus      string
+	shards             *ShardCoordinator
+	writable           atomic.Pointer[index.SegmentedIndex]
+	writeToken         string
+	inflight           flightGroup
+	queryTimeout       time.Duration
+	contextVerses      int
+	searchMode         string
+	embeddingBudget    time.Duration
+	vectorSearch       string
+	probeChapters      int
+	mmrLambda          float32
+	chapterPenalty     float32
 	logger             *log.Logger
 }
 
+// defaultQueryTimeout bounds embedding and search work for a single query
+const defaultQueryTimeout = 10 * time.Second
+
 // NewHandler creates a new API handler with dependencies
 func NewHandler(verseIndex *index.VerseIndex, openaiAPIKey, embeddingModel string, logger *log.Logger) *Handler {
-	return &Handler{
-		verseIndex:         verseIndex,
-		embeddingGenerator: NewOpenAIEmbeddingGenerator(openaiAPIKey, embeddingModel),
-		logger:             logger,
-	}
+	return NewHandlerWithGenerator(verseIndex, NewOpenAIEmbeddingGenerator(openaiAPIKey, embeddingModel), logger)
 }
 
 // NewHandlerWithGenerator creates a new API handler with custom embedding generator
 func NewHandlerWithGenerator(verseIndex *index.VerseIndex, generator EmbeddingGenerator, logger *log.Logger) *Handler {
-	return &Handler{
-		verseIndex:         verseIndex,
+	h := &Handler{
 		embeddingGenerator: generator,
+		queryTimeout:       defaultQueryTimeout,
+		contextVerses:      index.DefaultContextVerses,
+		searchMode:         SearchModeVector,
+		embeddingBudget:    defaultEmbeddingBudget,
+		vectorSearch:       VectorSearchFlat,
+		probeChapters:      index.DefaultProbeChapters,
+		mmrLambda:          index.DefaultMMRLambda,
+		chapterPenalty:     index.DefaultChapterPenalty,
 		logger:             logger,
 	}
+	h.verseIndex.Store(verseIndex)
+	h.fragments.Store(newVerseFragments(verseIndex))
+	return h
+}
+
+// SetResultCache enables reuse of results for near-duplicate query embeddings
+func (h *Handler) SetResultCache(cache *SemanticResultCache) {
+	h.resultCache = cache
+}
+
+// SetQueryTimeout sets the deadline budget for producing a query's results
+func (h *Handler) SetQueryTimeout(timeout time.Duration) {
+	if timeout > 0 {
+		h.queryTimeout = timeout
+	}
+}
+
+// SetContextVerses sets how many following verses are returned as context
+// when a request does not specify a window
+func (h *Handler) SetContextVerses(window int) {
+	if window >= 0 {
+		h.contextVerses = min(window, index.MaxContextVerses)
+	}
+}
+
+// contextWindow resolves a requested context window against the default
+func (h *Handler) contextWindow(requested *int) int {
+	if requested == nil || *requested < 0 {
+		return h.contextVerses
+	}
+	return min(*requested, index.MaxContextVerses)
+}
+
+// ReloadIndex swaps in a freshly loaded verse index and drops cached results;
+// registered corpora are unloaded and read again on their next use
+func (h *Handler) ReloadIndex(verseIndex *index.VerseIndex) {
+	h.fragments.Store(newVerseFragments(verseIndex))
+	h.verseIndex.Store(verseIndex)
+	h.invalidateResults()
+	if h.corpora != nil {
+		h.corpora.Invalidate()
+	}
+}
+
+// invalidateResults drops cached rankings and open cursors
+func (h *Handler) invalidateResults() {
+	if h.resultCache != nil {
+		h.resultCache.Invalidate()
+	}
+	if h.cursors != nil {
+		h.cursors.Invalidate()
+	}
 }
 
 // QueryRequest represents the incoming search query
@@ -94,13 +252,59 @@ type QueryRequest struct {
 	MaxDistanceComputations *int     `json:"max_distance_computations,omitempty"`
 	AccuracyThreshold       *float32 `json:"accuracy_threshold,omitempty"`
 	UseApproximateSearch    *bool    `json:"use_approximate_search,omitempty"`
+
+	// Embedding optionally supplies the query vector directly (base64,
+	// little-endian), in which case Query may be empty and no embedding
+	// call is made. EmbeddingFormat is "fp32" (default) or "fp16".
+	Embedding       string `json:"embedding,omitempty"`
+	EmbeddingFormat string `json:"embedding_format,omitempty"`
+
+	// ContextVerses sets how many following verses are returned in
+	// next_five (server default when omitted)
+	ContextVerses *int `json:"context_verses,omitempty"`
+
+	// Mode is "vector", "lexical" or "hybrid" (server default when omitted)
+	Mode string `json:"mode,omitempty"`
+
+	// PassageVerses searches windows of this many consecutive verses
+	// instead of single verses; the server must have built that size
+	PassageVerses int `json:"passage_verses,omitempty"`
+
+	// MMRLambda trades relevance against diversity for verse results, from
+	// 1 (relevance only) down to 0 (server default when omitted)
+	MMRLambda *float32 `json:"mmr_lambda,omitempty"`
+
+	// Facets asks for per-book and per-testament counts of every matching
+	// verse, gathered during a full vector scan
+	Facets bool `json:"facets,omitempty"`
+
+	// Paginate keeps the ranking beyond the first k results under a cursor
+	// returned as next_cursor; sending Cursor (with only k) fetches the next
+	// page from it without searching again
+	Paginate bool   `json:"paginate,omitempty"`
+	Cursor   string `json:"cursor,omitempty"`
+
+	// Examples makes a multi-vector query ("like these verses, not that
+	// one"), scored in one pass and combined by Combine: "sum" (default),
+	// "max" or "min"
+	Examples []QueryExample `json:"examples,omitempty"`
+	Combine  string         `json:"combine,omitempty"`
+
+	// Corpus names the translation or corpus to search (server default
+	// when omitted)
+	Corpus string `json:"corpus,omitempty"`
+
+	// fragments is the resolved corpus, whose index the request searches
+	fragments *verseFragments
 }
 
-// Query embedding helper (to avoid breaking existing API)
-func (qr *QueryRequest) QueryEmbedding() []float32 {
-	// Place holder: in your real code you should create embedding here or accept it from client.
-	// For now just return empty slice
-	return []float32{}
+// QueryEmbedding decodes the client-supplied embedding, or returns nil if
+// the request carries none
+func (qr *QueryRequest) QueryEmbedding() ([]float32, error) {
+	if qr.Embedding == "" {
+		return nil, nil
+	}
+	return DecodeEmbedding(qr.Embedding, qr.EmbeddingFormat)
 }
 
 // QueryResponse represents the search results
@@ -108,13 +312,24 @@ type QueryResponse struct {
 	Results []VerseResult `json:"results"`
 	Query   string        `json:"query"`
 	Count   int           `json:"count"`
+
+	// Facets counts the matching verses per book and testament, when the
+	// request asked for them and the vector search ran
+	Facets *index.Facets `json:"facets,omitempty"`
+
+	// NextCursor fetches the following page of a paginated query
+	NextCursor string `json:"next_cursor,omitempty"`
+
+	// Partial is set by a shard coordinator when some shards did not answer,
+	// so better matches held by them may be missing
+	Partial bool `json:"partial,omitempty"`
 }
 
 // VerseResult represents a single verse result with context
 type VerseResult struct {
 	Ref      string  `json:"ref"`
 	Text     string  `json:"text"`
-	NextFive string  `json:"next_five"`
+	NextFive string  `json:"next_five"` // text of the following verses in the same book
 	Score    float32 `json:"score"`
 }
 
@@ -137,12 +352,34 @@ func (h *Handler) HandleQuery(w http.ResponseWriter, r *http.Request) {
 		return
 	}
 
+	if req.Cursor != "" {
+		h.continueCursor(w, &req)
+		return
+	}
+
+	fragments, ok := h.resolveCorpus(w, req.Corpus)
+	if !ok {
+		return
+	}
+	req.fragments = fragments
+
 	// Validate query
-	if req.Query == "" {
+	if req.Query == "" && req.Embedding == "" && len(req.Examples) == 0 {
 		h.sendError(w, "Query cannot be empty", http.StatusBadRequest)
 		return
 	}
 
+	// A client-supplied embedding skips the embedding service entirely
+	suppliedEmbedding, err := req.QueryEmbedding()
+	if err != nil {
+		h.sendError(w, fmt.Sprintf("Invalid embedding: %v", err), http.StatusBadRequest)
+		return
+	}
+	if dim := req.fragments.verseIndex.Dimension(); suppliedEmbedding != nil && dim != 0 && len(suppliedEmbedding) != dim {
+		h.sendError(w, fmt.Sprintf("Embedding must have %d dimensions, got %d", dim, len(suppliedEmbedding)), http.StatusBadRequest)
+		return
+	}
+
 	// Set default k value
 	if req.K <= 0 {
 		req.K = 20
@@ -151,59 +388,477 @@ func (h *Handler) HandleQuery(w http.ResponseWriter, r *http.Request) {
 		req.K = 50
 	}
 
-	h.logger.Printf("📝 Query: '%s', k=%d", req.Query, req.K)
+	if h.shards != nil {
+		h.shardedQuery(w, r, &req, suppliedEmbedding)
+		return
+	}
 
-	// Generate embedding for query
-	h.logger.Println("🧠 Generating query embedding...")
-	queryEmbedding, err := h.embeddingGenerator.GenerateEmbedding(req.Query)
-	if err != nil {
-		h.logger.Printf("❌ Failed to generate embedding: %v", err)
-		h.sendError(w, "Failed to process query", http.StatusInternalServerError)
+	if len(req.Examples) > 0 {
+		h.multiQuery(w, r, &req, suppliedEmbedding)
 		return
 	}
 
-	embeddingTime := time.Since(startTime)
-	h.logger.Printf("✅ Generated embedding in %v", embeddingTime)
+	if req.PassageVerses != 0 && !slices.Contains(req.fragments.verseIndex.PassageWindows(), req.PassageVerses) {
+		h.sendError(w, fmt.Sprintf("Passages of %d verses are not available", req.PassageVerses), http.StatusBadRequest)
+		return
+	}
 
-	// Search for similar verses
-	h.logger.Println("🔎 Searching for similar verses...")
-	searchStart := time.Now()
-	results, err := h.verseIndex.Search(queryEmbedding, req.K)
+	if h.writableFor(req.fragments) != nil && (req.Facets || req.PassageVerses != 0) {
+		h.sendError(w, "Facets and passages are not available while the index takes writes", http.StatusConflict)
+		return
+	}
+
+	if req.MMRLambda != nil && (*req.MMRLambda < 0 || *req.MMRLambda > 1) {
+		h.sendError(w, "mmr_lambda must be between 0 and 1", http.StatusBadRequest)
+		return
+	}
+
+	mode, err := h.resolveSearchMode(&req)
 	if err != nil {
-		h.logger.Printf("❌ Search failed: %v", err)
-		h.sendError(w, "Search failed", http.StatusInternalServerError)
+		h.sendError(w, err.Error(), http.StatusBadRequest)
 		return
 	}
+	req.Mode = mode
 
-	searchTime := time.Since(searchStart)
-	h.logger.Printf("✅ Found %d results in %v", len(results), searchTime)
+	h.logger.Printf("📝 Query: '%s', k=%d, mode=%s", req.Query, req.K, req.Mode)
 
-	// Convert to response format
-	verseResults := make([]VerseResult, len(results))
-	for i, result := range results {
-		verseResults[i] = VerseResult{
-			Ref:      result.Verse.Ref,
-			Text:     result.Verse.Text,
-			NextFive: result.Verse.NextFive,
-			Score:    result.Score,
-		}
+	if req.Paginate {
+		h.paginatedQuery(w, r, &req, suppliedEmbedding)
+		return
 	}
 
-	response := QueryResponse{
-		Results: verseResults,
-		Query:   req.Query,
-		Count:   len(verseResults),
+	// Identical concurrent queries share a single embedding call and search
+	outcome, err, shared := h.inflight.Do(req.coalescingKey(), func() (queryOutcome, error) {
+		ctx, cancel := h.queryContext(r)
+		defer cancel()
+		return h.executeQuery(ctx, &req, suppliedEmbedding)
+	})
+	if err != nil {
+		h.sendQueryError(w, err)
+		return
 	}
+	if shared {
+		h.logger.Println("🤝 Shared result with identical in-flight queries")
+	}
+	embeddingTime, searchTime := outcome.embeddingTime, outcome.searchTime
 
 	totalTime := time.Since(startTime)
 	h.logger.Printf("🎯 Query completed in %v (embedding: %v, search: %v)", totalTime, embeddingTime, searchTime)
 
 	// Send JSON response
+	h.sendResults(w, req.fragments, req.Query, outcome.results, outcome.facets, h.contextWindow(req.ContextVerses))
+}
+
+// maxReferenceVerses bounds the verses returned for one reference lookup
+const maxReferenceVerses = 500
+
+// VersesResponse represents the verses covered by a reference lookup
+type VersesResponse struct {
+	Verses    []VerseText `json:"verses"`
+	Reference string      `json:"reference"`
+	Count     int         `json:"count"`
+}
+
+// VerseText is a verse without search context
+type VerseText struct {
+	ID   string `json:"id"`
+	Ref  string `json:"ref"`
+	Text string `json:"text"`
+}
+
+// HandleVerses looks up a verse, chapter or range by reference:
+// GET /verses?ref=ROM.8.28-39&corpus=kjv
+func (h *Handler) HandleVerses(w http.ResponseWriter, r *http.Request) {
+	if r.Method != http.MethodGet {
+		h.sendError(w, "Method not allowed", http.StatusMethodNotAllowed)
+		return
+	}
+	reference := r.URL.Query().Get("ref")
+	if reference == "" {
+		h.sendError(w, "Reference is required", http.StatusBadRequest)
+		return
+	}
+
+	// Fragments carry their own index, so rows and text always agree
+	fragments, ok := h.resolveCorpus(w, r.URL.Query().Get("corpus"))
+	if !ok {
+		return
+	}
+	start, end, err := fragments.verseIndex.LookupReference(reference)
+	if err != nil {
+		status := http.StatusBadRequest
+		if errors.Is(err, index.ErrUnknownReference) {
+			status = http.StatusNotFound
+		}
+		h.sendError(w, err.Error(), status)
+		return
+	}
+	if end-start > maxReferenceVerses {
+		h.sendError(w, fmt.Sprintf("Reference covers more than %d verses", maxReferenceVerses), http.StatusBadRequest)
+		return
+	}
+	if writable := h.writableFor(fragments); writable != nil {
+		h.sendCurrentVerses(w, writable, fragments.verseIndex.Verses[start:end], reference)
+		return
+	}
+	writeVersesResponse(w, fragments, reference, start, end)
+}
+
+// sendCurrentVerses answers a reference lookup with the current version of
+// each loaded verse it covers, leaving out deleted ones. Verses added since
+// the index was loaded have no place in its references.
+func (h *Handler) sendCurrentVerses(w http.ResponseWriter, writable *index.SegmentedIndex, loaded []index.Verse, reference string) {
+	response := VersesResponse{Verses: make([]VerseText, 0, len(loaded)), Reference: reference}
+	for i := range loaded {
+		if verse, ok := writable.GetByID(loaded[i].ID); ok {
+			response.Verses = append(response.Verses, VerseText{ID: verse.ID, Ref: verse.Ref, Text: verse.Text})
+		}
+	}
+	response.Count = len(response.Verses)
 	w.Header().Set("Content-Type", "application/json")
 	w.WriteHeader(http.StatusOK)
 	json.NewEncoder(w).Encode(response)
 }
 
+// maxSuggestions bounds the completions returned by /suggest
+const maxSuggestions = 20
+
+// SuggestResponse lists autocomplete candidates for a prefix
+type SuggestResponse struct {
+	Suggestions []index.Suggestion `json:"suggestions"`
+	Prefix      string             `json:"prefix"`
+	Count       int                `json:"count"`
+}
+
+// HandleSuggest completes book names, references and common phrases from a
+// prefix trie built at load, without an embedding call:
+// GET /suggest?q=rom&k=8
+func (h *Handler) HandleSuggest(w http.ResponseWriter, r *http.Request) {
+	if r.Method != http.MethodGet {
+		h.sendError(w, "Method not allowed", http.StatusMethodNotAllowed)
+		return
+	}
+	params := r.URL.Query()
+	prefix := params.Get("q")
+	if prefix == "" {
+		h.sendError(w, "Prefix is required", http.StatusBadRequest)
+		return
+	}
+	k := 8
+	if raw := params.Get("k"); raw != "" {
+		parsed, err := strconv.Atoi(raw)
+		if err != nil {
+			h.sendError(w, "k must be an integer", http.StatusBadRequest)
+			return
+		}
+		if parsed > 0 {
+			k = min(parsed, maxSuggestions)
+		}
+	}
+
+	fragments, ok := h.resolveCorpus(w, params.Get("corpus"))
+	if !ok {
+		return
+	}
+	var buf [maxSuggestions]index.Suggestion
+	suggestions := fragments.verseIndex.Suggest(buf[:0], prefix, k)
+	writeSuggestResponse(w, prefix, suggestions)
+}
+
+// HandleSimilar returns verses similar to a stored verse, using its
+// embedding as the query: GET /similar?id=GEN.1.1&k=20
+func (h *Handler) HandleSimilar(w http.ResponseWriter, r *http.Request) {
+	startTime := time.Now()
+
+	id, k, window, ok := h.parseVerseRequest(w, r)
+	if !ok {
+		return
+	}
+	fragments, ok := h.resolveCorpus(w, r.URL.Query().Get("corpus"))
+	if !ok {
+		return
+	}
+
+	// A writable index holds the verse as last written and every verse it
+	// may now be similar to
+	search := fragments.verseIndex.Search
+	verse, ok := fragments.verseIndex.GetByID(id)
+	if writable := h.writableFor(fragments); writable != nil {
+		var current index.Verse
+		current, ok = writable.GetByID(id)
+		search, verse = writable.Search, &current
+	}
+	if !ok {
+		h.sendError(w, fmt.Sprintf("Verse %s not found", id), http.StatusNotFound)
+		return
+	}
+
+	// One extra result leaves room to drop the verse itself
+	results, err := search(verse.Embedding, k+1)
+	if err != nil {
+		h.logger.Printf("❌ Search failed: %v", err)
+		h.sendError(w, "Search failed", http.StatusInternalServerError)
+		return
+	}
+	similar := make([]index.SearchResult, 0, k)
+	for _, result := range results {
+		if result.Verse.ID != verse.ID && len(similar) < k {
+			similar = append(similar, result)
+		}
+	}
+
+	h.logger.Printf("🎯 Similar verses for %s in %v", id, time.Since(startTime))
+	h.sendResults(w, fragments, id, similar, nil, window)
+}
+
+// HandleRelated serves a verse's precomputed related verses from the table
+// built offline into the index: GET /related?id=GEN.1.1&k=10
+func (h *Handler) HandleRelated(w http.ResponseWriter, r *http.Request) {
+	id, k, window, ok := h.parseVerseRequest(w, r)
+	if !ok {
+		return
+	}
+	fragments, ok := h.resolveCorpus(w, r.URL.Query().Get("corpus"))
+	if !ok {
+		return
+	}
+
+	verseIndex := fragments.verseIndex
+	if verseIndex.Related == nil {
+		h.sendError(w, "Related verses are not available for this index", http.StatusNotFound)
+		return
+	}
+	related, ok := verseIndex.RelatedTo(id, k)
+	if writable := h.writableFor(fragments); ok && writable != nil {
+		// The table was built from the loaded verses; verses written since
+		// keep what is left of it
+		_, ok = writable.GetByID(id)
+		related = h.currentVersions(fragments, related)
+	}
+	if !ok {
+		h.sendError(w, fmt.Sprintf("Verse %s not found", id), http.StatusNotFound)
+		return
+	}
+	h.sendResults(w, fragments, id, related, nil, window)
+}
+
+// parseVerseRequest validates a GET request naming a verse by id, with an
+// optional k defaulting to 20 and capped at 50, and an optional context
+// window
+func (h *Handler) parseVerseRequest(w http.ResponseWriter, r *http.Request) (id string, k, window int, ok bool) {
+	if r.Method != http.MethodGet {
+		h.sendError(w, "Method not allowed", http.StatusMethodNotAllowed)
+		return "", 0, 0, false
+	}
+
+	id = r.URL.Query().Get("id")
+	if id == "" {
+		h.sendError(w, "Verse id is required", http.StatusBadRequest)
+		return "", 0, 0, false
+	}
+	k = 20
+	if raw := r.URL.Query().Get("k"); raw != "" {
+		parsed, err := strconv.Atoi(raw)
+		if err != nil {
+			h.sendError(w, "k must be an integer", http.StatusBadRequest)
+			return "", 0, 0, false
+		}
+		if parsed > 0 {
+			k = parsed
+		}
+	}
+	if k > 50 {
+		k = 50
+	}
+	var requested *int
+	if raw := r.URL.Query().Get("context"); raw != "" {
+		parsed, err := strconv.Atoi(raw)
+		if err != nil {
+			h.sendError(w, "context must be an integer", http.StatusBadRequest)
+			return "", 0, 0, false
+		}
+		requested = &parsed
+	}
+	return id, k, h.contextWindow(requested), true
+}
+
+// sendResults sends search results as a JSON QueryResponse, assembled from
+// the pre-escaped fragments of the corpus searched
+func (h *Handler) sendResults(w http.ResponseWriter, fragments *verseFragments, query string, results []index.SearchResult, facets *index.Facets, window int) {
+	writeQueryResponse(w, fragments, query, results, facets, "", window)
+}
+
+// queryOutcome is the shareable result of executing a query
+type queryOutcome struct {
+	results       []index.SearchResult
+	facets        *index.Facets
+	embeddingTime time.Duration
+	searchTime    time.Duration
+}
+
+// queryError carries the client-facing message and status for a failed query
+type queryError struct {
+	message string
+	status  int
+	err     error
+}
+
+func (e *queryError) Error() string {
+	return fmt.Sprintf("%s: %v", e.message, e.err)
+}
+
+func (e *queryError) Unwrap() error {
+	return e.err
+}
+
+// coalescingKey identifies requests that produce identical results
+func (qr *QueryRequest) coalescingKey() string {
+	key := fmt.Sprintf("%s\x00k=%d", NormalizeQuery(qr.Query), qr.K)
+	if qr.Embedding != "" {
+		// The supplied vector, not the text, determines the results
+		key = fmt.Sprintf("%s:%s\x00k=%d", qr.EmbeddingFormat, qr.Embedding, qr.K)
+	}
+	if qr.Mode != "" {
+		key += ";mode=" + qr.Mode
+	}
+	if qr.PassageVerses != 0 {
+		key += fmt.Sprintf(";passage=%d", qr.PassageVerses)
+	}
+	if qr.SearchWidth != nil {
+		key += fmt.Sprintf(";ef=%d", *qr.SearchWidth)
+	}
+	if qr.MaxDistanceComputations != nil {
+		key += fmt.Sprintf(";maxdc=%d", *qr.MaxDistanceComputations)
+	}
+	if qr.AccuracyThreshold != nil {
+		key += fmt.Sprintf(";acc=%g", *qr.AccuracyThreshold)
+	}
+	if qr.UseApproximateSearch != nil {
+		key += fmt.Sprintf(";approx=%t", *qr.UseApproximateSearch)
+	}
+	if qr.MMRLambda != nil {
+		key += fmt.Sprintf(";mmr=%g", *qr.MMRLambda)
+	}
+	if qr.Facets {
+		key += ";facets"
+	}
+	if qr.Corpus != "" {
+		key += ";corpus=" + qr.Corpus
+	}
+	return key
+}
+
+// queryContext derives the context for a query's work: it keeps the request's
+// deadline (capped by the query timeout) but not its cancellation, since
+// coalesced followers must not fail because the leading client went away
+func (h *Handler) queryContext(r *http.Request) (context.Context, context.CancelFunc) {
+	deadline := time.Now().Add(h.queryTimeout)
+	if requestDeadline, ok := r.Context().Deadline(); ok && requestDeadline.Before(deadline) {
+		deadline = requestDeadline
+	}
+	return context.WithDeadline(context.WithoutCancel(r.Context()), deadline)
+}
+
+// executeQuery searches the index in the request's mode
+func (h *Handler) executeQuery(ctx context.Context, req *QueryRequest, queryEmbedding []float32) (queryOutcome, error) {
+	if req.PassageVerses > 0 {
+		return h.passageQuery(ctx, req, queryEmbedding)
+	}
+	switch req.Mode {
+	case SearchModeLexical:
+		return h.lexicalQuery(req), nil
+	case SearchModeHybrid:
+		return h.hybridQuery(ctx, req, queryEmbedding)
+	}
+	return h.vectorQuery(ctx, req, queryEmbedding)
+}
+
+// vectorQuery generates the query embedding, unless the client supplied
+// one, and searches the index, reusing results of a near-duplicate query
+// when cached
+func (h *Handler) vectorQuery(ctx context.Context, req *QueryRequest, queryEmbedding []float32) (queryOutcome, error) {
+	var outcome queryOutcome
+	var err error
+
+	queryEmbedding, outcome.embeddingTime, err = h.embedQuery(ctx, req, queryEmbedding)
+	if err != nil {
+		return outcome, err
+	}
+
+	searchStart := time.Now()
+	var cacheGeneration uint64
+	cached := false
+	// Cached results come from the default corpus, search strategy and diversity
+	useCache := h.resultCache != nil && req.fragments == h.fragments.Load() &&
+		req.UseApproximateSearch == nil && req.SearchWidth == nil && req.MMRLambda == nil && !req.Facets
+	if useCache {
+		cacheGeneration = h.resultCache.Generation()
+		outcome.results, cached = h.resultCache.Lookup(queryEmbedding, req.K)
+	}
+	if cached {
+		h.logger.Println("♻️ Reusing cached results for a near-duplicate query")
+	} else {
+		h.logger.Println("🔎 Searching for similar verses...")
+		if lambda := h.mmrLambdaFor(req); lambda < 1 {
+			outcome.results, outcome.facets, err = h.diversifiedSearch(req, queryEmbedding, lambda)
+		} else {
+			outcome.results, outcome.facets, err = h.searchVerses(req, queryEmbedding, req.K)
+		}
+		if err != nil {
+			h.logger.Printf("❌ Search failed: %v", err)
+			return outcome, &queryError{message: "Search failed", status: http.StatusInternalServerError, err: err}
+		}
+		if useCache {
+			h.resultCache.Store(cacheGeneration, queryEmbedding, req.K, outcome.results)
+		}
+	}
+	outcome.searchTime = time.Since(searchStart)
+	h.logger.Printf("✅ Found %d results in %v", len(outcome.results), outcome.searchTime)
+
+	return outcome, nil
+}
+
+// passageQuery ranks windows of consecutive verses by embedding similarity.
+// Passage results bypass the result cache, which holds single verses.
+func (h *Handler) passageQuery(ctx context.Context, req *QueryRequest, queryEmbedding []float32) (queryOutcome, error) {
+	var outcome queryOutcome
+	var err error
+
+	queryEmbedding, outcome.embeddingTime, err = h.embedQuery(ctx, req, queryEmbedding)
+	if err != nil {
+		return outcome, err
+	}
+
+	searchStart := time.Now()
+	outcome.results, err = req.fragments.verseIndex.SearchPassages(queryEmbedding, req.PassageVerses, req.K)
+	if err != nil {
+		h.logger.Printf("❌ Passage search failed: %v", err)
+		return outcome, &queryError{message: "Search failed", status: http.StatusInternalServerError, err: err}
+	}
+	outcome.searchTime = time.Since(searchStart)
+	h.logger.Printf("✅ Found %d %d-verse passages in %v", len(outcome.results), req.PassageVerses, outcome.searchTime)
+	return outcome, nil
+}
+
+// embedQuery generates the query embedding, unless the client supplied one
+func (h *Handler) embedQuery(ctx context.Context, req *QueryRequest, queryEmbedding []float32) ([]float32, time.Duration, error) {
+	if queryEmbedding != nil {
+		return queryEmbedding, 0, nil
+	}
+
+	// Generate embedding for query
+	h.logger.Println("🧠 Generating query embedding...")
+	embeddingStart := time.Now()
+	queryEmbedding, err := generateEmbedding(ctx, h.embeddingGenerator, req.Query)
+	if err != nil {
+		h.logger.Printf("❌ Failed to generate embedding: %v", err)
+		return nil, 0, &queryError{message: "Failed to process query", status: http.StatusInternalServerError, err: err}
+	}
+	embeddingTime := time.Since(embeddingStart)
+	h.logger.Printf("✅ Generated embedding in %v", embeddingTime)
+	return queryEmbedding, embeddingTime, nil
+}
+
 // sendError sends a JSON error response
 func (h *Handler) sendError(w http.ResponseWriter, message string, statusCode int) {
 	w.Header().Set("Content-Type", "application/json")
@@ -217,3 +872,13 @@ func (h *Handler) sendError(w http.ResponseWriter, message string, statusCode in
 
 	json.NewEncoder(w).Encode(errorResponse)
 }
+
+// sendQueryError reports a failed query with its client-facing status
+func (h *Handler) sendQueryError(w http.ResponseWriter, err error) {
+	var qerr *queryError
+	if errors.As(err, &qerr) {
+		h.sendError(w, qerr.message, qerr.status)
+	} else {
+		h.sendError(w, "Failed to process query", http.StatusInternalServerError)
+	}
+}
@@ -2,6 +2,7 @@ package api
 
 import (
 	"bytes"
+	"encoding/base64"
 	"encoding/json"
 	"fmt"
 	"log"
@@ -9,7 +10,10 @@ import (
 	"net/http/httptest"
 	"os"
 	"strings"
+	"sync"
+	"sync/atomic"
 	"testing"
+	"time"
 
 	"versejet/internal/index"
 )
@@ -289,6 +293,673 @@ func TestHandleQuery_EmbeddingFailure(t *testing.T) {
 	}
 }
 
+func TestHandleQuery_CoalescesIdenticalRequests(t *testing.T) {
+	handler := createMockHandler(false)
+
+	var calls atomic.Int64
+	release := make(chan struct{})
+	mockGen := handler.embeddingGenerator.(*MockEmbeddingGenerator)
+	mockGen.customEmbedding = func(text string) ([]float32, error) {
+		calls.Add(1)
+		<-release
+		return []float32{0.6, 0.7, 0.8, 0.9, 1.0}, nil
+	}
+
+	const concurrent = 20
+	body, _ := json.Marshal(QueryRequest{Query: "God so loved the world", K: 2})
+	codes := make(chan int, concurrent)
+	var wg sync.WaitGroup
+	for i := 0; i < concurrent; i++ {
+		wg.Add(1)
+		go func(i int) {
+			defer wg.Done()
+			// Vary case and spacing: all normalize to the same key.
+			query := body
+			if i%2 == 1 {
+				query, _ = json.Marshal(QueryRequest{Query: "  god so LOVED the world ", K: 2})
+			}
+			req := httptest.NewRequest(http.MethodPost, "/query", bytes.NewReader(query))
+			w := httptest.NewRecorder()
+			handler.HandleQuery(w, req)
+			codes <- w.Code
+		}(i)
+	}
+
+	key := (&QueryRequest{Query: "God so loved the world", K: 2}).coalescingKey()
+	deadline := time.Now().Add(5 * time.Second)
+	for handler.inflight.waiting(key) < concurrent-1 && time.Now().Before(deadline) {
+		time.Sleep(time.Millisecond)
+	}
+	close(release)
+	wg.Wait()
+	close(codes)
+
+	for code := range codes {
+		if code != http.StatusOK {
+			t.Errorf("Expected status 200, got %d", code)
+		}
+	}
+	if calls.Load() != 1 {
+		t.Errorf("Expected 1 embedding call for %d identical requests, got %d", concurrent, calls.Load())
+	}
+}
+
+func TestQueryRequest_CoalescingKey(t *testing.T) {
+	width := 64
+	base := QueryRequest{Query: "Jesus wept", K: 5}
+	sameQuery := QueryRequest{Query: " jesus   WEPT", K: 5}
+	otherK := QueryRequest{Query: "Jesus wept", K: 6}
+	otherFilter := QueryRequest{Query: "Jesus wept", K: 5, SearchWidth: &width}
+
+	if base.coalescingKey() != sameQuery.coalescingKey() {
+		t.Error("Expected normalized queries to share a key")
+	}
+	if base.coalescingKey() == otherK.coalescingKey() {
+		t.Error("Expected different k to produce a different key")
+	}
+	if base.coalescingKey() == otherFilter.coalescingKey() {
+		t.Error("Expected different search options to produce a different key")
+	}
+	otherMode := QueryRequest{Query: "Jesus wept", K: 5, Mode: SearchModeLexical}
+	if base.coalescingKey() == otherMode.coalescingKey() {
+		t.Error("Expected different search modes to produce a different key")
+	}
+}
+
+func TestHandleQuery_SuppliedEmbedding(t *testing.T) {
+	// A failing generator proves the embedding service is not called
+	handler := createMockHandler(true)
+
+	fp16 := []byte{}
+	for _, h := range []uint16{0x38cd, 0x399a, 0x3a66, 0x3b33, 0x3c00} { // 0.6 .. 1.0
+		fp16 = append(fp16, byte(h), byte(h>>8))
+	}
+	requests := []QueryRequest{
+		{Embedding: EncodeEmbedding([]float32{0.6, 0.7, 0.8, 0.9, 1.0}), K: 2},
+		{Embedding: base64.StdEncoding.EncodeToString(fp16), EmbeddingFormat: "fp16", K: 2},
+	}
+	for _, requestBody := range requests {
+		body, _ := json.Marshal(requestBody)
+		req := httptest.NewRequest(http.MethodPost, "/query", bytes.NewReader(body))
+		w := httptest.NewRecorder()
+		handler.HandleQuery(w, req)
+
+		if w.Code != http.StatusOK {
+			t.Fatalf("Expected status 200 for %s embedding, got %d: %s", requestBody.EmbeddingFormat, w.Code, w.Body.String())
+		}
+		var response QueryResponse
+		if err := json.NewDecoder(w.Body).Decode(&response); err != nil {
+			t.Fatalf("Failed to decode response: %v", err)
+		}
+		if len(response.Results) != 2 || response.Results[0].Ref != "John 3:16" {
+			t.Errorf("Expected John 3:16 first of 2 results, got %+v", response.Results)
+		}
+	}
+
+	invalid := []QueryRequest{
+		{Embedding: EncodeEmbedding([]float32{0.6, 0.7, 0.8})},
+		{Embedding: "not base64!"},
+		{Embedding: EncodeEmbedding([]float32{0.6, 0.7, 0.8, 0.9, 1.0}), EmbeddingFormat: "int8"},
+	}
+	for _, requestBody := range invalid {
+		body, _ := json.Marshal(requestBody)
+		req := httptest.NewRequest(http.MethodPost, "/query", bytes.NewReader(body))
+		w := httptest.NewRecorder()
+		handler.HandleQuery(w, req)
+		if w.Code != http.StatusBadRequest {
+			t.Errorf("Expected status 400 for %+v, got %d", requestBody, w.Code)
+		}
+	}
+}
+
+func TestHandleQuery_SearchModes(t *testing.T) {
+	handler := createMockHandler(false)
+	var stall atomic.Bool
+	release := make(chan struct{})
+	defer close(release)
+	mockGen := handler.embeddingGenerator.(*MockEmbeddingGenerator)
+	mockGen.customEmbedding = func(text string) ([]float32, error) {
+		if stall.Load() {
+			<-release
+		}
+		return []float32{0.6, 0.7, 0.8, 0.9, 1.0}, nil
+	}
+
+	query := func(req QueryRequest) (int, QueryResponse) {
+		body, _ := json.Marshal(req)
+		w := httptest.NewRecorder()
+		handler.HandleQuery(w, httptest.NewRequest(http.MethodPost, "/query", bytes.NewReader(body)))
+		var response QueryResponse
+		json.NewDecoder(w.Body).Decode(&response)
+		return w.Code, response
+	}
+
+	// Lexical mode never calls the embedding service
+	mockGen.shouldFail = true
+	code, response := query(QueryRequest{Query: "the LORD is my shepherd", K: 5, Mode: SearchModeLexical})
+	if code != http.StatusOK || len(response.Results) == 0 || response.Results[0].Ref != "Psalms 23:1" {
+		t.Errorf("Lexical: expected Psalms 23:1 first, got %d %+v", code, response.Results)
+	}
+
+	// Hybrid mode degrades to lexical results when the embedding fails
+	code, response = query(QueryRequest{Query: "the LORD is my shepherd", K: 5, Mode: SearchModeHybrid})
+	if code != http.StatusOK || len(response.Results) == 0 || response.Results[0].Ref != "Psalms 23:1" {
+		t.Errorf("Hybrid fallback: expected Psalms 23:1 first, got %d %+v", code, response.Results)
+	}
+
+	// ...and when it misses the embedding budget
+	mockGen.shouldFail = false
+	stall.Store(true)
+	handler.SetEmbeddingBudget(10 * time.Millisecond)
+	code, response = query(QueryRequest{Query: "created heaven", K: 5, Mode: SearchModeHybrid})
+	if code != http.StatusOK || len(response.Results) != 1 || response.Results[0].Ref != "Genesis 1:1" {
+		t.Errorf("Hybrid budget: expected only Genesis 1:1, got %d %+v", code, response.Results)
+	}
+
+	// With both rankings available, verses found by either are returned
+	stall.Store(false)
+	handler.SetEmbeddingBudget(5 * time.Second)
+	code, response = query(QueryRequest{Query: "God created the heaven", K: 3, Mode: SearchModeHybrid})
+	if code != http.StatusOK || len(response.Results) != 3 {
+		t.Errorf("Hybrid: expected 3 fused results, got %d %+v", code, response.Results)
+	}
+
+	if code, _ := query(QueryRequest{Query: "shepherd", Mode: "fuzzy"}); code != http.StatusBadRequest {
+		t.Errorf("Expected status 400 for an unknown mode, got %d", code)
+	}
+	embedding := EncodeEmbedding([]float32{0.6, 0.7, 0.8, 0.9, 1.0})
+	if code, _ := query(QueryRequest{Embedding: embedding, Mode: SearchModeLexical}); code != http.StatusBadRequest {
+		t.Errorf("Expected status 400 for lexical search without text, got %d", code)
+	}
+}
+
+func TestHandleChapters(t *testing.T) {
+	handler := createMockHandler(true)
+	embedding := EncodeEmbedding([]float32{0.6, 0.7, 0.8, 0.9, 1.0})
+
+	body, _ := json.Marshal(QueryRequest{Embedding: embedding, K: 2})
+	w := httptest.NewRecorder()
+	handler.HandleChapters(w, httptest.NewRequest(http.MethodPost, "/chapters", bytes.NewReader(body)))
+	if w.Code != http.StatusOK {
+		t.Fatalf("Expected status 200, got %d: %s", w.Code, w.Body.String())
+	}
+	var response SectionsResponse
+	if err := json.NewDecoder(w.Body).Decode(&response); err != nil {
+		t.Fatalf("Failed to decode response: %v", err)
+	}
+	if response.Count != 2 || response.Sections[0].ID != "JOH.3" || response.Sections[0].Ref != "John 3" {
+		t.Errorf("Expected John 3 first of 2 chapters, got %+v", response)
+	}
+
+	w = httptest.NewRecorder()
+	handler.HandleBooks(w, httptest.NewRequest(http.MethodPost, "/books", bytes.NewReader(body)))
+	if err := json.NewDecoder(w.Body).Decode(&response); err != nil || response.Sections[0].Ref != "John" {
+		t.Errorf("Expected John first, got %+v (%v)", response, err)
+	}
+
+	for _, requestBody := range []string{`{}`, `{"query": "shepherd"}`, `{"embedding": "AACAPw=="}`} {
+		w := httptest.NewRecorder()
+		handler.HandleChapters(w, httptest.NewRequest(http.MethodPost, "/chapters", strings.NewReader(requestBody)))
+		if w.Code == http.StatusOK {
+			t.Errorf("%s: expected an error status, got 200", requestBody)
+		}
+	}
+}
+
+func TestHandleQuery_ApproximateSearch(t *testing.T) {
+	handler := createMockHandler(true)
+	if err := handler.SetVectorSearch(VectorSearchHierarchical, 1); err != nil {
+		t.Fatalf("SetVectorSearch failed: %v", err)
+	}
+	embedding := EncodeEmbedding([]float32{0.6, 0.7, 0.8, 0.9, 1.0})
+
+	count := func(approximate bool) int {
+		body, _ := json.Marshal(QueryRequest{Embedding: embedding, K: 10, UseApproximateSearch: &approximate})
+		w := httptest.NewRecorder()
+		handler.HandleQuery(w, httptest.NewRequest(http.MethodPost, "/query", bytes.NewReader(body)))
+		var response QueryResponse
+		if err := json.NewDecoder(w.Body).Decode(&response); err != nil {
+			t.Fatalf("Failed to decode response: %v", err)
+		}
+		if response.Count == 0 || response.Results[0].Ref != "John 3:16" {
+			t.Errorf("Expected John 3:16 first, got %+v", response.Results)
+		}
+		return response.Count
+	}
+	// Each test verse is its own chapter: probing one finds one verse
+	if approximate, exact := count(true), count(false); approximate != 1 || exact != 3 {
+		t.Errorf("Expected 1 approximate and 3 exact results, got %d and %d", approximate, exact)
+	}
+
+	if err := handler.SetVectorSearch("ivf", 0); err == nil {
+		t.Error("Expected an error for an unknown strategy")
+	}
+}
+
+func TestHandleQuery_Diversity(t *testing.T) {
+	handler := createMockHandler(true)
+	embedding := EncodeEmbedding([]float32{0.6, 0.7, 0.8, 0.9, 1.0})
+
+	refs := func(lambda *float32) []string {
+		body, _ := json.Marshal(QueryRequest{Embedding: embedding, K: 2, MMRLambda: lambda})
+		w := httptest.NewRecorder()
+		handler.HandleQuery(w, httptest.NewRequest(http.MethodPost, "/query", bytes.NewReader(body)))
+		if w.Code != http.StatusOK {
+			t.Fatalf("Expected status 200, got %d: %s", w.Code, w.Body.String())
+		}
+		var response QueryResponse
+		if err := json.NewDecoder(w.Body).Decode(&response); err != nil {
+			t.Fatalf("Failed to decode response: %v", err)
+		}
+		var refs []string
+		for _, result := range response.Results {
+			refs = append(refs, result.Ref)
+		}
+		return refs
+	}
+
+	plain := refs(nil)
+	lambda := float32(0.5)
+	diverse := refs(&lambda)
+	if len(plain) != 2 || len(diverse) != 2 || plain[0] != "John 3:16" || diverse[0] != "John 3:16" {
+		t.Fatalf("Expected John 3:16 first, got %v and %v", plain, diverse)
+	}
+
+	if err := handler.SetDiversity(0.5, 0); err != nil {
+		t.Fatalf("SetDiversity failed: %v", err)
+	}
+	if defaults := refs(nil); fmt.Sprint(defaults) != fmt.Sprint(diverse) {
+		t.Errorf("Expected the server default to diversify like the request, got %v and %v", defaults, diverse)
+	}
+	if err := handler.SetDiversity(1.5, 0); err == nil {
+		t.Error("Expected an error for lambda outside [0, 1]")
+	}
+
+	w := httptest.NewRecorder()
+	handler.HandleQuery(w, httptest.NewRequest(http.MethodPost, "/query", strings.NewReader(`{"query": "love", "mmr_lambda": 2}`)))
+	if w.Code != http.StatusBadRequest {
+		t.Errorf("Expected status 400 for mmr_lambda 2, got %d", w.Code)
+	}
+}
+
+func TestHandleQuery_Facets(t *testing.T) {
+	handler := createMockHandler(true)
+	embedding := EncodeEmbedding([]float32{0.6, 0.7, 0.8, 0.9, 1.0})
+
+	body, _ := json.Marshal(QueryRequest{Embedding: embedding, K: 1, Facets: true})
+	w := httptest.NewRecorder()
+	handler.HandleQuery(w, httptest.NewRequest(http.MethodPost, "/query", bytes.NewReader(body)))
+	if w.Code != http.StatusOK {
+		t.Fatalf("Expected status 200, got %d: %s", w.Code, w.Body.String())
+	}
+	var response QueryResponse
+	if err := json.NewDecoder(w.Body).Decode(&response); err != nil {
+		t.Fatalf("Failed to decode response: %v", err)
+	}
+	if response.Count != 1 || response.Facets == nil {
+		t.Fatalf("Expected one result with facets, got %+v", response)
+	}
+	// Facets count all three matching verses, beyond k
+	books := response.Facets.Books
+	if len(books) != 3 || books[1].Name != "John" || books[1].Count != 1 || books[1].MaxScore < 0.999 {
+		t.Errorf("Expected Genesis, John and Psalms with John scoring 1, got %+v", books)
+	}
+	testaments := response.Facets.Testaments
+	if len(testaments) != 2 || testaments[0].Count != 2 || testaments[1].Count != 1 {
+		t.Errorf("Expected 2 Old and 1 New Testament matches, got %+v", testaments)
+	}
+
+	// Without the flag there are no facets
+	body, _ = json.Marshal(QueryRequest{Embedding: embedding, K: 1})
+	w = httptest.NewRecorder()
+	handler.HandleQuery(w, httptest.NewRequest(http.MethodPost, "/query", bytes.NewReader(body)))
+	if strings.Contains(w.Body.String(), `"facets"`) {
+		t.Errorf("Expected no facets, got %s", w.Body.String())
+	}
+}
+
+func TestHandleQuery_Pagination(t *testing.T) {
+	handler := createMockHandler(true)
+	embedding := EncodeEmbedding([]float32{0.6, 0.7, 0.8, 0.9, 1.0})
+
+	post := func(body string) (int, QueryResponse) {
+		w := httptest.NewRecorder()
+		handler.HandleQuery(w, httptest.NewRequest(http.MethodPost, "/query", strings.NewReader(body)))
+		var response QueryResponse
+		json.NewDecoder(w.Body).Decode(&response)
+		return w.Code, response
+	}
+
+	request := fmt.Sprintf(`{"embedding": %q, "k": 2, "paginate": true}`, embedding)
+	if code, _ := post(request); code != http.StatusBadRequest {
+		t.Errorf("Expected status 400 with pagination disabled, got %d", code)
+	}
+
+	handler.SetCursorCache(NewCursorCache(4, 0))
+	code, first := post(request)
+	if code != http.StatusOK || first.Count != 2 || first.Results[0].Ref != "John 3:16" || first.NextCursor == "" {
+		t.Fatalf("Expected a first page of 2 with a cursor, got %d %+v", code, first)
+	}
+
+	code, second := post(fmt.Sprintf(`{"cursor": %q, "k": 2}`, first.NextCursor))
+	if code != http.StatusOK || second.Count != 1 || second.NextCursor != "" {
+		t.Fatalf("Expected a last page of 1 without a cursor, got %d %+v", code, second)
+	}
+	if second.Results[0].Ref == first.Results[0].Ref || second.Results[0].Ref == first.Results[1].Ref {
+		t.Errorf("Expected the second page to continue the first, got %s", second.Results[0].Ref)
+	}
+	if second.Results[0].Score > first.Results[1].Score {
+		t.Errorf("Expected scores to keep falling across pages")
+	}
+
+	// An exhausted cursor is dropped
+	if code, _ := post(fmt.Sprintf(`{"cursor": %q}`, first.NextCursor)); code != http.StatusNotFound {
+		t.Errorf("Expected status 404 for an exhausted cursor, got %d", code)
+	}
+
+	// Reloading the index drops open cursors
+	_, open := post(fmt.Sprintf(`{"embedding": %q, "k": 1, "paginate": true}`, embedding))
+	handler.ReloadIndex(handler.verseIndex.Load())
+	if code, _ := post(fmt.Sprintf(`{"cursor": %q}`, open.NextCursor)); code != http.StatusNotFound {
+		t.Errorf("Expected status 404 after reload, got %d", code)
+	}
+}
+
+func TestHandleQuery_Examples(t *testing.T) {
+	handler := createMockHandler(true)
+
+	post := func(body string) (int, QueryResponse) {
+		w := httptest.NewRecorder()
+		handler.HandleQuery(w, httptest.NewRequest(http.MethodPost, "/query", strings.NewReader(body)))
+		var response QueryResponse
+		json.NewDecoder(w.Body).Decode(&response)
+		return w.Code, response
+	}
+
+	// Like John 3:16 but not Genesis 1:1: the examples themselves are left out
+	code, response := post(`{"examples": [{"ref": "John 3:16"}, {"ref": "GEN.1.1", "weight": -0.5}], "k": 5}`)
+	if code != http.StatusOK || response.Count != 1 || response.Results[0].Ref != "Psalms 23:1" {
+		t.Fatalf("Expected only Psalms 23:1, got %d %+v", code, response)
+	}
+	if score := response.Results[0].Score; score < 0.4 || score > 0.5 {
+		t.Errorf("Expected the negative example to lower the score to about 0.47, got %g", score)
+	}
+
+	// The request's own embedding joins the examples
+	embedding := EncodeEmbedding([]float32{0.6, 0.7, 0.8, 0.9, 1.0})
+	code, response = post(fmt.Sprintf(`{"embedding": %q, "examples": [{"ref": "PSA.23.1"}], "combine": "min", "k": 5}`, embedding))
+	if code != http.StatusOK || response.Count != 2 || response.Results[0].Ref == "Psalms 23:1" {
+		t.Errorf("Expected 2 results without the example verse, got %d %+v", code, response)
+	}
+
+	for _, body := range []string{
+		`{"examples": [{"ref": "John 3:16", "query": "love"}]}`,
+		`{"examples": [{}]}`,
+		`{"examples": [{"ref": "Nowhere 1:1"}]}`,
+		`{"examples": [{"ref": "John 3:16"}], "combine": "avg"}`,
+		`{"examples": [{"ref": "John 3:16", "weight": -1}]}`,
+		`{"examples": [{"embedding": "AACAPw=="}]}`,
+	} {
+		if code, _ := post(body); code != http.StatusBadRequest {
+			t.Errorf("%s: expected status 400, got %d", body, code)
+		}
+	}
+}
+
+func TestHandleQuery_Corpus(t *testing.T) {
+	handler := createMockHandler(true)
+	handler.SetCursorCache(NewCursorCache(4, 0))
+
+	// A second translation of the same verses
+	registry := NewCorpusRegistry(func(path string) (*index.VerseIndex, error) {
+		verseIndex := index.NewVerseIndex()
+		for _, verse := range handler.verseIndex.Load().Verses {
+			verse.Text = "[" + path + "] " + verse.Text
+			verseIndex.AddVerse(verse)
+		}
+		return verseIndex, nil
+	}, 0)
+	registry.Register("web", "web.gob")
+	handler.SetCorpusRegistry(registry, "kjv")
+
+	post := func(body string) (int, QueryResponse) {
+		w := httptest.NewRecorder()
+		handler.HandleQuery(w, httptest.NewRequest(http.MethodPost, "/query", strings.NewReader(body)))
+		var response QueryResponse
+		json.NewDecoder(w.Body).Decode(&response)
+		return w.Code, response
+	}
+
+	embedding := EncodeEmbedding([]float32{0.6, 0.7, 0.8, 0.9, 1.0})
+	for corpus, prefix := range map[string]string{"": "For God", "kjv": "For God", "web": "[web.gob] For God"} {
+		code, response := post(fmt.Sprintf(`{"embedding": %q, "corpus": %q, "k": 1}`, embedding, corpus))
+		if code != http.StatusOK || response.Count != 1 || !strings.HasPrefix(response.Results[0].Text, prefix) {
+			t.Errorf("corpus %q: expected text starting %q, got %d %+v", corpus, prefix, code, response)
+		}
+	}
+	if code, _ := post(fmt.Sprintf(`{"embedding": %q, "corpus": "asv"}`, embedding)); code != http.StatusNotFound {
+		t.Errorf("Expected status 404 for an unknown corpus, got %d", code)
+	}
+
+	// Later pages stay in the cursor's corpus
+	_, first := post(fmt.Sprintf(`{"embedding": %q, "corpus": "web", "paginate": true, "k": 1}`, embedding))
+	if first.NextCursor == "" {
+		t.Fatalf("Expected a cursor, got %+v", first)
+	}
+	_, second := post(fmt.Sprintf(`{"cursor": %q, "k": 1}`, first.NextCursor))
+	if second.Count != 1 || !strings.HasPrefix(second.Results[0].Text, "[web.gob]") {
+		t.Errorf("Expected the second page from the web corpus, got %+v", second)
+	}
+
+	w := httptest.NewRecorder()
+	handler.HandleVerses(w, httptest.NewRequest(http.MethodGet, "/verses?ref=GEN.1.1&corpus=web", nil))
+	if !strings.Contains(w.Body.String(), "[web.gob] In the beginning") {
+		t.Errorf("Expected the verse from the web corpus, got %s", w.Body.String())
+	}
+
+	w = httptest.NewRecorder()
+	handler.HandleCorpora(w, httptest.NewRequest(http.MethodGet, "/corpora", nil))
+	var corpora CorporaResponse
+	json.NewDecoder(w.Body).Decode(&corpora)
+	if corpora.Default != "kjv" || strings.Join(corpora.Corpora, ",") != "kjv,web" {
+		t.Errorf("Unexpected corpora %+v", corpora)
+	}
+}
+
+func TestHandleSimilar(t *testing.T) {
+	handler := createMockHandler(true)
+
+	req := httptest.NewRequest(http.MethodGet, "/similar?id=JOH.3.16&k=5", nil)
+	w := httptest.NewRecorder()
+	handler.HandleSimilar(w, req)
+
+	if w.Code != http.StatusOK {
+		t.Fatalf("Expected status 200, got %d: %s", w.Code, w.Body.String())
+	}
+	var response QueryResponse
+	if err := json.NewDecoder(w.Body).Decode(&response); err != nil {
+		t.Fatalf("Failed to decode response: %v", err)
+	}
+	if response.Count == 0 {
+		t.Fatal("Expected similar verses")
+	}
+	for _, result := range response.Results {
+		if result.Ref == "John 3:16" {
+			t.Error("Expected the query verse to be excluded")
+		}
+	}
+
+	for target, expected := range map[string]int{
+		"/similar?id=NON.1.1":     http.StatusNotFound,
+		"/similar":                http.StatusBadRequest,
+		"/similar?id=GEN.1.1&k=x": http.StatusBadRequest,
+	} {
+		w := httptest.NewRecorder()
+		handler.HandleSimilar(w, httptest.NewRequest(http.MethodGet, target, nil))
+		if w.Code != expected {
+			t.Errorf("%s: expected status %d, got %d", target, expected, w.Code)
+		}
+	}
+}
+
+func TestHandleQuery_ContextVerses(t *testing.T) {
+	verseIndex := index.NewVerseIndex()
+	verseIndex.AddVerse(index.Verse{ID: "GEN.1.1", Ref: "Genesis 1:1", Text: "In the beginning God created the heaven and the earth.", Embedding: []float32{0.1, 0.2, 0.3, 0.4, 0.5}})
+	verseIndex.AddVerse(index.Verse{ID: "GEN.1.2", Ref: "Genesis 1:2", Text: "And the earth was without form, and void;", Embedding: []float32{0.5, 0.4, 0.3, 0.2, 0.1}})
+	handler := NewHandlerWithGenerator(verseIndex, &MockEmbeddingGenerator{shouldFail: true}, log.New(os.Stdout, "[TEST] ", 0))
+	embedding := EncodeEmbedding([]float32{0.1, 0.2, 0.3, 0.4, 0.5})
+
+	for window, expected := range map[int]string{0: "", 1: "And the earth was without form, and void;"} {
+		body, _ := json.Marshal(QueryRequest{Embedding: embedding, K: 50, ContextVerses: &window})
+		w := httptest.NewRecorder()
+		handler.HandleQuery(w, httptest.NewRequest(http.MethodPost, "/query", bytes.NewReader(body)))
+
+		var response QueryResponse
+		if err := json.NewDecoder(w.Body).Decode(&response); err != nil {
+			t.Fatalf("Failed to decode response: %v", err)
+		}
+		found := false
+		for _, result := range response.Results {
+			if result.Ref == "Genesis 1:1" {
+				found = true
+				if result.NextFive != expected {
+					t.Errorf("Window %d: expected context %q, got %q", window, expected, result.NextFive)
+				}
+			}
+		}
+		if !found {
+			t.Errorf("Window %d: expected Genesis 1:1 in results", window)
+		}
+	}
+}
+
+func TestHandleQuery_PassageVerses(t *testing.T) {
+	verseIndex := index.NewVerseIndex()
+	for i, text := range []string{"In the beginning God created the heaven and the earth.", "And the earth was without form, and void;", "And God said, Let there be light: and there was light."} {
+		embedding := []float32{0.1, 0.1, 0.1, 0.1, 0.1}
+		embedding[i] = 1
+		verseIndex.AddVerse(index.Verse{ID: fmt.Sprintf("GEN.1.%d", i+1), Ref: fmt.Sprintf("Genesis 1:%d", i+1), Text: text, Embedding: embedding})
+	}
+	if err := verseIndex.BuildPassages([]int{2}, index.PoolMean); err != nil {
+		t.Fatalf("BuildPassages failed: %v", err)
+	}
+	handler := NewHandlerWithGenerator(verseIndex, &MockEmbeddingGenerator{shouldFail: true}, log.New(os.Stdout, "[TEST] ", 0))
+	embedding := EncodeEmbedding([]float32{1, 1, 0, 0, 0})
+
+	body, _ := json.Marshal(QueryRequest{Embedding: embedding, K: 1, PassageVerses: 2})
+	w := httptest.NewRecorder()
+	handler.HandleQuery(w, httptest.NewRequest(http.MethodPost, "/query", bytes.NewReader(body)))
+	if w.Code != http.StatusOK {
+		t.Fatalf("Expected status 200, got %d: %s", w.Code, w.Body.String())
+	}
+	var response QueryResponse
+	if err := json.NewDecoder(w.Body).Decode(&response); err != nil {
+		t.Fatalf("Failed to decode response: %v", err)
+	}
+	expected := VerseResult{
+		Ref:      "Genesis 1:1-2",
+		Text:     "In the beginning God created the heaven and the earth. And the earth was without form, and void;",
+		NextFive: "And God said, Let there be light: and there was light.",
+	}
+	if len(response.Results) != 1 || response.Results[0].Ref != expected.Ref || response.Results[0].Text != expected.Text || response.Results[0].NextFive != expected.NextFive {
+		t.Errorf("Expected %+v, got %+v", expected, response.Results)
+	}
+
+	body, _ = json.Marshal(QueryRequest{Embedding: embedding, PassageVerses: 3})
+	w = httptest.NewRecorder()
+	handler.HandleQuery(w, httptest.NewRequest(http.MethodPost, "/query", bytes.NewReader(body)))
+	if w.Code != http.StatusBadRequest {
+		t.Errorf("Expected status 400 for a passage size that was not built, got %d", w.Code)
+	}
+}
+
+func TestHandleVerses(t *testing.T) {
+	handler := createMockHandler(true)
+
+	w := httptest.NewRecorder()
+	handler.HandleVerses(w, httptest.NewRequest(http.MethodGet, "/verses?ref=John+3:16", nil))
+	if w.Code != http.StatusOK {
+		t.Fatalf("Expected status 200, got %d: %s", w.Code, w.Body.String())
+	}
+	var response VersesResponse
+	if err := json.NewDecoder(w.Body).Decode(&response); err != nil {
+		t.Fatalf("Failed to decode response: %v", err)
+	}
+	if response.Count != 1 || response.Verses[0].ID != "JOH.3.16" || response.Verses[0].Text == "" {
+		t.Errorf("Unexpected response %+v", response)
+	}
+
+	for target, expected := range map[string]int{
+		"/verses?ref=NON.1.1": http.StatusNotFound,
+		"/verses":             http.StatusBadRequest,
+	} {
+		w := httptest.NewRecorder()
+		handler.HandleVerses(w, httptest.NewRequest(http.MethodGet, target, nil))
+		if w.Code != expected {
+			t.Errorf("%s: expected status %d, got %d", target, expected, w.Code)
+		}
+	}
+}
+
+func TestHandleSuggest(t *testing.T) {
+	handler := createMockHandler(true)
+
+	w := httptest.NewRecorder()
+	handler.HandleSuggest(w, httptest.NewRequest(http.MethodGet, "/suggest?q=psa&k=2", nil))
+	if w.Code != http.StatusOK {
+		t.Fatalf("Expected status 200, got %d: %s", w.Code, w.Body.String())
+	}
+	var response SuggestResponse
+	if err := json.NewDecoder(w.Body).Decode(&response); err != nil {
+		t.Fatalf("Failed to decode response: %v", err)
+	}
+	if response.Count != 2 || response.Suggestions[0] != (index.Suggestion{Text: "Psalms", Kind: index.SuggestBook}) {
+		t.Errorf("Expected Psalms first of 2 suggestions, got %+v", response)
+	}
+	if response.Prefix != "psa" {
+		t.Errorf("Expected prefix psa, got %q", response.Prefix)
+	}
+
+	for target, expected := range map[string]int{
+		"/suggest":          http.StatusBadRequest,
+		"/suggest?q=g&k=x":  http.StatusBadRequest,
+		"/suggest?q=zzz":    http.StatusOK,
+		"/suggest?q=j&k=99": http.StatusOK,
+	} {
+		w := httptest.NewRecorder()
+		handler.HandleSuggest(w, httptest.NewRequest(http.MethodGet, target, nil))
+		if w.Code != expected {
+			t.Errorf("%s: expected status %d, got %d", target, expected, w.Code)
+		}
+	}
+}
+
+func TestHandleRelated(t *testing.T) {
+	handler := createMockHandler(true)
+
+	w := httptest.NewRecorder()
+	handler.HandleRelated(w, httptest.NewRequest(http.MethodGet, "/related?id=GEN.1.1", nil))
+	if w.Code != http.StatusNotFound {
+		t.Errorf("Expected status 404 without a related table, got %d", w.Code)
+	}
+
+	if err := handler.verseIndex.Load().BuildRelated(2, 1); err != nil {
+		t.Fatalf("BuildRelated failed: %v", err)
+	}
+	w = httptest.NewRecorder()
+	handler.HandleRelated(w, httptest.NewRequest(http.MethodGet, "/related?id=GEN.1.1&k=1", nil))
+	if w.Code != http.StatusOK {
+		t.Fatalf("Expected status 200, got %d: %s", w.Code, w.Body.String())
+	}
+	var response QueryResponse
+	if err := json.NewDecoder(w.Body).Decode(&response); err != nil {
+		t.Fatalf("Failed to decode response: %v", err)
+	}
+	if response.Count != 1 || response.Results[0].Ref != "Psalms 23:1" {
+		t.Errorf("Expected Psalms 23:1 as the closest verse, got %+v", response.Results)
+	}
+}
+
 func TestGenerateEmbedding_Success(t *testing.T) {
 	handler := createMockHandler(false)
 
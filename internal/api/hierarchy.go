@@ -0,0 +1,141 @@
+package api
+
+import (
+	"encoding/json"
+	"fmt"
+	"net/http"
+	"time"
+
+	"versejet/internal/index"
+)
+
+// Vector search strategies
+const (
+	VectorSearchFlat              = "flat"               // score every verse
+	VectorSearchHierarchical      = "hierarchical"       // score verses of the best-matching chapters only
+	VectorSearchHierarchicalExact = "hierarchical-exact" // visit chapters by bound until no better verse can remain
+)
+
+// SetVectorSearch sets how verses are scored against a query embedding and,
+// for hierarchical search, how many chapters are probed by default
+func (h *Handler) SetVectorSearch(strategy string, probeChapters int) error {
+	switch strategy {
+	case VectorSearchFlat, VectorSearchHierarchical, VectorSearchHierarchicalExact:
+	default:
+		return fmt.Errorf("unknown vector search strategy %q", strategy)
+	}
+	h.vectorSearch = strategy
+	if probeChapters > 0 {
+		h.probeChapters = probeChapters
+	}
+	return nil
+}
+
+// searchVerses runs the configured vector search for the k best verses. A
+// request may ask for approximate search (use_approximate_search, probing
+// search_width chapters) or turn it off to get exact results. Facets need
+// every verse scored, so a request for them always scans flat. A writable
+// index has no chapters to probe and is always searched exactly.
+func (h *Handler) searchVerses(req *QueryRequest, queryEmbedding []float32, k int) ([]index.SearchResult, *index.Facets, error) {
+	if writable := h.writableFor(req.fragments); writable != nil {
+		results, err := writable.Search(queryEmbedding, k)
+		return results, nil, err
+	}
+	verseIndex := req.fragments.verseIndex
+	if req.Facets {
+		return verseIndex.SearchWithFacets(queryEmbedding, k)
+	}
+	strategy := h.vectorSearch
+	if req.UseApproximateSearch != nil {
+		switch {
+		case *req.UseApproximateSearch:
+			strategy = VectorSearchHierarchical
+		case strategy == VectorSearchHierarchical:
+			strategy = VectorSearchHierarchicalExact
+		}
+	}
+	probeChapters := h.probeChapters
+	if req.SearchWidth != nil && *req.SearchWidth > 0 {
+		probeChapters = *req.SearchWidth
+	}
+
+	var results []index.SearchResult
+	var err error
+	switch strategy {
+	case VectorSearchHierarchical:
+		results, err = verseIndex.SearchHierarchical(queryEmbedding, k, probeChapters, false)
+	case VectorSearchHierarchicalExact:
+		results, err = verseIndex.SearchHierarchical(queryEmbedding, k, 0, true)
+	default:
+		results, err = verseIndex.Search(queryEmbedding, k)
+	}
+	return results, nil, err
+}
+
+// SectionsResponse lists chapters or books ranked against a query
+type SectionsResponse struct {
+	Sections []index.Section `json:"sections"`
+	Query    string          `json:"query"`
+	Count    int             `json:"count"`
+}
+
+// HandleChapters answers "which chapters are about X" by ranking chapter
+// centroids: POST /chapters with a query or embedding and k
+func (h *Handler) HandleChapters(w http.ResponseWriter, r *http.Request) {
+	h.handleSections(w, r, (*index.VerseIndex).TopChapters)
+}
+
+// HandleBooks ranks book centroids the same way: POST /books
+func (h *Handler) HandleBooks(w http.ResponseWriter, r *http.Request) {
+	h.handleSections(w, r, (*index.VerseIndex).TopBooks)
+}
+
+func (h *Handler) handleSections(w http.ResponseWriter, r *http.Request, rank func(*index.VerseIndex, []float32, int) ([]index.Section, error)) {
+	startTime := time.Now()
+	if r.Method != http.MethodPost {
+		h.sendError(w, "Method not allowed", http.StatusMethodNotAllowed)
+		return
+	}
+	var req QueryRequest
+	if err := json.NewDecoder(r.Body).Decode(&req); err != nil {
+		h.sendError(w, "Invalid JSON request", http.StatusBadRequest)
+		return
+	}
+	if req.Query == "" && req.Embedding == "" {
+		h.sendError(w, "Query cannot be empty", http.StatusBadRequest)
+		return
+	}
+	fragments, ok := h.resolveCorpus(w, req.Corpus)
+	if !ok {
+		return
+	}
+	suppliedEmbedding, err := req.QueryEmbedding()
+	if err != nil {
+		h.sendError(w, fmt.Sprintf("Invalid embedding: %v", err), http.StatusBadRequest)
+		return
+	}
+	if req.K <= 0 {
+		req.K = 10
+	}
+	if req.K > 50 {
+		req.K = 50
+	}
+
+	ctx, cancel := h.queryContext(r)
+	defer cancel()
+	queryEmbedding, _, err := h.embedQuery(ctx, &req, suppliedEmbedding)
+	if err != nil {
+		h.sendError(w, "Failed to process query", http.StatusInternalServerError)
+		return
+	}
+	sections, err := rank(fragments.verseIndex, queryEmbedding, req.K)
+	if err != nil {
+		h.sendError(w, fmt.Sprintf("Invalid embedding: %v", err), http.StatusBadRequest)
+		return
+	}
+
+	h.logger.Printf("🎯 Ranked %d sections in %v", len(sections), time.Since(startTime))
+	w.Header().Set("Content-Type", "application/json")
+	w.WriteHeader(http.StatusOK)
+	json.NewEncoder(w).Encode(SectionsResponse{Sections: sections, Query: req.Query, Count: len(sections)})
+}
@@ -0,0 +1,114 @@
+package api
+
+import (
+	"context"
+	"fmt"
+	"time"
+
+	"versejet/internal/index"
+)
+
+// Search modes for /query
+const (
+	SearchModeVector  = "vector"  // embedding similarity only
+	SearchModeLexical = "lexical" // BM25 over verse text only, no embedding call
+	SearchModeHybrid  = "hybrid"  // both, fused by reciprocal rank
+)
+
+// defaultEmbeddingBudget is how long a hybrid query waits for its embedding
+// before answering from the lexical ranking alone
+const defaultEmbeddingBudget = time.Second
+
+// SetSearchMode sets the mode used when a request does not name one
+func (h *Handler) SetSearchMode(mode string) error {
+	if !validSearchMode(mode) {
+		return fmt.Errorf("unknown search mode %q", mode)
+	}
+	h.searchMode = mode
+	return nil
+}
+
+// SetEmbeddingBudget sets how long hybrid queries wait for the embedding
+func (h *Handler) SetEmbeddingBudget(budget time.Duration) {
+	if budget > 0 {
+		h.embeddingBudget = budget
+	}
+}
+
+func validSearchMode(mode string) bool {
+	switch mode {
+	case SearchModeVector, SearchModeLexical, SearchModeHybrid:
+		return true
+	}
+	return false
+}
+
+// resolveSearchMode picks the mode for a request: lexical ranking needs query
+// text, and a request with only an embedding can only be searched by vector
+func (h *Handler) resolveSearchMode(req *QueryRequest) (string, error) {
+	mode := req.Mode
+	if mode == "" {
+		mode = h.searchMode
+	}
+	if !validSearchMode(mode) {
+		return "", fmt.Errorf("mode must be one of %s, %s or %s", SearchModeVector, SearchModeLexical, SearchModeHybrid)
+	}
+	if req.Query == "" {
+		if mode == SearchModeLexical {
+			return "", fmt.Errorf("lexical search needs query text")
+		}
+		mode = SearchModeVector
+	}
+	return mode, nil
+}
+
+// lexicalQuery ranks verses by BM25 alone
+func (h *Handler) lexicalQuery(req *QueryRequest) queryOutcome {
+	searchStart := time.Now()
+	results := h.currentVersions(req.fragments, req.fragments.verseIndex.LexicalSearch(req.Query, req.K))
+	h.logger.Printf("✅ Found %d lexical results in %v", len(results), time.Since(searchStart))
+	return queryOutcome{results: results, searchTime: time.Since(searchStart)}
+}
+
+// hybridQuery runs the lexical ranking while the embedding is generated and
+// fuses the two. If the embedding fails or misses the embedding budget, the
+// lexical ranking is served alone rather than failing the query.
+func (h *Handler) hybridQuery(ctx context.Context, req *QueryRequest, queryEmbedding []float32) (queryOutcome, error) {
+	type vectorOutcome struct {
+		outcome queryOutcome
+		err     error
+	}
+	vectorDone := make(chan vectorOutcome, 1)
+
+	// The budget bounds the whole wait, the lexical ranking included
+	budget := time.NewTimer(h.embeddingBudget)
+	defer budget.Stop()
+
+	// The embedding keeps the query deadline but outlives a missed budget,
+	// so the embedding cache is warm for the next identical query
+	deadline, _ := ctx.Deadline()
+	embedCtx, cancel := context.WithDeadline(context.WithoutCancel(ctx), deadline)
+	go func() {
+		defer cancel()
+		outcome, err := h.vectorQuery(embedCtx, req, queryEmbedding)
+		vectorDone <- vectorOutcome{outcome, err}
+	}()
+
+	lexical := h.lexicalQuery(req)
+	select {
+	case vector := <-vectorDone:
+		if vector.err != nil {
+			h.logger.Printf("⚠️ Vector search failed, serving lexical results: %v", vector.err)
+			return lexical, nil
+		}
+		fuseStart := time.Now()
+		outcome := vector.outcome
+		outcome.results = index.FuseRankings(req.K, vector.outcome.results, lexical.results)
+		outcome.searchTime += lexical.searchTime + time.Since(fuseStart)
+		return outcome, nil
+	case <-budget.C:
+		h.logger.Printf("⏱️ Embedding missed its %v budget, serving lexical results", h.embeddingBudget)
+		lexical.embeddingTime = h.embeddingBudget
+		return lexical, nil
+	}
+}
@@ -0,0 +1,114 @@
+package api
+
+import (
+	"fmt"
+	"net/http"
+	"time"
+
+	"versejet/internal/index"
+)
+
+// maxQueryExamples bounds the examples in one multi-vector query
+const maxQueryExamples = 16
+
+// QueryExample is one weighted example of a multi-vector query, given as
+// exactly one of a verse reference, query text or an embedding
+type QueryExample struct {
+	Ref       string   `json:"ref,omitempty"`
+	Query     string   `json:"query,omitempty"`
+	Embedding string   `json:"embedding,omitempty"` // base64, in the request's embedding_format
+	Weight    *float32 `json:"weight,omitempty"`    // 1 when omitted; negative to steer away
+}
+
+// multiQuery ranks verses against the request's examples, plus its own
+// query or embedding as an example of weight 1, in one scan. Verses named
+// as examples are left out of the results. Multi-vector queries rank by
+// embedding alone and are not coalesced or cached.
+func (h *Handler) multiQuery(w http.ResponseWriter, r *http.Request, req *QueryRequest, queryEmbedding []float32) {
+	if len(req.Examples) > maxQueryExamples {
+		h.sendError(w, fmt.Sprintf("At most %d examples are allowed", maxQueryExamples), http.StatusBadRequest)
+		return
+	}
+	ctx, cancel := h.queryContext(r)
+	defer cancel()
+	verseIndex := req.fragments.verseIndex
+
+	var queries []index.WeightedQuery
+	var embeddingTime time.Duration
+	if req.Query != "" || queryEmbedding != nil {
+		embedding, elapsed, err := h.embedQuery(ctx, req, queryEmbedding)
+		if err != nil {
+			h.sendQueryError(w, err)
+			return
+		}
+		embeddingTime += elapsed
+		queries = append(queries, index.WeightedQuery{Embedding: embedding, Weight: 1})
+	}
+
+	exclude := make(map[int]bool)
+	for i, example := range req.Examples {
+		weight := float32(1)
+		if example.Weight != nil {
+			weight = *example.Weight
+		}
+		var embedding []float32
+		switch {
+		case example.Ref != "" && example.Query == "" && example.Embedding == "":
+			start, end, err := verseIndex.LookupReference(example.Ref)
+			if err != nil || end-start != 1 {
+				h.sendError(w, fmt.Sprintf("Example %d: ref must name one verse", i+1), http.StatusBadRequest)
+				return
+			}
+			embedding = verseIndex.Verses[start].Embedding
+			if writable := h.writableFor(req.fragments); writable != nil {
+				verse, ok := writable.GetByID(verseIndex.Verses[start].ID)
+				if !ok {
+					h.sendError(w, fmt.Sprintf("Example %d: verse %s was deleted", i+1, example.Ref), http.StatusBadRequest)
+					return
+				}
+				embedding = verse.Embedding
+			}
+			exclude[start] = true
+		case example.Query != "" && example.Ref == "" && example.Embedding == "":
+			embeddingStart := time.Now()
+			var err error
+			if embedding, err = generateEmbedding(ctx, h.embeddingGenerator, example.Query); err != nil {
+				h.logger.Printf("❌ Failed to generate embedding: %v", err)
+				h.sendError(w, "Failed to process query", http.StatusInternalServerError)
+				return
+			}
+			embeddingTime += time.Since(embeddingStart)
+		case example.Embedding != "" && example.Ref == "" && example.Query == "":
+			var err error
+			if embedding, err = DecodeEmbedding(example.Embedding, req.EmbeddingFormat); err != nil {
+				h.sendError(w, fmt.Sprintf("Example %d: invalid embedding: %v", i+1, err), http.StatusBadRequest)
+				return
+			}
+		default:
+			h.sendError(w, fmt.Sprintf("Example %d must have exactly one of ref, query or embedding", i+1), http.StatusBadRequest)
+			return
+		}
+		if dim := verseIndex.Dimension(); len(embedding) != dim {
+			h.sendError(w, fmt.Sprintf("Example %d: embedding must have %d dimensions, got %d", i+1, dim, len(embedding)), http.StatusBadRequest)
+			return
+		}
+		queries = append(queries, index.WeightedQuery{Embedding: embedding, Weight: weight})
+	}
+
+	searchStart := time.Now()
+	results, err := verseIndex.SearchMulti(queries, req.Combine, req.K+len(exclude))
+	if err != nil {
+		h.sendError(w, fmt.Sprintf("Invalid multi-vector query: %v", err), http.StatusBadRequest)
+		return
+	}
+	kept := results[:0]
+	for _, result := range results {
+		if !exclude[result.Position] && len(kept) < req.K {
+			kept = append(kept, result)
+		}
+	}
+	// The scan ranks the loaded verses; drop and update the ones written since
+	kept = h.currentVersions(req.fragments, kept)
+	h.logger.Printf("✅ Found %d results for %d examples in %v (embedding: %v)", len(kept), len(queries), time.Since(searchStart), embeddingTime)
+	h.sendResults(w, req.fragments, req.Query, kept, nil, h.contextWindow(req.ContextVerses))
+}
@@ -0,0 +1,241 @@
+package api
+
+import (
+	"container/list"
+	"encoding/json"
+	"errors"
+	"fmt"
+	"net/http"
+	"sort"
+	"sync"
+
+	"versejet/internal/index"
+)
+
+// ErrUnknownCorpus is returned for a corpus name that is not registered
+var ErrUnknownCorpus = errors.New("unknown corpus")
+
+// CorpusLoader loads the verse index stored at path
+type CorpusLoader func(path string) (*index.VerseIndex, error)
+
+// CorpusRegistry serves several named verse indexes, such as translations,
+// from one process so they share the embedding generator, caches and the
+// stateless C search kernels. An index is loaded on first use; when the
+// loaded indexes exceed the memory budget the least recently used are
+// dropped and loaded again when next asked for.
+type CorpusRegistry struct {
+	load   CorpusLoader
+	budget int64 // bytes, 0 for no limit
+
+	mu         sync.Mutex
+	corpora    map[string]*corpusEntry
+	order      *list.List // loaded corpora, most recently used first
+	loaded     int64      // bytes held by loaded corpora
+	generation uint64     // bumped by Invalidate so stale loads are discarded
+}
+
+type corpusEntry struct {
+	name, path string
+	fragments  *verseFragments // nil until loaded
+	size       int64
+	element    *list.Element // in order while loaded
+	loading    chan struct{} // closed when an in-progress load finishes
+}
+
+// NewCorpusRegistry creates an empty registry; budget bounds the bytes of
+// loaded indexes, with 0 meaning no limit
+func NewCorpusRegistry(load CorpusLoader, budget int64) *CorpusRegistry {
+	return &CorpusRegistry{
+		load:    load,
+		budget:  max(budget, 0),
+		corpora: make(map[string]*corpusEntry),
+		order:   list.New(),
+	}
+}
+
+// Register adds a corpus stored at path without loading it
+func (c *CorpusRegistry) Register(name, path string) error {
+	if name == "" {
+		return fmt.Errorf("corpus name cannot be empty")
+	}
+	c.mu.Lock()
+	defer c.mu.Unlock()
+	if _, ok := c.corpora[name]; ok {
+		return fmt.Errorf("corpus %q is already registered", name)
+	}
+	c.corpora[name] = &corpusEntry{name: name, path: path}
+	return nil
+}
+
+// Names lists the registered corpora in name order
+func (c *CorpusRegistry) Names() []string {
+	c.mu.Lock()
+	defer c.mu.Unlock()
+	names := make([]string, 0, len(c.corpora))
+	for name := range c.corpora {
+		names = append(names, name)
+	}
+	sort.Strings(names)
+	return names
+}
+
+// Loaded reports whether a corpus is in memory
+func (c *CorpusRegistry) Loaded(name string) bool {
+	c.mu.Lock()
+	defer c.mu.Unlock()
+	entry, ok := c.corpora[name]
+	return ok && entry.fragments != nil
+}
+
+// LoadedBytes reports the estimated memory held by loaded corpora
+func (c *CorpusRegistry) LoadedBytes() int64 {
+	c.mu.Lock()
+	defer c.mu.Unlock()
+	return c.loaded
+}
+
+// Invalidate unloads every corpus, e.g. after the files are replaced; each
+// is read again on its next use
+func (c *CorpusRegistry) Invalidate() {
+	c.mu.Lock()
+	defer c.mu.Unlock()
+	for _, entry := range c.corpora {
+		entry.fragments = nil
+		entry.element = nil
+	}
+	c.order.Init()
+	c.loaded = 0
+	c.generation++
+}
+
+// get returns the fragments of a corpus, loading it if needed. Concurrent
+// first uses share one load; a failed load is not remembered, so the next
+// use tries again.
+func (c *CorpusRegistry) get(name string) (*verseFragments, error) {
+	c.mu.Lock()
+	entry, ok := c.corpora[name]
+	if !ok {
+		c.mu.Unlock()
+		return nil, fmt.Errorf("%w %q", ErrUnknownCorpus, name)
+	}
+	for entry.loading != nil {
+		wait := entry.loading
+		c.mu.Unlock()
+		<-wait
+		c.mu.Lock()
+	}
+	if entry.fragments != nil {
+		c.order.MoveToFront(entry.element)
+		fragments := entry.fragments
+		c.mu.Unlock()
+		return fragments, nil
+	}
+	done := make(chan struct{})
+	entry.loading = done
+	generation := c.generation
+	c.mu.Unlock()
+
+	var fragments *verseFragments
+	var size int64
+	verseIndex, err := c.load(entry.path)
+	if err == nil {
+		fragments = newVerseFragments(verseIndex)
+		size = verseIndex.MemoryFootprint() + int64(len(fragments.data)) + 8*int64(len(fragments.offsets))
+	}
+
+	c.mu.Lock()
+	defer c.mu.Unlock()
+	entry.loading = nil
+	close(done)
+	if err != nil {
+		return nil, fmt.Errorf("failed to load corpus %q: %w", name, err)
+	}
+	if generation == c.generation {
+		entry.fragments = fragments
+		entry.size = size
+		entry.element = c.order.PushFront(entry)
+		c.loaded += size
+		c.evict(entry)
+	}
+	return fragments, nil
+}
+
+// evict drops least recently used corpora other than keep until the loaded
+// ones fit the budget. Requests already holding a dropped index finish with
+// it; its memory is freed once they are done.
+func (c *CorpusRegistry) evict(keep *corpusEntry) {
+	for c.budget > 0 && c.loaded > c.budget {
+		oldest := c.order.Back()
+		entry := oldest.Value.(*corpusEntry)
+		if entry == keep {
+			return
+		}
+		c.order.Remove(oldest)
+		c.loaded -= entry.size
+		entry.fragments = nil
+		entry.element = nil
+	}
+}
+
+// SetCorpusRegistry serves the registry's corpora alongside the handler's own
+// index, which requests select by defaultName or by naming no corpus
+func (h *Handler) SetCorpusRegistry(registry *CorpusRegistry, defaultName string) {
+	h.corpora = registry
+	h.defaultCorpus = defaultName
+}
+
+// corpus resolves a corpus name to its fragments, which carry the index
+func (h *Handler) corpus(name string) (*verseFragments, error) {
+	if name == "" || name == h.defaultCorpus {
+		return h.fragments.Load(), nil
+	}
+	if h.corpora == nil {
+		return nil, fmt.Errorf("%w %q", ErrUnknownCorpus, name)
+	}
+	return h.corpora.get(name)
+}
+
+// resolveCorpus looks up a request's corpus, sending the error response
+// when it cannot be served
+func (h *Handler) resolveCorpus(w http.ResponseWriter, name string) (*verseFragments, bool) {
+	fragments, err := h.corpus(name)
+	switch {
+	case errors.Is(err, ErrUnknownCorpus):
+		h.sendError(w, fmt.Sprintf("Unknown corpus %q", name), http.StatusNotFound)
+		return nil, false
+	case err != nil:
+		h.logger.Printf("❌ %v", err)
+		h.sendError(w, "Corpus unavailable", http.StatusServiceUnavailable)
+		return nil, false
+	}
+	return fragments, true
+}
+
+// CorporaResponse lists the corpora a request may name
+type CorporaResponse struct {
+	Default string   `json:"default"`
+	Corpora []string `json:"corpora"`
+}
+
+// HandleCorpora lists the default corpus and every registered one:
+// GET /corpora
+func (h *Handler) HandleCorpora(w http.ResponseWriter, r *http.Request) {
+	if r.Method != http.MethodGet {
+		h.sendError(w, "Method not allowed", http.StatusMethodNotAllowed)
+		return
+	}
+	response := CorporaResponse{Default: h.defaultCorpus, Corpora: []string{}}
+	if h.defaultCorpus != "" {
+		response.Corpora = append(response.Corpora, h.defaultCorpus)
+	}
+	if h.corpora != nil {
+		for _, name := range h.corpora.Names() {
+			if name != h.defaultCorpus {
+				response.Corpora = append(response.Corpora, name)
+			}
+		}
+	}
+	w.Header().Set("Content-Type", "application/json")
+	w.WriteHeader(http.StatusOK)
+	json.NewEncoder(w).Encode(response)
+}
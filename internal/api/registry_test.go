@@ -0,0 +1,127 @@
+package api
+
+import (
+	"errors"
+	"fmt"
+	"sync"
+	"sync/atomic"
+	"testing"
+
+	"versejet/internal/index"
+)
+
+// countingLoader builds a small index per path and counts loads; paths
+// starting with "missing" fail
+func countingLoader(loads *atomic.Int32) CorpusLoader {
+	return func(path string) (*index.VerseIndex, error) {
+		loads.Add(1)
+		if len(path) >= 7 && path[:7] == "missing" {
+			return nil, fmt.Errorf("no such file %s", path)
+		}
+		verseIndex := index.NewVerseIndex()
+		for i := 0; i < 100; i++ {
+			verseIndex.AddVerse(index.Verse{
+				ID:        fmt.Sprintf("GEN.1.%d", i+1),
+				Ref:       fmt.Sprintf("Genesis 1:%d", i+1),
+				Text:      path,
+				Embedding: []float32{1, float32(i), 0, 0},
+			})
+		}
+		return verseIndex, nil
+	}
+}
+
+func TestCorpusRegistry_LoadsOnceOnFirstUse(t *testing.T) {
+	var loads atomic.Int32
+	registry := NewCorpusRegistry(countingLoader(&loads), 0)
+	if err := registry.Register("web", "web.gob"); err != nil {
+		t.Fatalf("Register failed: %v", err)
+	}
+	if err := registry.Register("web", "other.gob"); err == nil {
+		t.Error("Expected registering a name twice to fail")
+	}
+	if registry.Loaded("web") || loads.Load() != 0 {
+		t.Fatal("Expected registering not to load the corpus")
+	}
+
+	var wg sync.WaitGroup
+	fragments := make([]*verseFragments, 8)
+	for i := range fragments {
+		wg.Add(1)
+		go func(i int) {
+			defer wg.Done()
+			fragments[i], _ = registry.get("web")
+		}(i)
+	}
+	wg.Wait()
+	if loads.Load() != 1 {
+		t.Errorf("Expected concurrent first uses to share one load, got %d", loads.Load())
+	}
+	for _, f := range fragments {
+		if f == nil || f != fragments[0] || f.verseIndex.Verses[0].Text != "web.gob" {
+			t.Fatal("Expected every caller to get the loaded corpus")
+		}
+	}
+	if !registry.Loaded("web") || registry.LoadedBytes() <= 0 {
+		t.Error("Expected the corpus to be loaded and counted")
+	}
+
+	if _, err := registry.get("asv"); !errors.Is(err, ErrUnknownCorpus) {
+		t.Errorf("Expected ErrUnknownCorpus, got %v", err)
+	}
+
+	registry.Invalidate()
+	if registry.Loaded("web") || registry.LoadedBytes() != 0 {
+		t.Error("Expected Invalidate to unload every corpus")
+	}
+	registry.get("web")
+	if loads.Load() != 2 {
+		t.Errorf("Expected a reload after Invalidate, got %d loads", loads.Load())
+	}
+}
+
+func TestCorpusRegistry_EvictsLeastRecentlyUsedOverBudget(t *testing.T) {
+	var loads atomic.Int32
+	probe := NewCorpusRegistry(countingLoader(&loads), 0)
+	probe.Register("probe", "probe.gob")
+	probe.get("probe")
+	size := probe.LoadedBytes()
+
+	// Room for two corpora, not three
+	registry := NewCorpusRegistry(countingLoader(&loads), 2*size+size/2)
+	for _, name := range []string{"web", "asv", "ylt"} {
+		registry.Register(name, name+".gob")
+	}
+	registry.get("web")
+	registry.get("asv")
+	registry.get("web") // asv is now least recently used
+	registry.get("ylt")
+	if !registry.Loaded("web") || registry.Loaded("asv") || !registry.Loaded("ylt") {
+		t.Errorf("Expected asv to be evicted, loaded: web=%v asv=%v ylt=%v",
+			registry.Loaded("web"), registry.Loaded("asv"), registry.Loaded("ylt"))
+	}
+	if registry.LoadedBytes() > registry.budget {
+		t.Errorf("Expected %d loaded bytes to fit the %d byte budget", registry.LoadedBytes(), registry.budget)
+	}
+
+	// A corpus larger than the budget is still served
+	tiny := NewCorpusRegistry(countingLoader(&loads), 1)
+	tiny.Register("web", "web.gob")
+	if fragments, err := tiny.get("web"); err != nil || fragments == nil {
+		t.Errorf("Expected an oversized corpus to be served, got %v", err)
+	}
+}
+
+func TestCorpusRegistry_DoesNotRememberFailedLoads(t *testing.T) {
+	var loads atomic.Int32
+	registry := NewCorpusRegistry(countingLoader(&loads), 0)
+	registry.Register("broken", "missing.gob")
+	for i := 0; i < 2; i++ {
+		if _, err := registry.get("broken"); err == nil || errors.Is(err, ErrUnknownCorpus) {
+			t.Fatalf("Expected a load error, got %v", err)
+		}
+	}
+	if loads.Load() != 2 || registry.Loaded("broken") {
+		t.Errorf("Expected each use to retry the load, got %d loads", loads.Load())
+	}
+}
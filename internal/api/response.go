@@ -0,0 +1,306 @@
+package api
+
+import (
+	"encoding/json"
+	"math"
+	"net/http"
+	"strconv"
+	"sync"
+	"unicode/utf8"
+
+	"versejet/internal/index"
+)
+
+// verseFragments holds every verse's "ref" member and text already
+// JSON-escaped, so building a response is a sequence of appends instead of
+// reflection-based encoding. The "next_five" context is stitched together
+// from the escaped texts of the following verses.
+type verseFragments struct {
+	verseIndex *index.VerseIndex
+	data       []byte
+	offsets    []uint32 // verse i's escaped ref is data[offsets[i]:textStarts[i]]
+	textStarts []uint32 // and its escaped text (unquoted) runs to offsets[i+1]
+}
+
+func newVerseFragments(verseIndex *index.VerseIndex) *verseFragments {
+	f := &verseFragments{
+		verseIndex: verseIndex,
+		offsets:    make([]uint32, 1, len(verseIndex.Verses)+1),
+		textStarts: make([]uint32, len(verseIndex.Verses)),
+	}
+	for i := range verseIndex.Verses {
+		verse := &verseIndex.Verses[i]
+		f.data = appendJSONString(f.data, verse.Ref)
+		f.textStarts[i] = uint32(len(f.data))
+		f.data = appendJSONStringContent(f.data, verse.Text)
+		f.offsets = append(f.offsets, uint32(len(f.data)))
+	}
+	return f
+}
+
+// position returns the fragment row for a result, or -1 if the result came
+// from an index other than the one these fragments describe
+func (f *verseFragments) position(result *index.SearchResult) int {
+	verses := f.verseIndex.Verses
+	if p := result.Position; p >= 0 && p < len(verses) && verses[p].ID == result.Verse.ID {
+		return p
+	}
+	// A verse rewritten since the index was loaded is not the loaded row
+	if p, ok := f.verseIndex.Position(result.Verse.ID); ok && verses[p].Text == result.Verse.Text {
+		return p
+	}
+	return -1
+}
+
+// appendResult appends one VerseResult object with window verses of context
+func (f *verseFragments) appendResult(buf []byte, result *index.SearchResult, window int) []byte {
+	p := f.position(result)
+	if p < 0 {
+		buf = append(buf, `{"ref":`...)
+		buf = appendJSONString(buf, result.Verse.Ref)
+		buf = append(buf, `,"text":`...)
+		buf = appendJSONString(buf, result.Verse.Text)
+		buf = append(buf, `,"next_five":""`...)
+	} else {
+		// A passage result covers rows [p, last]; its context follows last
+		last := p
+		buf = append(buf, `{"ref":`...)
+		if result.End > p+1 && result.End <= len(f.verseIndex.Verses) {
+			last = result.End - 1
+			buf = appendJSONString(buf, f.verseIndex.SpanReference(p, result.End))
+		} else {
+			buf = append(buf, f.data[f.offsets[p]:f.textStarts[p]]...)
+		}
+		buf = append(buf, `,"text":"`...)
+		for row := p; row <= last; row++ {
+			if row > p {
+				buf = append(buf, ' ')
+			}
+			buf = append(buf, f.data[f.textStarts[row]:f.offsets[row+1]]...)
+		}
+		buf = append(buf, `","next_five":"`...)
+		start, end := f.verseIndex.ContextSpan(last, window)
+		for row := start; row < end; row++ {
+			if row > start {
+				buf = append(buf, ' ')
+			}
+			buf = append(buf, f.data[f.textStarts[row]:f.offsets[row+1]]...)
+		}
+		buf = append(buf, '"')
+	}
+	buf = append(buf, `,"score":`...)
+	buf = appendJSONFloat32(buf, result.Score)
+	return append(buf, '}')
+}
+
+// appendQueryResponse appends the JSON encoding of a QueryResponse, byte for
+// byte what json.Encoder produces
+func (f *verseFragments) appendQueryResponse(buf []byte, query string, results []index.SearchResult, facets *index.Facets, nextCursor string, window int) []byte {
+	buf = append(buf, `{"results":[`...)
+	for i := range results {
+		if i > 0 {
+			buf = append(buf, ',')
+		}
+		buf = f.appendResult(buf, &results[i], window)
+	}
+	buf = append(buf, `],"query":`...)
+	buf = appendJSONString(buf, query)
+	buf = append(buf, `,"count":`...)
+	buf = strconv.AppendInt(buf, int64(len(results)), 10)
+	if facets != nil {
+		buf = append(buf, `,"facets":{"books":`...)
+		buf = appendFacetList(buf, facets.Books)
+		buf = append(buf, `,"testaments":`...)
+		buf = appendFacetList(buf, facets.Testaments)
+		buf = append(buf, '}')
+	}
+	if nextCursor != "" {
+		buf = append(buf, `,"next_cursor":`...)
+		buf = appendJSONString(buf, nextCursor)
+	}
+	return append(buf, "}\n"...)
+}
+
+// appendFacetList appends a JSON array of facets
+func appendFacetList(buf []byte, facets []index.Facet) []byte {
+	if facets == nil {
+		return append(buf, "null"...)
+	}
+	buf = append(buf, '[')
+	for i := range facets {
+		if i > 0 {
+			buf = append(buf, ',')
+		}
+		buf = append(buf, `{"name":`...)
+		buf = appendJSONString(buf, facets[i].Name)
+		buf = append(buf, `,"count":`...)
+		buf = strconv.AppendInt(buf, int64(facets[i].Count), 10)
+		buf = append(buf, `,"max_score":`...)
+		buf = appendJSONFloat32(buf, facets[i].MaxScore)
+		buf = append(buf, '}')
+	}
+	return append(buf, ']')
+}
+
+// appendVersesResponse appends the JSON encoding of a VersesResponse for
+// the given rows of the fragments' index
+func (f *verseFragments) appendVersesResponse(buf []byte, reference string, start, end int) []byte {
+	buf = append(buf, `{"verses":[`...)
+	for row := start; row < end; row++ {
+		if row > start {
+			buf = append(buf, ',')
+		}
+		buf = append(buf, `{"id":`...)
+		buf = appendJSONString(buf, f.verseIndex.Verses[row].ID)
+		buf = append(buf, `,"ref":`...)
+		buf = append(buf, f.data[f.offsets[row]:f.textStarts[row]]...)
+		buf = append(buf, `,"text":"`...)
+		buf = append(buf, f.data[f.textStarts[row]:f.offsets[row+1]]...)
+		buf = append(buf, `"}`...)
+	}
+	buf = append(buf, `],"reference":`...)
+	buf = appendJSONString(buf, reference)
+	buf = append(buf, `,"count":`...)
+	buf = strconv.AppendInt(buf, int64(end-start), 10)
+	return append(buf, "}\n"...)
+}
+
+// appendSuggestResponse appends the JSON encoding of a SuggestResponse
+func appendSuggestResponse(buf []byte, prefix string, suggestions []index.Suggestion) []byte {
+	buf = append(buf, `{"suggestions":[`...)
+	for i := range suggestions {
+		if i > 0 {
+			buf = append(buf, ',')
+		}
+		buf = append(buf, `{"text":`...)
+		buf = appendJSONString(buf, suggestions[i].Text)
+		buf = append(buf, `,"kind":`...)
+		buf = appendJSONString(buf, suggestions[i].Kind)
+		buf = append(buf, '}')
+	}
+	buf = append(buf, `],"prefix":`...)
+	buf = appendJSONString(buf, prefix)
+	buf = append(buf, `,"count":`...)
+	buf = strconv.AppendInt(buf, int64(len(suggestions)), 10)
+	return append(buf, "}\n"...)
+}
+
+var responseBuffers = sync.Pool{
+	New: func() any {
+		buf := make([]byte, 0, 64<<10)
+		return &buf
+	},
+}
+
+// writeQueryResponse encodes results, and facets and a cursor if given, into
+// a pooled buffer and writes it
+func writeQueryResponse(w http.ResponseWriter, fragments *verseFragments, query string, results []index.SearchResult, facets *index.Facets, nextCursor string, window int) {
+	writePooled(w, func(buf []byte) []byte {
+		return fragments.appendQueryResponse(buf, query, results, facets, nextCursor, window)
+	})
+}
+
+// writeVersesResponse encodes rows [start, end) into a pooled buffer and writes it
+func writeVersesResponse(w http.ResponseWriter, fragments *verseFragments, reference string, start, end int) {
+	writePooled(w, func(buf []byte) []byte {
+		return fragments.appendVersesResponse(buf, reference, start, end)
+	})
+}
+
+// writeSuggestResponse encodes suggestions into a pooled buffer and writes it
+func writeSuggestResponse(w http.ResponseWriter, prefix string, suggestions []index.Suggestion) {
+	writePooled(w, func(buf []byte) []byte {
+		return appendSuggestResponse(buf, prefix, suggestions)
+	})
+}
+
+// writePooled builds a JSON body in a pooled buffer and writes it
+func writePooled(w http.ResponseWriter, build func([]byte) []byte) {
+	writePooledAs(w, "application/json", build)
+}
+
+// writePooledAs builds a body of the given content type in a pooled buffer
+// and writes it
+func writePooledAs(w http.ResponseWriter, contentType string, build func([]byte) []byte) {
+	bufPtr := responseBuffers.Get().(*[]byte)
+	buf := build((*bufPtr)[:0])
+
+	w.Header().Set("Content-Type", contentType)
+	w.WriteHeader(http.StatusOK)
+	w.Write(buf)
+
+	// Do not let one huge response pin its buffer in the pool
+	if cap(buf) <= 1<<20 {
+		*bufPtr = buf
+		responseBuffers.Put(bufPtr)
+	}
+}
+
+const hexDigits = "0123456789abcdef"
+
+// appendJSONString appends s as a JSON string with the same escaping as
+// encoding/json, including HTML-safe escapes
+func appendJSONString(buf []byte, s string) []byte {
+	buf = append(buf, '"')
+	buf = appendJSONStringContent(buf, s)
+	return append(buf, '"')
+}
+
+// appendJSONStringContent appends the escaped characters of s without quotes
+func appendJSONStringContent(buf []byte, s string) []byte {
+	start := 0
+	for i := 0; i < len(s); {
+		if c := s[i]; c < utf8.RuneSelf {
+			if c >= 0x20 && c != '"' && c != '\\' && c != '<' && c != '>' && c != '&' {
+				i++
+				continue
+			}
+			buf = append(buf, s[start:i]...)
+			switch c {
+			case '"', '\\':
+				buf = append(buf, '\\', c)
+			case '\n':
+				buf = append(buf, '\\', 'n')
+			case '\r':
+				buf = append(buf, '\\', 'r')
+			case '\t':
+				buf = append(buf, '\\', 't')
+			default:
+				buf = append(buf, '\\', 'u', '0', '0', hexDigits[c>>4], hexDigits[c&0xf])
+			}
+			i++
+			start = i
+			continue
+		}
+		r, size := utf8.DecodeRuneInString(s[i:])
+		if r == utf8.RuneError && size == 1 {
+			buf = append(buf, s[start:i]...)
+			buf = append(buf, `\ufffd`...)
+			i += size
+			start = i
+			continue
+		}
+		if r == '\u2028' || r == '\u2029' {
+			buf = append(buf, s[start:i]...)
+			buf = append(buf, '\\', 'u', '2', '0', '2', hexDigits[r&0xf])
+			i += size
+			start = i
+			continue
+		}
+		i += size
+	}
+	return append(buf, s[start:]...)
+}
+
+// appendJSONFloat32 formats f as encoding/json does for float32 values
+func appendJSONFloat32(buf []byte, f float32) []byte {
+	if abs := math.Abs(float64(f)); abs != 0 && (abs < 1e-6 || abs >= 1e21) || math.IsNaN(float64(f)) || math.IsInf(float64(f), 0) {
+		// Rare exponent forms: defer to the standard encoder
+		encoded, err := json.Marshal(f)
+		if err != nil {
+			return append(buf, '0')
+		}
+		return append(buf, encoded...)
+	}
+	return strconv.AppendFloat(buf, float64(f), 'f', -1, 32)
+}
@@ -0,0 +1,84 @@
+package api
+
+import (
+	"bytes"
+	"encoding/json"
+	"testing"
+
+	"versejet/internal/index"
+)
+
+func fragmentTestIndex() *index.VerseIndex {
+	verseIndex := index.NewVerseIndex()
+	verses := []index.Verse{
+		{ID: "JOH.11.35", Ref: "John 11:35", Text: "Jesus wept."},
+		{ID: "JOH.11.36", Ref: "John 11:36", Text: "Then said the Jews, Behold how he loved him!"},
+		{ID: "TST.1.1", Ref: "Test 1:1", Text: "He said, \"<b>&</b>\"\n\tC:\\path \x01"},
+		{ID: "TST.1.2", Ref: "Test 1:2", Text: "naïve — ünïcödé \u2028\u2029 \xff end"},
+		{ID: "TST.1.3", Ref: "", Text: ""},
+	}
+	for _, verse := range verses {
+		verseIndex.AddVerse(verse)
+	}
+	return verseIndex
+}
+
+func TestAppendQueryResponse_MatchesEncoder(t *testing.T) {
+	verseIndex := fragmentTestIndex()
+	fragments := newVerseFragments(verseIndex)
+
+	var results []index.SearchResult
+	for i, score := range []float32{0.91234567, 1, 0.5, 0.75, 0.6} {
+		results = append(results, index.SearchResult{Verse: &verseIndex.Verses[i], Score: score, Position: i})
+	}
+	// A stale position is resolved by ID; an unknown verse gets no context
+	results = append(results, index.SearchResult{Verse: &verseIndex.Verses[3], Score: 1e-7, Position: 0})
+	results = append(results, index.SearchResult{Verse: &index.Verse{ID: "OLD.1.1", Ref: "Old 1:1", Text: "gone"}, Score: 0.5, Position: 1})
+
+	for _, window := range []int{5, 1, 0} {
+		for _, subset := range [][]index.SearchResult{results, nil} {
+			query := "<love> & \"peace\""
+			verseResults := make([]VerseResult, len(subset))
+			for i, result := range subset {
+				context := ""
+				if p, ok := verseIndex.Position(result.Verse.ID); ok {
+					context = verseIndex.Context(p, window)
+				}
+				verseResults[i] = VerseResult{Ref: result.Verse.Ref, Text: result.Verse.Text, NextFive: context, Score: result.Score}
+			}
+			for _, facets := range []*index.Facets{nil, {}, {
+				Books:      []index.Facet{{Name: "John", Count: 2, MaxScore: 0.91234567}, {Name: "Test <1>", Count: 3, MaxScore: 0.5}},
+				Testaments: []index.Facet{},
+			}} {
+				nextCursor := ""
+				if facets != nil {
+					nextCursor = "0123abcd"
+				}
+				var expected bytes.Buffer
+				json.NewEncoder(&expected).Encode(QueryResponse{Results: verseResults, Query: query, Count: len(verseResults), Facets: facets, NextCursor: nextCursor})
+
+				got := fragments.appendQueryResponse(nil, query, subset, facets, nextCursor, window)
+				if !bytes.Equal(got, expected.Bytes()) {
+					t.Errorf("Encoding mismatch with window %d:\nexpected %s\ngot      %s", window, expected.Bytes(), got)
+				}
+			}
+		}
+	}
+}
+
+func TestAppendQueryResponse_NoAllocations(t *testing.T) {
+	verseIndex := fragmentTestIndex()
+	fragments := newVerseFragments(verseIndex)
+	results := []index.SearchResult{
+		{Verse: &verseIndex.Verses[0], Score: 0.9, Position: 0},
+		{Verse: &verseIndex.Verses[1], Score: 0.8, Position: 1},
+	}
+
+	buf := make([]byte, 0, 4096)
+	allocs := testing.AllocsPerRun(100, func() {
+		buf = fragments.appendQueryResponse(buf[:0], "Jesus wept", results, nil, "", 5)
+	})
+	if allocs != 0 {
+		t.Errorf("Expected no allocations, got %v", allocs)
+	}
+}
@@ -0,0 +1,175 @@
+package api
+
+import (
+	"math"
+	"slices"
+	"sync"
+	"sync/atomic"
+
+	"versejet/internal/index"
+)
+
+// SemanticResultCache reuses search results for queries whose embeddings are
+// near-duplicates of a recently answered query. Cached query embeddings are
+// kept unit-normalized in one flat matrix and matched by a linear scan, which
+// for a few thousand entries is far cheaper than a corpus search.
+type SemanticResultCache struct {
+	mu          sync.RWMutex
+	capacity    int
+	maxDistance float32
+
+	dim        int
+	vectors    []float32
+	entries    []resultCacheEntry
+	size       int
+	clock      atomic.Uint64
+	generation uint64
+}
+
+type resultCacheEntry struct {
+	k        int
+	results  []index.SearchResult
+	lastUsed atomic.Uint64
+}
+
+// NewSemanticResultCache creates a cache holding up to capacity result lists.
+// A cached list is reused when the cosine distance between query embeddings
+// is at most maxDistance.
+func NewSemanticResultCache(capacity int, maxDistance float32) *SemanticResultCache {
+	if capacity <= 0 {
+		capacity = 1
+	}
+	return &SemanticResultCache{
+		capacity:    capacity,
+		maxDistance: maxDistance,
+		entries:     make([]resultCacheEntry, capacity),
+	}
+}
+
+// Generation returns a token identifying the current cache contents. Pass it
+// to Store so results computed against a since-replaced index are dropped.
+func (c *SemanticResultCache) Generation() uint64 {
+	c.mu.RLock()
+	defer c.mu.RUnlock()
+	return c.generation
+}
+
+// Lookup returns a copy of the cached results for the closest stored query
+// within the configured distance that can satisfy k results.
+func (c *SemanticResultCache) Lookup(embedding []float32, k int) ([]index.SearchResult, bool) {
+	query := normalizedCopy(embedding)
+	if query == nil {
+		return nil, false
+	}
+
+	c.mu.RLock()
+	defer c.mu.RUnlock()
+	if c.size == 0 || len(query) != c.dim {
+		return nil, false
+	}
+
+	best := -1
+	bestSimilarity := 1 - c.maxDistance
+	for i := 0; i < c.size; i++ {
+		entry := &c.entries[i]
+		// A list computed for a smaller k only answers this query if the
+		// search ran out of matches before reaching its own k.
+		if entry.k < k && len(entry.results) >= entry.k {
+			continue
+		}
+		similarity := dot(query, c.vectors[i*c.dim:(i+1)*c.dim])
+		if similarity >= bestSimilarity {
+			best = i
+			bestSimilarity = similarity
+		}
+	}
+	if best < 0 {
+		return nil, false
+	}
+
+	entry := &c.entries[best]
+	entry.lastUsed.Store(c.clock.Add(1))
+	// Callers own what they get; the entry answers later lookups too
+	return slices.Clone(entry.results[:min(k, len(entry.results))]), true
+}
+
+// Store records a copy of results for a query embedding, replacing the least
+// recently used entry when full. Stores from an older generation are ignored.
+func (c *SemanticResultCache) Store(generation uint64, embedding []float32, k int, results []index.SearchResult) {
+	query := normalizedCopy(embedding)
+	if query == nil {
+		return
+	}
+
+	c.mu.Lock()
+	defer c.mu.Unlock()
+	if generation != c.generation {
+		return
+	}
+	if c.dim != len(query) {
+		// First entry, or the embedding model changed: start over.
+		c.dim = len(query)
+		c.vectors = make([]float32, c.capacity*c.dim)
+		c.size = 0
+	}
+
+	slot := c.size
+	if c.size < c.capacity {
+		c.size++
+	} else {
+		slot = 0
+		for i := 1; i < c.size; i++ {
+			if c.entries[i].lastUsed.Load() < c.entries[slot].lastUsed.Load() {
+				slot = i
+			}
+		}
+	}
+
+	copy(c.vectors[slot*c.dim:(slot+1)*c.dim], query)
+	entry := &c.entries[slot]
+	entry.k = k
+	entry.results = slices.Clone(results)
+	entry.lastUsed.Store(c.clock.Add(1))
+}
+
+// Invalidate drops every cached result, e.g. after the verse index is reloaded.
+func (c *SemanticResultCache) Invalidate() {
+	c.mu.Lock()
+	defer c.mu.Unlock()
+	for i := 0; i < c.size; i++ {
+		c.entries[i].results = nil
+	}
+	c.size = 0
+	c.generation++
+}
+
+// Len returns the number of cached result lists.
+func (c *SemanticResultCache) Len() int {
+	c.mu.RLock()
+	defer c.mu.RUnlock()
+	return c.size
+}
+
+func normalizedCopy(v []float32) []float32 {
+	var norm float32
+	for _, x := range v {
+		norm += x * x
+	}
+	if norm == 0 {
+		return nil
+	}
+	inv := 1 / float32(math.Sqrt(float64(norm)))
+	out := make([]float32, len(v))
+	for i, x := range v {
+		out[i] = x * inv
+	}
+	return out
+}
+
+func dot(a, b []float32) float32 {
+	var sum float32
+	for i := range a {
+		sum += a[i] * b[i]
+	}
+	return sum
+}
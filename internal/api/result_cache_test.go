@@ -0,0 +1,102 @@
+package api
+
+import (
+	"testing"
+
+	"versejet/internal/index"
+)
+
+func testResults(ids ...string) []index.SearchResult {
+	results := make([]index.SearchResult, len(ids))
+	for i, id := range ids {
+		results[i] = index.SearchResult{Verse: &index.Verse{ID: id}, Score: 1 - float32(i)/10}
+	}
+	return results
+}
+
+func TestSemanticResultCache_NearDuplicate(t *testing.T) {
+	cache := NewSemanticResultCache(8, 0.05)
+	cache.Store(cache.Generation(), []float32{1, 0, 0}, 3, testResults("A", "B", "C"))
+
+	// Cosine distance ~0.005 from the stored query.
+	results, ok := cache.Lookup([]float32{1, 0.1, 0}, 2)
+	if !ok {
+		t.Fatal("Expected near-duplicate query to hit the cache")
+	}
+	if len(results) != 2 || results[0].Verse.ID != "A" {
+		t.Errorf("Expected the first 2 cached results, got %v", results)
+	}
+
+	// Orthogonal query must miss.
+	if _, ok := cache.Lookup([]float32{0, 1, 0}, 2); ok {
+		t.Error("Expected distant query to miss the cache")
+	}
+
+	// A larger k than was cached cannot be answered from a full list.
+	if _, ok := cache.Lookup([]float32{1, 0, 0}, 5); ok {
+		t.Error("Expected lookup with larger k to miss the cache")
+	}
+}
+
+func TestSemanticResultCache_ExhaustedListAnswersLargerK(t *testing.T) {
+	cache := NewSemanticResultCache(8, 0.05)
+	// Only 2 matches existed for k=10, so the list is complete for any k.
+	cache.Store(cache.Generation(), []float32{0, 0, 1}, 10, testResults("A", "B"))
+
+	results, ok := cache.Lookup([]float32{0, 0, 1}, 20)
+	if !ok || len(results) != 2 {
+		t.Errorf("Expected complete cached list to be reused, got ok=%v results=%d", ok, len(results))
+	}
+}
+
+func TestSemanticResultCache_Invalidate(t *testing.T) {
+	cache := NewSemanticResultCache(8, 0.05)
+	staleGeneration := cache.Generation()
+	cache.Store(staleGeneration, []float32{1, 0, 0}, 3, testResults("A"))
+
+	cache.Invalidate()
+	if cache.Len() != 0 {
+		t.Errorf("Expected empty cache after invalidation, got %d entries", cache.Len())
+	}
+	if _, ok := cache.Lookup([]float32{1, 0, 0}, 3); ok {
+		t.Error("Expected lookup to miss after invalidation")
+	}
+
+	// Results computed before the reload must not be stored afterwards.
+	cache.Store(staleGeneration, []float32{1, 0, 0}, 3, testResults("A"))
+	if cache.Len() != 0 {
+		t.Error("Expected store from a stale generation to be ignored")
+	}
+}
+
+func TestSemanticResultCache_EvictsLeastRecentlyUsed(t *testing.T) {
+	cache := NewSemanticResultCache(2, 0.01)
+	gen := cache.Generation()
+	cache.Store(gen, []float32{1, 0, 0}, 1, testResults("X"))
+	cache.Store(gen, []float32{0, 1, 0}, 1, testResults("Y"))
+	cache.Lookup([]float32{1, 0, 0}, 1)
+	cache.Store(gen, []float32{0, 0, 1}, 1, testResults("Z"))
+
+	if _, ok := cache.Lookup([]float32{1, 0, 0}, 1); !ok {
+		t.Error("Expected recently used entry to survive eviction")
+	}
+	if _, ok := cache.Lookup([]float32{0, 1, 0}, 1); ok {
+		t.Error("Expected least recently used entry to be evicted")
+	}
+}
+
+func TestSemanticResultCache_CallersOwnResults(t *testing.T) {
+	cache := NewSemanticResultCache(8, 0.05)
+	stored := testResults("A", "B")
+	cache.Store(cache.Generation(), []float32{1, 0, 0}, 2, stored)
+	stored[0].Score = -1
+
+	first, _ := cache.Lookup([]float32{1, 0, 0}, 2)
+	first[1].Score = -1
+	copy(first[1:], testResults("C"))
+
+	second, ok := cache.Lookup([]float32{1, 0, 0}, 2)
+	if !ok || second[0].Score != 1 || second[1].Verse.ID != "B" || second[1].Score != 0.9 {
+		t.Errorf("Expected callers' changes not to reach the cache, got %v", second)
+	}
+}
@@ -0,0 +1,151 @@
+package api
+
+import (
+	"encoding/binary"
+	"fmt"
+	"io"
+	"math"
+	"net/http"
+
+	"versejet/internal/index"
+)
+
+// The shard protocol carries a vector query from a coordinator to a shard
+// and the shard's top results back, little-endian:
+//
+//	request:  "VJS1" | u32 k | u32 context window | u32 dim | dim × f32
+//	response: "VJS1" | u32 count | count × (f32 score | u32 n | n bytes)
+//
+// Each result's bytes are its JSON VerseResult object, rendered by the shard
+// from its own verses, so the coordinator merges by score and splices the
+// objects into its response without holding any verse data.
+const (
+	shardMagic       = "VJS1"
+	shardContentType = "application/x-versejet-shard"
+	shardSearchPath  = "/shard/search"
+
+	// maxShardDimension bounds the embedding a shard request may carry
+	maxShardDimension = 1 << 14
+
+	// maxShardResults matches the k limit of /query
+	maxShardResults = 50
+)
+
+// appendShardRequest encodes a shard query
+func appendShardRequest(buf []byte, k, window int, embedding []float32) []byte {
+	buf = append(buf, shardMagic...)
+	buf = binary.LittleEndian.AppendUint32(buf, uint32(k))
+	buf = binary.LittleEndian.AppendUint32(buf, uint32(window))
+	buf = binary.LittleEndian.AppendUint32(buf, uint32(len(embedding)))
+	for _, x := range embedding {
+		buf = binary.LittleEndian.AppendUint32(buf, math.Float32bits(x))
+	}
+	return buf
+}
+
+// decodeShardRequest decodes a shard query
+func decodeShardRequest(body []byte) (k, window int, embedding []float32, err error) {
+	const header = len(shardMagic) + 12
+	if len(body) < header || string(body[:len(shardMagic)]) != shardMagic {
+		return 0, 0, nil, fmt.Errorf("not a shard request")
+	}
+	k = int(binary.LittleEndian.Uint32(body[4:]))
+	window = int(binary.LittleEndian.Uint32(body[8:]))
+	dim := int(binary.LittleEndian.Uint32(body[12:]))
+	if dim == 0 || dim > maxShardDimension || len(body) != header+4*dim {
+		return 0, 0, nil, fmt.Errorf("embedding of %d dimensions does not match a %d byte request", dim, len(body))
+	}
+	embedding = make([]float32, dim)
+	for i := range embedding {
+		embedding[i] = math.Float32frombits(binary.LittleEndian.Uint32(body[header+4*i:]))
+	}
+	return k, window, embedding, nil
+}
+
+// shardHit is one result returned by a shard
+type shardHit struct {
+	score  float32
+	shard  int    // index of the shard that returned it
+	rank   int    // position in that shard's results
+	result []byte // JSON VerseResult object
+}
+
+// decodeShardResponse decodes a shard's results, which reference body
+func decodeShardResponse(body []byte, shard int) ([]shardHit, error) {
+	if len(body) < 8 || string(body[:len(shardMagic)]) != shardMagic {
+		return nil, fmt.Errorf("not a shard response")
+	}
+	count := int(binary.LittleEndian.Uint32(body[4:]))
+	if count > maxShardResults {
+		return nil, fmt.Errorf("shard returned %d results", count)
+	}
+	hits := make([]shardHit, count)
+	pos := 8
+	for i := range hits {
+		if len(body)-pos < 8 {
+			return nil, fmt.Errorf("shard response truncated at result %d", i)
+		}
+		score := math.Float32frombits(binary.LittleEndian.Uint32(body[pos:]))
+		n := int(binary.LittleEndian.Uint32(body[pos+4:]))
+		pos += 8
+		if n > len(body)-pos {
+			return nil, fmt.Errorf("shard response truncated at result %d", i)
+		}
+		hits[i] = shardHit{score: score, shard: shard, rank: i, result: body[pos : pos+n]}
+		pos += n
+	}
+	if pos != len(body) {
+		return nil, fmt.Errorf("shard response has %d trailing bytes", len(body)-pos)
+	}
+	return hits, nil
+}
+
+// HandleShardSearch answers a coordinator's vector query over this process's
+// verses with the shard protocol: POST /shard/search
+func (h *Handler) HandleShardSearch(w http.ResponseWriter, r *http.Request) {
+	if r.Method != http.MethodPost {
+		h.sendError(w, "Method not allowed", http.StatusMethodNotAllowed)
+		return
+	}
+	body, err := io.ReadAll(io.LimitReader(r.Body, int64(len(shardMagic)+12+4*maxShardDimension)))
+	if err != nil {
+		h.sendError(w, "Failed to read request", http.StatusBadRequest)
+		return
+	}
+	k, window, embedding, err := decodeShardRequest(body)
+	if err != nil {
+		h.sendError(w, fmt.Sprintf("Invalid shard request: %v", err), http.StatusBadRequest)
+		return
+	}
+	fragments := h.fragments.Load()
+	if dim := fragments.verseIndex.Dimension(); dim != 0 && len(embedding) != dim {
+		h.sendError(w, fmt.Sprintf("Embedding must have %d dimensions, got %d", dim, len(embedding)), http.StatusBadRequest)
+		return
+	}
+	k = max(1, min(k, maxShardResults))
+	window = min(window, index.MaxContextVerses)
+
+	// Shards rank by similarity alone, so the coordinator can merge by score
+	req := QueryRequest{K: k, fragments: fragments}
+	var results []index.SearchResult
+	if fragments.verseIndex.Dimension() != 0 {
+		if results, _, err = h.searchVerses(&req, embedding, k); err != nil {
+			h.logger.Printf("❌ Shard search failed: %v", err)
+			h.sendError(w, "Search failed", http.StatusInternalServerError)
+			return
+		}
+	}
+
+	writePooledAs(w, shardContentType, func(buf []byte) []byte {
+		buf = append(buf, shardMagic...)
+		buf = binary.LittleEndian.AppendUint32(buf, uint32(len(results)))
+		for i := range results {
+			buf = binary.LittleEndian.AppendUint32(buf, math.Float32bits(results[i].Score))
+			lengthAt := len(buf)
+			buf = append(buf, 0, 0, 0, 0)
+			buf = fragments.appendResult(buf, &results[i], window)
+			binary.LittleEndian.PutUint32(buf[lengthAt:], uint32(len(buf)-lengthAt-4))
+		}
+		return buf
+	})
+}
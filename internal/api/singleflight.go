@@ -0,0 +1,73 @@
+package api
+
+import (
+	"fmt"
+	"sync"
+)
+
+// flightGroup coalesces concurrent calls that share a key so only one of
+// them does the work; the others wait and receive the same result.
+type flightGroup struct {
+	mu    sync.Mutex
+	calls map[string]*flightCall
+}
+
+type flightCall struct {
+	wg      sync.WaitGroup
+	outcome queryOutcome
+	err     error
+	waiters int
+}
+
+// Do runs fn once per key among concurrent callers. shared reports whether
+// the result was handed to more than one caller.
+func (g *flightGroup) Do(key string, fn func() (queryOutcome, error)) (outcome queryOutcome, err error, shared bool) {
+	g.mu.Lock()
+	if g.calls == nil {
+		g.calls = make(map[string]*flightCall)
+	}
+	if call, ok := g.calls[key]; ok {
+		call.waiters++
+		g.mu.Unlock()
+		call.wg.Wait()
+		return call.outcome, call.err, true
+	}
+	call := &flightCall{}
+	call.wg.Add(1)
+	g.calls[key] = call
+	g.mu.Unlock()
+
+	func() {
+		// Release followers even if the leader panics.
+		defer func() {
+			if r := recover(); r != nil {
+				call.err = fmt.Errorf("coalesced call panicked: %v", r)
+				g.finish(key, call)
+				panic(r)
+			}
+		}()
+		call.outcome, call.err = fn()
+	}()
+
+	shared = g.finish(key, call)
+	return call.outcome, call.err, shared
+}
+
+func (g *flightGroup) finish(key string, call *flightCall) bool {
+	g.mu.Lock()
+	delete(g.calls, key)
+	shared := call.waiters > 0
+	g.mu.Unlock()
+	call.wg.Done()
+	return shared
+}
+
+// waiting returns how many followers are blocked on the in-flight call for key.
+func (g *flightGroup) waiting(key string) int {
+	g.mu.Lock()
+	defer g.mu.Unlock()
+	if call, ok := g.calls[key]; ok {
+		return call.waiters
+	}
+	return 0
+}
@@ -0,0 +1,179 @@
+package api
+
+import (
+	"crypto/subtle"
+	"encoding/json"
+	"errors"
+	"fmt"
+	"net/http"
+	"strings"
+
+	"versejet/internal/index"
+)
+
+// maxIndexWriteBytes bounds the body of one write; a verse and an encoded
+// embedding of the largest model fit well inside it
+const maxIndexWriteBytes = 64 << 10
+
+// maxVerseTextLength bounds the text of a written verse, which is sent to
+// the embeddings API unless an embedding comes with it
+const maxVerseTextLength = 4096
+
+// IndexWriteRequest adds a verse to the writable index, replacing any verse
+// with the same ID
+type IndexWriteRequest struct {
+	ID   string `json:"id"`
+	Ref  string `json:"ref"`
+	Text string `json:"text"`
+
+	// Embedding optionally supplies the verse vector, encoded as for
+	// QueryRequest; without it the text is embedded
+	Embedding       string `json:"embedding,omitempty"`
+	EmbeddingFormat string `json:"embedding_format,omitempty"`
+}
+
+// IndexWriteResponse acknowledges a write
+type IndexWriteResponse struct {
+	ID     string `json:"id"`
+	Status string `json:"status"` // "added" or "deleted"
+}
+
+// SetWritableIndex serves the default corpus from a segmented index that
+// takes writes through HandleIndexVerses. Vector searches, cursors and
+// /similar read it whatever search strategy is asked for; lexical,
+// multi-vector and /related results, ranked over the loaded verses, are
+// checked against it, and /verses serves current text. Facets and passages
+// are refused, since neither can be computed without the loaded rows. It
+// replaces and closes any writable index set before.
+func (h *Handler) SetWritableIndex(segmented *index.SegmentedIndex) {
+	if old := h.writable.Swap(segmented); old != nil {
+		old.Close()
+	}
+	h.invalidateResults()
+}
+
+// SetWriteToken sets the admin token writes must carry as a bearer token;
+// without one every write is refused
+func (h *Handler) SetWriteToken(token string) {
+	h.writeToken = token
+}
+
+// authorizedWrite reports whether a write request carries the admin token
+func (h *Handler) authorizedWrite(r *http.Request) bool {
+	token, ok := strings.CutPrefix(r.Header.Get("Authorization"), "Bearer ")
+	return ok && h.writeToken != "" && subtle.ConstantTimeCompare([]byte(token), []byte(h.writeToken)) == 1
+}
+
+// writableFor returns the writable index if fragments describe the default
+// corpus, or nil
+func (h *Handler) writableFor(fragments *verseFragments) *index.SegmentedIndex {
+	if fragments != h.fragments.Load() {
+		return nil
+	}
+	return h.writable.Load()
+}
+
+// currentVersions drops results deleted from the writable index and swaps
+// overwritten ones for their current version
+func (h *Handler) currentVersions(fragments *verseFragments, results []index.SearchResult) []index.SearchResult {
+	writable := h.writableFor(fragments)
+	if writable == nil {
+		return results
+	}
+	kept := results[:0]
+	for _, result := range results {
+		verse, ok := writable.GetByID(result.Verse.ID)
+		if !ok {
+			continue
+		}
+		if verse.Text != result.Verse.Text {
+			// The loaded row no longer describes the verse
+			result.Position = -1
+		}
+		result.Verse = &verse
+		kept = append(kept, result)
+	}
+	return kept
+}
+
+// HandleIndexVerses writes to the writable index: POST /index/verses with
+// an IndexWriteRequest adds or replaces a verse, and
+// DELETE /index/verses?id=GEN.1.1 removes one. Both need the admin token.
+func (h *Handler) HandleIndexVerses(w http.ResponseWriter, r *http.Request) {
+	writable := h.writable.Load()
+	if writable == nil {
+		h.sendError(w, "Writes are not enabled for this index", http.StatusNotFound)
+		return
+	}
+	if !h.authorizedWrite(r) {
+		w.Header().Set("WWW-Authenticate", "Bearer")
+		h.sendError(w, "Writes require the admin token", http.StatusUnauthorized)
+		return
+	}
+
+	var response IndexWriteResponse
+	switch r.Method {
+	case http.MethodPost:
+		var req IndexWriteRequest
+		r.Body = http.MaxBytesReader(w, r.Body, maxIndexWriteBytes)
+		if err := json.NewDecoder(r.Body).Decode(&req); err != nil {
+			var tooLarge *http.MaxBytesError
+			if errors.As(err, &tooLarge) {
+				h.sendError(w, fmt.Sprintf("Request body exceeds %d bytes", maxIndexWriteBytes), http.StatusRequestEntityTooLarge)
+				return
+			}
+			h.sendError(w, "Invalid JSON request", http.StatusBadRequest)
+			return
+		}
+		if req.ID == "" || req.Text == "" {
+			h.sendError(w, "Verse id and text are required", http.StatusBadRequest)
+			return
+		}
+		if len(req.Text) > maxVerseTextLength {
+			h.sendError(w, fmt.Sprintf("Verse text exceeds %d bytes", maxVerseTextLength), http.StatusBadRequest)
+			return
+		}
+		embedding, err := DecodeEmbedding(req.Embedding, req.EmbeddingFormat)
+		if err != nil {
+			h.sendError(w, fmt.Sprintf("Invalid embedding: %v", err), http.StatusBadRequest)
+			return
+		}
+		if embedding == nil {
+			ctx, cancel := h.queryContext(r)
+			embedding, err = generateEmbedding(ctx, h.embeddingGenerator, req.Text)
+			cancel()
+			if err != nil {
+				h.logger.Printf("❌ Failed to embed verse %s: %v", req.ID, err)
+				h.sendError(w, "Failed to generate embedding", http.StatusBadGateway)
+				return
+			}
+		}
+		verse := index.Verse{ID: req.ID, Ref: req.Ref, Text: req.Text, Embedding: embedding}
+		if err := writable.Add(verse); err != nil {
+			h.sendError(w, err.Error(), http.StatusBadRequest)
+			return
+		}
+		response = IndexWriteResponse{ID: req.ID, Status: "added"}
+	case http.MethodDelete:
+		id := r.URL.Query().Get("id")
+		if id == "" {
+			h.sendError(w, "Verse id is required", http.StatusBadRequest)
+			return
+		}
+		if !writable.Delete(id) {
+			h.sendError(w, fmt.Sprintf("Verse %s not found", id), http.StatusNotFound)
+			return
+		}
+		response = IndexWriteResponse{ID: id, Status: "deleted"}
+	default:
+		h.sendError(w, "Method not allowed", http.StatusMethodNotAllowed)
+		return
+	}
+
+	// Cached rankings may hold the verse as it was
+	h.invalidateResults()
+	h.logger.Printf("✏️ Verse %s %s", response.ID, response.Status)
+	w.Header().Set("Content-Type", "application/json")
+	w.WriteHeader(http.StatusOK)
+	json.NewEncoder(w).Encode(response)
+}
@@ -0,0 +1,269 @@
+package api
+
+import (
+	"encoding/json"
+	"fmt"
+	"math/rand"
+	"net/http"
+	"net/http/httptest"
+	"strings"
+	"testing"
+
+	"versejet/internal/hnsw"
+	"versejet/internal/index"
+)
+
+func TestHandleIndexVerses_WritesAreSearched(t *testing.T) {
+	const dim = 8
+	rng := rand.New(rand.NewSource(7))
+	base := shardTestIndex(rng, 2, 20, dim)
+	handler := newTestHandler(base)
+	handler.SetWriteToken("secret")
+
+	write := func(method, target, body string) int {
+		w := httptest.NewRecorder()
+		r := httptest.NewRequest(method, target, strings.NewReader(body))
+		r.Header.Set("Authorization", "Bearer secret")
+		handler.HandleIndexVerses(w, r)
+		return w.Code
+	}
+	query := func(embedding []float32) []VerseResult {
+		w := httptest.NewRecorder()
+		body := fmt.Sprintf(`{"embedding": %q, "k": 5, "mode": "vector"}`, EncodeEmbedding(embedding))
+		handler.HandleQuery(w, httptest.NewRequest(http.MethodPost, "/query", strings.NewReader(body)))
+		var response QueryResponse
+		json.NewDecoder(w.Body).Decode(&response)
+		return response.Results
+	}
+	randomEmbedding := func() []float32 {
+		embedding := make([]float32, dim)
+		for d := range embedding {
+			embedding[d] = float32(rng.NormFloat64())
+		}
+		return embedding
+	}
+
+	if code := write(http.MethodDelete, "/index/verses?id=B0.1.1", ""); code != http.StatusNotFound {
+		t.Errorf("Expected 404 without a writable index, got %d", code)
+	}
+
+	segmented := index.NewSegmentedIndex(4, 2, hnsw.Placement{})
+	if err := segmented.AddAll(base.Verses); err != nil {
+		t.Fatalf("AddAll failed: %v", err)
+	}
+	segmented.Compact()
+	handler.SetWritableIndex(segmented)
+	defer handler.SetWritableIndex(nil)
+
+	// A new verse is found at once, and reranking does not need it loaded
+	added := randomEmbedding()
+	body := fmt.Sprintf(`{"id": "NEW.1.1", "ref": "New 1:1", "text": "A new verse.", "embedding": %q}`, EncodeEmbedding(added))
+	if code := write(http.MethodPost, "/index/verses", body); code != http.StatusOK {
+		t.Fatalf("Expected the verse to be added, got %d", code)
+	}
+	if results := query(added); len(results) == 0 || results[0].Ref != "New 1:1" || results[0].Text != "A new verse." {
+		t.Errorf("Expected the added verse first, got %+v", results)
+	}
+
+	// An overwritten verse is served with its new text, not the loaded row's
+	replaced := randomEmbedding()
+	body = fmt.Sprintf(`{"id": "B0.1.1", "ref": "Book 0 1:1", "text": "Rewritten.", "embedding": %q}`, EncodeEmbedding(replaced))
+	if code := write(http.MethodPost, "/index/verses", body); code != http.StatusOK {
+		t.Fatalf("Expected the verse to be replaced, got %d", code)
+	}
+	if results := query(replaced); len(results) == 0 || results[0].Text != "Rewritten." {
+		t.Errorf("Expected the rewritten verse first, got %+v", results)
+	}
+
+	deleted := base.Verses[1]
+	if code := write(http.MethodDelete, "/index/verses?id="+deleted.ID, ""); code != http.StatusOK {
+		t.Fatalf("Expected the verse to be deleted, got %d", code)
+	}
+	for _, result := range query(deleted.Embedding) {
+		if result.Ref == deleted.Ref {
+			t.Errorf("Expected %s to be gone after its delete", deleted.ID)
+		}
+	}
+	if code := write(http.MethodDelete, "/index/verses?id="+deleted.ID, ""); code != http.StatusNotFound {
+		t.Errorf("Expected 404 deleting a deleted verse, got %d", code)
+	}
+
+	if code := write(http.MethodPost, "/index/verses", `{"id": "NEW.1.2"}`); code != http.StatusBadRequest {
+		t.Errorf("Expected 400 for a verse without text, got %d", code)
+	}
+	body = fmt.Sprintf(`{"id": "NEW.1.2", "text": "Too short.", "embedding": %q}`, EncodeEmbedding([]float32{1, 2}))
+	if code := write(http.MethodPost, "/index/verses", body); code != http.StatusBadRequest {
+		t.Errorf("Expected 400 for an embedding of another dimension, got %d", code)
+	}
+	if code := write(http.MethodGet, "/index/verses", ""); code != http.StatusMethodNotAllowed {
+		t.Errorf("Expected 405 for GET, got %d", code)
+	}
+}
+
+func TestHandleIndexVerses_RequiresTokenAndBoundsBody(t *testing.T) {
+	const dim = 8
+	rng := rand.New(rand.NewSource(7))
+	base := shardTestIndex(rng, 1, 5, dim)
+	handler := newTestHandler(base)
+	segmented := index.NewSegmentedIndex(4, 2, hnsw.Placement{})
+	if err := segmented.AddAll(base.Verses); err != nil {
+		t.Fatalf("AddAll failed: %v", err)
+	}
+	handler.SetWritableIndex(segmented)
+	defer handler.SetWritableIndex(nil)
+
+	write := func(authorization, body string) int {
+		w := httptest.NewRecorder()
+		r := httptest.NewRequest(http.MethodPost, "/index/verses", strings.NewReader(body))
+		if authorization != "" {
+			r.Header.Set("Authorization", authorization)
+		}
+		handler.HandleIndexVerses(w, r)
+		return w.Code
+	}
+	embedding := EncodeEmbedding(base.Verses[0].Embedding)
+	verse := func(text string) string {
+		return fmt.Sprintf(`{"id": "NEW.1.1", "text": %q, "embedding": %q}`, text, embedding)
+	}
+
+	// Without a token configured every write is refused
+	if code := write("Bearer ", verse("A new verse.")); code != http.StatusUnauthorized {
+		t.Errorf("Expected 401 without a configured token, got %d", code)
+	}
+
+	handler.SetWriteToken("secret")
+	for _, authorization := range []string{"", "secret", "Bearer wrong", "Basic secret"} {
+		if code := write(authorization, verse("A new verse.")); code != http.StatusUnauthorized {
+			t.Errorf("%q: expected 401, got %d", authorization, code)
+		}
+	}
+	if _, ok := segmented.GetByID("NEW.1.1"); ok {
+		t.Error("Expected unauthorized writes to be dropped")
+	}
+
+	if code := write("Bearer secret", verse(strings.Repeat("a", maxVerseTextLength+1))); code != http.StatusBadRequest {
+		t.Errorf("Expected 400 for text over the limit, got %d", code)
+	}
+	padded := fmt.Sprintf(`{"id": "NEW.1.1", "text": "A new verse.", "ref": %q, "embedding": %q}`, strings.Repeat("a", maxIndexWriteBytes), embedding)
+	if code := write("Bearer secret", padded); code != http.StatusRequestEntityTooLarge {
+		t.Errorf("Expected 413 for a body over the limit, got %d", code)
+	}
+	if code := write("Bearer secret", verse("A new verse.")); code != http.StatusOK {
+		t.Errorf("Expected the authorized write to succeed, got %d", code)
+	}
+}
+
+func TestHandleIndexVerses_EveryPathReadsWrites(t *testing.T) {
+	const dim = 8
+	rng := rand.New(rand.NewSource(11))
+	base := shardTestIndex(rng, 2, 20, dim)
+	if err := base.BuildRelated(40, 1); err != nil {
+		t.Fatalf("BuildRelated failed: %v", err)
+	}
+	handler := newTestHandler(base)
+	handler.SetCursorCache(NewCursorCache(4, 0))
+	segmented := index.NewSegmentedIndex(4, 2, hnsw.Placement{})
+	if err := segmented.AddAll(base.Verses); err != nil {
+		t.Fatalf("AddAll failed: %v", err)
+	}
+	segmented.Compact()
+	handler.SetWritableIndex(segmented)
+	defer handler.SetWritableIndex(nil)
+
+	// The added verse lies close to B0.1.1, so /similar can find it
+	added := make([]float32, dim)
+	for d := range added {
+		added[d] = base.Verses[0].Embedding[d] + 0.1*float32(rng.NormFloat64())
+	}
+	segmented.Add(index.Verse{ID: "NEW.1.1", Ref: "New 1:1", Text: "A new verse.", Embedding: added})
+	segmented.Add(index.Verse{ID: "B0.1.2", Ref: "Book 0 1:2", Text: "Rewritten.", Embedding: base.Verses[1].Embedding})
+	segmented.Delete("B0.1.3")
+
+	query := func(body string) (int, QueryResponse) {
+		w := httptest.NewRecorder()
+		handler.HandleQuery(w, httptest.NewRequest(http.MethodPost, "/query", strings.NewReader(body)))
+		var response QueryResponse
+		json.NewDecoder(w.Body).Decode(&response)
+		return w.Code, response
+	}
+	get := func(serve http.HandlerFunc, target string) (int, *httptest.ResponseRecorder) {
+		w := httptest.NewRecorder()
+		serve(w, httptest.NewRequest(http.MethodGet, target, nil))
+		return w.Code, w
+	}
+	embedding := EncodeEmbedding(added)
+
+	// Approximate search and cursors read the writes like flat search
+	for _, options := range []string{`"use_approximate_search": true`, `"paginate": true`, `"mmr_lambda": 0.5`} {
+		code, response := query(fmt.Sprintf(`{"embedding": %q, "k": 5, "mode": "vector", %s}`, embedding, options))
+		if code != http.StatusOK || len(response.Results) == 0 || response.Results[0].Ref != "New 1:1" {
+			t.Errorf("%s: expected the added verse first, got %d %+v", options, code, response.Results)
+		}
+	}
+	if code, _ := query(fmt.Sprintf(`{"embedding": %q, "facets": true}`, embedding)); code != http.StatusConflict {
+		t.Errorf("Expected 409 for facets, got %d", code)
+	}
+
+	// Multi-vector results are checked against the writes
+	code, response := query(fmt.Sprintf(`{"embedding": %q, "k": 50, "examples": [{"embedding": %q}]}`, EncodeEmbedding(base.Verses[2].Embedding), EncodeEmbedding(base.Verses[1].Embedding)))
+	if code != http.StatusOK {
+		t.Fatalf("Expected a multi-vector query to succeed, got %d", code)
+	}
+	for _, result := range response.Results {
+		if result.Ref == "Book 0 1:3" {
+			t.Error("Expected the deleted verse to be left out of multi-vector results")
+		}
+		if result.Ref == "Book 0 1:2" && result.Text != "Rewritten." {
+			t.Errorf("Expected the rewritten text, got %q", result.Text)
+		}
+	}
+
+	// /similar looks verses up and searches in the writable index
+	if code, w := get(handler.HandleSimilar, "/similar?id=NEW.1.1&k=5"); code != http.StatusOK {
+		t.Errorf("Expected /similar for an added verse, got %d: %s", code, w.Body)
+	}
+	if code, _ := get(handler.HandleSimilar, "/similar?id=B0.1.3"); code != http.StatusNotFound {
+		t.Errorf("Expected 404 for /similar of a deleted verse, got %d", code)
+	}
+	code, w := get(handler.HandleSimilar, "/similar?id=B0.1.1&k=50")
+	var similar QueryResponse
+	json.NewDecoder(w.Body).Decode(&similar)
+	found := false
+	for _, result := range similar.Results {
+		found = found || result.Ref == "New 1:1"
+		if result.Ref == "Book 0 1:3" {
+			t.Error("Expected the deleted verse to be left out of /similar")
+		}
+	}
+	if code != http.StatusOK || !found {
+		t.Errorf("Expected /similar to rank the added verse, got %d %+v", code, similar.Results)
+	}
+
+	// /verses serves current text and leaves deleted verses out
+	code, w = get(handler.HandleVerses, "/verses?ref=B0.1.1-4")
+	var verses VersesResponse
+	json.NewDecoder(w.Body).Decode(&verses)
+	if code != http.StatusOK || verses.Count != 3 || verses.Verses[1].Text != "Rewritten." || verses.Verses[2].ID != "B0.1.4" {
+		t.Errorf("Expected the current verses 1, 2 and 4, got %d %+v", code, verses)
+	}
+
+	// /related keeps what is left of the table built at load
+	if code, _ := get(handler.HandleRelated, "/related?id=B0.1.3"); code != http.StatusNotFound {
+		t.Errorf("Expected 404 for /related of a deleted verse, got %d", code)
+	}
+	code, w = get(handler.HandleRelated, "/related?id=B0.1.1&k=50")
+	var related QueryResponse
+	json.NewDecoder(w.Body).Decode(&related)
+	rewritten := false
+	for _, result := range related.Results {
+		if result.Ref == "Book 0 1:3" {
+			t.Error("Expected the deleted verse to be left out of /related")
+		}
+		if result.Ref == "Book 0 1:2" {
+			rewritten = result.Text == "Rewritten."
+		}
+	}
+	if code != http.StatusOK || !rewritten {
+		t.Errorf("Expected /related to serve the rewritten verse, got %d %+v", code, related.Results)
+	}
+}
@@ -0,0 +1,44 @@
+package hnsw
+
+/*
+#cgo CFLAGS: -I${SRCDIR}/csrc
+#cgo LDFLAGS: -L${SRCDIR}/csrc -lvector_search -lm
+#include "vector_search.h"
+*/
+import "C"
+
+import (
+	"errors"
+	"unsafe"
+)
+
+// AllPairsTopN finds, for rows [rowStart, rowEnd) of a row-major matrix of
+// unit vectors, the topN most similar other rows using the blocked C kernel.
+// ids and scores receive topN entries per row, best first; unused entries
+// have id -1. Disjoint row ranges may be computed concurrently.
+func AllPairsTopN(matrix []float32, count, dim, rowStart, rowEnd, topN int, ids []int32, scores []float32) error {
+	if count <= 0 || dim <= 0 || len(matrix) < count*dim {
+		return errors.New("matrix is smaller than count x dim")
+	}
+	if rowStart < 0 || rowEnd > count || rowStart >= rowEnd || topN <= 0 {
+		return errors.New("invalid row range or top-n")
+	}
+	if need := (rowEnd - rowStart) * topN; len(ids) < need || len(scores) < need {
+		return errors.New("output slices too small")
+	}
+
+	ok := C.all_pairs_top_n(
+		(*C.float)(unsafe.Pointer(&matrix[0])),
+		C.int(count),
+		C.int(dim),
+		C.int(rowStart),
+		C.int(rowEnd),
+		C.int(topN),
+		(*C.int)(unsafe.Pointer(&ids[0])),
+		(*C.float)(unsafe.Pointer(&scores[0])),
+	)
+	if ok == 0 {
+		return errors.New("all-pairs kernel failed")
+	}
+	return nil
+}
@@ -2,7 +2,7 @@ package hnsw
 
 /*
 #cgo CFLAGS: -I${SRCDIR}/csrc
-#cgo LDFLAGS: -L${SRCDIR}/csrc -lvector_search
+#cgo LDFLAGS: -L${SRCDIR}/csrc -lvector_search -lm
 #include <stdlib.h>
 #include "vector_search.h"
 */
@@ -17,9 +17,58 @@ import (
 // Takes a slice of vectors, a query vector, number of neighbors k, and a similarity threshold.
 // Returns a slice of matched indices or an error.
 func BruteForceSearch(vectors []*Vector, query *Vector, k int, similarityThreshold float32) ([]int, error) {
+	results, err := bruteForceSearch(vectors, query, k, similarityThreshold, nil, nil, nil)
+	if err == nil && len(results) == 0 {
+		return nil, errors.New("no results returned from brute force search")
+	}
+	return results, err
+}
+
+// BruteForceSearchFaceted is BruteForceSearch that also tallies, in the same
+// pass, every match above the threshold by group: groups[i] is the group of
+// vectors[i], and counts and maxScores receive one entry per group (the max
+// score of a group without matches is -math.MaxFloat32). The tallies cover
+// all matches, not only the k returned. No matches is not an error.
+func BruteForceSearchFaceted(vectors []*Vector, query *Vector, k int, similarityThreshold float32, groups, counts []int32, maxScores []float32) ([]int, error) {
+	if len(groups) < len(vectors) {
+		return nil, errors.New("groups slice too small")
+	}
+	if len(counts) == 0 || len(maxScores) < len(counts) {
+		return nil, errors.New("facet output slices too small")
+	}
+	return bruteForceSearch(vectors, query, k, similarityThreshold, groups, counts, maxScores)
+}
+
+func bruteForceSearch(vectors []*Vector, query *Vector, k int, similarityThreshold float32, groups, counts []int32, maxScores []float32) ([]int, error) {
 	if len(vectors) == 0 {
 		return nil, errors.New("input vectors slice is empty")
 	}
+	cVectors, err := newCVectorArray(vectors)
+	if err != nil {
+		return nil, err
+	}
+	defer C.free(unsafe.Pointer(cVectors))
+
+	return knnSearch(query, k, groups, counts, maxScores, func(cGroups, cCounts *C.int, cMaxScores *C.float, outCount *C.int) *C.int {
+		return C.brute_force_knn_search_faceted(
+			cVectors,
+			C.int(len(vectors)),
+			query.cvec,
+			C.int(k),
+			C.float(similarityThreshold),
+			cGroups,
+			C.int(len(counts)),
+			cCounts,
+			cMaxScores,
+			outCount,
+		)
+	})
+}
+
+// knnSearch runs a brute-force kernel, passing it C views of the facet
+// slices (nil without groups), and copies out the ids it returns
+func knnSearch(query *Vector, k int, groups, counts []int32, maxScores []float32,
+	kernel func(cGroups, cCounts *C.int, cMaxScores *C.float, outCount *C.int) *C.int) ([]int, error) {
 	if query == nil || query.cvec == nil {
 		return nil, errors.New("query vector is nil")
 	}
@@ -27,46 +76,53 @@ func BruteForceSearch(vectors []*Vector, query *Vector, k int, similarityThresho
 		return nil, errors.New("k must be positive")
 	}
 
+	var outCount C.int
+	var cGroups, cCounts *C.int
+	var cMaxScores *C.float
+	if groups != nil {
+		cGroups = (*C.int)(unsafe.Pointer(&groups[0]))
+		cCounts = (*C.int)(unsafe.Pointer(&counts[0]))
+		cMaxScores = (*C.float)(unsafe.Pointer(&maxScores[0]))
+	}
+
+	// Call the C brute force search function
+	cResults := kernel(cGroups, cCounts, cMaxScores, &outCount)
+	if cResults == nil {
+		return nil, errors.New("brute force search failed")
+	}
+	defer C.free(unsafe.Pointer(cResults))
+	if outCount == 0 {
+		return nil, nil
+	}
+
+	count := int(outCount)
+	results := make([]int, count)
+	cResultArray := (*[1 << 30]C.int)(unsafe.Pointer(cResults))[:count:count]
+	for i := 0; i < count; i++ {
+		results[i] = int(cResultArray[i])
+	}
+
+	return results, nil
+}
+
+// newCVectorArray copies the vectors' C structs into a C array, which the
+// caller must free. The vector data itself is shared, not copied.
+func newCVectorArray(vectors []*Vector) (*C.Vector, error) {
 	// Create a C array for the vectors
 	cVectors := (*C.Vector)(C.malloc(C.size_t(len(vectors)) * C.size_t(unsafe.Sizeof(C.Vector{}))))
 	if cVectors == nil {
 		return nil, errors.New("failed to allocate memory for C vectors array")
 	}
-	defer C.free(unsafe.Pointer(cVectors))
 
 	// Copy Go Vector pointers into the C array
 	cVectorArray := (*[1 << 30]C.Vector)(unsafe.Pointer(cVectors))[:len(vectors):len(vectors)]
 	for i, vec := range vectors {
 		if vec == nil || vec.cvec == nil {
+			C.free(unsafe.Pointer(cVectors))
 			return nil, errors.New("one of the input vectors is nil")
 		}
 		// Copy the C Vector struct contents (shallow copy is enough)
 		cVectorArray[i] = *vec.cvec
 	}
-
-	var outCount C.int
-
-	// Call the C brute force search function
-	cResults := C.brute_force_knn_search(
-		cVectors,
-		C.int(len(vectors)),
-		query.cvec,
-		C.int(k),
-		C.float(similarityThreshold),
-		&outCount,
-	)
-
-	if cResults == nil || outCount == 0 {
-		return nil, errors.New("no results returned from brute force search")
-	}
-	defer C.free(unsafe.Pointer(cResults))
-
-	count := int(outCount)
-	results := make([]int, count)
-	cResultArray := (*[1 << 30]C.int)(unsafe.Pointer(cResults))[:count:count]
-	for i := 0; i < count; i++ {
-		results[i] = int(cResultArray[i])
-	}
-
-	return results, nil
+	return cVectors, nil
 }
@@ -6,6 +6,12 @@
 #include <time.h>
 #include <limits.h>
 #include <stdio.h>
+#include <stdint.h>
+#ifdef __linux__
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
 
 // ================================
 // UTILITY FUNCTIONS
@@ -525,6 +531,26 @@ int* knn_search(VectorIndex* index, Vector* query, int k) {
 
 // Brute force cosine similarity k-NN search with threshold
 int* brute_force_knn_search(Vector* vectors, int len, Vector* query, int k, float similarity_threshold, int* out_count) {
+    return brute_force_knn_search_faceted(vectors, len, query, k, similarity_threshold,
+                                          NULL, 0, NULL, NULL, out_count);
+}
+
+// Brute force search that also tallies, for every vector at or above the
+// threshold, a hit and the best similarity for its group (groups[i] in
+// [0, group_count)) in group_counts and group_max_scores. The tallies cover
+// all matches, not just the k returned; pass groups NULL to skip them.
+int* brute_force_knn_search_faceted(Vector* vectors, int len, Vector* query, int k, float similarity_threshold,
+                                    const int* groups, int group_count, int* group_counts,
+                                    float* group_max_scores, int* out_count) {
+    if (groups != NULL && (group_count <= 0 || group_counts == NULL || group_max_scores == NULL)) {
+        groups = NULL;
+    }
+    if (groups != NULL) {
+        for (int group = 0; group < group_count; group++) {
+            group_counts[group] = 0;
+            group_max_scores[group] = -FLT_MAX;
+        }
+    }
     if (vectors == NULL || len <= 0 || query == NULL || k <= 0 || out_count == NULL) {
         if (out_count) {
             *out_count = 0;
@@ -567,6 +593,13 @@ int* brute_force_knn_search(Vector* vectors, int len, Vector* query, int k, floa
             neighbors[match_count] = i;
             similarities[match_count] = similarity;
             match_count++;
+
+            if (groups != NULL && groups[i] >= 0 && groups[i] < group_count) {
+                group_counts[groups[i]]++;
+                if (similarity > group_max_scores[groups[i]]) {
+                    group_max_scores[groups[i]] = similarity;
+                }
+            }
         }
     }
 
@@ -590,8 +623,8 @@ int* brute_force_knn_search(Vector* vectors, int len, Vector* query, int k, floa
         match_count = k;
     }
 
-    // For safety, realloc to reduce size
-    int* result = (int*)realloc(neighbors, sizeof(int) * match_count);
+    // For safety, realloc to reduce size (a zero-size realloc may free)
+    int* result = match_count > 0 ? (int*)realloc(neighbors, sizeof(int) * match_count) : NULL;
     if (result == NULL) {
         // realloc failed, return original
         result = neighbors;
@@ -845,4 +878,642 @@ void free_index(VectorIndex* index) {
         free_hnsw_graph(index->hnsw_graph);
     }
     free(index);
-}
\ No newline at end of file
+}
+// ================================
+// ALL-PAIRS TOP-N (RELATED VERSES)
+// ================================
+
+// Tile sizes keep a row panel, a column panel and the partial dot products
+// resident in L2 while the dimension is swept in chunks.
+#define ALL_PAIRS_ROW_BLOCK 256
+#define ALL_PAIRS_COL_BLOCK 64
+#define ALL_PAIRS_DIM_BLOCK 256
+
+typedef float float4 __attribute__((vector_size(16)));
+
+static inline float4 load_float4(const float* source) {
+    float4 value;
+    memcpy(&value, source, sizeof(value));
+    return value;
+}
+
+static inline float horizontal_sum(float4 value) {
+    return value[0] + value[1] + value[2] + value[3];
+}
+
+// Accumulates the dot products of one row against four columns
+static void dot_row_by_four_columns(const float* row, const float* column_0, const float* column_1,
+                                    const float* column_2, const float* column_3, int length, float* sums) {
+    float4 accumulator_0 = {0}, accumulator_1 = {0}, accumulator_2 = {0}, accumulator_3 = {0};
+    int dimension_index = 0;
+    for (; dimension_index + 4 <= length; dimension_index += 4) {
+        float4 row_values = load_float4(row + dimension_index);
+        accumulator_0 += row_values * load_float4(column_0 + dimension_index);
+        accumulator_1 += row_values * load_float4(column_1 + dimension_index);
+        accumulator_2 += row_values * load_float4(column_2 + dimension_index);
+        accumulator_3 += row_values * load_float4(column_3 + dimension_index);
+    }
+    float sum_0 = horizontal_sum(accumulator_0);
+    float sum_1 = horizontal_sum(accumulator_1);
+    float sum_2 = horizontal_sum(accumulator_2);
+    float sum_3 = horizontal_sum(accumulator_3);
+    for (; dimension_index < length; dimension_index++) {
+        sum_0 += row[dimension_index] * column_0[dimension_index];
+        sum_1 += row[dimension_index] * column_1[dimension_index];
+        sum_2 += row[dimension_index] * column_2[dimension_index];
+        sum_3 += row[dimension_index] * column_3[dimension_index];
+    }
+    sums[0] += sum_0;
+    sums[1] += sum_1;
+    sums[2] += sum_2;
+    sums[3] += sum_3;
+}
+
+// Inserts a candidate into a descending top-n list if it qualifies
+static void insert_top_n(int* ids, float* scores, int top_n, int candidate_id, float candidate_score) {
+    if (candidate_score <= scores[top_n - 1]) {
+        return;
+    }
+    int position = top_n - 1;
+    while (position > 0 && scores[position - 1] < candidate_score) {
+        ids[position] = ids[position - 1];
+        scores[position] = scores[position - 1];
+        position--;
+    }
+    ids[position] = candidate_id;
+    scores[position] = candidate_score;
+}
+
+// For rows [row_start, row_end) of a row-major matrix of unit vectors, finds
+// the top_n most similar other rows by dot product. out_ids and out_scores
+// hold top_n entries per row, best first; unused entries have id -1.
+// Returns 1 on success, 0 on failure.
+int all_pairs_top_n(const float* matrix, int count, int dimension, int row_start, int row_end,
+                    int top_n, int* out_ids, float* out_scores) {
+    if (matrix == NULL || count <= 0 || dimension <= 0 || top_n <= 0 ||
+        row_start < 0 || row_end > count || row_start >= row_end ||
+        out_ids == NULL || out_scores == NULL) {
+        return 0;
+    }
+
+    float* partial_dots = (float*)malloc(sizeof(float) * ALL_PAIRS_ROW_BLOCK * ALL_PAIRS_COL_BLOCK);
+    if (partial_dots == NULL) {
+        return 0;
+    }
+
+    for (int entry = 0; entry < (row_end - row_start) * top_n; entry++) {
+        out_ids[entry] = -1;
+        out_scores[entry] = -FLT_MAX;
+    }
+
+    for (int row_block = row_start; row_block < row_end; row_block += ALL_PAIRS_ROW_BLOCK) {
+        int row_block_end = row_block + ALL_PAIRS_ROW_BLOCK < row_end ? row_block + ALL_PAIRS_ROW_BLOCK : row_end;
+
+        for (int column_block = 0; column_block < count; column_block += ALL_PAIRS_COL_BLOCK) {
+            int column_block_end = column_block + ALL_PAIRS_COL_BLOCK < count ? column_block + ALL_PAIRS_COL_BLOCK : count;
+            memset(partial_dots, 0, sizeof(float) * ALL_PAIRS_ROW_BLOCK * ALL_PAIRS_COL_BLOCK);
+
+            for (int dimension_block = 0; dimension_block < dimension; dimension_block += ALL_PAIRS_DIM_BLOCK) {
+                int length = dimension - dimension_block < ALL_PAIRS_DIM_BLOCK ? dimension - dimension_block : ALL_PAIRS_DIM_BLOCK;
+
+                for (int row = row_block; row < row_block_end; row++) {
+                    const float* row_data = matrix + (size_t)row * dimension + dimension_block;
+                    float* row_dots = partial_dots + (row - row_block) * ALL_PAIRS_COL_BLOCK;
+                    int column = column_block;
+                    for (; column + 4 <= column_block_end; column += 4) {
+                        const float* column_data = matrix + (size_t)column * dimension + dimension_block;
+                        dot_row_by_four_columns(row_data, column_data, column_data + dimension,
+                                                column_data + 2 * dimension, column_data + 3 * dimension,
+                                                length, row_dots + (column - column_block));
+                    }
+                    for (; column < column_block_end; column++) {
+                        const float* column_data = matrix + (size_t)column * dimension + dimension_block;
+                        float sum = 0.0f;
+                        for (int dimension_index = 0; dimension_index < length; dimension_index++) {
+                            sum += row_data[dimension_index] * column_data[dimension_index];
+                        }
+                        row_dots[column - column_block] += sum;
+                    }
+                }
+            }
+
+            for (int row = row_block; row < row_block_end; row++) {
+                int* row_ids = out_ids + (size_t)(row - row_start) * top_n;
+                float* row_scores = out_scores + (size_t)(row - row_start) * top_n;
+                const float* row_dots = partial_dots + (row - row_block) * ALL_PAIRS_COL_BLOCK;
+                for (int column = column_block; column < column_block_end; column++) {
+                    if (column != row) {
+                        insert_top_n(row_ids, row_scores, top_n, column, row_dots[column - column_block]);
+                    }
+                }
+            }
+        }
+    }
+
+    free(partial_dots);
+    return 1;
+}
+
+// ================================
+// PASSAGE WINDOW POOLING
+// ================================
+
+// Writes to out row i the weighted sum of rows starts[i] .. starts[i]+window-1
+// of a row-major matrix, scaled to unit length (rows that sum to zero stay
+// zero). weights holds window entries. Returns 1 on success, 0 on failure.
+int pool_windows(const float* matrix, int count, int dimension, const int* starts, int window_count,
+                 int window, const float* weights, float* out) {
+    if (matrix == NULL || starts == NULL || weights == NULL || out == NULL ||
+        count <= 0 || dimension <= 0 || window_count < 0 || window <= 0) {
+        return 0;
+    }
+
+    for (int window_index = 0; window_index < window_count; window_index++) {
+        int start = starts[window_index];
+        if (start < 0 || start + window > count) {
+            return 0;
+        }
+        float* pooled = out + (size_t)window_index * dimension;
+        memset(pooled, 0, sizeof(float) * dimension);
+
+        for (int offset = 0; offset < window; offset++) {
+            const float* row = matrix + (size_t)(start + offset) * dimension;
+            float4 weight = {weights[offset], weights[offset], weights[offset], weights[offset]};
+            int dimension_index = 0;
+            for (; dimension_index + 4 <= dimension; dimension_index += 4) {
+                float4 sum = load_float4(pooled + dimension_index) + weight * load_float4(row + dimension_index);
+                memcpy(pooled + dimension_index, &sum, sizeof(sum));
+            }
+            for (; dimension_index < dimension; dimension_index++) {
+                pooled[dimension_index] += weights[offset] * row[dimension_index];
+            }
+        }
+
+        float4 squares = {0};
+        int dimension_index = 0;
+        for (; dimension_index + 4 <= dimension; dimension_index += 4) {
+            float4 value = load_float4(pooled + dimension_index);
+            squares += value * value;
+        }
+        float norm = horizontal_sum(squares);
+        for (; dimension_index < dimension; dimension_index++) {
+            norm += pooled[dimension_index] * pooled[dimension_index];
+        }
+        if (norm == 0.0f) {
+            continue;
+        }
+
+        float inverse = 1.0f / sqrtf(norm);
+        float4 scale = {inverse, inverse, inverse, inverse};
+        dimension_index = 0;
+        for (; dimension_index + 4 <= dimension; dimension_index += 4) {
+            float4 scaled = load_float4(pooled + dimension_index) * scale;
+            memcpy(pooled + dimension_index, &scaled, sizeof(scaled));
+        }
+        for (; dimension_index < dimension; dimension_index++) {
+            pooled[dimension_index] *= inverse;
+        }
+    }
+    return 1;
+}
+
+// ================================
+// MAXIMAL MARGINAL RELEVANCE
+// ================================
+
+// Picks up to k diverse rows from candidate_count unit vectors (row-major,
+// in rank order) by maximal marginal relevance. Each step takes the row
+// maximizing lambda * relevance - (1 - lambda) * (highest similarity to a
+// row already taken), less group_penalty if a taken row shares its group.
+// groups may be NULL. Ties keep rank order. Writes the picked candidate
+// indexes to out_order and returns how many were picked, which is fewer than
+// k if no remaining candidate has a finite score, or 0 on failure.
+int mmr_select(const float* candidates, int candidate_count, int dimension, const float* relevance,
+               const int* groups, int k, float lambda, float group_penalty, int* out_order) {
+    if (candidates == NULL || relevance == NULL || out_order == NULL ||
+        candidate_count <= 0 || dimension <= 0 || k <= 0) {
+        return 0;
+    }
+    if (k > candidate_count) {
+        k = candidate_count;
+    }
+
+    // redundancy[i] is the highest similarity of candidate i to a picked row;
+    // picked candidates are marked with -FLT_MAX
+    float* redundancy = (float*)malloc(sizeof(float) * candidate_count);
+    unsigned char* group_taken = (unsigned char*)calloc(candidate_count, 1);
+    if (redundancy == NULL || group_taken == NULL) {
+        free(redundancy);
+        free(group_taken);
+        return 0;
+    }
+    for (int candidate = 0; candidate < candidate_count; candidate++) {
+        redundancy[candidate] = 0.0f;
+    }
+
+    int picked = 0;
+    for (; picked < k; picked++) {
+        int best = -1;
+        float best_score = -FLT_MAX;
+        for (int candidate = 0; candidate < candidate_count; candidate++) {
+            if (redundancy[candidate] == -FLT_MAX) {
+                continue;
+            }
+            float score = lambda * relevance[candidate] - (1.0f - lambda) * redundancy[candidate];
+            if (group_taken[candidate]) {
+                score -= group_penalty;
+            }
+            if (score > best_score) {
+                best = candidate;
+                best_score = score;
+            }
+        }
+        if (best < 0) {
+            // No candidate scores above -FLT_MAX (NaN relevance or an
+            // overwhelming penalty); stop with what was picked
+            break;
+        }
+        out_order[picked] = best;
+        redundancy[best] = -FLT_MAX;
+
+        // Fold the new row's similarities into the remaining candidates,
+        // four columns per pass
+        const float* row = candidates + (size_t)best * dimension;
+        int candidate = 0;
+        while (candidate < candidate_count) {
+            int columns[4];
+            int column_count = 0;
+            for (; candidate < candidate_count && column_count < 4; candidate++) {
+                if (redundancy[candidate] != -FLT_MAX) {
+                    columns[column_count++] = candidate;
+                }
+            }
+            if (column_count == 0) {
+                break;
+            }
+            for (int padding = column_count; padding < 4; padding++) {
+                columns[padding] = columns[0];
+            }
+            float sums[4] = {0};
+            dot_row_by_four_columns(row,
+                                    candidates + (size_t)columns[0] * dimension,
+                                    candidates + (size_t)columns[1] * dimension,
+                                    candidates + (size_t)columns[2] * dimension,
+                                    candidates + (size_t)columns[3] * dimension,
+                                    dimension, sums);
+            for (int column = 0; column < column_count; column++) {
+                if (sums[column] > redundancy[columns[column]]) {
+                    redundancy[columns[column]] = sums[column];
+                }
+            }
+        }
+        if (groups != NULL) {
+            for (int other = 0; other < candidate_count; other++) {
+                if (groups[other] == groups[best]) {
+                    group_taken[other] = 1;
+                }
+            }
+        }
+    }
+
+    free(redundancy);
+    free(group_taken);
+    return picked;
+}
+
+// ================================
+// MULTI-VECTOR QUERIES
+// ================================
+
+// Scores every vector against query_count unit query vectors (row-major) in
+// one pass and keeps the k best combined scores at or above the threshold.
+// Each vector's cosine similarity to query i is multiplied by weights[i],
+// then the weighted similarities are summed (MULTI_QUERY_SUM) or reduced to
+// their maximum (MULTI_QUERY_MAX) or minimum (MULTI_QUERY_MIN). out_ids and
+// out_scores receive k entries, best first; unused entries have id -1.
+// Returns the number of matches kept, or -1 on failure.
+int multi_query_top_k(Vector* vectors, int len, const float* queries, int query_count, int dimension,
+                      const float* weights, int combine, int k, float similarity_threshold,
+                      int* out_ids, float* out_scores) {
+    if (vectors == NULL || len <= 0 || queries == NULL || query_count <= 0 || dimension <= 0 ||
+        weights == NULL || k <= 0 || out_ids == NULL || out_scores == NULL ||
+        (combine != MULTI_QUERY_SUM && combine != MULTI_QUERY_MAX && combine != MULTI_QUERY_MIN)) {
+        return -1;
+    }
+
+    for (int entry = 0; entry < k; entry++) {
+        out_ids[entry] = -1;
+        out_scores[entry] = -FLT_MAX;
+    }
+
+    int match_count = 0;
+    for (int vector_index = 0; vector_index < len; vector_index++) {
+        const float* row = vectors[vector_index].data;
+        if (vectors[vector_index].len != dimension) {
+            continue;
+        }
+
+        float4 squares = {0};
+        int dimension_index = 0;
+        for (; dimension_index + 4 <= dimension; dimension_index += 4) {
+            float4 value = load_float4(row + dimension_index);
+            squares += value * value;
+        }
+        float norm = horizontal_sum(squares);
+        for (; dimension_index < dimension; dimension_index++) {
+            norm += row[dimension_index] * row[dimension_index];
+        }
+        if (norm == 0.0f) {
+            continue;
+        }
+        float inverse_norm = 1.0f / sqrtf(norm);
+
+        // Four queries per sweep of the row; a short last group repeats query 0
+        float combined = combine == MULTI_QUERY_SUM ? 0.0f : (combine == MULTI_QUERY_MAX ? -FLT_MAX : FLT_MAX);
+        for (int query_index = 0; query_index < query_count; query_index += 4) {
+            int group = query_count - query_index < 4 ? query_count - query_index : 4;
+            const float* query_rows[4];
+            for (int slot = 0; slot < 4; slot++) {
+                query_rows[slot] = queries + (size_t)(query_index + (slot < group ? slot : 0)) * dimension;
+            }
+            float sums[4] = {0};
+            dot_row_by_four_columns(row, query_rows[0], query_rows[1], query_rows[2], query_rows[3], dimension, sums);
+            for (int slot = 0; slot < group; slot++) {
+                float weighted = weights[query_index + slot] * sums[slot] * inverse_norm;
+                if (combine == MULTI_QUERY_SUM) {
+                    combined += weighted;
+                } else if (combine == MULTI_QUERY_MAX ? weighted > combined : weighted < combined) {
+                    combined = weighted;
+                }
+            }
+        }
+
+        if (combined >= similarity_threshold) {
+            if (match_count < k) {
+                match_count++;
+            }
+            insert_top_n(out_ids, out_scores, k, vector_index, combined);
+        }
+    }
+    return match_count;
+}
+
+// ================================
+// EMBEDDING MATRIX MEMORY
+// ================================
+
+// Every query scans the whole matrix. At 1536 floats a row is 6KB, so with
+// base pages a scan of 31k verses walks ~47k TLB entries; 2MB pages need 512
+// times fewer.
+#define MATRIX_HUGE_PAGE_SIZE ((size_t)2 << 20)
+
+// Memory policies of mbind(2), which libc does not wrap
+#define MATRIX_MPOL_BIND 2
+#define MATRIX_MPOL_INTERLEAVE 3
+#define MATRIX_MAX_NODES 64
+
+#ifdef __linux__
+
+// Reads the online NUMA nodes, a list like "0-1" or "0,2-3", into nodes
+static int online_numa_nodes(int* nodes, int capacity) {
+    FILE* file = fopen("/sys/devices/system/node/online", "r");
+    if (file == NULL) {
+        return 0;
+    }
+    int count = 0;
+    int first, last;
+    while (fscanf(file, "%d", &first) == 1) {
+        last = first;
+        int separator = fgetc(file);
+        if (separator == '-') {
+            if (fscanf(file, "%d", &last) != 1) {
+                break;
+            }
+            separator = fgetc(file);
+        }
+        for (int node = first; node <= last && count < capacity; node++) {
+            nodes[count++] = node;
+        }
+        if (separator != ',') {
+            break;
+        }
+    }
+    fclose(file);
+    return count;
+}
+
+// Applies a memory policy over nodes to an untouched region
+static int bind_region(void* region, size_t size, int mode, const int* nodes, int node_count) {
+    unsigned long mask[MATRIX_MAX_NODES / (8 * sizeof(unsigned long)) + 1] = {0};
+    for (int i = 0; i < node_count; i++) {
+        if (nodes[i] >= 0 && nodes[i] < MATRIX_MAX_NODES) {
+            mask[nodes[i] / (8 * sizeof(unsigned long))] |= 1UL << (nodes[i] % (8 * sizeof(unsigned long)));
+        }
+    }
+    return (int)syscall(SYS_mbind, region, size, mode, mask, MATRIX_MAX_NODES + 1, 0);
+}
+
+static int transparent_huge_pages_enabled(void) {
+    FILE* file = fopen("/sys/kernel/mm/transparent_hugepage/enabled", "r");
+    if (file == NULL) {
+        return 0;
+    }
+    char modes[64] = {0};
+    size_t length = fread(modes, 1, sizeof(modes) - 1, file);
+    fclose(file);
+    return length > 0 && strstr(modes, "[never]") == NULL;
+}
+
+static size_t base_page_size(void) {
+    long size = sysconf(_SC_PAGESIZE);
+    return size > 0 ? (size_t)size : 4096;
+}
+
+// Maps size bytes (a multiple of MATRIX_HUGE_PAGE_SIZE, or of the base page
+// size for base pages) with the best pages available up to those asked for,
+// recording which were obtained
+static float* map_matrix_region(size_t size, int pages, int* obtained) {
+    *obtained = MATRIX_PAGES_SMALL;
+    if (pages == MATRIX_PAGES_SMALL) {
+        void* region = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        return region == MAP_FAILED ? NULL : (float*)region;
+    }
+    if (pages == MATRIX_PAGES_EXPLICIT) {
+        void* region = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+        if (region != MAP_FAILED) {
+            *obtained = MATRIX_PAGES_EXPLICIT;
+            return (float*)region;
+        }
+        // The reserved pool is empty or too small
+        pages = MATRIX_PAGES_TRANSPARENT;
+    }
+
+    // Over-map by a huge page and trim, so every 2MB of the region is
+    // aligned and can be backed by one huge page
+    size_t padded = size + MATRIX_HUGE_PAGE_SIZE;
+    char* raw = (char*)mmap(NULL, padded, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (raw == (char*)MAP_FAILED) {
+        return NULL;
+    }
+    char* aligned = (char*)(((uintptr_t)raw + MATRIX_HUGE_PAGE_SIZE - 1) & ~(uintptr_t)(MATRIX_HUGE_PAGE_SIZE - 1));
+    if (aligned > raw) {
+        munmap(raw, aligned - raw);
+    }
+    if (raw + padded > aligned + size) {
+        munmap(aligned + size, (raw + padded) - (aligned + size));
+    }
+
+    if (pages == MATRIX_PAGES_TRANSPARENT && transparent_huge_pages_enabled() &&
+        madvise(aligned, size, MADV_HUGEPAGE) == 0) {
+        *obtained = MATRIX_PAGES_TRANSPARENT;
+    }
+    return (float*)aligned;
+}
+
+static void unmap_matrix_region(float* region, size_t size) {
+    munmap(region, size);
+}
+
+#else
+
+static int online_numa_nodes(int* nodes, int capacity) {
+    return 0;
+}
+
+static int bind_region(void* region, size_t size, int mode, const int* nodes, int node_count) {
+    return -1;
+}
+
+static size_t base_page_size(void) {
+    return 4096;
+}
+
+static float* map_matrix_region(size_t size, int pages, int* obtained) {
+    *obtained = MATRIX_PAGES_SMALL;
+    return (float*)malloc(size);
+}
+
+static void unmap_matrix_region(float* region, size_t size) {
+    free(region);
+}
+
+#endif
+
+// Maps a count x dimension matrix with up to the pages asked for, and
+// places it on NUMA nodes as asked when the host has more than one. Any
+// step the host refuses falls back: explicit huge pages to transparent ones
+// to base pages, replication to interleaving to local placement. Returns
+// NULL only if no memory could be mapped.
+EmbeddingMatrix* embedding_matrix_create(int count, int dimension, int pages, int numa) {
+    if (count <= 0 || dimension <= 0) {
+        return NULL;
+    }
+    EmbeddingMatrix* matrix = (EmbeddingMatrix*)calloc(1, sizeof(EmbeddingMatrix));
+    if (matrix == NULL) {
+        return NULL;
+    }
+    matrix->count = count;
+    matrix->dimension = dimension;
+    size_t size = (size_t)count * dimension * sizeof(float);
+    // A matrix under a huge page, such as a small segment, would only be
+    // padded out to one: it gets base pages and is rounded to those
+    if (size < MATRIX_HUGE_PAGE_SIZE) {
+        pages = MATRIX_PAGES_SMALL;
+    }
+    size_t granule = pages == MATRIX_PAGES_SMALL ? base_page_size() : MATRIX_HUGE_PAGE_SIZE;
+    matrix->mapped_size = (size + granule - 1) & ~(granule - 1);
+
+    int nodes[MATRIX_MAX_NODES];
+    matrix->node_count = online_numa_nodes(nodes, MATRIX_MAX_NODES);
+    int replicas = 1;
+    if (numa == MATRIX_NUMA_REPLICATE && matrix->node_count > 1) {
+        replicas = matrix->node_count < MATRIX_MAX_REPLICAS ? matrix->node_count : MATRIX_MAX_REPLICAS;
+    }
+    if (matrix->node_count == 0) {
+        matrix->node_count = 1;
+    }
+
+    matrix->pages = pages;
+    for (int replica = 0; replica < replicas; replica++) {
+        int obtained;
+        matrix->data[replica] = map_matrix_region(matrix->mapped_size, pages, &obtained);
+        if (matrix->data[replica] == NULL) {
+            embedding_matrix_free(matrix);
+            return NULL;
+        }
+        matrix->replica_count++;
+        if (obtained < matrix->pages) {
+            matrix->pages = obtained;
+        }
+    }
+
+    matrix->numa = MATRIX_NUMA_LOCAL;
+    if (replicas > 1) {
+        int bound = 1;
+        for (int replica = 0; replica < replicas && bound; replica++) {
+            bound = bind_region(matrix->data[replica], matrix->mapped_size, MATRIX_MPOL_BIND, &nodes[replica], 1) == 0;
+            matrix->replica_nodes[replica] = nodes[replica];
+        }
+        if (bound) {
+            matrix->numa = MATRIX_NUMA_REPLICATE;
+        } else {
+            for (int replica = 1; replica < replicas; replica++) {
+                unmap_matrix_region(matrix->data[replica], matrix->mapped_size);
+                matrix->data[replica] = NULL;
+            }
+            matrix->replica_count = 1;
+        }
+    }
+    if (matrix->numa == MATRIX_NUMA_LOCAL && numa != MATRIX_NUMA_LOCAL && matrix->node_count > 1 &&
+        bind_region(matrix->data[0], matrix->mapped_size, MATRIX_MPOL_INTERLEAVE, nodes, matrix->node_count) == 0) {
+        matrix->numa = MATRIX_NUMA_INTERLEAVE;
+    }
+
+    for (int replica = 0; replica < matrix->replica_count; replica++) {
+        matrix->rows[replica] = (Vector*)malloc(sizeof(Vector) * count);
+        if (matrix->rows[replica] == NULL) {
+            embedding_matrix_free(matrix);
+            return NULL;
+        }
+        for (int row = 0; row < count; row++) {
+            matrix->rows[replica][row].data = matrix->data[replica] + (size_t)row * dimension;
+            matrix->rows[replica][row].len = dimension;
+        }
+    }
+    return matrix;
+}
+
+// Copying faults each replica's pages in on the node it is bound to
+void embedding_matrix_publish(EmbeddingMatrix* matrix) {
+    size_t size = (size_t)matrix->count * matrix->dimension * sizeof(float);
+    for (int replica = 1; replica < matrix->replica_count; replica++) {
+        memcpy(matrix->data[replica], matrix->data[0], size);
+    }
+}
+
+Vector* embedding_matrix_local_rows(EmbeddingMatrix* matrix) {
+#ifdef __linux__
+    unsigned int cpu, node;
+    if (matrix->replica_count > 1 && syscall(SYS_getcpu, &cpu, &node, NULL) == 0) {
+        for (int replica = 0; replica < matrix->replica_count; replica++) {
+            if (matrix->replica_nodes[replica] == (int)node) {
+                return matrix->rows[replica];
+            }
+        }
+    }
+#endif
+    return matrix->rows[0];
+}
+
+void embedding_matrix_free(EmbeddingMatrix* matrix) {
+    if (matrix == NULL) {
+        return;
+    }
+    for (int replica = 0; replica < MATRIX_MAX_REPLICAS; replica++) {
+        if (matrix->data[replica] != NULL) {
+            unmap_matrix_region(matrix->data[replica], matrix->mapped_size);
+        }
+        free(matrix->rows[replica]);
+    }
+    free(matrix);
+}
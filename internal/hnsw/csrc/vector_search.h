@@ -1,6 +1,8 @@
 #ifndef VECTOR_SEARCH_H
 #define VECTOR_SEARCH_H
 
+#include <stddef.h>
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -83,6 +85,67 @@ HNSWGraph* deserialize_hnsw_graph(const char* buffer, int size);
 
 // Brute force cosine similarity k-NN search with threshold
 int* brute_force_knn_search(Vector* vectors, int len, Vector* query, int k, float similarity_threshold, int* out_count);
+// Same, also tallying matches and best similarity per group of vectors during the scan
+int* brute_force_knn_search_faceted(Vector* vectors, int len, Vector* query, int k, float similarity_threshold,
+                                    const int* groups, int group_count, int* group_counts,
+                                    float* group_max_scores, int* out_count);
+
+// All-pairs top-n over rows [row_start, row_end) of a row-major matrix of unit vectors
+int all_pairs_top_n(const float* matrix, int count, int dimension, int row_start, int row_end,
+                    int top_n, int* out_ids, float* out_scores);
+
+// Pools windows of consecutive rows of a row-major matrix into unit vectors
+int pool_windows(const float* matrix, int count, int dimension, const int* starts, int window_count,
+                 int window, const float* weights, float* out);
+
+// Picks up to k diverse candidates (unit vectors in rank order) by maximal marginal relevance
+int mmr_select(const float* candidates, int candidate_count, int dimension, const float* relevance,
+               const int* groups, int k, float lambda, float group_penalty, int* out_order);
+
+// How multi_query_top_k combines a vector's weighted similarities to the queries
+#define MULTI_QUERY_SUM 0
+#define MULTI_QUERY_MAX 1
+#define MULTI_QUERY_MIN 2
+
+// Scores every vector against several weighted unit query vectors in one pass, keeping the k best
+int multi_query_top_k(Vector* vectors, int len, const float* queries, int query_count, int dimension,
+                      const float* weights, int combine, int k, float similarity_threshold,
+                      int* out_ids, float* out_scores);
+
+// Pages requested for an embedding matrix
+#define MATRIX_PAGES_SMALL 0        // the base page size
+#define MATRIX_PAGES_TRANSPARENT 1  // 2MB-aligned and advised for transparent huge pages
+#define MATRIX_PAGES_EXPLICIT 2     // MAP_HUGETLB from the reserved pool, else transparent
+
+// Placement of an embedding matrix across NUMA nodes
+#define MATRIX_NUMA_LOCAL 0       // where the kernel places it, usually the first toucher's node
+#define MATRIX_NUMA_INTERLEAVE 1  // pages spread round-robin over all nodes
+#define MATRIX_NUMA_REPLICATE 2   // one copy bound to each node, read from the caller's
+
+#define MATRIX_MAX_REPLICAS 8
+
+// Read-only row-major matrix of vectors in memory the library maps itself.
+// The fields after dimension record what was obtained, which can be less
+// than what was asked for.
+typedef struct {
+    float* data[MATRIX_MAX_REPLICAS];   // copy per replica; fill data[0], then publish
+    Vector* rows[MATRIX_MAX_REPLICAS];  // row views into each copy
+    int replica_nodes[MATRIX_MAX_REPLICAS];
+    int replica_count;
+    int count;
+    int dimension;
+    size_t mapped_size;                 // bytes mapped per copy
+    int pages;                          // MATRIX_PAGES_*
+    int numa;                           // MATRIX_NUMA_*
+    int node_count;                     // NUMA nodes online
+} EmbeddingMatrix;
+
+EmbeddingMatrix* embedding_matrix_create(int count, int dimension, int pages, int numa);
+// Copies data[0] to the other replicas once it has been filled
+void embedding_matrix_publish(EmbeddingMatrix* matrix);
+// Rows of the replica on the calling thread's NUMA node
+Vector* embedding_matrix_local_rows(EmbeddingMatrix* matrix);
+void embedding_matrix_free(EmbeddingMatrix* matrix);
 
 float calculate_euclidean_distance(Vector* vector_a, Vector* vector_b);
 int determine_random_layer(float level_generation_factor);
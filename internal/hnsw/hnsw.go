@@ -2,7 +2,7 @@ package hnsw
 
 /*
 #cgo CFLAGS: -I${SRCDIR}/csrc
-#cgo LDFLAGS: -L${SRCDIR}/csrc -lvector_search
+#cgo LDFLAGS: -L${SRCDIR}/csrc -lvector_search -lm
 #include <stdlib.h>
 #include "vector_search.h"
 
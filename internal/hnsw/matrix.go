@@ -0,0 +1,270 @@
+package hnsw
+
+/*
+#cgo CFLAGS: -I${SRCDIR}/csrc
+#cgo LDFLAGS: -L${SRCDIR}/csrc -lvector_search -lm
+#include <stdlib.h>
+#include "vector_search.h"
+
+// The kernels read the replica of the node the calling thread is on, chosen
+// within the same cgo call so the thread cannot change in between
+
+static int* matrix_knn_search(EmbeddingMatrix* matrix, Vector* query, int k, float similarity_threshold,
+                              const int* groups, int group_count, int* group_counts,
+                              float* group_max_scores, int* out_count) {
+	return brute_force_knn_search_faceted(embedding_matrix_local_rows(matrix), matrix->count, query, k,
+	                                      similarity_threshold, groups, group_count, group_counts,
+	                                      group_max_scores, out_count);
+}
+
+static int matrix_multi_query_top_k(EmbeddingMatrix* matrix, const float* queries, int query_count,
+                                    const float* weights, int combine, int k, float similarity_threshold,
+                                    int* out_ids, float* out_scores) {
+	return multi_query_top_k(embedding_matrix_local_rows(matrix), matrix->count, queries, query_count,
+	                         matrix->dimension, weights, combine, k, similarity_threshold, out_ids, out_scores);
+}
+*/
+import "C"
+
+import (
+	"bufio"
+	"errors"
+	"fmt"
+	"os"
+	"runtime"
+	"strconv"
+	"strings"
+	"unsafe"
+)
+
+// Pages a Matrix can ask for
+const (
+	PagesSmall       = "off"         // base pages
+	PagesTransparent = "transparent" // transparent huge pages, advised with madvise
+	PagesExplicit    = "explicit"    // MAP_HUGETLB from the reserved pool, else transparent
+)
+
+// Placements of a Matrix across NUMA nodes
+const (
+	NUMALocal      = "local"      // wherever the kernel puts it
+	NUMAInterleave = "interleave" // pages spread over all nodes
+	NUMAReplicate  = "replicate"  // a copy per node, each scan reading its own node's
+)
+
+var pageNames = map[string]C.int{
+	PagesSmall:       C.MATRIX_PAGES_SMALL,
+	PagesTransparent: C.MATRIX_PAGES_TRANSPARENT,
+	PagesExplicit:    C.MATRIX_PAGES_EXPLICIT,
+}
+
+var numaNames = map[string]C.int{
+	NUMALocal:      C.MATRIX_NUMA_LOCAL,
+	NUMAInterleave: C.MATRIX_NUMA_INTERLEAVE,
+	NUMAReplicate:  C.MATRIX_NUMA_REPLICATE,
+}
+
+// Placement is the memory a Matrix asks for
+type Placement struct {
+	HugePages string // PagesSmall, PagesTransparent or PagesExplicit
+	NUMA      string // NUMALocal, NUMAInterleave or NUMAReplicate
+}
+
+// DefaultPlacement asks for transparent huge pages interleaved over the
+// NUMA nodes, which changes nothing on a host with a single node
+var DefaultPlacement = Placement{HugePages: PagesTransparent, NUMA: NUMAInterleave}
+
+// Validate reports whether the placement names known policies
+func (p Placement) Validate() error {
+	if _, ok := pageNames[p.HugePages]; !ok {
+		return fmt.Errorf("unknown huge pages policy %q (want %s, %s or %s)", p.HugePages, PagesSmall, PagesTransparent, PagesExplicit)
+	}
+	if _, ok := numaNames[p.NUMA]; !ok {
+		return fmt.Errorf("unknown NUMA policy %q (want %s, %s or %s)", p.NUMA, NUMALocal, NUMAInterleave, NUMAReplicate)
+	}
+	return nil
+}
+
+// PlacementReport is the memory a Matrix obtained, which falls back from
+// what was asked when the host refuses it
+type PlacementReport struct {
+	Bytes     int    // mapped per copy
+	HugePages string // pages obtained
+	HugeBytes int    // bytes of the first copy backed by huge pages, -1 if unknown
+	NUMA      string // placement obtained
+	Nodes     int    // NUMA nodes online
+	Replicas  int    // copies of the matrix
+}
+
+// String summarizes the report for the startup log
+func (r PlacementReport) String() string {
+	huge := "unknown"
+	if r.HugeBytes >= 0 {
+		huge = fmt.Sprintf("%.1f MB", float64(r.HugeBytes)/(1<<20))
+	}
+	pages := r.HugePages + " huge"
+	if r.HugePages == PagesSmall {
+		pages = "base"
+	}
+	return fmt.Sprintf("%.1f MB on %s pages (%s huge), NUMA %s over %d node(s), %d replica(s)",
+		float64(r.Bytes)/(1<<20), pages, huge, r.NUMA, r.Nodes, r.Replicas)
+}
+
+// Matrix is a read-only row-major matrix of vectors in memory mapped by the
+// C library, for the kernels to scan without per-query copies. Rows are
+// copied in once; its memory is released by Free or when it is collected.
+type Matrix struct {
+	matrix *C.EmbeddingMatrix
+	count  int
+	dim    int
+	report PlacementReport
+}
+
+// NewMatrix copies rows into a matrix of dim columns placed as asked, with
+// fallbacks. Rows of another length are stored as zeros and never match.
+func NewMatrix(rows [][]float32, dim int, placement Placement) (*Matrix, error) {
+	if err := placement.Validate(); err != nil {
+		return nil, err
+	}
+	if len(rows) == 0 || dim <= 0 {
+		return nil, errors.New("matrix has no rows")
+	}
+	cMatrix := C.embedding_matrix_create(C.int(len(rows)), C.int(dim), pageNames[placement.HugePages], numaNames[placement.NUMA])
+	if cMatrix == nil {
+		return nil, errors.New("failed to map embedding matrix")
+	}
+
+	data := unsafe.Slice((*float32)(unsafe.Pointer(cMatrix.data[0])), len(rows)*dim)
+	for i, row := range rows {
+		if len(row) == dim {
+			copy(data[i*dim:(i+1)*dim], row)
+		} else {
+			clear(data[i*dim : (i+1)*dim])
+		}
+	}
+	C.embedding_matrix_publish(cMatrix)
+
+	m := &Matrix{matrix: cMatrix, count: len(rows), dim: dim}
+	m.report = PlacementReport{
+		Bytes:     int(cMatrix.mapped_size),
+		HugeBytes: hugePageBytes(uintptr(unsafe.Pointer(cMatrix.data[0])), int(cMatrix.mapped_size)),
+		Nodes:     int(cMatrix.node_count),
+		Replicas:  int(cMatrix.replica_count),
+	}
+	for name, value := range pageNames {
+		if value == cMatrix.pages {
+			m.report.HugePages = name
+		}
+	}
+	for name, value := range numaNames {
+		if value == cMatrix.numa {
+			m.report.NUMA = name
+		}
+	}
+	if cMatrix.pages == C.MATRIX_PAGES_EXPLICIT {
+		m.report.HugeBytes = m.report.Bytes
+	}
+	runtime.SetFinalizer(m, (*Matrix).Free)
+	return m, nil
+}
+
+// Report returns the memory the matrix obtained
+func (m *Matrix) Report() PlacementReport {
+	return m.report
+}
+
+// Len returns the number of rows
+func (m *Matrix) Len() int {
+	return m.count
+}
+
+// Row returns row i of the first copy as a slice of the matrix memory, or
+// nil if out of range. It is valid until the matrix is freed and must not
+// be written.
+func (m *Matrix) Row(i int) []float32 {
+	if m.matrix == nil || i < 0 || i >= m.count {
+		return nil
+	}
+	data := unsafe.Slice((*float32)(unsafe.Pointer(m.matrix.data[0])), m.count*m.dim)
+	return data[i*m.dim : (i+1)*m.dim : (i+1)*m.dim]
+}
+
+// Free releases the matrix memory
+func (m *Matrix) Free() {
+	if m.matrix != nil {
+		C.embedding_matrix_free(m.matrix)
+		m.matrix = nil
+	}
+}
+
+// Search is BruteForceSearchFaceted over the matrix rows, or BruteForceSearch
+// without groups, except that no matches is not an error
+func (m *Matrix) Search(query *Vector, k int, similarityThreshold float32, groups, counts []int32, maxScores []float32) ([]int, error) {
+	if m.matrix == nil {
+		return nil, errors.New("matrix has been freed")
+	}
+	if groups != nil && (len(groups) < m.count || len(counts) == 0 || len(maxScores) < len(counts)) {
+		return nil, errors.New("facet slices too small")
+	}
+	if query != nil && query.cvec != nil && int(query.cvec.len) != m.dim {
+		return nil, errors.New("query dimension does not match the matrix")
+	}
+	defer runtime.KeepAlive(m)
+	return knnSearch(query, k, groups, counts, maxScores, func(cGroups, cCounts *C.int, cMaxScores *C.float, outCount *C.int) *C.int {
+		return C.matrix_knn_search(m.matrix, query.cvec, C.int(k), C.float(similarityThreshold),
+			cGroups, C.int(len(counts)), cCounts, cMaxScores, outCount)
+	})
+}
+
+// MultiQuerySearch is MultiQuerySearch over the matrix rows
+func (m *Matrix) MultiQuerySearch(queries []float32, weights []float32, combine, k int, threshold float32, ids []int32, scores []float32) (int, error) {
+	if m.matrix == nil {
+		return 0, errors.New("matrix has been freed")
+	}
+	defer runtime.KeepAlive(m)
+	return multiQuery(queries, m.dim, weights, k, ids, scores, func() C.int {
+		return C.matrix_multi_query_top_k(
+			m.matrix,
+			(*C.float)(unsafe.Pointer(&queries[0])),
+			C.int(len(weights)),
+			(*C.float)(unsafe.Pointer(&weights[0])),
+			C.int(combine),
+			C.int(k),
+			C.float(threshold),
+			(*C.int)(unsafe.Pointer(&ids[0])),
+			(*C.float)(unsafe.Pointer(&scores[0])),
+		)
+	})
+}
+
+// hugePageBytes sums, from /proc/self/smaps, the huge pages backing the
+// mappings that overlap [start, start+size), or returns -1 if it cannot
+func hugePageBytes(start uintptr, size int) int {
+	file, err := os.Open("/proc/self/smaps")
+	if err != nil {
+		return -1
+	}
+	defer file.Close()
+
+	end := start + uintptr(size)
+	total, overlapping := 0, false
+	scanner := bufio.NewScanner(file)
+	for scanner.Scan() {
+		line := scanner.Text()
+		if fields := strings.Fields(line); len(fields) > 0 && strings.Contains(fields[0], "-") && !strings.HasSuffix(fields[0], ":") {
+			bounds := strings.SplitN(fields[0], "-", 2)
+			low, lowErr := strconv.ParseUint(bounds[0], 16, 64)
+			high, highErr := strconv.ParseUint(bounds[1], 16, 64)
+			overlapping = lowErr == nil && highErr == nil && uintptr(low) < end && uintptr(high) > start
+			continue
+		}
+		if overlapping && strings.HasPrefix(line, "AnonHugePages:") {
+			if kb, err := strconv.Atoi(strings.Fields(line)[1]); err == nil {
+				total += kb << 10
+			}
+		}
+	}
+	if scanner.Err() != nil {
+		return -1
+	}
+	return min(total, size)
+}
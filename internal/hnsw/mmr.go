@@ -0,0 +1,55 @@
+package hnsw
+
+/*
+#cgo CFLAGS: -I${SRCDIR}/csrc
+#cgo LDFLAGS: -L${SRCDIR}/csrc -lvector_search -lm
+#include "vector_search.h"
+*/
+import "C"
+
+import (
+	"errors"
+	"unsafe"
+)
+
+// SelectMMR reranks candidates (unit vectors in a row-major matrix, in rank
+// order) by maximal marginal relevance using the C kernel. Each pick
+// maximizes lambda*relevance minus (1-lambda) times its highest similarity
+// to earlier picks, less groupPenalty if an earlier pick shares its group.
+// groups may be nil. The picked candidate indexes are written to order,
+// best first, and their number is returned.
+func SelectMMR(candidates []float32, dim int, relevance []float32, groups []int32, k int, lambda, groupPenalty float32, order []int32) (int, error) {
+	count := len(relevance)
+	if count == 0 || k <= 0 {
+		return 0, nil
+	}
+	if dim <= 0 || len(candidates) < count*dim {
+		return 0, errors.New("candidate matrix is smaller than count x dim")
+	}
+	if groups != nil && len(groups) < count {
+		return 0, errors.New("groups slice too small")
+	}
+	if len(order) < min(k, count) {
+		return 0, errors.New("output slice too small")
+	}
+
+	var cGroups *C.int
+	if groups != nil {
+		cGroups = (*C.int)(unsafe.Pointer(&groups[0]))
+	}
+	picked := C.mmr_select(
+		(*C.float)(unsafe.Pointer(&candidates[0])),
+		C.int(count),
+		C.int(dim),
+		(*C.float)(unsafe.Pointer(&relevance[0])),
+		cGroups,
+		C.int(k),
+		C.float(lambda),
+		C.float(groupPenalty),
+		(*C.int)(unsafe.Pointer(&order[0])),
+	)
+	if picked == 0 {
+		return 0, errors.New("mmr kernel failed")
+	}
+	return int(picked), nil
+}
@@ -0,0 +1,71 @@
+package hnsw
+
+/*
+#cgo CFLAGS: -I${SRCDIR}/csrc
+#cgo LDFLAGS: -L${SRCDIR}/csrc -lvector_search -lm
+#include <stdlib.h>
+#include "vector_search.h"
+*/
+import "C"
+
+import (
+	"errors"
+	"unsafe"
+)
+
+// Ways MultiQuerySearch combines a vector's weighted similarities to the queries
+const (
+	CombineSum = C.MULTI_QUERY_SUM
+	CombineMax = C.MULTI_QUERY_MAX
+	CombineMin = C.MULTI_QUERY_MIN
+)
+
+// MultiQuerySearch scores every vector against several unit query vectors
+// (row-major in queries, dim floats each) in a single pass of the C kernel.
+// Each cosine similarity is multiplied by its query's weight, and the
+// weighted similarities are combined by sum, max or min. The k best combined
+// scores at or above threshold are written to ids and scores, best first,
+// and their number is returned.
+func MultiQuerySearch(vectors []*Vector, queries []float32, dim int, weights []float32, combine, k int, threshold float32, ids []int32, scores []float32) (int, error) {
+	if len(vectors) == 0 {
+		return 0, errors.New("input vectors slice is empty")
+	}
+	cVectors, err := newCVectorArray(vectors)
+	if err != nil {
+		return 0, err
+	}
+	defer C.free(unsafe.Pointer(cVectors))
+
+	return multiQuery(queries, dim, weights, k, ids, scores, func() C.int {
+		return C.multi_query_top_k(
+			cVectors,
+			C.int(len(vectors)),
+			(*C.float)(unsafe.Pointer(&queries[0])),
+			C.int(len(weights)),
+			C.int(dim),
+			(*C.float)(unsafe.Pointer(&weights[0])),
+			C.int(combine),
+			C.int(k),
+			C.float(threshold),
+			(*C.int)(unsafe.Pointer(&ids[0])),
+			(*C.float)(unsafe.Pointer(&scores[0])),
+		)
+	})
+}
+
+// multiQuery checks the arguments shared by the multi-query entry points and
+// runs the kernel
+func multiQuery(queries []float32, dim int, weights []float32, k int, ids []int32, scores []float32, kernel func() C.int) (int, error) {
+	if dim <= 0 || len(weights) == 0 || len(queries) < len(weights)*dim {
+		return 0, errors.New("queries are smaller than weights x dim")
+	}
+	if k <= 0 || len(ids) < k || len(scores) < k {
+		return 0, errors.New("output slices smaller than k")
+	}
+
+	count := kernel()
+	if count < 0 {
+		return 0, errors.New("multi-query kernel failed")
+	}
+	return int(count), nil
+}
@@ -0,0 +1,46 @@
+package hnsw
+
+/*
+#cgo CFLAGS: -I${SRCDIR}/csrc
+#cgo LDFLAGS: -L${SRCDIR}/csrc -lvector_search -lm
+#include "vector_search.h"
+*/
+import "C"
+
+import (
+	"errors"
+	"unsafe"
+)
+
+// PoolWindows writes to out, for each start, the weighted sum of rows
+// start..start+len(weights)-1 of a row-major matrix normalized to unit
+// length, using the C kernel. out must hold len(starts)*dim floats.
+func PoolWindows(matrix []float32, count, dim int, starts []int32, weights []float32, out []float32) error {
+	if count <= 0 || dim <= 0 || len(matrix) < count*dim {
+		return errors.New("matrix is smaller than count x dim")
+	}
+	if len(weights) == 0 {
+		return errors.New("window weights are empty")
+	}
+	if len(out) < len(starts)*dim {
+		return errors.New("output slice too small")
+	}
+	if len(starts) == 0 {
+		return nil
+	}
+
+	ok := C.pool_windows(
+		(*C.float)(unsafe.Pointer(&matrix[0])),
+		C.int(count),
+		C.int(dim),
+		(*C.int)(unsafe.Pointer(&starts[0])),
+		C.int(len(starts)),
+		C.int(len(weights)),
+		(*C.float)(unsafe.Pointer(&weights[0])),
+		(*C.float)(unsafe.Pointer(&out[0])),
+	)
+	if ok == 0 {
+		return errors.New("window outside the matrix")
+	}
+	return nil
+}
@@ -0,0 +1,330 @@
+package index
+
+import (
+	"bufio"
+	"encoding/binary"
+	"fmt"
+	"hash/crc32"
+	"io"
+	"math"
+	"os"
+	"path/filepath"
+	"runtime"
+	"sync"
+
+	"versejet/internal/mmap"
+)
+
+// Index file formats
+const (
+	FormatColumnar = "columnar"
+	FormatGob      = "gob"
+)
+
+// The columnar layout stores each field of every verse together so a load
+// makes a handful of allocations and decodes the embeddings in parallel:
+//
+//	header       64 bytes, see below
+//	chunk CRCs   uint32 per chunk of columnarChunkRows embedding rows
+//	strings      uint32 end offsets of every ID, reference and text, then
+//	             the IDs and references back to back and the texts joined
+//	             by single spaces, as the text arena holds them
+//	embeddings   count*dim float32, row after row
+//	related      count*N int32 IDs, then count*N uint16 scores, if N > 0
+//
+// Header: magic, then uint32 count, dim, chunk rows and related N, uint64
+// strings length, and uint32 CRCs of the strings and related sections.
+// Integers and floats are little-endian; CRCs are CRC-32C.
+const (
+	columnarMagic      = "VJCOLIX1"
+	columnarHeaderSize = 64
+	columnarChunkRows  = 1024
+)
+
+var columnarCRC = crc32.MakeTable(crc32.Castagnoli)
+
+// Save writes the index to path in a format, replacing any file there only
+// once the new one is complete
+func (vi *VerseIndex) Save(path, format string) error {
+	switch format {
+	case FormatGob:
+		return vi.SaveToGob(path)
+	case FormatColumnar:
+		return vi.SaveColumnar(path)
+	}
+	return fmt.Errorf("unknown index format %q", format)
+}
+
+// Load reads an index in either format, telling them apart by content
+func Load(path string) (*VerseIndex, error) {
+	file, err := os.Open(path)
+	if err != nil {
+		return nil, fmt.Errorf("failed to open index file: %w", err)
+	}
+	magic := make([]byte, len(columnarMagic))
+	_, err = io.ReadFull(file, magic)
+	file.Close()
+	if err == nil && string(magic) == columnarMagic {
+		return LoadColumnar(path)
+	}
+	return LoadFromGob(path)
+}
+
+// SaveColumnar writes the index in the columnar layout
+func (vi *VerseIndex) SaveColumnar(path string) error {
+	count, dim := len(vi.Verses), vi.Dimension()
+	var idEnds, refEnds, textEnds []uint32
+	var idLen, refLen, textLen int
+	for i := range vi.Verses {
+		verse := &vi.Verses[i]
+		if len(verse.Embedding) != dim {
+			return fmt.Errorf("verse %s has %d dimensions, expected %d", verse.ID, len(verse.Embedding), dim)
+		}
+		if i > 0 {
+			textLen++
+		}
+		idLen += len(verse.ID)
+		refLen += len(verse.Ref)
+		textLen += len(verse.Text)
+		idEnds = append(idEnds, uint32(idLen))
+		refEnds = append(refEnds, uint32(refLen))
+		textEnds = append(textEnds, uint32(textLen))
+	}
+	if idLen+refLen+textLen > math.MaxUint32 {
+		return fmt.Errorf("index strings exceed the columnar layout")
+	}
+
+	strs := make([]byte, 0, 12*count+idLen+refLen+textLen)
+	for _, ends := range [][]uint32{idEnds, refEnds, textEnds} {
+		for _, end := range ends {
+			strs = binary.LittleEndian.AppendUint32(strs, end)
+		}
+	}
+	for i := range vi.Verses {
+		strs = append(strs, vi.Verses[i].ID...)
+	}
+	for i := range vi.Verses {
+		strs = append(strs, vi.Verses[i].Ref...)
+	}
+	for i := range vi.Verses {
+		if i > 0 {
+			strs = append(strs, ' ')
+		}
+		strs = append(strs, vi.Verses[i].Text...)
+	}
+
+	chunks := (count + columnarChunkRows - 1) / columnarChunkRows
+	chunkCRCs := make([]uint32, chunks)
+	rowBytes := make([]byte, dim*4)
+	for chunk := range chunkCRCs {
+		crc := uint32(0)
+		for row := chunk * columnarChunkRows; row < min(count, (chunk+1)*columnarChunkRows); row++ {
+			crc = crc32.Update(crc, columnarCRC, appendFloats(rowBytes[:0], vi.Verses[row].Embedding))
+		}
+		chunkCRCs[chunk] = crc
+	}
+
+	var related []byte
+	relatedN := 0
+	if table := vi.Related; table != nil {
+		if len(table.IDs) != count*table.N || len(table.Scores) != count*table.N {
+			return fmt.Errorf("related table does not match the verses")
+		}
+		relatedN = table.N
+		related = make([]byte, 0, len(table.IDs)*6)
+		for _, id := range table.IDs {
+			related = binary.LittleEndian.AppendUint32(related, uint32(id))
+		}
+		for _, score := range table.Scores {
+			related = binary.LittleEndian.AppendUint16(related, score)
+		}
+	}
+
+	header := make([]byte, columnarHeaderSize)
+	copy(header, columnarMagic)
+	binary.LittleEndian.PutUint32(header[8:], uint32(count))
+	binary.LittleEndian.PutUint32(header[12:], uint32(dim))
+	binary.LittleEndian.PutUint32(header[16:], columnarChunkRows)
+	binary.LittleEndian.PutUint32(header[20:], uint32(relatedN))
+	binary.LittleEndian.PutUint64(header[24:], uint64(len(strs)))
+	binary.LittleEndian.PutUint32(header[32:], crc32.Checksum(strs, columnarCRC))
+	binary.LittleEndian.PutUint32(header[36:], crc32.Checksum(related, columnarCRC))
+
+	// Write beside the target and rename, so a reload never sees half a file
+	temp, err := os.CreateTemp(filepath.Dir(path), filepath.Base(path)+".*.tmp")
+	if err != nil {
+		return fmt.Errorf("failed to create index file: %w", err)
+	}
+	defer os.Remove(temp.Name())
+	w := bufio.NewWriterSize(temp, 1<<20)
+	w.Write(header)
+	for _, crc := range chunkCRCs {
+		w.Write(binary.LittleEndian.AppendUint32(nil, crc))
+	}
+	w.Write(strs)
+	for i := range vi.Verses {
+		w.Write(appendFloats(rowBytes[:0], vi.Verses[i].Embedding))
+	}
+	w.Write(related)
+	err = w.Flush()
+	if err == nil {
+		err = temp.Sync()
+	}
+	if closeErr := temp.Close(); err == nil {
+		err = closeErr
+	}
+	if err == nil {
+		err = os.Rename(temp.Name(), path)
+	}
+	if err != nil {
+		return fmt.Errorf("failed to write index file: %w", err)
+	}
+	return nil
+}
+
+func appendFloats(buf []byte, values []float32) []byte {
+	for _, v := range values {
+		buf = binary.LittleEndian.AppendUint32(buf, math.Float32bits(v))
+	}
+	return buf
+}
+
+// LoadColumnar reads an index in the columnar layout. The file is mapped
+// rather than read; all embeddings are decoded into one block, by chunk in
+// parallel, and all strings share one allocation that also backs the text
+// arena.
+func LoadColumnar(path string) (*VerseIndex, error) {
+	mapped, err := mmap.Open(path, 0, false)
+	if err != nil {
+		return nil, fmt.Errorf("failed to open index file: %w", err)
+	}
+	defer mapped.Close()
+	vi, err := decodeColumnar(mapped.Bytes())
+	if err != nil {
+		return nil, fmt.Errorf("failed to decode %s: %w", path, err)
+	}
+	vi.prepare()
+	return vi, nil
+}
+
+func decodeColumnar(data []byte) (*VerseIndex, error) {
+	if len(data) < columnarHeaderSize || string(data[:len(columnarMagic)]) != columnarMagic {
+		return nil, fmt.Errorf("not a columnar index")
+	}
+	count := int(binary.LittleEndian.Uint32(data[8:]))
+	dim := int(binary.LittleEndian.Uint32(data[12:]))
+	chunkRows := int(binary.LittleEndian.Uint32(data[16:]))
+	relatedN := int(binary.LittleEndian.Uint32(data[20:]))
+	stringsLen := binary.LittleEndian.Uint64(data[24:])
+	if chunkRows <= 0 || uint64(count)*12 > stringsLen || stringsLen > uint64(len(data)) {
+		return nil, fmt.Errorf("corrupt header")
+	}
+	chunks := (count + chunkRows - 1) / chunkRows
+	stringsStart := uint64(columnarHeaderSize + chunks*4)
+	embeddingsStart := stringsStart + stringsLen
+	relatedStart := embeddingsStart + uint64(count)*uint64(dim)*4
+	if relatedStart+uint64(count)*uint64(relatedN)*6 != uint64(len(data)) {
+		return nil, fmt.Errorf("file is %d bytes, header describes %d", len(data), relatedStart+uint64(count)*uint64(relatedN)*6)
+	}
+
+	strs := data[stringsStart:embeddingsStart]
+	if crc32.Checksum(strs, columnarCRC) != binary.LittleEndian.Uint32(data[32:]) {
+		return nil, fmt.Errorf("strings fail their checksum")
+	}
+	related := data[relatedStart:]
+	if crc32.Checksum(related, columnarCRC) != binary.LittleEndian.Uint32(data[36:]) {
+		return nil, fmt.Errorf("related verses fail their checksum")
+	}
+
+	// One copy of every string; IDs, references and texts are substrings
+	ends := func(column int) []uint32 {
+		out := make([]uint32, count)
+		for i := range out {
+			out[i] = binary.LittleEndian.Uint32(strs[(column*count+i)*4:])
+		}
+		return out
+	}
+	idEnds, refEnds, textEnds := ends(0), ends(1), ends(2)
+	all := string(strs[count*12:])
+	idLen, refLen := 0, 0
+	if count > 0 {
+		idLen, refLen = int(idEnds[count-1]), int(refEnds[count-1])
+	}
+	if idLen+refLen > len(all) {
+		return nil, fmt.Errorf("corrupt string offsets")
+	}
+	ids, refs, texts := all[:idLen], all[idLen:idLen+refLen], all[idLen+refLen:]
+
+	vi := NewVerseIndex()
+	vi.Verses = make([]Verse, count)
+	arena := &textArena{text: texts, starts: make([]uint32, count), ends: textEnds, bookEnd: make([]int32, count)}
+	var idStart, refStart uint32
+	for i := range vi.Verses {
+		textStart := uint32(0)
+		if i > 0 {
+			textStart = textEnds[i-1] + 1
+		}
+		if idEnds[i] < idStart || int(idEnds[i]) > len(ids) || refEnds[i] < refStart || int(refEnds[i]) > len(refs) ||
+			textEnds[i] < textStart || int(textEnds[i]) > len(texts) {
+			return nil, fmt.Errorf("corrupt string offsets at row %d", i)
+		}
+		arena.starts[i] = textStart
+		vi.Verses[i] = Verse{
+			ID:   ids[idStart:idEnds[i]],
+			Ref:  refs[refStart:refEnds[i]],
+			Text: texts[textStart:textEnds[i]],
+		}
+		idStart, refStart = idEnds[i], refEnds[i]
+	}
+	arena.markBooks(vi.Verses)
+	vi.arena.Store(arena)
+
+	block := make([]float32, count*dim)
+	var wg sync.WaitGroup
+	errs := make([]error, chunks)
+	next := make(chan int, chunks)
+	for chunk := 0; chunk < chunks; chunk++ {
+		next <- chunk
+	}
+	close(next)
+	for w := 0; w < min(chunks, runtime.GOMAXPROCS(0)); w++ {
+		wg.Add(1)
+		go func() {
+			defer wg.Done()
+			for chunk := range next {
+				first, last := chunk*chunkRows, min(count, (chunk+1)*chunkRows)
+				raw := data[embeddingsStart+uint64(first*dim*4) : embeddingsStart+uint64(last*dim*4)]
+				if crc32.Checksum(raw, columnarCRC) != binary.LittleEndian.Uint32(data[columnarHeaderSize+chunk*4:]) {
+					errs[chunk] = fmt.Errorf("embedding chunk %d fails its checksum", chunk)
+					continue
+				}
+				values := block[first*dim : last*dim]
+				for i := range values {
+					values[i] = math.Float32frombits(binary.LittleEndian.Uint32(raw[i*4:]))
+				}
+			}
+		}()
+	}
+	wg.Wait()
+	for _, err := range errs {
+		if err != nil {
+			return nil, err
+		}
+	}
+	for i := range vi.Verses {
+		vi.Verses[i].Embedding = block[i*dim : (i+1)*dim : (i+1)*dim]
+	}
+
+	if relatedN > 0 {
+		table := &RelatedTable{N: relatedN, IDs: make([]int32, count*relatedN), Scores: make([]uint16, count*relatedN)}
+		for i := range table.IDs {
+			table.IDs[i] = int32(binary.LittleEndian.Uint32(related[i*4:]))
+		}
+		scores := related[len(table.IDs)*4:]
+		for i := range table.Scores {
+			table.Scores[i] = binary.LittleEndian.Uint16(scores[i*2:])
+		}
+		vi.Related = table
+	}
+	return vi, nil
+}
@@ -0,0 +1,109 @@
+package index
+
+import (
+	"os"
+	"path/filepath"
+	"reflect"
+	"testing"
+)
+
+func TestColumnar_RoundTrip(t *testing.T) {
+	// More rows than one chunk, and not a multiple of it
+	verseIndex := randomIndex(2*columnarChunkRows+37, 13, 7)
+	for i := range verseIndex.Verses {
+		verseIndex.Verses[i].Text = verseIndex.Verses[i].Ref + " text"
+	}
+	if err := verseIndex.BuildRelated(4, 1); err != nil {
+		t.Fatalf("BuildRelated failed: %v", err)
+	}
+	path := filepath.Join(t.TempDir(), "index.bin")
+	if err := verseIndex.Save(path, FormatColumnar); err != nil {
+		t.Fatalf("Save failed: %v", err)
+	}
+
+	loaded, err := Load(path)
+	if err != nil {
+		t.Fatalf("Load failed: %v", err)
+	}
+	if !reflect.DeepEqual(loaded.Verses, verseIndex.Verses) {
+		t.Error("Expected the loaded verses to equal the saved ones")
+	}
+	if !reflect.DeepEqual(loaded.Related, verseIndex.Related) {
+		t.Error("Expected the related table to survive the round trip")
+	}
+	if verse, ok := loaded.GetByID("TST.1500.1"); !ok || verse.Ref != "Test 1500:1" {
+		t.Errorf("Expected lookups to be built at load, got %v, %v", verse, ok)
+	}
+	if got := loaded.Context(1500, 2); got != "Test 1501:1 text Test 1502:1 text" {
+		t.Errorf("Unexpected context after load: %q", got)
+	}
+	results, err := loaded.Search(verseIndex.Verses[2000].Embedding, 1)
+	if err != nil || len(results) != 1 || results[0].Verse.ID != "TST.2000.1" {
+		t.Errorf("Expected a verse to find itself after load, got %v, %v", results, err)
+	}
+}
+
+func TestLoad_DetectsFormat(t *testing.T) {
+	verseIndex := contextTestIndex()
+	for i := range verseIndex.Verses {
+		verseIndex.Verses[i].Embedding = []float32{float32(i), 1}
+	}
+	dir := t.TempDir()
+	for _, format := range []string{FormatGob, FormatColumnar} {
+		path := filepath.Join(dir, "index."+format)
+		if err := verseIndex.Save(path, format); err != nil {
+			t.Fatalf("Save %s failed: %v", format, err)
+		}
+		loaded, err := Load(path)
+		if err != nil {
+			t.Fatalf("Load %s failed: %v", format, err)
+		}
+		if !reflect.DeepEqual(loaded.Verses, verseIndex.Verses) {
+			t.Errorf("Expected %s verses to round trip", format)
+		}
+		if got := loaded.Context(0, 5); got != "And he shall turn the heart of the fathers to the children" {
+			t.Errorf("Unexpected %s context after load: %q", format, got)
+		}
+	}
+	if err := verseIndex.Save(filepath.Join(dir, "index"), "json"); err == nil {
+		t.Error("Expected an unknown format to be refused")
+	}
+
+	empty := NewVerseIndex()
+	path := filepath.Join(dir, "empty")
+	if err := empty.SaveColumnar(path); err != nil {
+		t.Fatalf("SaveColumnar of an empty index failed: %v", err)
+	}
+	if loaded, err := Load(path); err != nil || len(loaded.Verses) != 0 {
+		t.Errorf("Expected an empty index to round trip, got %v", err)
+	}
+}
+
+func TestLoadColumnar_RejectsDamage(t *testing.T) {
+	verseIndex := randomIndex(50, 8, 3)
+	path := filepath.Join(t.TempDir(), "index.bin")
+	if err := verseIndex.SaveColumnar(path); err != nil {
+		t.Fatalf("SaveColumnar failed: %v", err)
+	}
+	data, err := os.ReadFile(path)
+	if err != nil {
+		t.Fatal(err)
+	}
+
+	for name, damaged := range map[string][]byte{
+		"truncated":         data[:len(data)-1],
+		"header only":       data[:columnarHeaderSize],
+		"flipped string":    flipped(data, columnarHeaderSize+4+50*12+3),
+		"flipped embedding": flipped(data, len(data)-5),
+	} {
+		if _, err := decodeColumnar(damaged); err == nil {
+			t.Errorf("%s: expected the file to be refused", name)
+		}
+	}
+}
+
+func flipped(data []byte, at int) []byte {
+	out := append([]byte(nil), data...)
+	out[at] ^= 0x40
+	return out
+}
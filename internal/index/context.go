@@ -0,0 +1,110 @@
+package index
+
+import "strings"
+
+// DefaultContextVerses is the number of following verses returned as context
+// when a caller does not ask for a specific window
+const DefaultContextVerses = 5
+
+// MaxContextVerses bounds a requested context window
+const MaxContextVerses = 20
+
+// textArena stores every verse's text back to back, in index order and
+// separated by single spaces, so the text of consecutive verses is one
+// contiguous substring
+type textArena struct {
+	text    string
+	starts  []uint32 // verse i's text is text[starts[i]:ends[i]]
+	ends    []uint32
+	bookEnd []int32 // one past the last row of the verse's book
+}
+
+func newTextArena(verses []Verse) *textArena {
+	size := 0
+	for i := range verses {
+		size += len(verses[i].Text) + 1
+	}
+	var sb strings.Builder
+	sb.Grow(size)
+	a := &textArena{
+		starts:  make([]uint32, len(verses)),
+		ends:    make([]uint32, len(verses)),
+		bookEnd: make([]int32, len(verses)),
+	}
+	for i := range verses {
+		if i > 0 {
+			sb.WriteByte(' ')
+		}
+		a.starts[i] = uint32(sb.Len())
+		sb.WriteString(verses[i].Text)
+		a.ends[i] = uint32(sb.Len())
+	}
+	a.text = sb.String()
+	a.markBooks(verses)
+	return a
+}
+
+// markBooks records where each verse's book ends
+func (a *textArena) markBooks(verses []Verse) {
+	end := len(verses)
+	for i := len(verses) - 1; i >= 0; i-- {
+		if i+1 < len(verses) && bookOf(verses[i].ID) != bookOf(verses[i+1].ID) {
+			end = i + 1
+		}
+		a.bookEnd[i] = int32(end)
+	}
+}
+
+// bookOf returns the book code of a verse ID such as "GEN.1.1"
+func bookOf(id string) string {
+	if dot := strings.IndexByte(id, '.'); dot >= 0 {
+		return id[:dot]
+	}
+	return id
+}
+
+// compactText builds the text arena and points every Verse.Text into it,
+// releasing the individually allocated strings. The legacy NextFive copies
+// are dropped; context is served from the arena instead.
+func (vi *VerseIndex) compactText() {
+	a := newTextArena(vi.Verses)
+	for i := range vi.Verses {
+		vi.Verses[i].Text = a.text[a.starts[i]:a.ends[i]]
+		vi.Verses[i].NextFive = ""
+	}
+	vi.arena.Store(a)
+}
+
+func (vi *VerseIndex) textArena() *textArena {
+	if a := vi.arena.Load(); a != nil {
+		return a
+	}
+	a := newTextArena(vi.Verses)
+	vi.arena.CompareAndSwap(nil, a)
+	return vi.arena.Load()
+}
+
+// ContextSpan returns the rows [start, end) of up to window verses that
+// follow the verse at position within the same book
+func (vi *VerseIndex) ContextSpan(position, window int) (start, end int) {
+	if position < 0 || position >= len(vi.Verses) || window <= 0 {
+		return 0, 0
+	}
+	window = min(window, MaxContextVerses)
+	end = min(position+1+window, int(vi.textArena().bookEnd[position]))
+	if end <= position+1 {
+		return 0, 0
+	}
+	return position + 1, end
+}
+
+// Context returns the text of up to window verses that follow the verse at
+// position within the same book, as a slice of the text arena (no copying)
+func (vi *VerseIndex) Context(position, window int) string {
+	start, end := vi.ContextSpan(position, window)
+	if start == end {
+		return ""
+	}
+	a := vi.textArena()
+	return a.text[a.starts[start]:a.ends[end-1]]
+}
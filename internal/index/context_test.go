@@ -0,0 +1,71 @@
+package index
+
+import (
+	"path/filepath"
+	"testing"
+)
+
+func contextTestIndex() *VerseIndex {
+	verseIndex := NewVerseIndex()
+	for _, verse := range []Verse{
+		{ID: "MAL.4.5", Text: "Behold, I will send you Elijah the prophet"},
+		{ID: "MAL.4.6", Text: "And he shall turn the heart of the fathers to the children"},
+		{ID: "MAT.1.1", Text: "The book of the generation of Jesus Christ"},
+		{ID: "MAT.1.2", Text: "Abraham begat Isaac;"},
+		{ID: "MAT.1.3", Text: "And Judas begat Phares and Zara of Thamar;"},
+	} {
+		verseIndex.AddVerse(verse)
+	}
+	return verseIndex
+}
+
+func TestContext(t *testing.T) {
+	verseIndex := contextTestIndex()
+
+	tests := []struct {
+		position, window int
+		expected         string
+	}{
+		{2, 2, "Abraham begat Isaac; And Judas begat Phares and Zara of Thamar;"},
+		{2, 1, "Abraham begat Isaac;"},
+		{2, 5, "Abraham begat Isaac; And Judas begat Phares and Zara of Thamar;"},
+		{0, 5, "And he shall turn the heart of the fathers to the children"}, // stops at the book boundary
+		{1, 5, ""},
+		{4, 5, ""},
+		{2, 0, ""},
+	}
+	for _, tt := range tests {
+		if got := verseIndex.Context(tt.position, tt.window); got != tt.expected {
+			t.Errorf("Context(%d, %d): expected %q, got %q", tt.position, tt.window, tt.expected, got)
+		}
+	}
+
+	// Adding a verse extends the arena
+	verseIndex.AddVerse(Verse{ID: "MAT.1.4", Text: "And Phares begat Esrom;"})
+	if got := verseIndex.Context(4, 1); got != "And Phares begat Esrom;" {
+		t.Errorf("Expected context to include the added verse, got %q", got)
+	}
+}
+
+func TestLoadFromGob_CompactsText(t *testing.T) {
+	verseIndex := contextTestIndex()
+	verseIndex.Verses[2].NextFive = "Abraham begat Isaac; And Judas begat Phares and Zara of Thamar;"
+	path := filepath.Join(t.TempDir(), "index.gob")
+	if err := verseIndex.SaveToGob(path); err != nil {
+		t.Fatalf("SaveToGob failed: %v", err)
+	}
+
+	loaded, err := LoadFromGob(path)
+	if err != nil {
+		t.Fatalf("LoadFromGob failed: %v", err)
+	}
+	if loaded.Verses[2].NextFive != "" {
+		t.Error("Expected legacy NextFive to be dropped at load")
+	}
+	if got := loaded.Context(2, 5); got != "Abraham begat Isaac; And Judas begat Phares and Zara of Thamar;" {
+		t.Errorf("Unexpected context after load: %q", got)
+	}
+	if loaded.Verses[3].Text != "Abraham begat Isaac;" {
+		t.Errorf("Expected verse text to survive compaction, got %q", loaded.Verses[3].Text)
+	}
+}
@@ -0,0 +1,94 @@
+package index
+
+import (
+	"fmt"
+	"sync"
+	"unsafe"
+)
+
+// SearchCursor pages through the best matches at or above the similarity
+// threshold for one query, best first. The matches are scored once by the
+// search kernel when the cursor is opened, up to a limit, so no page
+// re-scores the index.
+type SearchCursor struct {
+	mu       sync.Mutex
+	vi       *VerseIndex
+	verses   []*Verse    // the matched rows of a SegmentedIndex, nil for vi's
+	matches  []scoredRow // best first
+	returned int
+}
+
+// OpenCursor scores every verse against the query and returns a cursor over
+// the limit best matches
+func (vi *VerseIndex) OpenCursor(queryEmbedding []float32, limit int) (*SearchCursor, error) {
+	if _, err := unitQuery(queryEmbedding, vi.Dimension()); err != nil {
+		return nil, err
+	}
+	if limit <= 0 {
+		return nil, fmt.Errorf("limit must be positive")
+	}
+	limit = min(limit, len(vi.Verses))
+	if limit == 0 {
+		return &SearchCursor{vi: vi}, nil
+	}
+
+	var matches []scoredRow
+	var err error
+	matrix, release := vi.acquireMatrix()
+	defer release()
+	if matrix != nil {
+		matches, err = scanMatrix(matrix, vi.embedding, queryEmbedding, limit, minSimilarity, nil)
+	} else {
+		embeddings := make([][]float32, len(vi.Verses))
+		for i := range vi.Verses {
+			embeddings[i] = vi.Verses[i].Embedding
+		}
+		matches, err = scanEmbeddings(embeddings, queryEmbedding, limit, minSimilarity, nil)
+	}
+	if err != nil {
+		return nil, err
+	}
+	return &SearchCursor{vi: vi, matches: matches}, nil
+}
+
+// Next returns up to k more results, continuing where the last page ended
+func (c *SearchCursor) Next(k int) ([]SearchResult, error) {
+	if k <= 0 {
+		return nil, fmt.Errorf("k must be positive")
+	}
+	c.mu.Lock()
+	defer c.mu.Unlock()
+
+	page := c.matches[c.returned:min(c.returned+k, len(c.matches))]
+	results := make([]SearchResult, len(page))
+	for i, s := range page {
+		if c.verses != nil {
+			results[i] = SearchResult{Verse: c.verses[s.row], Score: s.score, Position: -1}
+			continue
+		}
+		results[i] = SearchResult{Verse: &c.vi.Verses[s.row], Score: s.score, Position: s.row}
+	}
+	c.returned += len(results)
+	return results, nil
+}
+
+// Remaining reports how many matches have not been returned yet
+func (c *SearchCursor) Remaining() int {
+	c.mu.Lock()
+	defer c.mu.Unlock()
+	return len(c.matches) - c.returned
+}
+
+// Returned reports how many matches earlier pages returned
+func (c *SearchCursor) Returned() int {
+	c.mu.Lock()
+	defer c.mu.Unlock()
+	return c.returned
+}
+
+// Bytes reports the memory the cursor holds for its matches
+func (c *SearchCursor) Bytes() int {
+	c.mu.Lock()
+	defer c.mu.Unlock()
+	return cap(c.matches)*int(unsafe.Sizeof(scoredRow{})) + cap(c.verses)*int(unsafe.Sizeof(&Verse{}))
+}
@@ -0,0 +1,108 @@
+package index
+
+import (
+	"fmt"
+	"math/rand"
+	"testing"
+)
+
+func TestSearchCursor_PagesMatchFullRanking(t *testing.T) {
+	// Verses scattered around one direction, so hundreds match the query
+	rng := rand.New(rand.NewSource(13))
+	const dim = 32
+	query := make([]float32, dim)
+	for d := range query {
+		query[d] = float32(rng.NormFloat64())
+	}
+	verseIndex := NewVerseIndex()
+	for i := 0; i < 400; i++ {
+		embedding := make([]float32, dim)
+		for d := range embedding {
+			embedding[d] = query[d] + float32(rng.NormFloat64())
+		}
+		verseIndex.AddVerse(Verse{ID: fmt.Sprintf("B.1.%d", i+1), Ref: fmt.Sprintf("Book 1:%d", i+1), Embedding: embedding})
+	}
+
+	first, err := verseIndex.Search(query, 50)
+	if err != nil {
+		t.Fatalf("Search failed: %v", err)
+	}
+	cursor, err := verseIndex.OpenCursor(query, len(verseIndex.Verses))
+	if err != nil {
+		t.Fatalf("OpenCursor failed: %v", err)
+	}
+	total := cursor.Remaining()
+	if total <= 50 {
+		t.Fatalf("Expected more than one full page of matches, got %d", total)
+	}
+
+	var paged []SearchResult
+	for cursor.Remaining() > 0 {
+		page, err := cursor.Next(7)
+		if err != nil {
+			t.Fatalf("Next failed: %v", err)
+		}
+		if len(page) == 0 || len(page) > 7 {
+			t.Fatalf("Expected 1 to 7 results, got %d", len(page))
+		}
+		paged = append(paged, page...)
+	}
+	if len(paged) != total || cursor.Returned() != total {
+		t.Fatalf("Expected %d results over all pages, got %d", total, len(paged))
+	}
+	for i := range paged {
+		if i > 0 && paged[i].Score > paged[i-1].Score {
+			t.Fatalf("Result %d scores %g after %g", i, paged[i].Score, paged[i-1].Score)
+		}
+		if paged[i].Score < minSimilarity || paged[i].Verse.ID != verseIndex.Verses[paged[i].Position].ID {
+			t.Fatalf("Unexpected result %+v", paged[i])
+		}
+	}
+	// The pages continue the single-shot ranking
+	for i := range first {
+		if paged[i].Position != first[i].Position {
+			t.Errorf("Result %d: expected %s, got %s", i, first[i].Verse.ID, paged[i].Verse.ID)
+		}
+	}
+
+	if page, _ := cursor.Next(5); len(page) != 0 {
+		t.Errorf("Expected an exhausted cursor to return nothing, got %d", len(page))
+	}
+	if _, err := cursor.Next(0); err == nil {
+		t.Error("Expected an error for k 0")
+	}
+}
+
+func TestSearchCursor_KeepsLimitBestMatches(t *testing.T) {
+	verseIndex := randomIndex(300, 8, 21)
+	query := verseIndex.Verses[17].Embedding
+
+	all, err := verseIndex.OpenCursor(query, len(verseIndex.Verses))
+	if err != nil {
+		t.Fatalf("OpenCursor failed: %v", err)
+	}
+	if all.Remaining() <= 20 {
+		t.Fatalf("Expected more than 20 matches, got %d", all.Remaining())
+	}
+	limited, err := verseIndex.OpenCursor(query, 20)
+	if err != nil {
+		t.Fatalf("OpenCursor failed: %v", err)
+	}
+	if limited.Remaining() != 20 || limited.Bytes() >= all.Bytes() {
+		t.Fatalf("Expected 20 matches held in less memory, got %d in %d bytes", limited.Remaining(), limited.Bytes())
+	}
+	best, _ := all.Next(20)
+	kept, _ := limited.Next(50)
+	if len(kept) != 20 || kept[0].Position != 17 {
+		t.Fatalf("Expected the query's own verse first of 20, got %d results", len(kept))
+	}
+	for i := range kept {
+		if kept[i].Position != best[i].Position {
+			t.Errorf("Rank %d: expected row %d, got %d", i, best[i].Position, kept[i].Position)
+		}
+	}
+
+	if _, err := verseIndex.OpenCursor(query, 0); err == nil {
+		t.Error("Expected an error for limit 0")
+	}
+}
@@ -0,0 +1,110 @@
+package index
+
+import "math"
+
+// Testament names reported in facets
+const (
+	OldTestament = "Old Testament"
+	NewTestament = "New Testament"
+)
+
+// newTestamentBooks names the New Testament books as they appear in verse
+// references; every other book counts toward the Old Testament
+var newTestamentBooks = map[string]bool{
+	"Matthew": true, "Mark": true, "Luke": true, "John": true, "Acts": true,
+	"Romans": true, "1 Corinthians": true, "2 Corinthians": true, "Galatians": true,
+	"Ephesians": true, "Philippians": true, "Colossians": true,
+	"1 Thessalonians": true, "2 Thessalonians": true, "1 Timothy": true,
+	"2 Timothy": true, "Titus": true, "Philemon": true, "Hebrews": true,
+	"James": true, "1 Peter": true, "2 Peter": true, "1 John": true,
+	"2 John": true, "3 John": true, "Jude": true, "Revelation": true,
+}
+
+// Facet counts the verses of one book or testament at or above the search
+// similarity threshold, and the best score among them
+type Facet struct {
+	Name     string  `json:"name"`
+	Count    int     `json:"count"`
+	MaxScore float32 `json:"max_score"`
+}
+
+// Facets break down every verse a search matched, not only those returned.
+// Books are listed in index order and testaments Old before New; groups
+// without matches are left out.
+type Facets struct {
+	Books      []Facet `json:"books"`
+	Testaments []Facet `json:"testaments"`
+}
+
+// groupTally accumulates, during a scan, the matches and best score of
+// each group of rows
+type groupTally struct {
+	groups    []int32 // group of each row
+	counts    []int32
+	maxScores []float32
+}
+
+func newGroupTally(groups []int32, groupCount int) *groupTally {
+	t := &groupTally{
+		groups:    groups,
+		counts:    make([]int32, groupCount),
+		maxScores: make([]float32, groupCount),
+	}
+	t.reset()
+	return t
+}
+
+func (t *groupTally) reset() {
+	for i := range t.counts {
+		t.counts[i] = 0
+		t.maxScores[i] = -math.MaxFloat32
+	}
+}
+
+func (t *groupTally) add(row int, score float32) {
+	group := t.groups[row]
+	t.counts[group]++
+	t.maxScores[group] = max(t.maxScores[group], score)
+}
+
+// SearchWithFacets is Search that also counts the matching verses of every
+// book and testament. The counts are gathered by the search kernel in the
+// same pass over the embeddings, so they cover all matches although at most
+// k verses are returned.
+func (vi *VerseIndex) SearchWithFacets(queryEmbedding []float32, k int) ([]SearchResult, *Facets, error) {
+	h := vi.hierarchy()
+	tally := newGroupTally(h.rowBook, len(h.books))
+	if len(h.books) == 0 {
+		tally = nil
+	}
+	results, err := vi.search(queryEmbedding, k, tally)
+	if err != nil {
+		return nil, nil, err
+	}
+
+	facets := &Facets{Books: []Facet{}, Testaments: []Facet{}}
+	if tally == nil {
+		return results, facets, nil
+	}
+	testaments := [2]Facet{{Name: OldTestament, MaxScore: -math.MaxFloat32}, {Name: NewTestament, MaxScore: -math.MaxFloat32}}
+	for book, count := range tally.counts {
+		if count == 0 {
+			continue
+		}
+		facet := Facet{Name: h.books[book].ref, Count: int(count), MaxScore: tally.maxScores[book]}
+		facets.Books = append(facets.Books, facet)
+
+		testament := &testaments[0]
+		if newTestamentBooks[facet.Name] {
+			testament = &testaments[1]
+		}
+		testament.Count += facet.Count
+		testament.MaxScore = max(testament.MaxScore, facet.MaxScore)
+	}
+	for _, testament := range testaments {
+		if testament.Count > 0 {
+			facets.Testaments = append(facets.Testaments, testament)
+		}
+	}
+	return results, facets, nil
+}
@@ -0,0 +1,84 @@
+package index
+
+import (
+	"math/rand"
+	"testing"
+)
+
+func TestSearchWithFacets_CountsEveryMatch(t *testing.T) {
+	rng := rand.New(rand.NewSource(11))
+	verseIndex := hierarchyTestIndex(rng, 32)
+	query := verseIndex.Verses[230].Embedding
+
+	results, facets, err := verseIndex.SearchWithFacets(query, 1)
+	if err != nil {
+		t.Fatalf("SearchWithFacets failed: %v", err)
+	}
+	if len(results) != 1 || results[0].Position != 230 {
+		t.Fatalf("Expected the query verse alone, got %v", resultIDs(results))
+	}
+
+	// Tally the matches directly
+	expected := make(map[string]int)
+	best := make(map[string]float32)
+	total := 0
+	for _, verse := range verseIndex.Verses {
+		if score := cosineSimilarity(query, verse.Embedding); score >= minSimilarity {
+			book := verse.Ref[:len("Book 0")]
+			expected[book]++
+			best[book] = max(best[book], score)
+			total++
+		}
+	}
+	if total < 20 {
+		t.Fatalf("Expected a chapter's worth of matches, got %d", total)
+	}
+	if len(facets.Books) != len(expected) {
+		t.Fatalf("Expected %d books, got %+v", len(expected), facets.Books)
+	}
+	for _, facet := range facets.Books {
+		if facet.Count != expected[facet.Name] || facet.MaxScore < best[facet.Name]-1e-5 || facet.MaxScore > best[facet.Name]+1e-5 {
+			t.Errorf("%s: expected %d matches scoring up to %g, got %+v", facet.Name, expected[facet.Name], best[facet.Name], facet)
+		}
+	}
+	if len(facets.Testaments) != 1 || facets.Testaments[0].Name != OldTestament || facets.Testaments[0].Count != total {
+		t.Errorf("Expected all %d matches in the Old Testament, got %+v", total, facets.Testaments)
+	}
+}
+
+func TestSearchWithFacets_Testaments(t *testing.T) {
+	verseIndex := NewVerseIndex()
+	for _, verse := range []Verse{
+		{ID: "GEN.1.1", Ref: "Genesis 1:1", Embedding: []float32{1, 0, 0}},
+		{ID: "GEN.1.2", Ref: "Genesis 1:2", Embedding: []float32{0, 1, 0}},
+		{ID: "PSA.23.1", Ref: "Psalms 23:1", Embedding: []float32{0.9, 0.1, 0}},
+		{ID: "JOH.1.1", Ref: "John 1:1", Embedding: []float32{1, 0.1, 0}},
+		{ID: "1JO.4.8", Ref: "1 John 4:8", Embedding: []float32{0.8, 0, 0.3}},
+	} {
+		verseIndex.AddVerse(verse)
+	}
+
+	_, facets, err := verseIndex.SearchWithFacets([]float32{1, 0, 0}, 2)
+	if err != nil {
+		t.Fatalf("SearchWithFacets failed: %v", err)
+	}
+	books := map[string]int{}
+	for _, facet := range facets.Books {
+		books[facet.Name] = facet.Count
+	}
+	if len(books) != 4 || books["Genesis"] != 1 || books["1 John"] != 1 {
+		t.Errorf("Expected one match in each of 4 books, got %+v", facets.Books)
+	}
+	if len(facets.Testaments) != 2 || facets.Testaments[0].Count != 2 || facets.Testaments[1].Name != NewTestament || facets.Testaments[1].Count != 2 {
+		t.Errorf("Expected 2 Old and 2 New Testament matches, got %+v", facets.Testaments)
+	}
+	if facets.Testaments[0].MaxScore != 1 {
+		t.Errorf("Expected the Old Testament's best score to be 1, got %g", facets.Testaments[0].MaxScore)
+	}
+
+	// No matches gives empty facets, not an error
+	results, facets, err := verseIndex.SearchWithFacets([]float32{0, 0, -1}, 5)
+	if err != nil || len(results) != 0 || len(facets.Books) != 0 || len(facets.Testaments) != 0 {
+		t.Errorf("Expected no matches, got %d results, %+v, %v", len(results), facets, err)
+	}
+}
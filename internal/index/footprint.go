@@ -0,0 +1,70 @@
+package index
+
+import "unsafe"
+
+// Approximate per-entry costs of Go values the footprint cannot measure
+// directly
+const (
+	mapEntryBytes = 48 // key header, value and bucket overhead
+	stringBytes   = int64(unsafe.Sizeof(""))
+)
+
+// MemoryFootprint estimates the bytes held by the index: verses and their
+// embeddings, the related table, passages, and whichever lookup, lexical,
+// autocomplete, centroid and embedding matrix structures have been built so
+// far. It is meant for budgeting several loaded indexes against each other,
+// not for exact accounting.
+func (vi *VerseIndex) MemoryFootprint() int64 {
+	size := int64(len(vi.Verses)) * int64(unsafe.Sizeof(Verse{}))
+	arena := vi.arena.Load()
+	for i := range vi.Verses {
+		v := &vi.Verses[i]
+		size += int64(len(v.ID) + len(v.Ref) + len(v.NextFive) + 4*len(v.Embedding))
+		if arena == nil {
+			size += int64(len(v.Text))
+		}
+	}
+	if arena != nil {
+		size += int64(len(arena.text)) + 4*int64(len(arena.starts)+len(arena.ends)+len(arena.bookEnd))
+	}
+
+	if vi.Related != nil {
+		size += 4*int64(len(vi.Related.IDs)) + 2*int64(len(vi.Related.Scores))
+	}
+	if passages := vi.passages.Load(); passages != nil {
+		for _, table := range *passages {
+			size += 4 * int64(len(table.starts))
+			for _, row := range table.rows {
+				size += 24 + 4*int64(len(row))
+			}
+		}
+	}
+	if lookups := vi.lookups.Load(); lookups != nil {
+		// Keys share the verses' strings
+		size += mapEntryBytes * int64(len(lookups.byID)+len(lookups.byRef)+len(lookups.chapters))
+	}
+	if li := vi.lexicalIdx.Load(); li != nil {
+		size += (mapEntryBytes + stringBytes) * int64(len(li.terms))
+		size += 4*int64(len(li.postingStarts)+len(li.rows)+len(li.blockStarts)+len(li.blockLast)+len(li.blockMax)+len(li.idf)) +
+			2*int64(len(li.freqs)+len(li.docLen))
+	}
+	if t := vi.suggest.Load(); t != nil {
+		size += int64(len(t.labels)) + 4*int64(len(t.childStart)+len(t.topStart)+len(t.top))
+		for i := range t.entries {
+			size += int64(unsafe.Sizeof(t.entries[i])) + int64(len(t.entries[i].Text))
+		}
+	}
+	if h := vi.centroids.Load(); h != nil {
+		for _, groups := range [][]centroidGroup{h.chapters, h.books} {
+			for i := range groups {
+				size += int64(unsafe.Sizeof(groups[i])) + 4*int64(len(groups[i].centroid))
+			}
+		}
+		size += 4 * int64(len(h.invNorms)+len(h.rowBook))
+	}
+	if placed := vi.matrix.Load(); placed != nil && placed.matrix != nil {
+		report := placed.matrix.Report()
+		size += int64(report.Bytes) * int64(report.Replicas)
+	}
+	return size
+}
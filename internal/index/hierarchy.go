@@ -0,0 +1,274 @@
+package index
+
+import (
+	"container/heap"
+	"fmt"
+	"math"
+	"sort"
+	"strings"
+)
+
+// DefaultProbeChapters is the number of best-matching chapters whose verses
+// an approximate hierarchical search scores
+const DefaultProbeChapters = 16
+
+// Section is a chapter or book ranked against a query
+type Section struct {
+	ID     string  `json:"id"`  // e.g. "ROM.8" or "ROM"
+	Ref    string  `json:"ref"` // e.g. "Romans 8" or "Romans"
+	Verses int     `json:"verses"`
+	Score  float32 `json:"score"`
+}
+
+// centroidGroup is a run of rows (a chapter or a book) summarized by the
+// normalized mean of its verse embeddings
+type centroidGroup struct {
+	id, ref    string
+	start, end int32
+	centroid   []float32 // unit length
+
+	// radius is the largest angle between the centroid and a member verse;
+	// no member can be closer to a query than its centroid is, less radius
+	radius float64
+}
+
+// hierarchy holds chapter and book centroids over the verse embeddings
+type hierarchy struct {
+	chapters []centroidGroup
+	books    []centroidGroup
+	invNorms []float32 // 1/|embedding| per verse, 0 for zero vectors
+	rowBook  []int32   // index into books of each verse
+}
+
+func newHierarchy(verses []Verse) *hierarchy {
+	h := &hierarchy{invNorms: make([]float32, len(verses))}
+	for i := range verses {
+		var norm float32
+		for _, x := range verses[i].Embedding {
+			norm += x * x
+		}
+		if norm > 0 {
+			h.invNorms[i] = 1 / float32(math.Sqrt(float64(norm)))
+		}
+	}
+
+	chapterOf := func(v *Verse) (id, ref string) {
+		id, ref = v.ID, v.Ref
+		if dot := strings.LastIndexByte(id, '.'); dot > 0 {
+			id = id[:dot]
+		}
+		if colon := strings.LastIndexByte(ref, ':'); colon > 0 {
+			ref = ref[:colon]
+		}
+		return id, ref
+	}
+	bookOfVerse := func(v *Verse) (id, ref string) {
+		_, ref = chapterOf(v)
+		if space := strings.LastIndexByte(ref, ' '); space > 0 {
+			ref = ref[:space]
+		}
+		return bookOf(v.ID), ref
+	}
+	h.chapters = h.group(verses, chapterOf)
+	h.books = h.group(verses, bookOfVerse)
+	h.rowBook = make([]int32, len(verses))
+	for book, g := range h.books {
+		for row := g.start; row < g.end; row++ {
+			h.rowBook[row] = int32(book)
+		}
+	}
+	return h
+}
+
+// group splits rows into runs with the same key and computes their centroids
+func (h *hierarchy) group(verses []Verse, key func(*Verse) (id, ref string)) []centroidGroup {
+	var groups []centroidGroup
+	for start := 0; start < len(verses); {
+		id, ref := key(&verses[start])
+		end := start + 1
+		for end < len(verses) {
+			if next, _ := key(&verses[end]); next != id {
+				break
+			}
+			end++
+		}
+		groups = append(groups, h.centroid(verses, id, ref, start, end))
+		start = end
+	}
+	return groups
+}
+
+func (h *hierarchy) centroid(verses []Verse, id, ref string, start, end int) centroidGroup {
+	g := centroidGroup{id: id, ref: ref, start: int32(start), end: int32(end)}
+	dim := len(verses[start].Embedding)
+	sum := make([]float32, dim)
+	for row := start; row < end; row++ {
+		if len(verses[row].Embedding) != dim {
+			continue
+		}
+		for d, x := range verses[row].Embedding {
+			sum[d] += x * h.invNorms[row]
+		}
+	}
+	g.centroid = make([]float32, dim)
+	normalizeInto(g.centroid, sum)
+
+	minCos := 1.0
+	for row := start; row < end; row++ {
+		if len(verses[row].Embedding) != dim || h.invNorms[row] == 0 {
+			minCos = -1 // unknown direction: never prune this group
+			continue
+		}
+		minCos = min(minCos, float64(dot(g.centroid, verses[row].Embedding)*h.invNorms[row]))
+	}
+	g.radius = math.Acos(max(-1, min(1, minCos)))
+	return g
+}
+
+func dot(a, b []float32) float32 {
+	var sum float32
+	for i := range a {
+		sum += a[i] * b[i]
+	}
+	return sum
+}
+
+func (vi *VerseIndex) hierarchy() *hierarchy {
+	if h := vi.centroids.Load(); h != nil {
+		return h
+	}
+	h := newHierarchy(vi.Verses)
+	vi.centroids.CompareAndSwap(nil, h)
+	return vi.centroids.Load()
+}
+
+// rankGroups scores each group's centroid against a unit query, best first
+func rankGroups(groups []centroidGroup, query []float32) []scoredRow {
+	scored := make([]scoredRow, 0, len(groups))
+	for i := range groups {
+		if len(groups[i].centroid) == len(query) {
+			scored = append(scored, scoredRow{row: i, score: dot(groups[i].centroid, query)})
+		}
+	}
+	sort.Slice(scored, func(i, j int) bool { return scored[i].score > scored[j].score })
+	return scored
+}
+
+// TopChapters ranks chapters by the similarity of their centroid to the query
+func (vi *VerseIndex) TopChapters(queryEmbedding []float32, k int) ([]Section, error) {
+	return vi.topSections(vi.hierarchy().chapters, queryEmbedding, k)
+}
+
+// TopBooks ranks books by the similarity of their centroid to the query
+func (vi *VerseIndex) TopBooks(queryEmbedding []float32, k int) ([]Section, error) {
+	return vi.topSections(vi.hierarchy().books, queryEmbedding, k)
+}
+
+func (vi *VerseIndex) topSections(groups []centroidGroup, queryEmbedding []float32, k int) ([]Section, error) {
+	query, err := unitQuery(queryEmbedding, vi.Dimension())
+	if err != nil {
+		return nil, err
+	}
+	scored := rankGroups(groups, query)
+	sections := make([]Section, 0, min(k, len(scored)))
+	for _, s := range scored[:min(k, len(scored))] {
+		g := &groups[s.row]
+		sections = append(sections, Section{ID: g.id, Ref: g.ref, Verses: int(g.end - g.start), Score: s.score})
+	}
+	return sections, nil
+}
+
+func unitQuery(queryEmbedding []float32, dim int) ([]float32, error) {
+	if len(queryEmbedding) == 0 {
+		return nil, fmt.Errorf("query embedding cannot be empty")
+	}
+	if len(queryEmbedding) != dim {
+		return nil, fmt.Errorf("query has %d dimensions, index has %d", len(queryEmbedding), dim)
+	}
+	query := make([]float32, len(queryEmbedding))
+	normalizeInto(query, queryEmbedding)
+	return query, nil
+}
+
+// SearchHierarchical finds verses coarse-to-fine: chapters are ranked by
+// centroid first and only verses inside the best ones are scored.
+//
+// With exact false, the verses of the top probeChapters chapters are scored
+// (DefaultProbeChapters if probeChapters <= 0). With exact true, chapters
+// are visited best bound first and the search stops only once no remaining
+// chapter can hold a verse better than the k-th found, so the results match
+// Search.
+func (vi *VerseIndex) SearchHierarchical(queryEmbedding []float32, k, probeChapters int, exact bool) ([]SearchResult, error) {
+	if k <= 0 {
+		k = 20
+	}
+	if k > 50 {
+		k = 50
+	}
+	if probeChapters <= 0 {
+		probeChapters = DefaultProbeChapters
+	}
+	query, err := unitQuery(queryEmbedding, vi.Dimension())
+	if err != nil {
+		return nil, err
+	}
+	h := vi.hierarchy()
+
+	ranked := rankGroups(h.chapters, query)
+	if exact {
+		// Order by the best similarity any member could have
+		for i := range ranked {
+			g := &h.chapters[ranked[i].row]
+			angle := math.Acos(float64(max(-1, min(1, ranked[i].score))))
+			ranked[i].score = float32(math.Cos(max(0, angle-g.radius))) + 1e-4
+		}
+		sort.Slice(ranked, func(i, j int) bool { return ranked[i].score > ranked[j].score })
+	} else if len(ranked) > probeChapters {
+		ranked = ranked[:probeChapters]
+	}
+
+	top := make(scoredHeap, 0, k)
+	for _, chapter := range ranked {
+		if exact && (chapter.score < minSimilarity || len(top) == k && chapter.score <= top[0].score) {
+			break
+		}
+		g := &h.chapters[chapter.row]
+		for row := int(g.start); row < int(g.end); row++ {
+			embedding := vi.Verses[row].Embedding
+			if len(embedding) != len(query) {
+				continue
+			}
+			score := dot(query, embedding) * h.invNorms[row]
+			if score < minSimilarity {
+				continue
+			}
+			if len(top) < k {
+				heap.Push(&top, scoredRow{row: row, score: score})
+			} else if score > top[0].score {
+				top[0] = scoredRow{row: row, score: score}
+				heap.Fix(&top, 0)
+			}
+		}
+	}
+
+	sort.Slice(top, func(i, j int) bool { return top[i].score > top[j].score })
+	results := make([]SearchResult, len(top))
+	for i, s := range top {
+		results[i] = SearchResult{Verse: &vi.Verses[s.row], Score: s.score, Position: s.row}
+	}
+	return results, nil
+}
+
+// scoredHeap is a min-heap of the best rows so far
+type scoredHeap []scoredRow
+
+func (h scoredHeap) Len() int           { return len(h) }
+func (h scoredHeap) Less(i, j int) bool { return h[i].score < h[j].score }
+func (h scoredHeap) Swap(i, j int)      { h[i], h[j] = h[j], h[i] }
+func (h *scoredHeap) Push(x any)        { *h = append(*h, x.(scoredRow)) }
+func (h *scoredHeap) Pop() any {
+	old := *h
+	row := old[len(old)-1]
+	*h = old[:len(old)-1]
+	return row
+}
@@ -0,0 +1,123 @@
+package index
+
+import (
+	"fmt"
+	"math/rand"
+	"testing"
+)
+
+// hierarchyTestIndex builds books of chapters whose verses scatter around a
+// per-chapter direction
+func hierarchyTestIndex(rng *rand.Rand, dim int) *VerseIndex {
+	verseIndex := NewVerseIndex()
+	for book := 0; book < 3; book++ {
+		for chapter := 1; chapter <= 10; chapter++ {
+			center := make([]float32, dim)
+			for d := range center {
+				center[d] = float32(rng.NormFloat64())
+			}
+			for verse := 1; verse <= 20; verse++ {
+				embedding := make([]float32, dim)
+				for d := range embedding {
+					embedding[d] = center[d] + 0.6*float32(rng.NormFloat64())
+				}
+				verseIndex.AddVerse(Verse{
+					ID:        fmt.Sprintf("B%d.%d.%d", book, chapter, verse),
+					Ref:       fmt.Sprintf("Book %d %d:%d", book, chapter, verse),
+					Embedding: embedding,
+				})
+			}
+		}
+	}
+	return verseIndex
+}
+
+func resultIDs(results []SearchResult) []string {
+	ids := make([]string, len(results))
+	for i, r := range results {
+		ids[i] = r.Verse.ID
+	}
+	return ids
+}
+
+func TestSearchHierarchical_ExactMatchesFlatSearch(t *testing.T) {
+	rng := rand.New(rand.NewSource(7))
+	verseIndex := hierarchyTestIndex(rng, 32)
+
+	for trial := 0; trial < 20; trial++ {
+		// Queries near a random verse, so plenty of verses clear the threshold
+		anchor := verseIndex.Verses[rng.Intn(len(verseIndex.Verses))].Embedding
+		query := make([]float32, len(anchor))
+		for d := range query {
+			query[d] = anchor[d] + 0.3*float32(rng.NormFloat64())
+		}
+
+		for _, k := range []int{1, 10, 50} {
+			flat, err := verseIndex.Search(query, k)
+			if err != nil {
+				t.Fatalf("Search failed: %v", err)
+			}
+			exact, err := verseIndex.SearchHierarchical(query, k, 0, true)
+			if err != nil {
+				t.Fatalf("SearchHierarchical failed: %v", err)
+			}
+			if fmt.Sprint(resultIDs(exact)) != fmt.Sprint(resultIDs(flat)) {
+				t.Fatalf("Trial %d k=%d: exact hierarchical %v differs from flat %v", trial, k, resultIDs(exact), resultIDs(flat))
+			}
+
+			// Probing every chapter is exhaustive too
+			all, _ := verseIndex.SearchHierarchical(query, k, 30, false)
+			if fmt.Sprint(resultIDs(all)) != fmt.Sprint(resultIDs(flat)) {
+				t.Fatalf("Trial %d k=%d: probing all chapters %v differs from flat %v", trial, k, resultIDs(all), resultIDs(flat))
+			}
+		}
+	}
+}
+
+func TestSearchHierarchical_ProbesOnlyTopChapters(t *testing.T) {
+	rng := rand.New(rand.NewSource(3))
+	verseIndex := hierarchyTestIndex(rng, 32)
+	query := verseIndex.Verses[45].Embedding // B0.3.6
+
+	results, err := verseIndex.SearchHierarchical(query, 50, 1, false)
+	if err != nil {
+		t.Fatalf("SearchHierarchical failed: %v", err)
+	}
+	if len(results) == 0 || results[0].Verse.ID != "B0.3.6" || results[0].Position != 45 {
+		t.Fatalf("Expected B0.3.6 first, got %v", resultIDs(results))
+	}
+	for _, result := range results {
+		if result.Position < 40 || result.Position >= 60 {
+			t.Errorf("Expected only verses of chapter B0.3, got %s", result.Verse.ID)
+		}
+	}
+
+	if _, err := verseIndex.SearchHierarchical(query[:8], 5, 1, false); err == nil {
+		t.Error("Expected an error for a query of the wrong dimension")
+	}
+}
+
+func TestTopChaptersAndBooks(t *testing.T) {
+	rng := rand.New(rand.NewSource(5))
+	verseIndex := hierarchyTestIndex(rng, 32)
+	query := verseIndex.Verses[2*200+7*20].Embedding // a verse of B2.8
+
+	chapters, err := verseIndex.TopChapters(query, 3)
+	if err != nil {
+		t.Fatalf("TopChapters failed: %v", err)
+	}
+	if len(chapters) != 3 || chapters[0].ID != "B2.8" || chapters[0].Ref != "Book 2 8" || chapters[0].Verses != 20 {
+		t.Errorf("Expected chapter B2.8 first, got %+v", chapters)
+	}
+	if chapters[0].Score < chapters[1].Score {
+		t.Errorf("Expected chapters best first, got %+v", chapters)
+	}
+
+	books, err := verseIndex.TopBooks(query, 5)
+	if err != nil {
+		t.Fatalf("TopBooks failed: %v", err)
+	}
+	if len(books) != 3 || books[0].ID != "B2" || books[0].Ref != "Book 2" || books[0].Verses != 200 {
+		t.Errorf("Expected book B2 first of 3, got %+v", books)
+	}
+}
@@ -0,0 +1,540 @@
+package index
+
+import (
+	"bufio"
+	"bytes"
+	"encoding/json"
+	"fmt"
+	"io"
+	"math"
+	"runtime"
+	"sort"
+	"strconv"
+	"strings"
+	"sync"
+	"unsafe"
+)
+
+// canonicalBooks lists the books in canonical order with the codes used in
+// verse IDs
+var canonicalBooks = []struct{ name, code string }{
+	{"Genesis", "GEN"}, {"Exodus", "EXO"}, {"Leviticus", "LEV"}, {"Numbers", "NUM"},
+	{"Deuteronomy", "DEU"}, {"Joshua", "JOS"}, {"Judges", "JDG"}, {"Ruth", "RUT"},
+	{"1 Samuel", "1SA"}, {"2 Samuel", "2SA"}, {"1 Kings", "1KI"}, {"2 Kings", "2KI"},
+	{"1 Chronicles", "1CH"}, {"2 Chronicles", "2CH"}, {"Ezra", "EZR"}, {"Nehemiah", "NEH"},
+	{"Esther", "EST"}, {"Job", "JOB"}, {"Psalms", "PSA"}, {"Proverbs", "PRO"},
+	{"Ecclesiastes", "ECC"}, {"Song of Solomon", "SNG"}, {"Isaiah", "ISA"}, {"Jeremiah", "JER"},
+	{"Lamentations", "LAM"}, {"Ezekiel", "EZK"}, {"Daniel", "DAN"}, {"Hosea", "HOS"},
+	{"Joel", "JOL"}, {"Amos", "AMO"}, {"Obadiah", "OBA"}, {"Jonah", "JON"},
+	{"Micah", "MIC"}, {"Nahum", "NAM"}, {"Habakkuk", "HAB"}, {"Zephaniah", "ZEP"},
+	{"Haggai", "HAG"}, {"Zechariah", "ZEC"}, {"Malachi", "MAL"},
+	{"Matthew", "MAT"}, {"Mark", "MRK"}, {"Luke", "LUK"}, {"John", "JHN"},
+	{"Acts", "ACT"}, {"Romans", "ROM"}, {"1 Corinthians", "1CO"}, {"2 Corinthians", "2CO"},
+	{"Galatians", "GAL"}, {"Ephesians", "EPH"}, {"Philippians", "PHP"}, {"Colossians", "COL"},
+	{"1 Thessalonians", "1TH"}, {"2 Thessalonians", "2TH"}, {"1 Timothy", "1TI"}, {"2 Timothy", "2TI"},
+	{"Titus", "TIT"}, {"Philemon", "PHM"}, {"Hebrews", "HEB"}, {"James", "JAS"},
+	{"1 Peter", "1PE"}, {"2 Peter", "2PE"}, {"1 John", "1JN"}, {"2 John", "2JN"},
+	{"3 John", "3JN"}, {"Jude", "JUD"}, {"Revelation", "REV"},
+}
+
+// bookAliases maps other spellings of book names to canonicalBooks rows
+var bookAliases = map[string]int{"Psalm": 18, "Song of Songs": 21, "Revelation of John": 65}
+
+var bookOrder = func() map[string]int {
+	order := make(map[string]int, len(canonicalBooks)+len(bookAliases))
+	for i, book := range canonicalBooks {
+		order[book.name] = i
+	}
+	for name, i := range bookAliases {
+		order[name] = i
+	}
+	return order
+}()
+
+// IngestOptions configures IngestEmbeddings
+type IngestOptions struct {
+	// Texts maps references ("Genesis 1:1") to verse text with its original
+	// punctuation; when nil the records' cleaned_text is used
+	Texts map[string]string
+
+	Workers   int  // parsing goroutines, 0 means one per CPU
+	Normalize bool // scale embeddings to unit length
+}
+
+// embeddingRecord is one verse of the embeddings JSON written by the
+// notebook
+type embeddingRecord struct {
+	Book        string     `json:"book"`
+	Chapter     int        `json:"chapter"`
+	Verse       int        `json:"verse"`
+	CleanedText string     `json:"cleaned_text"`
+	Embedding   floatArray `json:"embedding"`
+}
+
+// floatArray decodes a JSON array of numbers without reflection or an
+// allocation per element
+type floatArray []float32
+
+func (f *floatArray) UnmarshalJSON(data []byte) error {
+	data = trimJSONSpace(data)
+	if string(data) == "null" {
+		return nil
+	}
+	if len(data) < 2 || data[0] != '[' || data[len(data)-1] != ']' {
+		return fmt.Errorf("embedding is not an array")
+	}
+	data = trimJSONSpace(data[1 : len(data)-1])
+	if len(data) == 0 {
+		*f = nil
+		return nil
+	}
+	values := make([]float32, 0, bytes.Count(data, []byte{','})+1)
+	for len(data) > 0 {
+		end := bytes.IndexByte(data, ',')
+		if end < 0 {
+			end = len(data)
+		}
+		number := trimJSONSpace(data[:end])
+		if len(number) == 0 {
+			return fmt.Errorf("embedding has an empty element")
+		}
+		// The string aliases data only for the call; errors keep just the
+		// cause
+		value, err := strconv.ParseFloat(unsafe.String(&number[0], len(number)), 32)
+		if err != nil {
+			return fmt.Errorf("embedding element %d: %s", len(values), err.(*strconv.NumError).Err)
+		}
+		values = append(values, float32(value))
+		if end == len(data) {
+			break
+		}
+		data = data[end+1:]
+	}
+	*f = values
+	return nil
+}
+
+func trimJSONSpace(data []byte) []byte {
+	for len(data) > 0 && isJSONSpace(data[0]) {
+		data = data[1:]
+	}
+	for len(data) > 0 && isJSONSpace(data[len(data)-1]) {
+		data = data[:len(data)-1]
+	}
+	return data
+}
+
+func isJSONSpace(c byte) bool {
+	return c == ' ' || c == '\n' || c == '\r' || c == '\t'
+}
+
+// ReadVerseTexts reads a JSON object of references to verse texts, such as
+// verses-1769.json
+func ReadVerseTexts(r io.Reader) (map[string]string, error) {
+	decoder := json.NewDecoder(bufio.NewReader(r))
+	if token, err := decoder.Token(); err != nil || token != json.Delim('{') {
+		return nil, fmt.Errorf("verse texts must be a JSON object")
+	}
+	texts := make(map[string]string)
+	for decoder.More() {
+		token, err := decoder.Token()
+		if err != nil {
+			return nil, fmt.Errorf("failed to read verse texts: %w", err)
+		}
+		var text string
+		if err := decoder.Decode(&text); err != nil {
+			return nil, fmt.Errorf("failed to read text of %v: %w", token, err)
+		}
+		texts[token.(string)] = text
+	}
+	return texts, nil
+}
+
+// ingested is a parsed record, or the reason it was rejected
+type ingested struct {
+	seq   int
+	verse Verse
+	order [3]int // book, chapter, verse
+	err   error
+}
+
+// IngestEmbeddings builds a verse index from a JSON array of embedding
+// records, such as the notebook's VersejetKJV_recreated.json. One goroutine
+// splits the stream into records while workers parse, validate and
+// normalize them, so only the records in flight are held as JSON. Verses
+// are ordered by book, chapter and verse; every embedding must be finite,
+// non-zero and of one dimension, and with Texts every verse must have both
+// a text and an embedding.
+func IngestEmbeddings(r io.Reader, opts IngestOptions) (*VerseIndex, error) {
+	workers := opts.Workers
+	if workers <= 0 {
+		workers = runtime.NumCPU()
+	}
+
+	type record struct {
+		seq  int
+		data []byte
+	}
+	records := make(chan record, workers*4)
+	parsed := make(chan ingested, workers*4)
+	done := make(chan struct{})
+	defer close(done)
+
+	var splitErr error
+	go func() {
+		defer close(records)
+		seq := 0
+		splitErr = splitJSONArray(r, func(data []byte) bool {
+			select {
+			case records <- record{seq, data}:
+				seq++
+				return true
+			case <-done:
+				return false
+			}
+		})
+	}()
+
+	var wg sync.WaitGroup
+	for i := 0; i < workers; i++ {
+		wg.Add(1)
+		go func() {
+			defer wg.Done()
+			for rec := range records {
+				result := parseEmbeddingRecord(rec.data, opts)
+				result.seq = rec.seq
+				select {
+				case parsed <- result:
+				case <-done:
+					return
+				}
+			}
+		}()
+	}
+	go func() {
+		wg.Wait()
+		close(parsed)
+	}()
+
+	var results []ingested
+	for result := range parsed {
+		if result.err != nil {
+			return nil, fmt.Errorf("record %d: %w", result.seq, result.err)
+		}
+		results = append(results, result)
+	}
+	// parsed closes after the splitter has returned
+	if splitErr != nil {
+		return nil, splitErr
+	}
+	if len(results) == 0 {
+		return nil, fmt.Errorf("no embedding records")
+	}
+	return assembleIndex(results, opts.Texts)
+}
+
+// IngestTexts builds a verse index from texts by reference, such as
+// verses-1769.json, asking embed for the embeddings of all texts in
+// canonical order. The embeddings are checked as in IngestEmbeddings.
+func IngestTexts(texts map[string]string, embed func(texts []string) ([][]float32, error), normalize bool) (*VerseIndex, error) {
+	results := make([]ingested, 0, len(texts))
+	for ref, text := range texts {
+		book, chapter, verse, err := parseReference(ref)
+		if err != nil {
+			return nil, err
+		}
+		results = append(results, ingested{
+			verse: Verse{ID: verseID(book, chapter, verse), Ref: ref, Text: text},
+			order: [3]int{book, chapter, verse},
+		})
+	}
+	if len(results) == 0 {
+		return nil, fmt.Errorf("no verse texts")
+	}
+	sortIngested(results)
+
+	batch := make([]string, len(results))
+	for i := range results {
+		batch[i] = results[i].verse.Text
+	}
+	embeddings, err := embed(batch)
+	if err != nil {
+		return nil, err
+	}
+	if len(embeddings) != len(results) {
+		return nil, fmt.Errorf("expected %d embeddings, received %d", len(results), len(embeddings))
+	}
+	for i := range results {
+		if err := checkEmbedding(results[i].verse.Ref, embeddings[i], normalize); err != nil {
+			return nil, err
+		}
+		results[i].verse.Embedding = embeddings[i]
+	}
+	return assembleIndex(results, nil)
+}
+
+// parseReference returns the canonical book row, chapter and verse of a
+// reference such as "Genesis 1:1"
+func parseReference(ref string) (book, chapter, verse int, err error) {
+	space := strings.LastIndexByte(ref, ' ')
+	colon := strings.LastIndexByte(ref, ':')
+	if space < 0 || colon < space {
+		return 0, 0, 0, fmt.Errorf("invalid reference %q", ref)
+	}
+	book, ok := bookOrder[ref[:space]]
+	if !ok {
+		return 0, 0, 0, fmt.Errorf("unknown book %q", ref[:space])
+	}
+	chapter, chapterErr := strconv.Atoi(ref[space+1 : colon])
+	verse, verseErr := strconv.Atoi(ref[colon+1:])
+	if chapterErr != nil || verseErr != nil || chapter <= 0 || verse <= 0 {
+		return 0, 0, 0, fmt.Errorf("invalid reference %q", ref)
+	}
+	return book, chapter, verse, nil
+}
+
+func verseID(book, chapter, verse int) string {
+	return fmt.Sprintf("%s.%d.%d", canonicalBooks[book].code, chapter, verse)
+}
+
+// sortIngested orders verses canonically, then by arrival
+func sortIngested(results []ingested) {
+	sort.Slice(results, func(i, j int) bool {
+		a, b := results[i].order, results[j].order
+		if a != b {
+			return a[0] < b[0] || a[0] == b[0] && (a[1] < b[1] || a[1] == b[1] && a[2] < b[2])
+		}
+		return results[i].seq < results[j].seq
+	})
+}
+
+// assembleIndex builds the index from parsed verses, checking that they
+// share a dimension, appear once and, with texts, cover every text
+func assembleIndex(results []ingested, texts map[string]string) (*VerseIndex, error) {
+	sortIngested(results)
+	verseIndex := NewVerseIndex()
+	verseIndex.Verses = make([]Verse, len(results))
+	dim := len(results[0].verse.Embedding)
+	for i := range results {
+		verse := results[i].verse
+		if len(verse.Embedding) != dim {
+			return nil, fmt.Errorf("%s has %d dimensions, expected %d", verse.Ref, len(verse.Embedding), dim)
+		}
+		if i > 0 && results[i].order == results[i-1].order {
+			return nil, fmt.Errorf("%s appears more than once", verse.Ref)
+		}
+		verseIndex.Verses[i] = verse
+	}
+	if texts != nil && len(texts) != len(results) {
+		return nil, fmt.Errorf("%d verses have texts but %d have embeddings", len(texts), len(results))
+	}
+	return verseIndex, nil
+}
+
+// checkEmbedding rejects non-finite and zero embeddings and, with
+// normalize, scales the embedding to unit length in place
+func checkEmbedding(ref string, embedding []float32, normalize bool) error {
+	var norm float64
+	for _, x := range embedding {
+		if math.IsNaN(float64(x)) || math.IsInf(float64(x), 0) {
+			return fmt.Errorf("%s has a non-finite embedding", ref)
+		}
+		norm += float64(x) * float64(x)
+	}
+	if norm == 0 {
+		return fmt.Errorf("%s has an empty or zero embedding", ref)
+	}
+	if normalize {
+		normalizeInto(embedding, embedding)
+	}
+	return nil
+}
+
+// parseEmbeddingRecord decodes and checks one record
+func parseEmbeddingRecord(data []byte, opts IngestOptions) ingested {
+	var rec embeddingRecord
+	array, rest, cut := cutEmbedding(data)
+	if !cut {
+		rest = data
+	}
+	if err := json.Unmarshal(rest, &rec); err != nil {
+		return ingested{err: err}
+	}
+	if cut {
+		if err := rec.Embedding.UnmarshalJSON(array); err != nil {
+			return ingested{err: err}
+		}
+	}
+	book, ok := bookOrder[rec.Book]
+	if !ok {
+		return ingested{err: fmt.Errorf("unknown book %q", rec.Book)}
+	}
+	if rec.Chapter <= 0 || rec.Verse <= 0 {
+		return ingested{err: fmt.Errorf("%s has chapter %d verse %d", rec.Book, rec.Chapter, rec.Verse)}
+	}
+	ref := fmt.Sprintf("%s %d:%d", rec.Book, rec.Chapter, rec.Verse)
+
+	text := rec.CleanedText
+	if opts.Texts != nil {
+		if text, ok = opts.Texts[ref]; !ok {
+			return ingested{err: fmt.Errorf("%s has no text", ref)}
+		}
+	}
+
+	if err := checkEmbedding(ref, rec.Embedding, opts.Normalize); err != nil {
+		return ingested{err: err}
+	}
+
+	return ingested{
+		verse: Verse{
+			ID:        verseID(book, rec.Chapter, rec.Verse),
+			Ref:       ref,
+			Text:      text,
+			Embedding: rec.Embedding,
+		},
+		order: [3]int{book, rec.Chapter, rec.Verse},
+	}
+}
+
+// cutEmbedding returns a record's embedding array and the record with null
+// in its place, so encoding/json decodes only the small fields and the
+// array is scanned once. It reports false for records it cannot cut.
+func cutEmbedding(record []byte) (array, rest []byte, ok bool) {
+	key := []byte(`"embedding"`)
+	depth := 0
+	for i := 0; i < len(record); i++ {
+		switch record[i] {
+		case '{', '[':
+			depth++
+		case '}', ']':
+			depth--
+		case '"':
+			end := i + 1
+			for end < len(record) && record[end] != '"' {
+				if record[end] == '\\' {
+					end++
+				}
+				end++
+			}
+			if depth == 1 && bytes.Equal(record[i:min(end+1, len(record))], key) {
+				j := end + 1
+				for j < len(record) && isJSONSpace(record[j]) {
+					j++
+				}
+				if j == len(record) || record[j] != ':' {
+					return nil, nil, false
+				}
+				j++
+				for j < len(record) && isJSONSpace(record[j]) {
+					j++
+				}
+				if j == len(record) || record[j] != '[' {
+					return nil, nil, false
+				}
+				length := bytes.IndexByte(record[j:], ']')
+				if length < 0 || bytes.IndexByte(record[j+1:j+length], '[') >= 0 {
+					return nil, nil, false
+				}
+				array = record[j : j+length+1]
+				rest = make([]byte, 0, len(record)-len(array)+4)
+				rest = append(append(append(rest, record[:j]...), "null"...), record[j+length+1:]...)
+				return array, rest, true
+			}
+			i = end
+		}
+	}
+	return nil, nil, false
+}
+
+// jsonStructural marks the bytes splitJSONArray must look at inside a record
+var jsonStructural = [256]bool{'"': true, '\\': true, '{': true, '}': true, '[': true, ']': true}
+
+// splitJSONArray reads a JSON array of objects and passes each object's
+// bytes to emit until it returns false. It scans whole blocks in one loop,
+// copying each object as a span, and checks only enough syntax to find
+// object boundaries; the objects are validated when decoded.
+func splitJSONArray(r io.Reader, emit func([]byte) bool) error {
+	const (
+		expectArray     = iota // before '['
+		expectFirst            // '{' or an empty array's ']'
+		expectRecord           // '{' after a comma
+		expectSeparator        // ',' or ']' after a record
+		inRecord
+	)
+	state := expectArray
+	var object []byte
+	size := 4096 // capacity of the next record, grown to the largest seen
+	depth, inString, escaped := 0, false, false
+
+	block := make([]byte, 1<<20)
+	for {
+		n, err := r.Read(block)
+		start := 0 // of the record's bytes in this block
+		for i := 0; i < n; i++ {
+			if state == inRecord && !inString {
+				// Numbers and whitespace make up most of a record
+				for i < n && !jsonStructural[block[i]] {
+					i++
+				}
+				if i == n {
+					break
+				}
+			}
+			b := block[i]
+			if state == inRecord {
+				switch {
+				case inString:
+					if escaped {
+						escaped = false
+					} else if b == '\\' {
+						escaped = true
+					} else if b == '"' {
+						inString = false
+					}
+				case b == '"':
+					inString = true
+				case b == '{' || b == '[':
+					depth++
+				case b == '}' || b == ']':
+					if depth--; depth == 0 {
+						object = append(object, block[start:i+1]...)
+						size = max(size, len(object))
+						if !emit(object) {
+							return nil
+						}
+						state = expectSeparator
+					}
+				}
+				continue
+			}
+
+			if isJSONSpace(b) {
+				continue
+			}
+			switch {
+			case state == expectArray && b == '[':
+				state = expectFirst
+			case state == expectFirst && b == ']', state == expectSeparator && b == ']':
+				return nil
+			case state == expectSeparator && b == ',':
+				state = expectRecord
+			case (state == expectFirst || state == expectRecord) && b == '{':
+				object = make([]byte, 0, size)
+				depth, start, state = 1, i, inRecord
+			case state == expectArray:
+				return fmt.Errorf("embeddings must be a JSON array")
+			default:
+				return fmt.Errorf("embeddings array holds %q where a record or separator belongs", b)
+			}
+		}
+		if state == inRecord {
+			object = append(object, block[start:n]...)
+		}
+		if err == io.EOF {
+			return fmt.Errorf("failed to read embeddings: %w", io.ErrUnexpectedEOF)
+		}
+		if err != nil {
+			return fmt.Errorf("failed to read embeddings: %w", err)
+		}
+	}
+}
@@ -0,0 +1,128 @@
+package index
+
+import (
+	"encoding/json"
+	"fmt"
+	"math"
+	"strings"
+	"testing"
+)
+
+func TestIngestEmbeddings(t *testing.T) {
+	// Out of canonical order and pretty-printed like the notebook's output
+	records := []map[string]any{
+		{"_id": map[string]string{"$oid": "a"}, "book": "John", "chapter": 1, "verse": 1, "cleaned_text": "In the beginning was the Word", "embedding": []float64{0, 3, 4}},
+		{"_id": map[string]string{"$oid": "b"}, "book": "Genesis", "chapter": 1, "verse": 2, "cleaned_text": "And the earth", "embedding": []float64{1e-3, -2.5e-3, 0.125}},
+		{"_id": map[string]string{"$oid": "c"}, "book": "Genesis", "chapter": 1, "verse": 1, "cleaned_text": "\"embedding\": [0, 1]", "embedding": []float64{2, 0, 0}},
+	}
+	data, _ := json.MarshalIndent(records, "", "  ")
+	texts, err := ReadVerseTexts(strings.NewReader(`{
+		"Genesis 1:1": "In the beginning God created the heaven and the earth.",
+		"Genesis 1:2": "And the earth was without form, and void;",
+		"John 1:1": "In the beginning was the Word, and the Word was with God, and the Word was God."
+	}`))
+	if err != nil {
+		t.Fatalf("ReadVerseTexts failed: %v", err)
+	}
+
+	for _, workers := range []int{1, 4} {
+		verseIndex, err := IngestEmbeddings(strings.NewReader(string(data)), IngestOptions{Texts: texts, Workers: workers, Normalize: true})
+		if err != nil {
+			t.Fatalf("IngestEmbeddings failed: %v", err)
+		}
+		var ids []string
+		for _, verse := range verseIndex.Verses {
+			ids = append(ids, verse.ID)
+		}
+		if strings.Join(ids, " ") != "GEN.1.1 GEN.1.2 JHN.1.1" {
+			t.Fatalf("Expected verses in canonical order, got %v", ids)
+		}
+		john := verseIndex.Verses[2]
+		if john.Ref != "John 1:1" || john.Text != texts["John 1:1"] {
+			t.Errorf("Expected the original text of John 1:1, got %+v", john)
+		}
+		if math.Abs(float64(john.Embedding[1])-0.6) > 1e-6 || math.Abs(float64(john.Embedding[2])-0.8) > 1e-6 {
+			t.Errorf("Expected a unit-length embedding, got %v", john.Embedding)
+		}
+		want := float32(-2.5e-3 / math.Sqrt(1e-6+6.25e-6+0.015625))
+		if got := verseIndex.Verses[1].Embedding[1]; math.Abs(float64(got-want)) > 1e-7 {
+			t.Errorf("Expected %v, got %v", want, got)
+		}
+	}
+
+	raw, err := IngestEmbeddings(strings.NewReader(string(data)), IngestOptions{})
+	if err != nil {
+		t.Fatalf("IngestEmbeddings failed: %v", err)
+	}
+	if raw.Verses[0].Text != `"embedding": [0, 1]` || raw.Verses[0].Embedding[0] != 2 {
+		t.Errorf("Expected cleaned text and raw embeddings without options, got %+v", raw.Verses[0])
+	}
+}
+
+func TestIngestEmbeddings_Rejects(t *testing.T) {
+	record := func(book string, verse int, embedding string) string {
+		return fmt.Sprintf(`{"book": %q, "chapter": 1, "verse": %d, "cleaned_text": "x", "embedding": %s}`, book, verse, embedding)
+	}
+	for name, input := range map[string]string{
+		"not an array":    `{}`,
+		"truncated":       `[` + record("Genesis", 1, "[1, 2]"),
+		"unknown book":    `[` + record("Genesis 2", 1, "[1, 2]") + `]`,
+		"zero vector":     `[` + record("Genesis", 1, "[0, 0]") + `]`,
+		"overflow":        `[` + record("Genesis", 1, "[1e300, 2]") + `]`,
+		"bad element":     `[` + record("Genesis", 1, `[1, "2"]`) + `]`,
+		"mixed dimension": `[` + record("Genesis", 1, "[1, 2]") + `,` + record("Genesis", 2, "[1, 2, 3]") + `]`,
+		"duplicate":       `[` + record("Genesis", 1, "[1, 2]") + `,` + record("Genesis", 1, "[1, 2]") + `]`,
+		"empty":           `[]`,
+	} {
+		if _, err := IngestEmbeddings(strings.NewReader(input), IngestOptions{Workers: 2}); err == nil {
+			t.Errorf("%s: expected an error", name)
+		}
+	}
+
+	texts := map[string]string{"Genesis 1:1": "a", "Genesis 1:2": "b"}
+	if _, err := IngestEmbeddings(strings.NewReader(`[`+record("Genesis", 1, "[1, 2]")+`]`), IngestOptions{Texts: texts}); err == nil {
+		t.Error("Expected a verse without an embedding to be rejected")
+	}
+}
+
+func TestIngestTexts(t *testing.T) {
+	texts := map[string]string{
+		"Revelation 22:21": "The grace of our Lord Jesus Christ be with you all. Amen.",
+		"Genesis 1:2":      "And the earth was without form, and void;",
+		"Genesis 1:10":     "And God called the dry land Earth;",
+		"Psalm 23:1":       "The LORD is my shepherd; I shall not want.",
+	}
+	var requested []string
+	verseIndex, err := IngestTexts(texts, func(batch []string) ([][]float32, error) {
+		requested = batch
+		embeddings := make([][]float32, len(batch))
+		for i, text := range batch {
+			embeddings[i] = []float32{float32(len(text)), 0}
+		}
+		return embeddings, nil
+	}, true)
+	if err != nil {
+		t.Fatalf("IngestTexts failed: %v", err)
+	}
+	var ids []string
+	for i, verse := range verseIndex.Verses {
+		ids = append(ids, verse.ID)
+		if requested[i] != verse.Text || math.Abs(float64(verse.Embedding[0])-1) > 1e-6 {
+			t.Errorf("Verse %s got the embedding of another text or was not normalized", verse.ID)
+		}
+	}
+	if strings.Join(ids, " ") != "GEN.1.2 GEN.1.10 PSA.23.1 REV.22.21" {
+		t.Errorf("Expected verses in canonical order, got %v", ids)
+	}
+
+	for _, ref := range []string{"Genesis", "Genesis 1", "Hezekiah 1:1", "Genesis 0:1", "Genesis 1:x"} {
+		if _, err := IngestTexts(map[string]string{ref: "text"}, nil, false); err == nil {
+			t.Errorf("Expected %q to be rejected", ref)
+		}
+	}
+	if _, err := IngestTexts(texts, func(batch []string) ([][]float32, error) {
+		return make([][]float32, len(batch)), nil
+	}, false); err == nil {
+		t.Error("Expected empty embeddings to be rejected")
+	}
+}
@@ -0,0 +1,363 @@
+package index
+
+import (
+	"container/heap"
+	"math"
+	"sort"
+	"unicode"
+)
+
+// BM25 parameters
+const (
+	bm25K1 = 1.2
+	bm25B  = 0.75
+)
+
+// postingBlockSize is the number of postings summarized by one block-max
+// entry; whole blocks are skipped when their best score cannot make the top k
+const postingBlockSize = 128
+
+// lexicalIndex is an inverted index over verse text. Each term's postings are
+// a run of ascending rows and matching term frequencies in two flat arrays,
+// split into fixed-size blocks that record their last row and the highest
+// BM25 contribution of any posting in the block.
+type lexicalIndex struct {
+	terms map[string]int32
+
+	// term t's postings are rows[postingStarts[t]:postingStarts[t+1]]
+	postingStarts []uint32
+	rows          []uint32
+	freqs         []uint16
+
+	// term t's blocks are blockLast[blockStarts[t]:blockStarts[t+1]]
+	blockStarts []uint32
+	blockLast   []uint32
+	blockMax    []float32
+
+	idf    []float32
+	docLen []uint16
+	avgLen float32
+}
+
+// tokenize lowercases text and splits it into runs of letters and digits;
+// apostrophes inside words are dropped so "LORD'S" and "lords" match
+func tokenize(text string, emit func(token string)) {
+	var buf [64]byte
+	token := buf[:0]
+	flush := func() {
+		if len(token) > 0 {
+			emit(string(token))
+			token = token[:0]
+		}
+	}
+	for _, r := range text {
+		switch {
+		case unicode.IsLetter(r) || unicode.IsDigit(r):
+			token = appendLowerRune(token, r)
+		case r == '\'' || r == '’':
+			// keep the word together
+		default:
+			flush()
+		}
+	}
+	flush()
+}
+
+func appendLowerRune(b []byte, r rune) []byte {
+	if r < 0x80 {
+		if 'A' <= r && r <= 'Z' {
+			r += 'a' - 'A'
+		}
+		return append(b, byte(r))
+	}
+	return append(b, string(unicode.ToLower(r))...)
+}
+
+func newLexicalIndex(verses []Verse) *lexicalIndex {
+	li := &lexicalIndex{
+		terms:  make(map[string]int32),
+		docLen: make([]uint16, len(verses)),
+	}
+
+	// Collect (term, row, freq) postings; rows are visited in order, so each
+	// term's list comes out sorted.
+	var lists [][]uint32
+	var listFreqs [][]uint16
+	counts := make(map[int32]uint16)
+	totalLen := 0
+	for row := range verses {
+		clear(counts)
+		length := 0
+		tokenize(verses[row].Text, func(token string) {
+			id, ok := li.terms[token]
+			if !ok {
+				id = int32(len(lists))
+				li.terms[token] = id
+				lists = append(lists, nil)
+				listFreqs = append(listFreqs, nil)
+			}
+			counts[id]++
+			length++
+		})
+		for id, freq := range counts {
+			lists[id] = append(lists[id], uint32(row))
+			listFreqs[id] = append(listFreqs[id], freq)
+		}
+		li.docLen[row] = uint16(min(length, math.MaxUint16))
+		totalLen += length
+	}
+	if len(verses) > 0 {
+		li.avgLen = float32(totalLen) / float32(len(verses))
+	}
+
+	n := float64(len(verses))
+	li.postingStarts = make([]uint32, 1, len(lists)+1)
+	li.blockStarts = make([]uint32, 1, len(lists)+1)
+	li.idf = make([]float32, len(lists))
+	for id, rows := range lists {
+		df := float64(len(rows))
+		li.idf[id] = float32(math.Log(1 + (n-df+0.5)/(df+0.5)))
+
+		li.rows = append(li.rows, rows...)
+		li.freqs = append(li.freqs, listFreqs[id]...)
+		li.postingStarts = append(li.postingStarts, uint32(len(li.rows)))
+
+		for start := 0; start < len(rows); start += postingBlockSize {
+			end := min(start+postingBlockSize, len(rows))
+			var best float32
+			for i := start; i < end; i++ {
+				best = max(best, li.score(int32(id), rows[i], listFreqs[id][i]))
+			}
+			li.blockLast = append(li.blockLast, rows[end-1])
+			li.blockMax = append(li.blockMax, best)
+		}
+		li.blockStarts = append(li.blockStarts, uint32(len(li.blockLast)))
+	}
+	return li
+}
+
+// score is the BM25 contribution of one posting
+func (li *lexicalIndex) score(term int32, row uint32, freq uint16) float32 {
+	tf := float32(freq)
+	norm := bm25K1 * (1 - bm25B + bm25B*float32(li.docLen[row])/li.avgLen)
+	return li.idf[term] * tf * (bm25K1 + 1) / (tf + norm)
+}
+
+// postingCursor walks one term's postings
+type postingCursor struct {
+	term       int32
+	pos, end   int // into rows/freqs
+	block      int // into blockLast/blockMax
+	blockBase  int // first block of the term
+	blockLimit int
+}
+
+func (c *postingCursor) done() bool { return c.pos >= c.end }
+
+// seek advances to the first posting with row >= target, skipping whole
+// blocks that end before it
+func (c *postingCursor) seek(li *lexicalIndex, target uint32) {
+	for c.block < c.blockLimit && li.blockLast[c.block] < target {
+		c.block++
+	}
+	if c.block >= c.blockLimit {
+		c.pos = c.end
+		return
+	}
+	blockFirst := int(li.postingStarts[c.term]) + (c.block-c.blockBase)*postingBlockSize
+	c.pos = max(c.pos, blockFirst)
+	for c.pos < c.end && li.rows[c.pos] < target {
+		c.pos++
+	}
+}
+
+type lexicalHit struct {
+	row   uint32
+	score float32
+}
+
+// hitHeap is a min-heap of the best hits so far
+type hitHeap []lexicalHit
+
+func (h hitHeap) Len() int           { return len(h) }
+func (h hitHeap) Less(i, j int) bool { return h[i].score < h[j].score }
+func (h hitHeap) Swap(i, j int)      { h[i], h[j] = h[j], h[i] }
+func (h *hitHeap) Push(x any)        { *h = append(*h, x.(lexicalHit)) }
+func (h *hitHeap) Pop() any {
+	old := *h
+	hit := old[len(old)-1]
+	*h = old[:len(old)-1]
+	return hit
+}
+
+// search returns the k best rows for the query by BM25, best first. It walks
+// postings document-at-a-time; when the block maxima of the terms at the
+// current row cannot beat the k-th best score, every row up to the end of
+// those blocks (or the next row of any other term) is skipped.
+func (li *lexicalIndex) search(query string, k int) []lexicalHit {
+	var cursors []postingCursor
+	seen := make(map[int32]bool)
+	tokenize(query, func(token string) {
+		term, ok := li.terms[token]
+		if !ok || seen[term] {
+			return
+		}
+		seen[term] = true
+		cursors = append(cursors, postingCursor{
+			term:       term,
+			pos:        int(li.postingStarts[term]),
+			end:        int(li.postingStarts[term+1]),
+			block:      int(li.blockStarts[term]),
+			blockBase:  int(li.blockStarts[term]),
+			blockLimit: int(li.blockStarts[term+1]),
+		})
+	})
+	if len(cursors) == 0 || k <= 0 {
+		return nil
+	}
+
+	top := make(hitHeap, 0, k)
+	for {
+		pivot := uint32(math.MaxUint32)
+		for i := range cursors {
+			if !cursors[i].done() {
+				pivot = min(pivot, li.rows[cursors[i].pos])
+			}
+		}
+		if pivot == math.MaxUint32 {
+			break
+		}
+
+		var bound float32
+		next := uint64(math.MaxUint32) + 1
+		for i := range cursors {
+			c := &cursors[i]
+			if c.done() {
+				continue
+			}
+			if li.rows[c.pos] == pivot {
+				bound += li.blockMax[c.block]
+				next = min(next, uint64(li.blockLast[c.block])+1)
+			} else {
+				next = min(next, uint64(li.rows[c.pos]))
+			}
+		}
+
+		if len(top) == k && bound <= top[0].score {
+			// Nothing in [pivot, next) can enter the top k
+			for i := range cursors {
+				if c := &cursors[i]; !c.done() && li.rows[c.pos] == pivot {
+					if next > math.MaxUint32 {
+						c.pos = c.end
+					} else {
+						c.seek(li, uint32(next))
+					}
+				}
+			}
+			continue
+		}
+
+		var score float32
+		for i := range cursors {
+			c := &cursors[i]
+			if !c.done() && li.rows[c.pos] == pivot {
+				score += li.score(c.term, pivot, li.freqs[c.pos])
+				c.pos++
+				if c.pos < c.end && li.rows[c.pos] > li.blockLast[c.block] {
+					c.block++
+				}
+			}
+		}
+		if len(top) < k {
+			heap.Push(&top, lexicalHit{row: pivot, score: score})
+		} else if score > top[0].score {
+			top[0] = lexicalHit{row: pivot, score: score}
+			heap.Fix(&top, 0)
+		}
+	}
+
+	sort.Slice(top, func(i, j int) bool {
+		if top[i].score != top[j].score {
+			return top[i].score > top[j].score
+		}
+		return top[i].row < top[j].row
+	})
+	return top
+}
+
+func (vi *VerseIndex) lexical() *lexicalIndex {
+	if li := vi.lexicalIdx.Load(); li != nil {
+		return li
+	}
+	li := newLexicalIndex(vi.Verses)
+	vi.lexicalIdx.CompareAndSwap(nil, li)
+	return vi.lexicalIdx.Load()
+}
+
+// LexicalSearch ranks verses by BM25 over their text. Scores are scaled so
+// the best match is 1.
+func (vi *VerseIndex) LexicalSearch(query string, k int) []SearchResult {
+	if k <= 0 {
+		k = 20
+	}
+	hits := vi.lexical().search(query, k)
+	results := make([]SearchResult, len(hits))
+	for i, hit := range hits {
+		results[i] = SearchResult{
+			Verse:    &vi.Verses[hit.row],
+			Score:    hit.score / hits[0].score,
+			Position: int(hit.row),
+		}
+	}
+	return results
+}
+
+// rrfK is the reciprocal rank fusion constant; 60 is the customary value
+const rrfK = 60
+
+// FuseRankings merges ranked result lists with reciprocal rank fusion and
+// returns the k best. A verse ranked first in every list scores 1.
+func FuseRankings(k int, lists ...[]SearchResult) []SearchResult {
+	type fused struct {
+		result SearchResult
+		score  float64
+	}
+	byID := make(map[string]*fused)
+	var order []*fused
+	for _, list := range lists {
+		for rank, result := range list {
+			f, ok := byID[result.Verse.ID]
+			if !ok {
+				f = &fused{result: result}
+				byID[result.Verse.ID] = f
+				order = append(order, f)
+			}
+			f.score += 1 / float64(rrfK+rank+1)
+		}
+	}
+
+	sort.SliceStable(order, func(i, j int) bool { return order[i].score > order[j].score })
+	if len(order) > k {
+		order = order[:k]
+	}
+	best := float64(len(lists)) / (rrfK + 1)
+	results := make([]SearchResult, len(order))
+	for i, f := range order {
+		results[i] = f.result
+		results[i].Score = float32(f.score / best)
+	}
+	return results
+}
+
+// HybridSearch runs the vector and lexical engines for one query and fuses
+// their rankings
+func (vi *VerseIndex) HybridSearch(query string, queryEmbedding []float32, k int) ([]SearchResult, error) {
+	if k <= 0 {
+		k = 20
+	}
+	vector, err := vi.Search(queryEmbedding, k)
+	if err != nil {
+		return nil, err
+	}
+	return FuseRankings(k, vector, vi.LexicalSearch(query, k)), nil
+}
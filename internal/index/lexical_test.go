@@ -0,0 +1,140 @@
+package index
+
+import (
+	"fmt"
+	"math/rand"
+	"sort"
+	"strings"
+	"testing"
+)
+
+func lexicalTestIndex() *VerseIndex {
+	verseIndex := NewVerseIndex()
+	for _, verse := range []Verse{
+		{ID: "GEN.1.1", Ref: "Genesis 1:1", Text: "In the beginning God created the heaven and the earth."},
+		{ID: "JOH.11.35", Ref: "John 11:35", Text: "Jesus wept."},
+		{ID: "JOH.11.33", Ref: "John 11:33", Text: "When Jesus therefore saw her weeping, and the Jews also weeping which came with her, he groaned in the spirit, and was troubled,"},
+		{ID: "PSA.23.1", Ref: "Psalms 23:1", Text: "The LORD is my shepherd; I shall not want."},
+		{ID: "PSA.23.4", Ref: "Psalms 23:4", Text: "Yea, though I walk through the valley of the shadow of death, I will fear no evil: for thou art with me; thy rod and thy staff they comfort me."},
+		{ID: "JOH.10.11", Ref: "John 10:11", Text: "I am the good shepherd: the good shepherd giveth his life for the sheep."},
+	} {
+		verseIndex.AddVerse(verse)
+	}
+	return verseIndex
+}
+
+func TestLexicalSearch_RanksByBM25(t *testing.T) {
+	verseIndex := lexicalTestIndex()
+
+	results := verseIndex.LexicalSearch("Jesus wept", 3)
+	if len(results) != 2 {
+		t.Fatalf("Expected 2 matching verses, got %d", len(results))
+	}
+	if results[0].Verse.ID != "JOH.11.35" || results[0].Score != 1 {
+		t.Errorf("Expected John 11:35 first with score 1, got %s (%g)", results[0].Verse.ID, results[0].Score)
+	}
+	if results[0].Position != 1 {
+		t.Errorf("Expected position 1, got %d", results[0].Position)
+	}
+
+	// Two occurrences in a short verse beat one in a long verse
+	results = verseIndex.LexicalSearch("the LORD's SHEPHERD", 2)
+	if len(results) != 2 || results[0].Verse.ID != "JOH.10.11" {
+		t.Errorf("Expected John 10:11 first, got %v", results)
+	}
+}
+
+func TestLexicalSearch_NoMatches(t *testing.T) {
+	verseIndex := lexicalTestIndex()
+	for _, query := range []string{"", "  ...  ", "zzyzx"} {
+		if results := verseIndex.LexicalSearch(query, 5); len(results) != 0 {
+			t.Errorf("%q: expected no results, got %d", query, len(results))
+		}
+	}
+}
+
+func TestLexicalSearch_BlockSkippingMatchesExhaustiveScoring(t *testing.T) {
+	rng := rand.New(rand.NewSource(1))
+	words := []string{"lord", "god", "israel", "king", "son", "house", "land", "people", "day", "david", "jerusalem", "covenant"}
+	verseIndex := NewVerseIndex()
+	for i := 0; i < 3000; i++ {
+		n := 3 + rng.Intn(25)
+		text := make([]string, n)
+		for j := range text {
+			// Skewed draws give long posting lists with uneven block maxima
+			text[j] = words[min(rng.Intn(len(words)), rng.Intn(len(words)))]
+		}
+		verseIndex.AddVerse(Verse{ID: fmt.Sprintf("V.%d", i), Text: strings.Join(text, " ")})
+	}
+	li := verseIndex.lexical()
+
+	for _, query := range []string{"lord", "covenant jerusalem", "king david son", "god of israel in the land"} {
+		for _, k := range []int{1, 10, 50} {
+			// Score every row directly
+			scores := make(map[uint32]float32)
+			seen := make(map[int32]bool)
+			tokenize(query, func(token string) {
+				term, ok := li.terms[token]
+				if !ok || seen[term] {
+					return
+				}
+				seen[term] = true
+				for i := li.postingStarts[term]; i < li.postingStarts[term+1]; i++ {
+					scores[li.rows[i]] += li.score(term, li.rows[i], li.freqs[i])
+				}
+			})
+			var expected []float32
+			for _, score := range scores {
+				expected = append(expected, score)
+			}
+			sort.Slice(expected, func(i, j int) bool { return expected[i] > expected[j] })
+			expected = expected[:min(k, len(expected))]
+
+			hits := li.search(query, k)
+			if len(hits) != len(expected) {
+				t.Fatalf("%q k=%d: expected %d hits, got %d", query, k, len(expected), len(hits))
+			}
+			for i, hit := range hits {
+				if hit.score != expected[i] || scores[hit.row] != hit.score {
+					t.Fatalf("%q k=%d: hit %d scored %g, expected %g", query, k, i, hit.score, expected[i])
+				}
+			}
+		}
+	}
+}
+
+func TestFuseRankings(t *testing.T) {
+	a := SearchResult{Verse: &Verse{ID: "A"}}
+	b := SearchResult{Verse: &Verse{ID: "B"}}
+	c := SearchResult{Verse: &Verse{ID: "C"}}
+
+	fused := FuseRankings(2, []SearchResult{a, b}, []SearchResult{a, c})
+	if len(fused) != 2 {
+		t.Fatalf("Expected 2 results, got %d", len(fused))
+	}
+	if fused[0].Verse.ID != "A" || fused[0].Score != 1 {
+		t.Errorf("Expected A first with score 1, got %s (%g)", fused[0].Verse.ID, fused[0].Score)
+	}
+	if fused[1].Verse.ID != "B" {
+		t.Errorf("Expected ties to keep first-list order, got %s", fused[1].Verse.ID)
+	}
+}
+
+func BenchmarkLexicalSearch(b *testing.B) {
+	rng := rand.New(rand.NewSource(1))
+	words := strings.Fields("and the of to that in he shall unto for i his a lord they be is him not them it with all thou")
+	verseIndex := NewVerseIndex()
+	for i := 0; i < 31102; i++ {
+		text := make([]string, 10+rng.Intn(30))
+		for j := range text {
+			text[j] = words[min(rng.Intn(len(words)), rng.Intn(len(words)))]
+		}
+		verseIndex.AddVerse(Verse{ID: fmt.Sprintf("V.%d", i), Text: strings.Join(text, " ")})
+	}
+	verseIndex.lexical()
+
+	b.ResetTimer()
+	for i := 0; i < b.N; i++ {
+		verseIndex.LexicalSearch("the lord shall be with thee", 20)
+	}
+}
@@ -0,0 +1,187 @@
+package index
+
+import (
+	"errors"
+	"fmt"
+	"strings"
+)
+
+// ErrUnknownReference is returned when a reference names no verse or chapter
+var ErrUnknownReference = errors.New("unknown reference")
+
+// lookupTables map verse IDs, references and chapters to rows of Verses.
+// Verses are stored in canonical order, so a chapter or a range of
+// references is a contiguous span of rows.
+type lookupTables struct {
+	byID     map[string]int32
+	byRef    map[string]int32
+	chapters map[string]rowSpan // keyed by "ROM.8" and "Romans 8"
+}
+
+type rowSpan struct {
+	start, end int32
+}
+
+func newLookupTables(verses []Verse) *lookupTables {
+	t := &lookupTables{
+		byID:     make(map[string]int32, len(verses)),
+		byRef:    make(map[string]int32, len(verses)),
+		chapters: make(map[string]rowSpan, 2*len(verses)/20),
+	}
+	for i := range verses {
+		row := int32(i)
+		verse := &verses[i]
+		if _, dup := t.byID[verse.ID]; !dup {
+			t.byID[verse.ID] = row
+		}
+		if _, dup := t.byRef[verse.Ref]; !dup && verse.Ref != "" {
+			t.byRef[verse.Ref] = row
+		}
+		if dot := strings.LastIndexByte(verse.ID, '.'); dot > 0 {
+			t.extendChapter(verse.ID[:dot], row)
+		}
+		if colon := strings.LastIndexByte(verse.Ref, ':'); colon > 0 {
+			t.extendChapter(verse.Ref[:colon], row)
+		}
+	}
+	return t
+}
+
+func (t *lookupTables) extendChapter(key string, row int32) {
+	span, ok := t.chapters[key]
+	if !ok {
+		span.start = row
+	}
+	span.end = row + 1
+	t.chapters[key] = span
+}
+
+func (vi *VerseIndex) lookupTables() *lookupTables {
+	if t := vi.lookups.Load(); t != nil {
+		return t
+	}
+	t := newLookupTables(vi.Verses)
+	vi.lookups.CompareAndSwap(nil, t)
+	return vi.lookups.Load()
+}
+
+// GetByRef finds a verse by its reference string
+func (vi *VerseIndex) GetByRef(ref string) (*Verse, bool) {
+	row, ok := vi.lookupTables().byRef[ref]
+	if !ok {
+		return nil, false
+	}
+	return &vi.Verses[row], true
+}
+
+// GetByID finds a verse by its ID
+func (vi *VerseIndex) GetByID(id string) (*Verse, bool) {
+	i, ok := vi.Position(id)
+	if !ok {
+		return nil, false
+	}
+	return &vi.Verses[i], true
+}
+
+// Position returns the row in Verses of the verse with the given ID
+func (vi *VerseIndex) Position(id string) (int, bool) {
+	row, ok := vi.lookupTables().byID[id]
+	return int(row), ok
+}
+
+// Span returns rows [start, end) of Verses as a view, without copying
+func (vi *VerseIndex) Span(start, end int) []Verse {
+	return vi.Verses[start:end:end]
+}
+
+// LookupReference resolves a verse, chapter or range to the rows [start, end)
+// it covers. References may be IDs or display references; the end of a range
+// may abbreviate what it shares with the start:
+//
+//	JOH.3.16, John 3:16    one verse
+//	ROM.8, Romans 8        a whole chapter
+//	ROM.8.28-39            verses 28 to 39 of Romans 8
+//	ROM.8.28-9.3           Romans 8:28 to 9:3
+//	Romans 8:28-39, Romans 8-9
+func (vi *VerseIndex) LookupReference(reference string) (start, end int, err error) {
+	reference = strings.TrimSpace(reference)
+	from, to, isRange := strings.Cut(reference, "-")
+	from, to = strings.TrimSpace(from), strings.TrimSpace(to)
+
+	t := vi.lookupTables()
+	first, ok := t.resolve(from)
+	if !ok {
+		return 0, 0, fmt.Errorf("%w: %s", ErrUnknownReference, from)
+	}
+	if !isRange {
+		return int(first.start), int(first.end), nil
+	}
+
+	last, ok := t.resolve(expandRangeEnd(from, to))
+	if !ok {
+		return 0, 0, fmt.Errorf("%w: %s", ErrUnknownReference, to)
+	}
+	if last.end <= first.start {
+		return 0, 0, fmt.Errorf("range %s ends before it starts", reference)
+	}
+	return int(first.start), int(last.end), nil
+}
+
+// resolve maps a single verse or chapter key to its rows
+func (t *lookupTables) resolve(key string) (rowSpan, bool) {
+	if row, ok := t.byID[key]; ok {
+		return rowSpan{row, row + 1}, true
+	}
+	if row, ok := t.byRef[key]; ok {
+		return rowSpan{row, row + 1}, true
+	}
+	span, ok := t.chapters[key]
+	return span, ok
+}
+
+// SpanReference formats rows [start, end) as a display reference range,
+// abbreviating the end where it shares a book or chapter with the start:
+// "Romans 8:28-30", "Romans 8:38-9:2"
+func (vi *VerseIndex) SpanReference(start, end int) string {
+	first := vi.Verses[start].Ref
+	if end-start <= 1 {
+		return first
+	}
+	last := vi.Verses[end-1].Ref
+	firstColon, lastColon := strings.LastIndexByte(first, ':'), strings.LastIndexByte(last, ':')
+	firstSpace, lastSpace := strings.LastIndexByte(first, ' '), strings.LastIndexByte(last, ' ')
+	switch {
+	case firstColon > 0 && lastColon > 0 && first[:firstColon] == last[:lastColon]:
+		return first + "-" + last[lastColon+1:]
+	case firstSpace > 0 && lastSpace > 0 && first[:firstSpace] == last[:lastSpace]:
+		return first + "-" + last[lastSpace+1:]
+	}
+	return first + "-" + last
+}
+
+// expandRangeEnd completes an abbreviated range end from the range start,
+// e.g. ("ROM.8.28", "39") -> "ROM.8.39" and ("Romans 8:28", "9:3") -> "Romans 9:3"
+func expandRangeEnd(from, to string) string {
+	if !strings.Contains(from, " ") {
+		// ID form: the end replaces as many trailing components as it has
+		fromParts := strings.Split(from, ".")
+		toParts := strings.Split(to, ".")
+		if len(toParts) >= len(fromParts) {
+			return to
+		}
+		return strings.Join(append(fromParts[:len(fromParts)-len(toParts)], toParts...), ".")
+	}
+
+	// Reference form: "Book C:V", "Book C"
+	if strings.Contains(to, " ") {
+		return to
+	}
+	book := from[:strings.LastIndexByte(from, ' ')]
+	if strings.Contains(to, ":") {
+		return book + " " + to
+	}
+	if colon := strings.LastIndexByte(from, ':'); colon >= 0 {
+		return from[:colon+1] + to
+	}
+	return book + " " + to
+}
@@ -0,0 +1,114 @@
+package index
+
+import (
+	"errors"
+	"fmt"
+	"testing"
+)
+
+func lookupTestIndex() *VerseIndex {
+	verseIndex := NewVerseIndex()
+	books := []struct {
+		id, name string
+		chapters []int
+	}{
+		{"ROM", "Romans", []int{3, 39, 38}},
+		{"1CO", "1 Corinthians", []int{2}},
+	}
+	for _, book := range books {
+		for chapter, verses := range book.chapters {
+			for verse := 1; verse <= verses; verse++ {
+				verseIndex.AddVerse(Verse{
+					ID:  fmt.Sprintf("%s.%d.%d", book.id, chapter+7, verse),
+					Ref: fmt.Sprintf("%s %d:%d", book.name, chapter+7, verse),
+				})
+			}
+		}
+	}
+	return verseIndex
+}
+
+func TestGetByRef_ReturnsStoredVerse(t *testing.T) {
+	verseIndex := lookupTestIndex()
+	verse, ok := verseIndex.GetByRef("Romans 8:28")
+	if !ok {
+		t.Fatal("Expected to find Romans 8:28")
+	}
+	if verse != &verseIndex.Verses[3+27] {
+		t.Error("Expected a pointer into the index, not a copy")
+	}
+	if byID, _ := verseIndex.GetByID("ROM.8.28"); byID != verse {
+		t.Error("Expected GetByID and GetByRef to agree")
+	}
+}
+
+func TestLookupReference(t *testing.T) {
+	verseIndex := lookupTestIndex()
+	row := func(id string) int {
+		p, ok := verseIndex.Position(id)
+		if !ok {
+			t.Fatalf("Unknown test verse %s", id)
+		}
+		return p
+	}
+
+	tests := []struct {
+		reference  string
+		start, end string // first and last verse IDs
+	}{
+		{"ROM.8.28", "ROM.8.28", "ROM.8.28"},
+		{"Romans 8:28", "ROM.8.28", "ROM.8.28"},
+		{"ROM.8.28-39", "ROM.8.28", "ROM.8.39"},
+		{"Romans 8:28-39", "ROM.8.28", "ROM.8.39"},
+		{"ROM.8.28-9.3", "ROM.8.28", "ROM.9.3"},
+		{"Romans 8:28-9:3", "ROM.8.28", "ROM.9.3"},
+		{"ROM.8", "ROM.8.1", "ROM.8.39"},
+		{"Romans 7-8", "ROM.7.1", "ROM.8.39"},
+		{"ROM.9.38-1CO.7.1", "ROM.9.38", "1CO.7.1"},
+		{"1 Corinthians 7:1-2", "1CO.7.1", "1CO.7.2"},
+	}
+	for _, tt := range tests {
+		start, end, err := verseIndex.LookupReference(tt.reference)
+		if err != nil {
+			t.Errorf("%s: unexpected error %v", tt.reference, err)
+			continue
+		}
+		if start != row(tt.start) || end != row(tt.end)+1 {
+			t.Errorf("%s: expected rows [%d, %d), got [%d, %d)", tt.reference, row(tt.start), row(tt.end)+1, start, end)
+		}
+		if span := verseIndex.Span(start, end); span[0].ID != tt.start || span[len(span)-1].ID != tt.end {
+			t.Errorf("%s: span covers %s to %s", tt.reference, span[0].ID, span[len(span)-1].ID)
+		}
+	}
+
+	for _, reference := range []string{"ROM.8.40", "Hezekiah 1:1", "ROM.8.28-45"} {
+		if _, _, err := verseIndex.LookupReference(reference); !errors.Is(err, ErrUnknownReference) {
+			t.Errorf("%s: expected ErrUnknownReference, got %v", reference, err)
+		}
+	}
+	if _, _, err := verseIndex.LookupReference("ROM.8.28-3"); err == nil || errors.Is(err, ErrUnknownReference) {
+		t.Errorf("Expected a backwards range to be rejected, got %v", err)
+	}
+}
+
+func TestSpanReference(t *testing.T) {
+	verseIndex := lookupTestIndex()
+	cases := []struct {
+		start, end int
+		expected   string
+	}{
+		{3, 4, "Romans 8:1"},
+		{3 + 27, 3 + 30, "Romans 8:28-30"},
+		{3 + 37, 3 + 41, "Romans 8:38-9:2"},
+		{3 + 39 + 37, 3 + 39 + 38 + 2, "Romans 9:38-1 Corinthians 7:2"},
+	}
+	for _, c := range cases {
+		if got := verseIndex.SpanReference(c.start, c.end); got != c.expected {
+			t.Errorf("SpanReference(%d, %d): expected %q, got %q", c.start, c.end, c.expected, got)
+		}
+		// Every formatted span resolves back to the same rows
+		if start, end, err := verseIndex.LookupReference(verseIndex.SpanReference(c.start, c.end)); err != nil || start != c.start || end != c.end {
+			t.Errorf("LookupReference(%q) = %d, %d, %v", verseIndex.SpanReference(c.start, c.end), start, end, err)
+		}
+	}
+}
@@ -0,0 +1,73 @@
+package index
+
+import (
+	"fmt"
+	"sort"
+
+	"versejet/internal/hnsw"
+)
+
+// Diversity defaults; a lambda of 1 ranks by relevance alone, so reranking
+// is opt-in with a lower one
+const (
+	DefaultMMRLambda      = 1.0
+	DefaultChapterPenalty = 0.1
+)
+
+// MMRCandidates is how many of the best verses are offered to Diversify;
+// it is the most Search returns
+const MMRCandidates = 50
+
+// Diversify reranks verse results by maximal marginal relevance and keeps
+// the k best. Each pick trades the result's score (weight lambda) against
+// its highest similarity to the results already picked (weight 1-lambda),
+// and loses chapterPenalty if an earlier pick is from the same chapter, so
+// runs of neighbouring verses give way to other passages. Scores are left
+// as they were. Passage results are returned unchanged.
+func (vi *VerseIndex) Diversify(results []SearchResult, k int, lambda, chapterPenalty float32) ([]SearchResult, error) {
+	if lambda < 0 || lambda > 1 {
+		return nil, fmt.Errorf("lambda must be between 0 and 1")
+	}
+	if len(results) == 0 || k <= 0 {
+		return results, nil
+	}
+	dim := vi.Dimension()
+	for _, result := range results {
+		if result.End != 0 || len(result.Verse.Embedding) != dim {
+			return results, nil
+		}
+	}
+
+	chapters := vi.hierarchy().chapters
+	candidates := make([]float32, len(results)*dim)
+	relevance := make([]float32, len(results))
+	groups := make([]int32, len(results))
+	for i, result := range results {
+		normalizeInto(candidates[i*dim:(i+1)*dim], result.Verse.Embedding)
+		relevance[i] = result.Score
+		position, ok := result.Position, result.Position >= 0
+		if !ok {
+			// Results of a SegmentedIndex carry no row; verses written since
+			// the index was loaded are a chapter of their own
+			position, ok = vi.Position(result.Verse.ID)
+		}
+		if !ok {
+			groups[i] = int32(len(chapters) + i)
+			continue
+		}
+		groups[i] = int32(sort.Search(len(chapters), func(c int) bool {
+			return int(chapters[c].end) > position
+		}))
+	}
+
+	order := make([]int32, min(k, len(results)))
+	picked, err := hnsw.SelectMMR(candidates, dim, relevance, groups, k, lambda, chapterPenalty, order)
+	if err != nil {
+		return nil, fmt.Errorf("failed to diversify results: %w", err)
+	}
+	diversified := make([]SearchResult, picked)
+	for i, candidate := range order[:picked] {
+		diversified[i] = results[candidate]
+	}
+	return diversified, nil
+}
@@ -0,0 +1,54 @@
+package index
+
+import (
+	"fmt"
+	"testing"
+)
+
+// mmrTestIndex has a chapter of near-identical verses and a second chapter
+// pointing a little further from the query
+func mmrTestIndex() *VerseIndex {
+	verseIndex := NewVerseIndex()
+	for verse := 1; verse <= 5; verse++ {
+		verseIndex.AddVerse(Verse{
+			ID:        fmt.Sprintf("ROM.8.%d", verse),
+			Ref:       fmt.Sprintf("Romans 8:%d", verse),
+			Embedding: []float32{1, 0.05 * float32(verse), 0},
+		})
+	}
+	verseIndex.AddVerse(Verse{ID: "JOH.3.16", Ref: "John 3:16", Embedding: []float32{0.8, 0, 0.6}})
+	return verseIndex
+}
+
+func TestDiversify_SpreadsAcrossChapters(t *testing.T) {
+	verseIndex := mmrTestIndex()
+	query := []float32{1, 0, 0.2}
+	results, err := verseIndex.Search(query, MMRCandidates)
+	if err != nil {
+		t.Fatalf("Search failed: %v", err)
+	}
+	if results[1].Verse.ID != "ROM.8.2" {
+		t.Fatalf("Expected Romans 8 to fill the top of the ranking, got %v", resultIDs(results))
+	}
+
+	diversified, err := verseIndex.Diversify(results, 3, 0.7, DefaultChapterPenalty)
+	if err != nil {
+		t.Fatalf("Diversify failed: %v", err)
+	}
+	if len(diversified) != 3 || diversified[0].Verse.ID != results[0].Verse.ID || diversified[1].Verse.ID != "JOH.3.16" {
+		t.Errorf("Expected John 3:16 second, got %v", resultIDs(diversified))
+	}
+	if diversified[1].Score != results[len(results)-1].Score {
+		t.Errorf("Expected John 3:16 to keep its score %g, got %g", results[len(results)-1].Score, diversified[1].Score)
+	}
+
+	// Lambda 1 keeps the relevance order
+	same, _ := verseIndex.Diversify(results, 4, 1, 0)
+	if fmt.Sprint(resultIDs(same)) != fmt.Sprint(resultIDs(results[:4])) {
+		t.Errorf("Expected relevance order, got %v", resultIDs(same))
+	}
+
+	if _, err := verseIndex.Diversify(results, 3, 1.5, 0); err == nil {
+		t.Error("Expected an error for lambda outside [0, 1]")
+	}
+}
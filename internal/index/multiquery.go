@@ -0,0 +1,98 @@
+package index
+
+import (
+	"fmt"
+
+	"versejet/internal/hnsw"
+)
+
+// Ways SearchMulti combines a verse's weighted similarities to the examples
+const (
+	CombineSum = "sum" // weighted sum: like all positive examples, unlike negative ones
+	CombineMax = "max" // like any one example
+	CombineMin = "min" // like every example
+)
+
+// WeightedQuery is one example of a multi-vector query. A negative weight
+// pushes results away from the example.
+type WeightedQuery struct {
+	Embedding []float32
+	Weight    float32
+}
+
+// SearchMulti ranks verses against several weighted query embeddings in a
+// single scan. Weights are scaled so the positive ones sum to 1, so a lone
+// example scores like Search and several positive examples score their
+// weighted mean similarity under CombineSum. Verses whose combined score is
+// not above zero are not returned.
+func (vi *VerseIndex) SearchMulti(queries []WeightedQuery, combine string, k int) ([]SearchResult, error) {
+	var mode int
+	switch combine {
+	case CombineSum, "":
+		mode = hnsw.CombineSum
+	case CombineMax:
+		mode = hnsw.CombineMax
+	case CombineMin:
+		mode = hnsw.CombineMin
+	default:
+		return nil, fmt.Errorf("combine must be %s, %s or %s", CombineSum, CombineMax, CombineMin)
+	}
+	if len(queries) == 0 {
+		return nil, fmt.Errorf("at least one query embedding is required")
+	}
+	if k <= 0 {
+		k = 20
+	}
+
+	var positive float32
+	for _, q := range queries {
+		positive += max(q.Weight, 0)
+	}
+	if positive == 0 {
+		return nil, fmt.Errorf("at least one query needs a positive weight")
+	}
+	dim := vi.Dimension()
+	matrix := make([]float32, len(queries)*dim)
+	weights := make([]float32, len(queries))
+	for i, q := range queries {
+		if len(q.Embedding) != dim {
+			return nil, fmt.Errorf("query %d has %d dimensions, index has %d", i, len(q.Embedding), dim)
+		}
+		normalizeInto(matrix[i*dim:(i+1)*dim], q.Embedding)
+		weights[i] = q.Weight / positive
+	}
+
+	ids := make([]int32, k)
+	scores := make([]float32, k)
+	var count int
+	var err error
+	embeddings, release := vi.acquireMatrix()
+	defer release()
+	if embeddings != nil {
+		count, err = embeddings.MultiQuerySearch(matrix, weights, mode, k, 0, ids, scores)
+	} else {
+		vectors := make([]*hnsw.Vector, len(vi.Verses))
+		for i := range vi.Verses {
+			vectors[i] = hnsw.NewVector(vi.Verses[i].Embedding)
+			if vectors[i] == nil {
+				// Rows without an embedding never match
+				vectors[i] = hnsw.NewVector([]float32{0})
+			}
+			defer vectors[i].Free()
+		}
+		count, err = hnsw.MultiQuerySearch(vectors, matrix, dim, weights, mode, k, 0, ids, scores)
+	}
+	if err != nil {
+		return nil, err
+	}
+
+	results := make([]SearchResult, 0, count)
+	for i := 0; i < count; i++ {
+		if scores[i] <= 0 {
+			continue
+		}
+		row := int(ids[i])
+		results = append(results, SearchResult{Verse: &vi.Verses[row], Score: scores[i], Position: row})
+	}
+	return results, nil
+}
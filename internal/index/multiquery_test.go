@@ -0,0 +1,91 @@
+package index
+
+import (
+	"math"
+	"math/rand"
+	"sort"
+	"testing"
+)
+
+func TestSearchMulti_MatchesDirectScoring(t *testing.T) {
+	rng := rand.New(rand.NewSource(17))
+	verseIndex := hierarchyTestIndex(rng, 30) // not a multiple of 4
+	examples := []WeightedQuery{
+		{Embedding: verseIndex.Verses[10].Embedding, Weight: 2},
+		{Embedding: verseIndex.Verses[250].Embedding, Weight: 1},
+		{Embedding: verseIndex.Verses[420].Embedding, Weight: 1},
+		{Embedding: verseIndex.Verses[11].Embedding, Weight: -1},
+		{Embedding: verseIndex.Verses[560].Embedding, Weight: 0.5},
+	}
+
+	for _, combine := range []string{CombineSum, CombineMax, CombineMin} {
+		type scored struct {
+			row   int
+			score float64
+		}
+		var expected []scored
+		for row, verse := range verseIndex.Verses {
+			combined := 0.0
+			switch combine {
+			case CombineMax:
+				combined = math.Inf(-1)
+			case CombineMin:
+				combined = math.Inf(1)
+			}
+			for _, example := range examples {
+				weighted := float64(example.Weight/4.5) * float64(cosineSimilarity(example.Embedding, verse.Embedding))
+				switch combine {
+				case CombineSum:
+					combined += weighted
+				case CombineMax:
+					combined = math.Max(combined, weighted)
+				case CombineMin:
+					combined = math.Min(combined, weighted)
+				}
+			}
+			if combined > 0 {
+				expected = append(expected, scored{row, combined})
+			}
+		}
+		sort.Slice(expected, func(i, j int) bool { return expected[i].score > expected[j].score })
+
+		results, err := verseIndex.SearchMulti(examples, combine, 15)
+		if err != nil {
+			t.Fatalf("%s: SearchMulti failed: %v", combine, err)
+		}
+		if len(results) != min(15, len(expected)) {
+			t.Fatalf("%s: expected %d results, got %d", combine, min(15, len(expected)), len(results))
+		}
+		for i, result := range results {
+			if math.Abs(float64(result.Score)-expected[i].score) > 1e-4 {
+				t.Errorf("%s: result %d scored %g, expected %g", combine, i, result.Score, expected[i].score)
+			}
+		}
+	}
+}
+
+func TestSearchMulti_SingleExampleMatchesSearch(t *testing.T) {
+	rng := rand.New(rand.NewSource(19))
+	verseIndex := hierarchyTestIndex(rng, 32)
+	query := verseIndex.Verses[123].Embedding
+
+	flat, _ := verseIndex.Search(query, 10)
+	multi, err := verseIndex.SearchMulti([]WeightedQuery{{Embedding: query, Weight: 3}}, CombineSum, 10)
+	if err != nil {
+		t.Fatalf("SearchMulti failed: %v", err)
+	}
+	for i := range flat {
+		if multi[i].Position != flat[i].Position {
+			t.Errorf("Result %d: expected %s, got %s", i, flat[i].Verse.ID, multi[i].Verse.ID)
+		}
+	}
+
+	for _, bad := range [][]WeightedQuery{nil, {{Embedding: query, Weight: -1}}, {{Embedding: query[:4], Weight: 1}}} {
+		if _, err := verseIndex.SearchMulti(bad, CombineSum, 10); err == nil {
+			t.Errorf("Expected an error for %d queries", len(bad))
+		}
+	}
+	if _, err := verseIndex.SearchMulti([]WeightedQuery{{Embedding: query, Weight: 1}}, "avg", 10); err == nil {
+		t.Error("Expected an error for an unknown combination")
+	}
+}
@@ -0,0 +1,40 @@
+package index
+
+import "fmt"
+
+// Partition splits the verses into n shard indexes of whole books, in order,
+// with about the same number of verses each. Keeping books whole lets every
+// shard serve context windows and references for its own verses. The related
+// table refers to rows of the full index and is not carried over.
+func (vi *VerseIndex) Partition(n int) ([]*VerseIndex, error) {
+	var bookStarts []int
+	for row := range vi.Verses {
+		if row == 0 || bookOf(vi.Verses[row].ID) != bookOf(vi.Verses[row-1].ID) {
+			bookStarts = append(bookStarts, row)
+		}
+	}
+	if n <= 0 || n > len(bookStarts) {
+		return nil, fmt.Errorf("cannot split %d books into %d shards", len(bookStarts), n)
+	}
+	bookStarts = append(bookStarts, len(vi.Verses))
+
+	// Cut at the book boundary nearest each even split, leaving at least one
+	// book for every later shard
+	shards := make([]*VerseIndex, 0, n)
+	book := 0
+	for shard := 0; shard < n; shard++ {
+		end := len(bookStarts) - 1
+		if shard < n-1 {
+			target := len(vi.Verses) * (shard + 1) / n
+			end = book + 1
+			for end < len(bookStarts)-1-(n-1-shard) && bookStarts[end+1]-target < target-bookStarts[end] {
+				end++
+			}
+		}
+		part := NewVerseIndex()
+		part.Verses = append([]Verse(nil), vi.Verses[bookStarts[book]:bookStarts[end]]...)
+		shards = append(shards, part)
+		book = end
+	}
+	return shards, nil
+}
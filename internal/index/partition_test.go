@@ -0,0 +1,48 @@
+package index
+
+import (
+	"fmt"
+	"testing"
+)
+
+func TestPartition_SplitsAtBookBoundaries(t *testing.T) {
+	verseIndex := NewVerseIndex()
+	for book, size := range []int{10, 50, 5, 30, 5} {
+		for verse := 1; verse <= size; verse++ {
+			verseIndex.AddVerse(Verse{ID: fmt.Sprintf("B%d.1.%d", book, verse), Embedding: []float32{1, 0}})
+		}
+	}
+
+	for n, sizes := range map[int][]int{
+		1: {100},
+		2: {60, 40},
+		3: {10, 55, 35},
+		5: {10, 50, 5, 30, 5},
+	} {
+		shards, err := verseIndex.Partition(n)
+		if err != nil {
+			t.Fatalf("n=%d: Partition failed: %v", n, err)
+		}
+		row := 0
+		for i, shard := range shards {
+			if len(shard.Verses) != sizes[i] {
+				t.Errorf("n=%d: expected shard %d to have %d verses, got %d", n, i, sizes[i], len(shard.Verses))
+			}
+			for _, verse := range shard.Verses {
+				if verse.ID != verseIndex.Verses[row].ID {
+					t.Fatalf("n=%d: expected %s in order, got %s", n, verseIndex.Verses[row].ID, verse.ID)
+				}
+				row++
+			}
+		}
+		if row != len(verseIndex.Verses) {
+			t.Errorf("n=%d: expected every verse in a shard, got %d", n, row)
+		}
+	}
+
+	for _, n := range []int{0, 6} {
+		if _, err := verseIndex.Partition(n); err == nil {
+			t.Errorf("n=%d: expected an error", n)
+		}
+	}
+}
@@ -0,0 +1,162 @@
+package index
+
+import (
+	"fmt"
+	"sort"
+
+	"versejet/internal/hnsw"
+)
+
+// Passage pooling schemes
+const (
+	PoolMean       = "mean"       // every verse in the window counts equally
+	PoolTriangular = "triangular" // verses nearer the middle of the window count more
+)
+
+// MaxPassageWindow bounds the number of verses pooled into one passage
+const MaxPassageWindow = 10
+
+// passageTable holds an embedding for every window of a fixed number of
+// consecutive verses that stays within one book. Embeddings are derived from
+// the verse embeddings, so building them needs no embedding API calls.
+type passageTable struct {
+	window int
+	starts []int32     // first row of passage i
+	rows   [][]float32 // unit embedding of passage i, views into one matrix
+}
+
+// passageSet maps a window size to its passages
+type passageSet map[int]*passageTable
+
+// poolingWeights returns the weight of each verse in a window
+func poolingWeights(pooling string, window int) ([]float32, error) {
+	weights := make([]float32, window)
+	for i := range weights {
+		switch pooling {
+		case PoolMean:
+			weights[i] = 1
+		case PoolTriangular:
+			weights[i] = float32(min(i+1, window-i))
+		default:
+			return nil, fmt.Errorf("unknown passage pooling %q", pooling)
+		}
+	}
+	return weights, nil
+}
+
+// BuildPassages derives passage embeddings for each window size by pooling
+// the normalized embeddings of consecutive verses in the C kernel and
+// renormalizing. It replaces any passages built before.
+func (vi *VerseIndex) BuildPassages(windows []int, pooling string) error {
+	count, dim := len(vi.Verses), vi.Dimension()
+	if count == 0 || dim == 0 {
+		return fmt.Errorf("index has no embeddings")
+	}
+	matrix := make([]float32, count*dim)
+	for i, verse := range vi.Verses {
+		if len(verse.Embedding) != dim {
+			return fmt.Errorf("verse %s has %d dimensions, expected %d", verse.ID, len(verse.Embedding), dim)
+		}
+		normalizeInto(matrix[i*dim:(i+1)*dim], verse.Embedding)
+	}
+	bookEnd := vi.textArena().bookEnd
+
+	set := make(passageSet, len(windows))
+	for _, window := range windows {
+		if window < 2 || window > MaxPassageWindow {
+			return fmt.Errorf("passage window must be between 2 and %d verses, got %d", MaxPassageWindow, window)
+		}
+		weights, err := poolingWeights(pooling, window)
+		if err != nil {
+			return err
+		}
+
+		var starts []int32
+		for row := 0; row+window <= count; row++ {
+			if row+window <= int(bookEnd[row]) {
+				starts = append(starts, int32(row))
+			}
+		}
+		pooled := make([]float32, len(starts)*dim)
+		if err := hnsw.PoolWindows(matrix, count, dim, starts, weights, pooled); err != nil {
+			return fmt.Errorf("failed to pool %d-verse passages: %w", window, err)
+		}
+
+		table := &passageTable{window: window, starts: starts, rows: make([][]float32, len(starts))}
+		for i := range starts {
+			table.rows[i] = pooled[i*dim : (i+1)*dim : (i+1)*dim]
+		}
+		set[window] = table
+	}
+	vi.passages.Store(&set)
+	return nil
+}
+
+// PassageWindows lists the window sizes with built passages, smallest first
+func (vi *VerseIndex) PassageWindows() []int {
+	set := vi.passages.Load()
+	if set == nil {
+		return nil
+	}
+	windows := make([]int, 0, len(*set))
+	for window := range *set {
+		windows = append(windows, window)
+	}
+	sort.Ints(windows)
+	return windows
+}
+
+// SearchPassages ranks passages of the given window size by cosine
+// similarity to the query in one scan. Each result's Verse and Position are
+// the passage's first verse and End is one past its last; passages that
+// overlap a better-scoring one are dropped.
+func (vi *VerseIndex) SearchPassages(queryEmbedding []float32, window, k int) ([]SearchResult, error) {
+	if len(queryEmbedding) == 0 {
+		return nil, fmt.Errorf("query embedding cannot be empty")
+	}
+	var table *passageTable
+	if set := vi.passages.Load(); set != nil {
+		table = (*set)[window]
+	}
+	if table == nil {
+		return nil, fmt.Errorf("no %d-verse passages have been built", window)
+	}
+	if k <= 0 {
+		k = 20
+	}
+	if k > 50 {
+		k = 50
+	}
+
+	// Neighbouring windows share most of their verses and score alike, so
+	// look deep enough to fill k after dropping overlaps
+	scored, err := scanEmbeddings(table.rows, queryEmbedding, k*window, minSimilarity, nil)
+	if err != nil {
+		return nil, err
+	}
+	results := make([]SearchResult, 0, k)
+	for _, s := range scored {
+		start := int(table.starts[s.row])
+		end := start + window
+		overlaps := false
+		for _, kept := range results {
+			if start < kept.End && kept.Position < end {
+				overlaps = true
+				break
+			}
+		}
+		if overlaps {
+			continue
+		}
+		results = append(results, SearchResult{
+			Verse:    &vi.Verses[start],
+			Score:    s.score,
+			Position: start,
+			End:      end,
+		})
+		if len(results) == k {
+			break
+		}
+	}
+	return results, nil
+}
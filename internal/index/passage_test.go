@@ -0,0 +1,104 @@
+package index
+
+import (
+	"fmt"
+	"math"
+	"testing"
+)
+
+func passageTestIndex() *VerseIndex {
+	verseIndex := NewVerseIndex()
+	for book, name := range []string{"GEN", "EXO"} {
+		for verse := 1; verse <= 6; verse++ {
+			// Each book spans its own six dimensions
+			embedding := make([]float32, 12)
+			embedding[book*6+verse-1] = 1
+			embedding[book*6+verse%6] = 0.5
+			verseIndex.AddVerse(Verse{
+				ID:        fmt.Sprintf("%s.1.%d", name, verse),
+				Ref:       fmt.Sprintf("%s 1:%d", name, verse),
+				Text:      fmt.Sprintf("%s verse %d.", name, verse),
+				Embedding: embedding,
+			})
+		}
+	}
+	return verseIndex
+}
+
+func TestBuildPassages_PoolsWithinBooks(t *testing.T) {
+	verseIndex := passageTestIndex()
+	if err := verseIndex.BuildPassages([]int{3}, PoolTriangular); err != nil {
+		t.Fatalf("BuildPassages failed: %v", err)
+	}
+	table := (*verseIndex.passages.Load())[3]
+
+	// Four windows fit in each six-verse book
+	if len(table.starts) != 8 || table.starts[3] != 3 || table.starts[4] != 6 {
+		t.Fatalf("Expected windows starting at 0-3 and 6-9, got %v", table.starts)
+	}
+
+	weights := []float32{1, 2, 1}
+	for i, start := range table.starts {
+		expected := make([]float32, 12)
+		for offset, weight := range weights {
+			unit := make([]float32, 12)
+			normalizeInto(unit, verseIndex.Verses[int(start)+offset].Embedding)
+			for d := range expected {
+				expected[d] += weight * unit[d]
+			}
+		}
+		normalizeInto(expected, expected)
+		for d := range expected {
+			if math.Abs(float64(expected[d]-table.rows[i][d])) > 1e-6 {
+				t.Fatalf("Passage %d: expected %v, got %v", i, expected, table.rows[i])
+			}
+		}
+	}
+
+	if got := verseIndex.PassageWindows(); len(got) != 1 || got[0] != 3 {
+		t.Errorf("Expected passage windows [3], got %v", got)
+	}
+}
+
+func TestBuildPassages_RejectsBadConfig(t *testing.T) {
+	verseIndex := passageTestIndex()
+	if err := verseIndex.BuildPassages([]int{1}, PoolMean); err == nil {
+		t.Error("Expected an error for a one-verse window")
+	}
+	if err := verseIndex.BuildPassages([]int{3}, "max"); err == nil {
+		t.Error("Expected an error for an unknown pooling")
+	}
+	if verseIndex.PassageWindows() != nil {
+		t.Error("Expected no passages after failed builds")
+	}
+}
+
+func TestSearchPassages_ReturnsDisjointSpans(t *testing.T) {
+	verseIndex := passageTestIndex()
+	if err := verseIndex.BuildPassages([]int{2, 3}, PoolMean); err != nil {
+		t.Fatalf("BuildPassages failed: %v", err)
+	}
+
+	query := []float32{0, 0, 1, 1, 0, 0, 0, 0, 0, 0, 0, 0}
+	results, err := verseIndex.SearchPassages(query, 2, 5)
+	if err != nil {
+		t.Fatalf("SearchPassages failed: %v", err)
+	}
+	if len(results) == 0 || results[0].Position != 2 || results[0].End != 4 || results[0].Verse.ID != "GEN.1.3" {
+		t.Fatalf("Expected GEN.1.3-4 first, got %+v", results)
+	}
+	for i, a := range results {
+		if a.End-a.Position != 2 {
+			t.Errorf("Expected 2-verse spans, got [%d, %d)", a.Position, a.End)
+		}
+		for _, b := range results[:i] {
+			if a.Position < b.End && b.Position < a.End {
+				t.Errorf("Spans [%d, %d) and [%d, %d) overlap", a.Position, a.End, b.Position, b.End)
+			}
+		}
+	}
+
+	if _, err := verseIndex.SearchPassages(query, 4, 5); err == nil {
+		t.Error("Expected an error for a window that was not built")
+	}
+}
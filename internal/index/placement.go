@@ -0,0 +1,121 @@
+package index
+
+import (
+	"sync/atomic"
+
+	"versejet/internal/hnsw"
+)
+
+// placedMatrix is the embedding matrix, or why it could not be built. It
+// counts the searches using it plus one for the index while it is current;
+// the last to let go frees the matrix.
+type placedMatrix struct {
+	matrix *hnsw.Matrix
+	err    error
+	refs   atomic.Int64
+}
+
+// acquire takes a reference, or fails once the matrix has been freed
+func (p *placedMatrix) acquire() bool {
+	for {
+		refs := p.refs.Load()
+		if refs == 0 {
+			return false
+		}
+		if p.refs.CompareAndSwap(refs, refs+1) {
+			return true
+		}
+	}
+}
+
+// release drops a reference, freeing the matrix with the last one
+func (p *placedMatrix) release() {
+	if p.refs.Add(-1) == 0 && p.matrix != nil {
+		p.matrix.Free()
+	}
+}
+
+// PlaceEmbeddings copies the embeddings into one matrix that the C library
+// maps with the pages and NUMA placement asked for, falling back where the
+// host refuses, and reports what was obtained. Searches scan the matrix in
+// place of copying every row for each query. It replaces any matrix placed
+// before, and the placement is kept for rebuilds after AddVerse; without it
+// the matrix is built with hnsw.DefaultPlacement on the first search.
+//
+// The verse embeddings are then slices of the matrix, so each is held once
+// and the Go rows can be collected. The matrix is mapped as long as the
+// index is reachable; copy an embedding to keep it longer. Since the
+// embeddings change, it must not run alongside searches.
+func (vi *VerseIndex) PlaceEmbeddings(placement hnsw.Placement) (hnsw.PlacementReport, error) {
+	if err := placement.Validate(); err != nil {
+		return hnsw.PlacementReport{}, err
+	}
+	vi.placement = placement
+	placed := vi.buildMatrix()
+	if placed.err == nil {
+		vi.pinRows(placed)
+	}
+	vi.replaceMatrix(placed)
+	if placed.err != nil {
+		return hnsw.PlacementReport{}, placed.err
+	}
+	return placed.matrix.Report(), nil
+}
+
+// pinRows points the verse embeddings at the rows of placed. The index
+// keeps a reference that is never released, so the matrix outlives any
+// replacement and is freed with the index by its finalizer.
+func (vi *VerseIndex) pinRows(placed *placedMatrix) {
+	dim := vi.Dimension()
+	for i := range vi.Verses {
+		if len(vi.Verses[i].Embedding) == dim {
+			vi.Verses[i].Embedding = placed.matrix.Row(i)
+		}
+	}
+	placed.refs.Add(1)
+	vi.pinned = append(vi.pinned, placed)
+}
+
+// acquireMatrix returns the embedding matrix, building it on first use, or
+// nil if it cannot be built. The matrix stays mapped until release is
+// called, even if AddVerse or PlaceEmbeddings replaces it meanwhile.
+func (vi *VerseIndex) acquireMatrix() (matrix *hnsw.Matrix, release func()) {
+	for {
+		placed := vi.matrix.Load()
+		if placed == nil {
+			placed = vi.buildMatrix()
+			if !vi.matrix.CompareAndSwap(nil, placed) {
+				placed.release()
+				continue
+			}
+		}
+		if placed.acquire() {
+			return placed.matrix, placed.release
+		}
+		// Replaced and freed since the load; the next load sees its successor
+	}
+}
+
+// replaceMatrix makes placed, possibly nil, the current matrix and frees
+// the one it replaces once no search is using it
+func (vi *VerseIndex) replaceMatrix(placed *placedMatrix) {
+	if old := vi.matrix.Swap(placed); old != nil {
+		old.release()
+	}
+}
+
+// buildMatrix copies the embeddings with the placement last asked for
+func (vi *VerseIndex) buildMatrix() *placedMatrix {
+	placement := vi.placement
+	if placement == (hnsw.Placement{}) {
+		placement = hnsw.DefaultPlacement
+	}
+	rows := make([][]float32, len(vi.Verses))
+	for i := range vi.Verses {
+		rows[i] = vi.Verses[i].Embedding
+	}
+	matrix, err := hnsw.NewMatrix(rows, vi.Dimension(), placement)
+	placed := &placedMatrix{matrix: matrix, err: err}
+	placed.refs.Store(1)
+	return placed
+}
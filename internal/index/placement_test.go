@@ -0,0 +1,139 @@
+package index
+
+import (
+	"slices"
+	"testing"
+
+	"versejet/internal/hnsw"
+)
+
+func TestPlaceEmbeddings_MatchesCopiedScan(t *testing.T) {
+	verseIndex := randomIndex(700, 24, 5)
+	rows := make([][]float32, len(verseIndex.Verses))
+	for i := range verseIndex.Verses {
+		rows[i] = verseIndex.Verses[i].Embedding
+	}
+	query := verseIndex.Verses[42].Embedding
+
+	for _, placement := range []hnsw.Placement{
+		{HugePages: hnsw.PagesSmall, NUMA: hnsw.NUMALocal},
+		{HugePages: hnsw.PagesTransparent, NUMA: hnsw.NUMAInterleave},
+		{HugePages: hnsw.PagesExplicit, NUMA: hnsw.NUMAReplicate},
+	} {
+		report, err := verseIndex.PlaceEmbeddings(placement)
+		if err != nil {
+			t.Fatalf("PlaceEmbeddings(%+v) failed: %v", placement, err)
+		}
+		if report.Bytes < 700*24*4 || report.Replicas < 1 || report.Nodes < 1 {
+			t.Errorf("%+v: implausible report %+v", placement, report)
+		}
+		if report.Nodes == 1 && (report.NUMA != hnsw.NUMALocal || report.Replicas != 1) {
+			t.Errorf("%+v: expected a single node to be placed locally, got %s", placement, report)
+		}
+		if placement.HugePages == hnsw.PagesSmall && report.HugePages != hnsw.PagesSmall {
+			t.Errorf("Expected base pages when huge pages are off, got %s", report.HugePages)
+		}
+
+		expected, err := scanEmbeddings(rows, query, 10, 0.1, nil)
+		if err != nil {
+			t.Fatalf("scanEmbeddings failed: %v", err)
+		}
+		matrix, release := verseIndex.acquireMatrix()
+		got, err := scanMatrix(matrix, verseIndex.embedding, query, 10, 0.1, nil)
+		release()
+		if err != nil {
+			t.Fatalf("scanMatrix failed: %v", err)
+		}
+		if len(got) != len(expected) {
+			t.Fatalf("%+v: expected %d results, got %d", placement, len(expected), len(got))
+		}
+		for i := range got {
+			if got[i] != expected[i] {
+				t.Errorf("%+v rank %d: expected %+v, got %+v", placement, i, expected[i], got[i])
+			}
+		}
+	}
+
+	// No matches is an answer, not a reason to rescan in Go
+	matrix, release := verseIndex.acquireMatrix()
+	defer release()
+	if got, err := scanMatrix(matrix, verseIndex.embedding, query, 10, 1.5, nil); err != nil || got != nil {
+		t.Errorf("Expected no matches above 1.5, got %v, %v", got, err)
+	}
+	if _, err := verseIndex.PlaceEmbeddings(hnsw.Placement{HugePages: "gigantic", NUMA: hnsw.NUMALocal}); err == nil {
+		t.Error("Expected an unknown huge pages policy to be refused")
+	}
+}
+
+func TestEmbeddingMatrix_FollowsAddedVerses(t *testing.T) {
+	verseIndex := randomIndex(10, 4, 9)
+	if _, err := verseIndex.PlaceEmbeddings(hnsw.Placement{HugePages: hnsw.PagesSmall, NUMA: hnsw.NUMALocal}); err != nil {
+		t.Fatalf("PlaceEmbeddings failed: %v", err)
+	}
+	placed, release := verseIndex.acquireMatrix()
+	release()
+	verseIndex.AddVerse(Verse{ID: "TST.10.1", Embedding: []float32{0, 0, 0, 1}})
+
+	// The placed matrix holds the verse embeddings and outlives its
+	// replacement
+	query := hnsw.NewVector([]float32{1, 0, 0, 0})
+	defer query.Free()
+	if _, err := placed.Search(query, 1, 0, nil, nil, nil); err != nil {
+		t.Errorf("Expected the placed matrix to stay mapped, got %v", err)
+	}
+
+	// A rebuilt matrix held by a search survives the next AddVerse, and the
+	// last release frees it
+	held, release := verseIndex.acquireMatrix()
+	if held == nil || held.Len() != 11 {
+		t.Fatal("Expected the matrix to be rebuilt with the added verse")
+	}
+	if report := held.Report(); report.HugePages != hnsw.PagesSmall {
+		t.Errorf("Expected the rebuild to keep the placement asked for, got %s", report)
+	}
+	verseIndex.AddVerse(Verse{ID: "TST.10.2", Embedding: []float32{0, 0, 1, 0}})
+	if _, err := held.Search(query, 1, 0, nil, nil, nil); err != nil {
+		t.Errorf("Expected the held matrix to stay mapped, got %v", err)
+	}
+	release()
+	if _, err := held.Search(query, 1, 0, nil, nil, nil); err == nil {
+		t.Error("Expected the replaced matrix to be freed on release")
+	}
+
+	results, err := verseIndex.Search([]float32{0, 0, 0, 1}, 1)
+	if err != nil || len(results) != 1 || results[0].Verse.ID != "TST.10.1" {
+		t.Errorf("Expected the added verse to be found, got %v, %v", results, err)
+	}
+}
+
+func TestPlaceEmbeddings_HoldsEmbeddingsOnce(t *testing.T) {
+	verseIndex := randomIndex(50, 8, 3)
+	original := make([][]float32, len(verseIndex.Verses))
+	for i := range verseIndex.Verses {
+		original[i] = slices.Clone(verseIndex.Verses[i].Embedding)
+	}
+	report, err := verseIndex.PlaceEmbeddings(hnsw.DefaultPlacement)
+	if err != nil {
+		t.Fatalf("PlaceEmbeddings failed: %v", err)
+	}
+	// Far smaller than a huge page, so not padded out to one
+	if report.HugePages != hnsw.PagesSmall || report.Bytes >= 2<<20 {
+		t.Errorf("Expected a small matrix on base pages, got %s", report)
+	}
+
+	matrix, release := verseIndex.acquireMatrix()
+	defer release()
+	for i := range verseIndex.Verses {
+		embedding := verseIndex.Verses[i].Embedding
+		if &embedding[0] != &matrix.Row(i)[0] {
+			t.Fatalf("Expected verse %d to read its matrix row", i)
+		}
+		if !slices.Equal(embedding, original[i]) {
+			t.Fatalf("Expected verse %d to keep its embedding", i)
+		}
+	}
+	results, err := verseIndex.Search(original[7], 1)
+	if err != nil || len(results) != 1 || results[0].Position != 7 {
+		t.Errorf("Expected verse 7 first, got %v, %v", results, err)
+	}
+}
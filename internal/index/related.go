@@ -0,0 +1,143 @@
+package index
+
+import (
+	"fmt"
+	"math"
+	"runtime"
+	"sync"
+	"sync/atomic"
+
+	"versejet/internal/hnsw"
+)
+
+// relatedRowsPerTask is the number of verses each worker hands to the
+// all-pairs kernel at a time; it matches the kernel's row block
+const relatedRowsPerTask = 256
+
+// RelatedTable stores each verse's precomputed nearest neighbors. Row i holds
+// N neighbor positions (into Verses) and scores, best first; positions of -1
+// mark unused entries. Scores are cosine similarities quantized to uint16.
+type RelatedTable struct {
+	N      int      `json:"n"`
+	IDs    []int32  `json:"ids"`
+	Scores []uint16 `json:"scores"`
+}
+
+// BuildRelated computes the topN most similar verses for every verse with a
+// blocked all-pairs pass over the normalized embedding matrix, split across
+// workers (0 means one per CPU), and stores the result in vi.Related.
+func (vi *VerseIndex) BuildRelated(topN, workers int) error {
+	count := len(vi.Verses)
+	if count == 0 {
+		return fmt.Errorf("index has no verses")
+	}
+	if topN <= 0 {
+		return fmt.Errorf("topN must be positive")
+	}
+	if workers <= 0 {
+		workers = runtime.NumCPU()
+	}
+
+	dim := vi.Dimension()
+	matrix := make([]float32, count*dim)
+	for i, verse := range vi.Verses {
+		if len(verse.Embedding) != dim {
+			return fmt.Errorf("verse %s has %d dimensions, expected %d", verse.ID, len(verse.Embedding), dim)
+		}
+		normalizeInto(matrix[i*dim:(i+1)*dim], verse.Embedding)
+	}
+
+	ids := make([]int32, count*topN)
+	scores := make([]float32, count*topN)
+	tasks := make(chan int)
+	errs := make(chan error, 1)
+	var failed atomic.Bool
+	var wg sync.WaitGroup
+	for w := 0; w < workers; w++ {
+		wg.Add(1)
+		go func() {
+			defer wg.Done()
+			for start := range tasks {
+				// After a failure the rest are drained so the sender never blocks
+				if failed.Load() {
+					continue
+				}
+				end := min(start+relatedRowsPerTask, count)
+				if err := hnsw.AllPairsTopN(matrix, count, dim, start, end, topN,
+					ids[start*topN:end*topN], scores[start*topN:end*topN]); err != nil && !failed.Swap(true) {
+					errs <- err
+				}
+			}
+		}()
+	}
+	for start := 0; start < count; start += relatedRowsPerTask {
+		tasks <- start
+	}
+	close(tasks)
+	wg.Wait()
+	close(errs)
+	if err := <-errs; err != nil {
+		return fmt.Errorf("failed to compute related verses: %w", err)
+	}
+
+	table := &RelatedTable{N: topN, IDs: ids, Scores: make([]uint16, len(scores))}
+	for i, score := range scores {
+		table.Scores[i] = quantizeScore(score)
+	}
+	vi.Related = table
+	return nil
+}
+
+// RelatedTo returns up to k precomputed related verses for the verse with the
+// given ID. ok is false if the verse is unknown or no table was built.
+func (vi *VerseIndex) RelatedTo(id string, k int) (results []SearchResult, ok bool) {
+	table := vi.Related
+	if table == nil || len(table.IDs) != len(vi.Verses)*table.N {
+		return nil, false
+	}
+	position, found := vi.Position(id)
+	if !found {
+		return nil, false
+	}
+	row := position * table.N
+	if k <= 0 || k > table.N {
+		k = table.N
+	}
+
+	results = make([]SearchResult, 0, k)
+	for _, neighbor := range table.IDs[row : row+k] {
+		if neighbor < 0 {
+			break
+		}
+		results = append(results, SearchResult{
+			Verse:    &vi.Verses[neighbor],
+			Score:    dequantizeScore(table.Scores[row+len(results)]),
+			Position: int(neighbor),
+		})
+	}
+	return results, true
+}
+
+func normalizeInto(dst, v []float32) {
+	var norm float32
+	for _, x := range v {
+		norm += x * x
+	}
+	if norm == 0 {
+		return
+	}
+	inv := 1 / float32(math.Sqrt(float64(norm)))
+	for i, x := range v {
+		dst[i] = x * inv
+	}
+}
+
+// quantizeScore maps a cosine similarity in [-1, 1] onto the uint16 range
+func quantizeScore(score float32) uint16 {
+	score = max(-1, min(1, score))
+	return uint16(math.Round(float64(score+1) / 2 * math.MaxUint16))
+}
+
+func dequantizeScore(q uint16) float32 {
+	return float32(q)/math.MaxUint16*2 - 1
+}
@@ -0,0 +1,120 @@
+package index
+
+import (
+	"fmt"
+	"math/rand"
+	"path/filepath"
+	"sort"
+	"testing"
+	"time"
+)
+
+func randomIndex(count, dim int, seed int64) *VerseIndex {
+	rng := rand.New(rand.NewSource(seed))
+	verseIndex := NewVerseIndex()
+	for i := 0; i < count; i++ {
+		embedding := make([]float32, dim)
+		for j := range embedding {
+			embedding[j] = rng.Float32()*2 - 1
+		}
+		verseIndex.AddVerse(Verse{
+			ID:        fmt.Sprintf("TST.%d.1", i),
+			Ref:       fmt.Sprintf("Test %d:1", i),
+			Embedding: embedding,
+		})
+	}
+	return verseIndex
+}
+
+func TestBuildRelated_MatchesBruteForce(t *testing.T) {
+	// Sizes that do not divide the kernel's blocks exercise the edge tiles.
+	const count, dim, topN = 601, 37, 5
+	verseIndex := randomIndex(count, dim, 1)
+
+	if err := verseIndex.BuildRelated(topN, 3); err != nil {
+		t.Fatalf("BuildRelated failed: %v", err)
+	}
+
+	for _, i := range []int{0, 1, 255, 256, 300, count - 1} {
+		type scored struct {
+			id    int
+			score float32
+		}
+		var expected []scored
+		for j := 0; j < count; j++ {
+			if j != i {
+				expected = append(expected, scored{j, cosineSimilarity(verseIndex.Verses[i].Embedding, verseIndex.Verses[j].Embedding)})
+			}
+		}
+		sort.Slice(expected, func(a, b int) bool { return expected[a].score > expected[b].score })
+
+		related, ok := verseIndex.RelatedTo(verseIndex.Verses[i].ID, topN)
+		if !ok || len(related) != topN {
+			t.Fatalf("Verse %d: expected %d related verses, got %d", i, topN, len(related))
+		}
+		for rank, result := range related {
+			if result.Verse.ID != verseIndex.Verses[expected[rank].id].ID {
+				t.Errorf("Verse %d rank %d: expected %s, got %s", i, rank, verseIndex.Verses[expected[rank].id].ID, result.Verse.ID)
+			}
+			if diff := result.Score - expected[rank].score; diff > 1e-3 || diff < -1e-3 {
+				t.Errorf("Verse %d rank %d: expected score %v, got %v", i, rank, expected[rank].score, result.Score)
+			}
+		}
+	}
+}
+
+func TestBuildRelated_PersistsInGob(t *testing.T) {
+	verseIndex := randomIndex(40, 8, 2)
+	if err := verseIndex.BuildRelated(3, 0); err != nil {
+		t.Fatalf("BuildRelated failed: %v", err)
+	}
+	want, _ := verseIndex.RelatedTo("TST.7.1", 3)
+
+	path := filepath.Join(t.TempDir(), "index.gob")
+	if err := verseIndex.SaveToGob(path); err != nil {
+		t.Fatalf("SaveToGob failed: %v", err)
+	}
+	loaded, err := LoadFromGob(path)
+	if err != nil {
+		t.Fatalf("LoadFromGob failed: %v", err)
+	}
+
+	got, ok := loaded.RelatedTo("TST.7.1", 3)
+	if !ok || len(got) != len(want) {
+		t.Fatalf("Expected %d related verses after reload, got %d", len(want), len(got))
+	}
+	for i := range want {
+		if got[i].Verse.ID != want[i].Verse.ID || got[i].Score != want[i].Score {
+			t.Errorf("Rank %d: expected %s (%v), got %s (%v)", i, want[i].Verse.ID, want[i].Score, got[i].Verse.ID, got[i].Score)
+		}
+	}
+	if _, ok := loaded.RelatedTo("NON.1.1", 3); ok {
+		t.Error("Expected unknown verse to have no related verses")
+	}
+}
+
+func TestRelatedTo_WithoutTable(t *testing.T) {
+	verseIndex := randomIndex(4, 4, 3)
+	if _, ok := verseIndex.RelatedTo("TST.0.1", 3); ok {
+		t.Error("Expected no related verses before BuildRelated")
+	}
+}
+
+func TestBuildRelated_FailsWithoutHanging(t *testing.T) {
+	// Verses without embeddings fail every task, and there are more tasks
+	// than workers
+	verseIndex := NewVerseIndex()
+	for i := 0; i < 4*relatedRowsPerTask; i++ {
+		verseIndex.AddVerse(Verse{ID: fmt.Sprintf("TST.%d.1", i)})
+	}
+	done := make(chan error, 1)
+	go func() { done <- verseIndex.BuildRelated(3, 2) }()
+	select {
+	case err := <-done:
+		if err == nil {
+			t.Error("Expected verses without embeddings to fail")
+		}
+	case <-time.After(10 * time.Second):
+		t.Fatal("BuildRelated hung after its workers failed")
+	}
+}
@@ -0,0 +1,473 @@
+package index
+
+import (
+	"container/heap"
+	"fmt"
+	"maps"
+	"slices"
+	"sort"
+	"sync"
+
+	"versejet/internal/hnsw"
+)
+
+// Segmented index defaults
+const (
+	// DefaultSegmentBuffer is the number of buffered verses that triggers a
+	// background seal into an immutable segment
+	DefaultSegmentBuffer = 1024
+
+	// DefaultMaxSegments is the number of segments past which compaction
+	// merges them all into one
+	DefaultMaxSegments = 8
+)
+
+// SegmentedIndex is a verse index that takes writes while serving queries.
+// New and updated verses go to a small mutable buffer; a background
+// compactor seals the buffer into an immutable segment and, once there are
+// more than maxSegments, merges every segment into one. Queries scan the
+// segments with the C kernel over matrices built once when each segment is
+// sealed, scan the buffer in Go, and merge by score, so their cost grows
+// with the corpus and not with the history of writes.
+//
+// Deletes and overwrites leave tombstones: every write takes the next
+// sequence number, and a row written at sequence s is live while its ID
+// has no tombstone above s. Merging drops dead rows and the tombstones it
+// has applied. A compaction builds its segment without blocking queries and
+// swaps it in under the write lock, so a query sees the layout before or
+// after, never a mix.
+type SegmentedIndex struct {
+	bufferSize  int
+	maxSegments int
+	placement   hnsw.Placement
+
+	mu          sync.RWMutex
+	segments    []*segment // oldest first
+	buffer      []Verse
+	bufferSeqs  []uint64
+	bufferIndex map[string]int // ID to its newest buffer row
+	tombstones  map[string]uint64
+	seq         uint64
+	dim         int
+	closed      bool
+
+	compactMu sync.Mutex // one compaction at a time
+	wake      chan struct{}
+	done      chan struct{}
+	wg        sync.WaitGroup
+	closeOnce sync.Once
+}
+
+// segment is an immutable run of verses, each live at the time it was
+// sealed
+type segment struct {
+	verses []Verse
+	seqs   []uint64
+	matrix *hnsw.Matrix // embeddings for the scan kernel, nil if not mapped
+	byID   map[string]int32
+	dead   int // rows since deleted or overwritten, under the index lock
+}
+
+func newSegment(verses []Verse, seqs []uint64, dim int, placement hnsw.Placement) *segment {
+	s := &segment{
+		verses: verses,
+		seqs:   seqs,
+		byID:   make(map[string]int32, len(verses)),
+	}
+	rows := make([][]float32, len(verses))
+	for i := range verses {
+		rows[i] = verses[i].Embedding
+		s.byID[verses[i].ID] = int32(i)
+	}
+	// Without a matrix the segment is scanned in Go like the buffer
+	s.matrix, _ = hnsw.NewMatrix(rows, dim, placement)
+	return s
+}
+
+func (seg *segment) embedding(row int) []float32 {
+	return seg.verses[row].Embedding
+}
+
+// SegmentStats describes the layout of a segmented index
+type SegmentStats struct {
+	Segments   int // immutable segments
+	Sealed     int // rows in immutable segments, live or not
+	Buffered   int // rows in the mutable buffer, live or not
+	Tombstones int
+}
+
+// NewSegmentedIndex creates an empty segmented index and starts its
+// compactor; bufferSize and maxSegments default when not positive, and
+// segment matrices are placed with hnsw.DefaultPlacement when placement is
+// zero. Close stops the compactor.
+func NewSegmentedIndex(bufferSize, maxSegments int, placement hnsw.Placement) *SegmentedIndex {
+	if bufferSize <= 0 {
+		bufferSize = DefaultSegmentBuffer
+	}
+	if maxSegments <= 0 {
+		maxSegments = DefaultMaxSegments
+	}
+	if placement == (hnsw.Placement{}) {
+		placement = hnsw.DefaultPlacement
+	}
+	s := &SegmentedIndex{
+		bufferSize:  bufferSize,
+		maxSegments: maxSegments,
+		placement:   placement,
+		bufferIndex: make(map[string]int),
+		tombstones:  make(map[string]uint64),
+		wake:        make(chan struct{}, 1),
+		done:        make(chan struct{}),
+	}
+	s.wg.Add(1)
+	go s.compactor()
+	return s
+}
+
+// Close stops the background compactor, waits for a running compaction and
+// frees the segment matrices, under the write lock as a merge does, so no
+// query is scanning them. Queries after Close still answer, scanning the
+// segments in Go, but nothing is compacted.
+func (s *SegmentedIndex) Close() {
+	s.closeOnce.Do(func() { close(s.done) })
+	s.wg.Wait()
+
+	s.compactMu.Lock()
+	defer s.compactMu.Unlock()
+	s.mu.Lock()
+	defer s.mu.Unlock()
+	s.closed = true
+	for _, seg := range s.segments {
+		if seg.matrix != nil {
+			seg.matrix.Free()
+			seg.matrix = nil
+		}
+	}
+}
+
+func (s *SegmentedIndex) compactor() {
+	defer s.wg.Done()
+	for {
+		select {
+		case <-s.done:
+			return
+		case <-s.wake:
+			s.compact(false)
+		}
+	}
+}
+
+// Add inserts a verse, replacing any verse with the same ID
+func (s *SegmentedIndex) Add(verse Verse) error {
+	return s.AddAll([]Verse{verse})
+}
+
+// AddAll inserts verses in order under one lock, as Add would one by one,
+// stopping at the first it rejects
+func (s *SegmentedIndex) AddAll(verses []Verse) error {
+	s.mu.Lock()
+	defer s.mu.Unlock()
+	var err error
+	for _, verse := range verses {
+		if err = s.addLocked(verse); err != nil {
+			break
+		}
+	}
+	if len(s.buffer) >= s.bufferSize {
+		select {
+		case s.wake <- struct{}{}:
+		default:
+		}
+	}
+	return err
+}
+
+func (s *SegmentedIndex) addLocked(verse Verse) error {
+	if verse.ID == "" {
+		return fmt.Errorf("verse ID cannot be empty")
+	}
+	if s.dim == 0 {
+		s.dim = len(verse.Embedding)
+	}
+	if len(verse.Embedding) == 0 || len(verse.Embedding) != s.dim {
+		return fmt.Errorf("verse %s has %d dimensions, index has %d", verse.ID, len(verse.Embedding), s.dim)
+	}
+
+	// The embedding may be a row of a placed VerseIndex, mapped only while
+	// that index is reachable
+	verse.Embedding = slices.Clone(verse.Embedding)
+
+	s.seq++
+	if s.findLocked(verse.ID) != nil {
+		s.tombstoneLocked(verse.ID)
+	}
+	s.buffer = append(s.buffer, verse)
+	s.bufferSeqs = append(s.bufferSeqs, s.seq)
+	s.bufferIndex[verse.ID] = len(s.buffer) - 1
+	return nil
+}
+
+// Delete removes the verse with an ID and reports whether there was one
+func (s *SegmentedIndex) Delete(id string) bool {
+	s.mu.Lock()
+	defer s.mu.Unlock()
+	if s.findLocked(id) == nil {
+		return false
+	}
+	s.seq++
+	s.tombstoneLocked(id)
+	return true
+}
+
+// tombstoneLocked kills every version of id written before the current
+// sequence number, counting the sealed rows it kills
+func (s *SegmentedIndex) tombstoneLocked(id string) {
+	for _, seg := range s.segments {
+		if row, ok := seg.byID[id]; ok && s.live(id, seg.seqs[row]) {
+			seg.dead++
+		}
+	}
+	s.tombstones[id] = s.seq
+}
+
+// GetByID returns the live verse with an ID
+func (s *SegmentedIndex) GetByID(id string) (Verse, bool) {
+	s.mu.RLock()
+	defer s.mu.RUnlock()
+	if verse := s.findLocked(id); verse != nil {
+		return *verse, true
+	}
+	return Verse{}, false
+}
+
+// findLocked returns the live version of a verse, newest data first
+func (s *SegmentedIndex) findLocked(id string) *Verse {
+	if row, ok := s.bufferIndex[id]; ok && s.live(id, s.bufferSeqs[row]) {
+		return &s.buffer[row]
+	}
+	for i := len(s.segments) - 1; i >= 0; i-- {
+		seg := s.segments[i]
+		if row, ok := seg.byID[id]; ok && s.live(id, seg.seqs[row]) {
+			return &seg.verses[row]
+		}
+	}
+	return nil
+}
+
+func (s *SegmentedIndex) live(id string, seq uint64) bool {
+	return seq >= s.tombstones[id]
+}
+
+// Search returns up to k live verses most similar to the query, best
+// first. Results carry Position -1: their rows belong to no VerseIndex.
+func (s *SegmentedIndex) Search(queryEmbedding []float32, k int) ([]SearchResult, error) {
+	if k <= 0 {
+		k = 20
+	}
+	return s.search(queryEmbedding, min(k, 50))
+}
+
+// OpenCursor scores every live verse against the query and returns a cursor
+// over the limit best matches, as VerseIndex.OpenCursor does
+func (s *SegmentedIndex) OpenCursor(queryEmbedding []float32, limit int) (*SearchCursor, error) {
+	if limit <= 0 {
+		return nil, fmt.Errorf("limit must be positive")
+	}
+	results, err := s.search(queryEmbedding, limit)
+	if err != nil {
+		return nil, err
+	}
+	// Rows are never rewritten in place, so the verses outlive the lock
+	cursor := &SearchCursor{matches: make([]scoredRow, len(results)), verses: make([]*Verse, len(results))}
+	for i, result := range results {
+		cursor.matches[i] = scoredRow{row: i, score: result.Score}
+		cursor.verses[i] = result.Verse
+	}
+	return cursor, nil
+}
+
+func (s *SegmentedIndex) search(queryEmbedding []float32, k int) ([]SearchResult, error) {
+	if len(queryEmbedding) == 0 {
+		return nil, fmt.Errorf("query embedding cannot be empty")
+	}
+
+	s.mu.RLock()
+	defer s.mu.RUnlock()
+	if s.dim != 0 && len(queryEmbedding) != s.dim {
+		return nil, fmt.Errorf("query has %d dimensions, index has %d", len(queryEmbedding), s.dim)
+	}
+
+	var results []SearchResult
+	for _, seg := range s.segments {
+		if seg.matrix == nil {
+			results = s.scanLive(results, seg.verses, seg.seqs, queryEmbedding, k)
+			continue
+		}
+		// Dead rows may take places in the segment's top k; over-fetch by
+		// the ones it holds so the live top k survives filtering
+		scored, err := scanMatrix(seg.matrix, seg.embedding, queryEmbedding, min(k+seg.dead, len(seg.verses)), minSimilarity, nil)
+		if err != nil {
+			return nil, err
+		}
+		for _, r := range scored {
+			if verse := &seg.verses[r.row]; s.live(verse.ID, seg.seqs[r.row]) {
+				results = append(results, SearchResult{Verse: verse, Score: r.score, Position: -1})
+			}
+		}
+	}
+	results = s.scanLive(results, s.buffer, s.bufferSeqs, queryEmbedding, k)
+
+	sort.SliceStable(results, func(i, j int) bool { return results[i].Score > results[j].Score })
+	return results[:min(k, len(results))], nil
+}
+
+// scanLive appends the k live rows of verses most similar to the query,
+// scored in Go: the buffer is small and changes with every write, so it is
+// not worth copying for the kernel
+func (s *SegmentedIndex) scanLive(results []SearchResult, verses []Verse, seqs []uint64, queryEmbedding []float32, k int) []SearchResult {
+	top := make(scoredHeap, 0, k)
+	for row := range verses {
+		verse := &verses[row]
+		if len(verse.Embedding) != len(queryEmbedding) || !s.live(verse.ID, seqs[row]) {
+			continue
+		}
+		score := cosineSimilarity(queryEmbedding, verse.Embedding)
+		if score < minSimilarity {
+			continue
+		}
+		if len(top) < k {
+			heap.Push(&top, scoredRow{row: row, score: score})
+		} else if score > top[0].score {
+			top[0] = scoredRow{row: row, score: score}
+			heap.Fix(&top, 0)
+		}
+	}
+	for _, r := range top {
+		results = append(results, SearchResult{Verse: &verses[r.row], Score: r.score, Position: -1})
+	}
+	return results
+}
+
+// Compact seals the buffer and merges every segment into one, dropping
+// deleted and overwritten verses, and returns when it is done
+func (s *SegmentedIndex) Compact() {
+	s.compact(true)
+}
+
+// compact seals the buffered rows into a segment, merging all segments into
+// one when full is set or there would be more than maxSegments. The new
+// segment is built from a snapshot without blocking queries or writes;
+// rows written meanwhile stay buffered.
+func (s *SegmentedIndex) compact(full bool) {
+	s.compactMu.Lock()
+	defer s.compactMu.Unlock()
+
+	// Only compaction removes rows, so the snapshot's rows stay valid
+	s.mu.RLock()
+	closed := s.closed
+	sealed := len(s.buffer)
+	segments := slices.Clone(s.segments)
+	tombstones := maps.Clone(s.tombstones)
+	snapshotSeq := s.seq
+	bufferVerses, bufferSeqs := s.buffer[:sealed], s.bufferSeqs[:sealed]
+	s.mu.RUnlock()
+
+	full = full || len(segments)+1 > s.maxSegments
+	if closed || sealed == 0 && (!full || len(segments) <= 1 && len(tombstones) == 0) {
+		return
+	}
+
+	var verses []Verse
+	var seqs []uint64
+	keep := func(from []Verse, fromSeqs []uint64) {
+		for i := range from {
+			if fromSeqs[i] >= tombstones[from[i].ID] {
+				verses = append(verses, from[i])
+				seqs = append(seqs, fromSeqs[i])
+			}
+		}
+	}
+	if full {
+		for _, seg := range segments {
+			keep(seg.verses, seg.seqs)
+		}
+	}
+	keep(bufferVerses, bufferSeqs)
+	var built *segment
+	if len(verses) > 0 {
+		built = newSegment(verses, seqs, len(verses[0].Embedding), s.placement)
+	}
+
+	s.mu.Lock()
+	defer s.mu.Unlock()
+	var swapped []*segment
+	if full {
+		// Queries hold the read lock while scanning, so none is using these
+		for _, seg := range s.segments {
+			if seg.matrix != nil {
+				seg.matrix.Free()
+			}
+		}
+	} else {
+		swapped = append(swapped, s.segments...)
+	}
+	if built != nil {
+		// Rows killed since the snapshot are dead on arrival
+		for id, seq := range s.tombstones {
+			if row, ok := built.byID[id]; ok && seq > snapshotSeq && built.seqs[row] < seq {
+				built.dead++
+			}
+		}
+		swapped = append(swapped, built)
+	}
+	s.segments = swapped
+
+	s.buffer = slices.Clone(s.buffer[sealed:])
+	s.bufferSeqs = slices.Clone(s.bufferSeqs[sealed:])
+	clear(s.bufferIndex)
+	for row := range s.buffer {
+		s.bufferIndex[s.buffer[row].ID] = row
+	}
+
+	// A full merge has applied every tombstone from the snapshot, and rows
+	// written since are newer than all of them
+	if full {
+		for id, seq := range s.tombstones {
+			if seq <= snapshotSeq {
+				delete(s.tombstones, id)
+			}
+		}
+	}
+}
+
+// Stats reports the current layout
+func (s *SegmentedIndex) Stats() SegmentStats {
+	s.mu.RLock()
+	defer s.mu.RUnlock()
+	stats := SegmentStats{Segments: len(s.segments), Buffered: len(s.buffer), Tombstones: len(s.tombstones)}
+	for _, seg := range s.segments {
+		stats.Sealed += len(seg.verses)
+	}
+	return stats
+}
+
+// Snapshot returns the live verses, oldest segment first, as a VerseIndex
+// for the endpoints that need one
+func (s *SegmentedIndex) Snapshot() *VerseIndex {
+	s.mu.RLock()
+	defer s.mu.RUnlock()
+	snapshot := NewVerseIndex()
+	for _, seg := range s.segments {
+		for i := range seg.verses {
+			if s.live(seg.verses[i].ID, seg.seqs[i]) {
+				snapshot.Verses = append(snapshot.Verses, seg.verses[i])
+			}
+		}
+	}
+	for i := range s.buffer {
+		if s.live(s.buffer[i].ID, s.bufferSeqs[i]) {
+			snapshot.Verses = append(snapshot.Verses, s.buffer[i])
+		}
+	}
+	return snapshot
+}
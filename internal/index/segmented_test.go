@@ -0,0 +1,226 @@
+package index
+
+import (
+	"fmt"
+	"math/rand"
+	"sync"
+	"testing"
+	"time"
+
+	"versejet/internal/hnsw"
+)
+
+func randomVerse(rng *rand.Rand, id string, dim int) Verse {
+	embedding := make([]float32, dim)
+	for d := range embedding {
+		embedding[d] = float32(rng.NormFloat64())
+	}
+	return Verse{ID: id, Ref: id, Text: "Text of " + id, Embedding: embedding}
+}
+
+func TestSegmentedIndex_MatchesRebuiltIndex(t *testing.T) {
+	const dim = 8
+	rng := rand.New(rand.NewSource(3))
+	segmented := NewSegmentedIndex(16, 3, hnsw.Placement{})
+	defer segmented.Close()
+
+	live := make(map[string]Verse)
+	check := func(step int) {
+		t.Helper()
+		segmented.mu.RLock()
+		for i, seg := range segmented.segments {
+			dead := 0
+			for row := range seg.verses {
+				if !segmented.live(seg.verses[row].ID, seg.seqs[row]) {
+					dead++
+				}
+			}
+			if seg.dead != dead {
+				t.Errorf("step %d: segment %d counts %d dead rows, holds %d", step, i, seg.dead, dead)
+			}
+		}
+		segmented.mu.RUnlock()
+		reference := NewVerseIndex()
+		for _, verse := range live {
+			reference.AddVerse(verse)
+		}
+		for trial := 0; trial < 3; trial++ {
+			query := randomVerse(rng, "", dim).Embedding
+			for _, verse := range live {
+				for d := range query {
+					query[d] = verse.Embedding[d] + 0.3*query[d]
+				}
+				break
+			}
+			got, err := segmented.Search(query, 10)
+			if err != nil {
+				t.Fatalf("step %d: Search failed: %v", step, err)
+			}
+			expected, _ := reference.Search(query, 10)
+			if len(got) != len(expected) {
+				t.Fatalf("step %d: expected %d results, got %d", step, len(expected), len(got))
+			}
+			for i := range got {
+				if got[i].Verse.ID != expected[i].Verse.ID || got[i].Score != expected[i].Score {
+					t.Fatalf("step %d: result %d is %s (%f), expected %s (%f)",
+						step, i, got[i].Verse.ID, got[i].Score, expected[i].Verse.ID, expected[i].Score)
+				}
+			}
+		}
+	}
+
+	for step := 0; step < 400; step++ {
+		id := fmt.Sprintf("V%d", rng.Intn(120))
+		switch op := rng.Intn(10); {
+		case op < 7:
+			verse := randomVerse(rng, id, dim)
+			if err := segmented.Add(verse); err != nil {
+				t.Fatalf("Add failed: %v", err)
+			}
+			live[id] = verse
+		case op < 9:
+			_, exists := live[id]
+			if deleted := segmented.Delete(id); deleted != exists {
+				t.Fatalf("step %d: Delete(%s) = %v, expected %v", step, id, deleted, exists)
+			}
+			delete(live, id)
+		default:
+			segmented.Compact()
+		}
+		if step%20 == 0 {
+			check(step)
+		}
+	}
+	check(400)
+
+	for id, verse := range live {
+		if got, ok := segmented.GetByID(id); !ok || got.Text != verse.Text || got.Embedding[0] != verse.Embedding[0] {
+			t.Fatalf("GetByID(%s) returned a stale verse", id)
+		}
+	}
+	if _, ok := segmented.GetByID("V-missing"); ok {
+		t.Error("Expected an unknown ID to be missing")
+	}
+
+	segmented.Compact()
+	stats := segmented.Stats()
+	if stats.Segments != 1 || stats.Buffered != 0 || stats.Tombstones != 0 || stats.Sealed != len(live) {
+		t.Errorf("Expected one segment of %d live verses after a full compaction, got %+v", len(live), stats)
+	}
+	if seg := segmented.segments[0]; seg.matrix == nil || seg.matrix.Len() != len(live) || seg.dead != 0 {
+		t.Errorf("Expected the segment to be sealed into a matrix with no dead rows")
+	}
+	if snapshot := segmented.Snapshot(); len(snapshot.Verses) != len(live) {
+		t.Errorf("Expected a snapshot of %d verses, got %d", len(live), len(snapshot.Verses))
+	}
+	check(401)
+}
+
+func TestSegmentedIndex_BackgroundCompaction(t *testing.T) {
+	rng := rand.New(rand.NewSource(4))
+	segmented := NewSegmentedIndex(10, 2, hnsw.Placement{})
+	defer segmented.Close()
+
+	for i := 0; i < 100; i++ {
+		if err := segmented.Add(randomVerse(rng, fmt.Sprintf("V%d", i), 4)); err != nil {
+			t.Fatalf("Add failed: %v", err)
+		}
+	}
+	deadline := time.Now().Add(5 * time.Second)
+	for segmented.Stats().Buffered >= 10 {
+		if time.Now().After(deadline) {
+			t.Fatalf("Expected the compactor to seal the buffer, got %+v", segmented.Stats())
+		}
+		time.Sleep(time.Millisecond)
+	}
+	stats := segmented.Stats()
+	if stats.Segments > 2 || stats.Sealed+stats.Buffered != 100 {
+		t.Errorf("Expected at most 2 segments holding every verse, got %+v", stats)
+	}
+
+	if err := segmented.Add(randomVerse(rng, "V-wide", 5)); err == nil {
+		t.Error("Expected a verse of another dimension to be rejected")
+	}
+	if _, err := segmented.Search(make([]float32, 3), 5); err == nil {
+		t.Error("Expected a query of another dimension to be rejected")
+	}
+}
+
+func TestSegmentedIndex_ConcurrentReadsAndWrites(t *testing.T) {
+	segmented := NewSegmentedIndex(8, 2, hnsw.Placement{})
+	defer segmented.Close()
+
+	var wg sync.WaitGroup
+	for writer := 0; writer < 2; writer++ {
+		wg.Add(1)
+		go func(writer int) {
+			defer wg.Done()
+			rng := rand.New(rand.NewSource(int64(writer)))
+			for i := 0; i < 300; i++ {
+				id := fmt.Sprintf("V%d", rng.Intn(50))
+				if i%4 == 3 {
+					segmented.Delete(id)
+				} else {
+					segmented.Add(randomVerse(rng, id, 4))
+				}
+			}
+		}(writer)
+	}
+	for reader := 0; reader < 2; reader++ {
+		wg.Add(1)
+		go func(reader int) {
+			defer wg.Done()
+			rng := rand.New(rand.NewSource(int64(10 + reader)))
+			for i := 0; i < 200; i++ {
+				results, err := segmented.Search(randomVerse(rng, "", 4).Embedding, 10)
+				if err != nil {
+					t.Errorf("Search failed: %v", err)
+					return
+				}
+				seen := make(map[string]bool)
+				for _, result := range results {
+					if seen[result.Verse.ID] {
+						t.Errorf("Expected one live version of %s, got two", result.Verse.ID)
+						return
+					}
+					seen[result.Verse.ID] = true
+				}
+				if i%50 == 0 {
+					segmented.Compact()
+				}
+			}
+		}(reader)
+	}
+	wg.Wait()
+}
+
+func TestSegmentedIndex_CloseFreesMatrices(t *testing.T) {
+	rng := rand.New(rand.NewSource(8))
+	segmented := NewSegmentedIndex(10, 4, hnsw.Placement{})
+	var verses []Verse
+	for i := 0; i < 30; i++ {
+		verses = append(verses, randomVerse(rng, fmt.Sprintf("V%d", i), 4))
+	}
+	segmented.AddAll(verses)
+	segmented.Compact()
+	segmented.mu.RLock()
+	matrix := segmented.segments[0].matrix
+	segmented.mu.RUnlock()
+	if matrix == nil {
+		t.Fatal("Expected the segment to be sealed into a matrix")
+	}
+
+	segmented.Close()
+	query := hnsw.NewVector(verses[3].Embedding)
+	defer query.Free()
+	if _, err := matrix.Search(query, 1, 0, nil, nil, nil); err == nil {
+		t.Error("Expected Close to free the segment matrix")
+	}
+	// Queries still answer from the verses, and Close is idempotent
+	results, err := segmented.Search(verses[3].Embedding, 1)
+	if err != nil || len(results) != 1 || results[0].Verse.ID != "V3" {
+		t.Errorf("Expected V3 after Close, got %v, %v", results, err)
+	}
+	segmented.Compact()
+	segmented.Close()
+}
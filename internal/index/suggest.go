@@ -0,0 +1,307 @@
+package index
+
+import (
+	"sort"
+	"strings"
+)
+
+// Suggestion kinds
+const (
+	SuggestBook    = "book"
+	SuggestChapter = "chapter"
+	SuggestVerse   = "verse"
+	SuggestPhrase  = "phrase"
+)
+
+// Suggestion is one autocomplete candidate
+type Suggestion struct {
+	Text string `json:"text"`
+	Kind string `json:"kind"`
+}
+
+const (
+	// suggestTopK is the number of completions stored per trie node, and so
+	// the most a single lookup can return
+	suggestTopK = 20
+
+	// maxSuggestPrefix bounds the normalized prefix a lookup will walk
+	maxSuggestPrefix = 64
+
+	// Phrases are word pairs and triples seen at least minPhraseCount times,
+	// keeping the maxPhrases most frequent
+	minPhraseCount = 8
+	maxPhrases     = 20000
+)
+
+// phraseStopWords may not start or end a suggested phrase
+var phraseStopWords = map[string]bool{
+	"a": true, "and": true, "as": true, "at": true, "be": true, "but": true,
+	"by": true, "for": true, "from": true, "he": true, "in": true, "is": true,
+	"it": true, "of": true, "on": true, "or": true, "shall": true, "that": true,
+	"the": true, "them": true, "they": true, "to": true, "unto": true, "was": true,
+	"which": true, "with": true,
+}
+
+// suggestTrie is a byte-wise prefix trie over normalized suggestion keys,
+// laid out breadth-first in flat arrays so a node's children are a
+// contiguous run of node ids. Every node stores the ids of its best
+// completions, so a lookup is a walk down the prefix plus a slice read.
+type suggestTrie struct {
+	labels     []byte   // labels[n] is the byte on the edge into node n
+	childStart []uint32 // children of node n are childStart[n]..childStart[n+1]-1
+	topStart   []uint32 // best completions of node n are top[topStart[n]:topStart[n+1]]
+	top        []uint32 // indexes into entries
+	entries    []Suggestion
+}
+
+type suggestEntry struct {
+	key    string // normalized
+	weight int
+	Suggestion
+}
+
+// suggestEntries gathers books, chapters, verse references and frequent
+// phrases. Books rank first, then phrases by frequency, then chapters and
+// verses; within a weight shorter keys come first, so "genesis 1" offers
+// chapters 1 to 9 before 10.
+func suggestEntries(verses []Verse) []suggestEntry {
+	const (
+		verseWeight   = 0
+		chapterWeight = 1
+		phraseWeight  = 2 // plus the phrase count
+		bookWeight    = 1 << 30
+	)
+	byKey := make(map[string]suggestEntry)
+	add := func(text, kind string, weight int) {
+		key := normalizeSuggestKey(text)
+		if key == "" {
+			return
+		}
+		if existing, ok := byKey[key]; ok && existing.weight >= weight {
+			return
+		}
+		byKey[key] = suggestEntry{key: key, weight: weight, Suggestion: Suggestion{Text: text, Kind: kind}}
+	}
+
+	for i := range verses {
+		ref := verses[i].Ref
+		add(ref, SuggestVerse, verseWeight)
+		if colon := strings.LastIndexByte(ref, ':'); colon > 0 {
+			chapter := ref[:colon]
+			add(chapter, SuggestChapter, chapterWeight)
+			if space := strings.LastIndexByte(chapter, ' '); space > 0 {
+				add(chapter[:space], SuggestBook, bookWeight)
+			}
+		}
+	}
+
+	for phrase, count := range frequentPhrases(verses) {
+		add(phrase, SuggestPhrase, phraseWeight+count)
+	}
+
+	entries := make([]suggestEntry, 0, len(byKey))
+	for _, entry := range byKey {
+		entries = append(entries, entry)
+	}
+	return entries
+}
+
+// frequentPhrases counts two- and three-word phrases that neither start nor
+// end with a stop word
+func frequentPhrases(verses []Verse) map[string]int {
+	counts := make(map[string]int)
+	var words []string
+	for i := range verses {
+		words = words[:0]
+		tokenize(verses[i].Text, func(token string) { words = append(words, token) })
+		for start := range words {
+			if phraseStopWords[words[start]] {
+				continue
+			}
+			for n := 2; n <= 3 && start+n <= len(words); n++ {
+				if !phraseStopWords[words[start+n-1]] {
+					counts[strings.Join(words[start:start+n], " ")]++
+				}
+			}
+		}
+	}
+
+	type phraseCount struct {
+		phrase string
+		count  int
+	}
+	var frequent []phraseCount
+	for phrase, count := range counts {
+		if count >= minPhraseCount {
+			frequent = append(frequent, phraseCount{phrase, count})
+		}
+	}
+	sort.Slice(frequent, func(i, j int) bool {
+		if frequent[i].count != frequent[j].count {
+			return frequent[i].count > frequent[j].count
+		}
+		return frequent[i].phrase < frequent[j].phrase
+	})
+	kept := make(map[string]int, min(len(frequent), maxPhrases))
+	for _, p := range frequent[:min(len(frequent), maxPhrases)] {
+		kept[p.phrase] = p.count
+	}
+	return kept
+}
+
+func newSuggestTrie(verses []Verse) *suggestTrie {
+	entries := suggestEntries(verses)
+
+	// Rank order: the order completions are offered in
+	sort.Slice(entries, func(i, j int) bool {
+		a, b := &entries[i], &entries[j]
+		if a.weight != b.weight {
+			return a.weight > b.weight
+		}
+		if len(a.key) != len(b.key) {
+			return len(a.key) < len(b.key)
+		}
+		return a.key < b.key
+	})
+	t := &suggestTrie{entries: make([]Suggestion, len(entries))}
+	for i := range entries {
+		t.entries[i] = entries[i].Suggestion
+	}
+
+	// Key order, for carving the trie out of contiguous ranges
+	byKey := make([]uint32, len(entries))
+	for i := range byKey {
+		byKey[i] = uint32(i)
+	}
+	sort.Slice(byKey, func(i, j int) bool { return entries[byKey[i]].key < entries[byKey[j]].key })
+
+	// Breadth-first: node i covers the keys byKey[lo:hi] sharing its prefix
+	// of length depth; its children are enqueued together, in label order
+	type span struct{ lo, hi, depth int }
+	queue := []span{{0, len(byKey), 0}}
+	t.labels = []byte{0}
+	for n := 0; n < len(queue); n++ {
+		t.childStart = append(t.childStart, uint32(len(queue)))
+		s := queue[n]
+		lo := s.lo
+		for lo < s.hi && len(entries[byKey[lo]].key) == s.depth {
+			lo++
+		}
+		for lo < s.hi {
+			label := entries[byKey[lo]].key[s.depth]
+			hi := lo + 1
+			for hi < s.hi && entries[byKey[hi]].key[s.depth] == label {
+				hi++
+			}
+			queue = append(queue, span{lo, hi, s.depth + 1})
+			t.labels = append(t.labels, label)
+			lo = hi
+		}
+	}
+	t.childStart = append(t.childStart, uint32(len(queue)))
+
+	// Offer entries in rank order to every node on their path; each node
+	// keeps the first suggestTopK it sees
+	counts := make([]uint8, len(queue))
+	best := make([]uint32, len(queue)*suggestTopK)
+	for id := range entries {
+		key := entries[id].key
+		node := uint32(0)
+		for depth := 0; ; depth++ {
+			if c := counts[node]; c < suggestTopK {
+				best[int(node)*suggestTopK+int(c)] = uint32(id)
+				counts[node]++
+			}
+			if depth == len(key) {
+				break
+			}
+			node, _ = t.child(node, key[depth])
+		}
+	}
+	t.topStart = make([]uint32, 1, len(queue)+1)
+	for node, c := range counts {
+		t.top = append(t.top, best[node*suggestTopK:node*suggestTopK+int(c)]...)
+		t.topStart = append(t.topStart, uint32(len(t.top)))
+	}
+	return t
+}
+
+// child finds the child of node reached by label
+func (t *suggestTrie) child(node uint32, label byte) (uint32, bool) {
+	lo, hi := t.childStart[node], t.childStart[node+1]
+	for lo < hi {
+		mid := (lo + hi) / 2
+		if t.labels[mid] < label {
+			lo = mid + 1
+		} else {
+			hi = mid
+		}
+	}
+	if lo < t.childStart[node+1] && t.labels[lo] == label {
+		return lo, true
+	}
+	return 0, false
+}
+
+// normalizeSuggestKey lowercases ASCII letters, drops leading spaces and
+// collapses runs of spaces
+func normalizeSuggestKey(s string) string {
+	return strings.TrimRight(string(appendSuggestKey(make([]byte, 0, len(s)), s)), " ")
+}
+
+func appendSuggestKey(dst []byte, s string) []byte {
+	space := true
+	for i := 0; i < len(s); i++ {
+		c := s[i]
+		if c == ' ' || c == '\t' {
+			if !space {
+				dst = append(dst, ' ')
+			}
+			space = true
+			continue
+		}
+		if 'A' <= c && c <= 'Z' {
+			c += 'a' - 'A'
+		}
+		dst = append(dst, c)
+		space = false
+	}
+	return dst
+}
+
+func (vi *VerseIndex) suggestions() *suggestTrie {
+	if t := vi.suggest.Load(); t != nil {
+		return t
+	}
+	t := newSuggestTrie(vi.Verses)
+	vi.suggest.CompareAndSwap(nil, t)
+	return vi.suggest.Load()
+}
+
+// Suggest appends up to k completions of prefix to dst, best first: book
+// names, frequent phrases, chapters and verse references. It does not
+// allocate beyond growing dst.
+func (vi *VerseIndex) Suggest(dst []Suggestion, prefix string, k int) []Suggestion {
+	if len(prefix) > maxSuggestPrefix {
+		return dst
+	}
+	var buf [maxSuggestPrefix]byte
+	key := appendSuggestKey(buf[:0], prefix)
+	if len(key) == 0 {
+		return dst
+	}
+
+	t := vi.suggestions()
+	node := uint32(0)
+	for _, label := range key {
+		var ok bool
+		if node, ok = t.child(node, label); !ok {
+			return dst
+		}
+	}
+	top := t.top[t.topStart[node]:t.topStart[node+1]]
+	for _, id := range top[:min(k, len(top))] {
+		dst = append(dst, t.entries[id])
+	}
+	return dst
+}
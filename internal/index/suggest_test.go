@@ -0,0 +1,94 @@
+package index
+
+import (
+	"fmt"
+	"testing"
+)
+
+func suggestTestIndex() *VerseIndex {
+	verseIndex := NewVerseIndex()
+	books := []struct {
+		name     string
+		chapters int
+	}{{"Genesis", 12}, {"Galatians", 2}, {"Romans", 2}}
+	for _, book := range books {
+		for chapter := 1; chapter <= book.chapters; chapter++ {
+			for verse := 1; verse <= 3; verse++ {
+				verseIndex.AddVerse(Verse{
+					ID:   fmt.Sprintf("%s.%d.%d", book.name[:3], chapter, verse),
+					Ref:  fmt.Sprintf("%s %d:%d", book.name, chapter, verse),
+					Text: "And God said, Let there be light: and there was light. The grace of our Lord Jesus Christ.",
+				})
+			}
+		}
+	}
+	return verseIndex
+}
+
+func suggestTexts(suggestions []Suggestion) []string {
+	texts := make([]string, len(suggestions))
+	for i, s := range suggestions {
+		texts[i] = s.Text
+	}
+	return texts
+}
+
+func TestSuggest_RanksBooksPhrasesThenReferences(t *testing.T) {
+	verseIndex := suggestTestIndex()
+
+	got := suggestTexts(verseIndex.Suggest(nil, "g", 4))
+	want := []string{"Genesis", "Galatians", "god said", "god said let"}
+	if fmt.Sprint(got) != fmt.Sprint(want) {
+		t.Errorf("Expected %v, got %v", want, got)
+	}
+
+	// Chapters come in numeric order, then verses
+	got = suggestTexts(verseIndex.Suggest(nil, "  GENESIS   1", 5))
+	want = []string{"Genesis 1", "Genesis 10", "Genesis 11", "Genesis 12", "Genesis 1:1"}
+	if fmt.Sprint(got) != fmt.Sprint(want) {
+		t.Errorf("Expected %v, got %v", want, got)
+	}
+
+	got = suggestTexts(verseIndex.Suggest(nil, "romans 2:", 10))
+	want = []string{"Romans 2:1", "Romans 2:2", "Romans 2:3"}
+	if fmt.Sprint(got) != fmt.Sprint(want) {
+		t.Errorf("Expected %v, got %v", want, got)
+	}
+
+	if got := verseIndex.Suggest(nil, "Genesis 1", 1); got[0].Kind != SuggestChapter {
+		t.Errorf("Expected a chapter suggestion, got %+v", got[0])
+	}
+}
+
+func TestSuggest_NoMatches(t *testing.T) {
+	verseIndex := suggestTestIndex()
+	for _, prefix := range []string{"", "   ", "exodus", "genesis 13"} {
+		if got := verseIndex.Suggest(nil, prefix, 5); len(got) != 0 {
+			t.Errorf("%q: expected no suggestions, got %v", prefix, suggestTexts(got))
+		}
+	}
+}
+
+func TestSuggest_DoesNotAllocate(t *testing.T) {
+	verseIndex := suggestTestIndex()
+	dst := make([]Suggestion, 0, suggestTopK)
+	verseIndex.Suggest(dst, "ge", 10)
+
+	allocs := testing.AllocsPerRun(100, func() {
+		dst = verseIndex.Suggest(dst[:0], "Genesis 1", 10)
+	})
+	if allocs != 0 {
+		t.Errorf("Expected no allocations per lookup, got %v", allocs)
+	}
+}
+
+func BenchmarkSuggest(b *testing.B) {
+	verseIndex := suggestTestIndex()
+	dst := make([]Suggestion, 0, suggestTopK)
+	verseIndex.Suggest(dst, "g", 8)
+
+	b.ResetTimer()
+	for i := 0; i < b.N; i++ {
+		dst = verseIndex.Suggest(dst[:0], "genesis 1", 8)
+	}
+}
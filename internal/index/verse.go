@@ -5,6 +5,8 @@ import (
 	"fmt"
 	"math"
 	"os"
+	"sync"
+	"sync/atomic"
 
 	"versejet/internal/hnsw"
 )
@@ -14,14 +16,43 @@ type Verse struct {
 	ID        string    `json:"id"`        // e.g. "GEN.1.1"
 	Ref       string    `json:"ref"`       // e.g. "Genesis 1:1"
 	Text      string    `json:"text"`      // original punctuation-preserved text
-	NextFive  string    `json:"next_five"` // concatenated text of next 5 verses
+	NextFive  string    `json:"next_five"` // legacy precomputed context; dropped at load, see VerseIndex.Context
 	Embedding []float32 `json:"embedding"` // 1536-dimensional embedding vector
 }
 
 // VerseIndex holds all verses and provides search functionality
 type VerseIndex struct {
-	Verses    []Verse `json:"verses"`
+	Verses    []Verse       `json:"verses"`
+	Related   *RelatedTable `json:"related,omitempty"` // optional, see BuildRelated
 	hnswIndex *hnsw.HNSWGraph
+
+	// lookups maps IDs, references and chapters to rows, built at load or
+	// on first lookup
+	lookups atomic.Pointer[lookupTables]
+
+	// arena holds the verse texts contiguously for context windows
+	arena atomic.Pointer[textArena]
+
+	// lexicalIdx is the BM25 inverted index over verse text
+	lexicalIdx atomic.Pointer[lexicalIndex]
+
+	// suggest is the autocomplete trie over references and phrases
+	suggest atomic.Pointer[suggestTrie]
+
+	// passages holds pooled embeddings of verse windows, see BuildPassages
+	passages atomic.Pointer[passageSet]
+
+	// centroids summarizes chapters and books for hierarchical search
+	centroids atomic.Pointer[hierarchy]
+
+	// matrix holds the embeddings in C memory for the search kernels, placed
+	// as PlaceEmbeddings last asked
+	matrix    atomic.Pointer[placedMatrix]
+	placement hnsw.Placement
+
+	// pinned are the matrices the verse embeddings point into, see
+	// PlaceEmbeddings; they stay mapped as long as the index
+	pinned []*placedMatrix
 }
 
 // NewVerseIndex creates a new empty verse index
@@ -35,17 +66,35 @@ func NewVerseIndex() *VerseIndex {
 // AddVerse adds a verse to the index
 func (vi *VerseIndex) AddVerse(verse Verse) {
 	vi.Verses = append(vi.Verses, verse)
+	vi.arena.Store(nil)
+	vi.lookups.Store(nil)
+	vi.lexicalIdx.Store(nil)
+	vi.suggest.Store(nil)
+	vi.passages.Store(nil)
+	vi.centroids.Store(nil)
+	vi.replaceMatrix(nil)
 }
 
-// SearchResult represents a search result with similarity score
+// SearchResult represents a search result with similarity score. Verse
+// points at the verse in the index searched, without copying it, and must
+// not be modified.
 type SearchResult struct {
-	Verse Verse   `json:"verse"`
-	Score float32 `json:"score"`
+	Verse    *Verse  `json:"verse"`
+	Score    float32 `json:"score"`
+	Position int     `json:"-"` // row of the verse in VerseIndex.Verses
+	End      int     `json:"-"` // for passage results, one past the last row; 0 otherwise
 }
 
+// minSimilarity is the cosine similarity below which verses are not returned
+const minSimilarity = 0.5
+
 // REPLACED WITH C SEARCH IMPLEMENTATION FOR SPEED
 // Search performs cosine similarity search against all verses
 func (vi *VerseIndex) Search(queryEmbedding []float32, k int) ([]SearchResult, error) {
+	return vi.search(queryEmbedding, k, nil)
+}
+
+func (vi *VerseIndex) search(queryEmbedding []float32, k int, tally *groupTally) ([]SearchResult, error) {
 	if len(queryEmbedding) == 0 {
 		return nil, fmt.Errorf("query embedding cannot be empty")
 	}
@@ -56,41 +105,123 @@ func (vi *VerseIndex) Search(queryEmbedding []float32, k int) ([]SearchResult, e
 		k = 50
 	}
 
-	cQueryVec := hnsw.NewVector(queryEmbedding)
-	if cQueryVec == nil {
-		return nil, fmt.Errorf("failed to create query vector")
+	var scored []scoredRow
+	var err error
+	matrix, release := vi.acquireMatrix()
+	defer release()
+	if matrix != nil {
+		scored, err = scanMatrix(matrix, vi.embedding, queryEmbedding, k, minSimilarity, tally)
+	} else {
+		embeddings := make([][]float32, len(vi.Verses))
+		for i := range vi.Verses {
+			embeddings[i] = vi.Verses[i].Embedding
+		}
+		scored, err = scanEmbeddings(embeddings, queryEmbedding, k, minSimilarity, tally)
 	}
-	defer cQueryVec.Free()
+	if err != nil {
+		return nil, err
+	}
+
+	results := make([]SearchResult, len(scored))
+	for i, s := range scored {
+		results[i] = SearchResult{
+			Verse:    &vi.Verses[s.row],
+			Score:    s.score,
+			Position: s.row,
+		}
+	}
+	return results, nil
+}
+
+// embedding returns the embedding of a row
+func (vi *VerseIndex) embedding(row int) []float32 {
+	return vi.Verses[row].Embedding
+}
+
+// scoredRow is a row of an embedding matrix and its similarity to a query
+type scoredRow struct {
+	row   int
+	score float32
+}
 
+// scanEmbeddings returns up to k rows whose cosine similarity to the query
+// is at least threshold, best first, using the C brute-force search and
+// falling back to Go if it fails
+func scanEmbeddings(rows [][]float32, queryEmbedding []float32, k int, threshold float32, tally *groupTally) ([]scoredRow, error) {
 	// Prepare vectors slice for C function
-	vectors := make([]*hnsw.Vector, len(vi.Verses))
-	for i, verse := range vi.Verses {
-		vectors[i] = hnsw.NewVector(verse.Embedding)
+	vectors := make([]*hnsw.Vector, len(rows))
+	for i, row := range rows {
+		vectors[i] = hnsw.NewVector(row)
 		defer vectors[i].Free()
 	}
 
-	threshold := float32(0.5)
+	return scanWith(len(rows), func(i int) []float32 { return rows[i] }, queryEmbedding, k, threshold, tally, func(cQueryVec *hnsw.Vector) ([]int, error) {
+		if tally != nil {
+			// The kernel tallies groups in the same pass; no matches is an answer
+			ids, err := hnsw.BruteForceSearchFaceted(vectors, cQueryVec, k, threshold, tally.groups, tally.counts, tally.maxScores)
+			if err == nil && len(ids) == 0 {
+				return nil, nil
+			}
+			return ids, err
+		}
+		return hnsw.BruteForceSearch(vectors, cQueryVec, k, threshold)
+	})
+}
+
+// scanMatrix is scanEmbeddings over rows already copied into matrix; row
+// returns the Go copy of a row, read only to rescore the matches
+func scanMatrix(matrix *hnsw.Matrix, row func(int) []float32, queryEmbedding []float32, k int, threshold float32, tally *groupTally) ([]scoredRow, error) {
+	var groups, counts []int32
+	var maxScores []float32
+	if tally != nil {
+		groups, counts, maxScores = tally.groups, tally.counts, tally.maxScores
+	}
+	return scanWith(matrix.Len(), row, queryEmbedding, k, threshold, tally, func(cQueryVec *hnsw.Vector) ([]int, error) {
+		ids, err := matrix.Search(cQueryVec, k, threshold, groups, counts, maxScores)
+		if err == nil && len(ids) == 0 {
+			return nil, nil
+		}
+		return ids, err
+	})
+}
+
+// scanWith runs a C search and rescores the ids it returns, or falls back to
+// scanning the count rows in Go if it fails. A nil, nil result means no
+// matches.
+func scanWith(count int, row func(int) []float32, queryEmbedding []float32, k int, threshold float32, tally *groupTally, search func(*hnsw.Vector) ([]int, error)) ([]scoredRow, error) {
+	cQueryVec := hnsw.NewVector(queryEmbedding)
+	if cQueryVec == nil {
+		return nil, fmt.Errorf("failed to create query vector")
+	}
+	defer cQueryVec.Free()
 
-	ids, err := hnsw.BruteForceSearch(vectors, cQueryVec, k, threshold)
+	ids, err := search(cQueryVec)
+	if err == nil && ids == nil {
+		return nil, nil
+	}
 	if err != nil || len(ids) == 0 {
 		// fallback to slow Go brute force if C function fails
-		var results []SearchResult
-		for _, verse := range vi.Verses {
-			if len(verse.Embedding) != len(queryEmbedding) {
+		if tally != nil {
+			tally.reset()
+		}
+		var results []scoredRow
+		for i := 0; i < count; i++ {
+			embedding := row(i)
+			if len(embedding) != len(queryEmbedding) {
 				continue
 			}
-			similarity := cosineSimilarity(queryEmbedding, verse.Embedding)
+			similarity := cosineSimilarity(queryEmbedding, embedding)
 			if similarity >= threshold {
-				results = append(results, SearchResult{
-					Verse: verse,
-					Score: similarity,
-				})
+				results = append(results, scoredRow{row: i, score: similarity})
+				if tally != nil {
+					tally.add(i, similarity)
+				}
 			}
 		}
 		// Sort by descending score
 		for i := 0; i < len(results)-1; i++ {
 			for j := i + 1; j < len(results); j++ {
-				if results[i].Score < results[j].Score {
+				if results[i].score < results[j].score {
 					results[i], results[j] = results[j], results[i]
 				}
 			}
@@ -103,20 +234,16 @@ func (vi *VerseIndex) Search(queryEmbedding []float32, k int) ([]SearchResult, e
 		return results[:k], nil
 	}
 
-	results := make([]SearchResult, 0, len(ids))
+	results := make([]scoredRow, 0, len(ids))
 	for _, id := range ids {
-		if id < 0 || id >= len(vi.Verses) {
+		if id < 0 || id >= count {
 			continue
 		}
-		verse := vi.Verses[id]
-		similarity := cosineSimilarity(queryEmbedding, verse.Embedding)
+		similarity := cosineSimilarity(queryEmbedding, row(id))
 		if similarity < threshold {
 			continue
 		}
-		results = append(results, SearchResult{
-			Verse: verse,
-			Score: similarity,
-		})
+		results = append(results, scoredRow{row: id, score: similarity})
 	}
 
 	return results, nil
@@ -258,31 +385,39 @@ func LoadFromGob(filepath string) (*VerseIndex, error) {
 	if err := decoder.Decode(&verseIndex); err != nil {
 		return nil, fmt.Errorf("failed to decode verse index: %w", err)
 	}
+	verseIndex.compactText()
+	verseIndex.prepare()
 
 	return &verseIndex, nil
 }
 
+// prepare builds, side by side, the structures a loaded index serves from
+func (vi *VerseIndex) prepare() {
+	var wg sync.WaitGroup
+	for _, build := range []func(){
+		func() { vi.lookupTables() },
+		func() { vi.lexical() },
+		func() { vi.suggestions() },
+		func() { vi.hierarchy() },
+	} {
+		wg.Add(1)
+		go func(build func()) {
+			defer wg.Done()
+			build()
+		}(build)
+	}
+	wg.Wait()
+}
+
 // GetVerseCount returns the number of verses in the index
 func (vi *VerseIndex) GetVerseCount() int {
 	return len(vi.Verses)
 }
 
-// GetByRef finds a verse by its reference string
-func (vi *VerseIndex) GetByRef(ref string) (*Verse, bool) {
-	for _, verse := range vi.Verses {
-		if verse.Ref == ref {
-			return &verse, true
-		}
-	}
-	return nil, false
-}
-
-// GetByID finds a verse by its ID
-func (vi *VerseIndex) GetByID(id string) (*Verse, bool) {
-	for _, verse := range vi.Verses {
-		if verse.ID == id {
-			return &verse, true
-		}
+// Dimension returns the length of the stored embeddings, or 0 if empty
+func (vi *VerseIndex) Dimension() int {
+	if len(vi.Verses) == 0 {
+		return 0
 	}
-	return nil, false
+	return len(vi.Verses[0].Embedding)
 }
@@ -320,6 +320,27 @@ func TestSaveAndLoadGob(t *testing.T) {
 	}
 }
 
+func TestMemoryFootprint(t *testing.T) {
+	verseIndex := NewVerseIndex()
+	for i := 0; i < 50; i++ {
+		verseIndex.AddVerse(Verse{
+			ID:        fmt.Sprintf("GEN.1.%d", i+1),
+			Ref:       fmt.Sprintf("Genesis 1:%d", i+1),
+			Text:      "In the beginning God created the heaven and the earth.",
+			Embedding: make([]float32, 64),
+		})
+	}
+	base := verseIndex.MemoryFootprint()
+	if base < 50*64*4 {
+		t.Errorf("Expected at least the embedding bytes, got %d", base)
+	}
+	verseIndex.lexical()
+	verseIndex.hierarchy()
+	if built := verseIndex.MemoryFootprint(); built <= base {
+		t.Errorf("Expected built structures to add to the footprint, got %d then %d", base, built)
+	}
+}
+
 func TestSearchResultSorting(t *testing.T) {
 	verseIndex := NewVerseIndex()
 
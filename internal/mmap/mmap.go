@@ -0,0 +1,85 @@
+// Package mmap provides thin helpers for mapping index and cache files into memory.
+package mmap
+
+import (
+	"fmt"
+	"os"
+)
+
+// File is a memory-mapped view of a file on disk.
+type File struct {
+	file     *os.File
+	data     []byte
+	writable bool
+}
+
+// Open maps path into memory. When writable is true the file is created if
+// missing, grown to size bytes and mapped shared so writes reach the file.
+// A size of 0 maps the file at its current length.
+func Open(path string, size int, writable bool) (*File, error) {
+	flags := os.O_RDONLY
+	if writable {
+		flags = os.O_RDWR | os.O_CREATE
+	}
+	file, err := os.OpenFile(path, flags, 0644)
+	if err != nil {
+		return nil, fmt.Errorf("failed to open %s: %w", path, err)
+	}
+
+	info, err := file.Stat()
+	if err != nil {
+		file.Close()
+		return nil, fmt.Errorf("failed to stat %s: %w", path, err)
+	}
+	if size == 0 {
+		size = int(info.Size())
+	}
+	if size == 0 {
+		file.Close()
+		return nil, fmt.Errorf("cannot map empty file %s", path)
+	}
+	if writable && info.Size() < int64(size) {
+		if err := file.Truncate(int64(size)); err != nil {
+			file.Close()
+			return nil, fmt.Errorf("failed to grow %s: %w", path, err)
+		}
+	}
+
+	data, err := mapFile(file, size, writable)
+	if err != nil {
+		file.Close()
+		return nil, fmt.Errorf("failed to map %s: %w", path, err)
+	}
+	return &File{file: file, data: data, writable: writable}, nil
+}
+
+// Bytes returns the mapped region.
+func (f *File) Bytes() []byte {
+	return f.data
+}
+
+// Sync flushes modified pages back to the file.
+func (f *File) Sync() error {
+	if !f.writable || f.data == nil {
+		return nil
+	}
+	return syncFile(f.file, f.data)
+}
+
+// Close flushes and unmaps the region and closes the file.
+func (f *File) Close() error {
+	if f.data == nil {
+		return nil
+	}
+	syncErr := f.Sync()
+	unmapErr := unmapFile(f.data)
+	f.data = nil
+	closeErr := f.file.Close()
+	if syncErr != nil {
+		return syncErr
+	}
+	if unmapErr != nil {
+		return unmapErr
+	}
+	return closeErr
+}
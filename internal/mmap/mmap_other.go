@@ -0,0 +1,28 @@
+//go:build !linux
+
+package mmap
+
+import (
+	"io"
+	"os"
+)
+
+// On platforms without a mapping implementation the file is read into a heap
+// buffer and written back on Sync.
+
+func mapFile(file *os.File, size int, _ bool) ([]byte, error) {
+	data := make([]byte, size)
+	if _, err := file.ReadAt(data, 0); err != nil && err != io.EOF {
+		return nil, err
+	}
+	return data, nil
+}
+
+func syncFile(file *os.File, data []byte) error {
+	_, err := file.WriteAt(data, 0)
+	return err
+}
+
+func unmapFile(_ []byte) error {
+	return nil
+}
@@ -5,16 +5,23 @@ import (
 	"encoding/json"
 	"fmt"
 	"log"
+	"net"
 	"net/http"
 	"os"
 	"os/signal"
 	"path/filepath"
+	"runtime/debug"
+	"sort"
 	"strconv"
+	"strings"
 	"syscall"
 	"time"
 
 	"versejet/internal/api"
+	"versejet/internal/hnsw"
 	"versejet/internal/index"
+
+	"github.com/sashabaranov/go-openai"
 )
 
 func main() {
@@ -25,13 +32,24 @@ func main() {
 	logger := log.New(os.Stdout, "[VERSEJET] ", log.LstdFlags|log.Lshortfile)
 	logger.Println("🚀 Starting VerseJet server...")
 
-	// Load verse index from gob file
-	logger.Println("📚 Loading verse index...")
-	verseIndex, err := index.LoadFromGob(config.IndexPath)
-	if err != nil {
-		logger.Fatalf("❌ Failed to load verse index: %v", err)
+	placement := hnsw.Placement{HugePages: config.IndexHugePages, NUMA: config.IndexNUMA}
+	if err := placement.Validate(); err != nil {
+		logger.Fatalf("❌ Invalid INDEX_HUGE_PAGES or INDEX_NUMA: %v", err)
+	}
+
+	// Load verse index from gob file; a shard coordinator holds no verses
+	verseIndex := index.NewVerseIndex()
+	var err error
+	if len(config.Shards) == 0 {
+		logger.Println("📚 Loading verse index...")
+		verseIndex, err = index.Load(config.IndexPath)
+		if err != nil {
+			logger.Fatalf("❌ Failed to load verse index: %v", err)
+		}
+		logger.Printf("✅ Loaded %d verses from index", len(verseIndex.Verses))
+		buildPassages(verseIndex, config, logger)
+		placeEmbeddings(verseIndex, placement, logger)
 	}
-	logger.Printf("✅ Loaded %d verses from index", len(verseIndex.Verses))
 
 	// HNSW checkpoint startup logic
 	checkpointPath := config.HNSWCheckpointPath
@@ -73,8 +91,101 @@ func main() {
 		}
 	*/
 
+	// Initialize embedding generator: upstream calls share a pooled client and
+	// are hedged against slow responses, concurrent misses are batched into one
+	// upstream call, and the whole chain is fronted by the query-embedding cache
+	openAIConfig := openai.DefaultConfig(config.OpenAIAPIKey)
+	openAIConfig.HTTPClient = api.NewPooledHTTPClient(config.EmbeddingMaxConns)
+	openAIGenerator := api.NewOpenAIEmbeddingGeneratorWithConfig(openAIConfig, config.EmbeddingModel)
+	var embeddingGenerator api.EmbeddingGenerator = openAIGenerator
+	var upstream api.BatchEmbeddingGenerator = openAIGenerator
+	if config.EmbeddingHedging {
+		hedged := api.NewHedgedEmbeddingGenerator(openAIGenerator, api.HedgingConfig{
+			AttemptTimeout: time.Duration(config.EmbeddingAttemptTimeoutMS) * time.Millisecond,
+			MaxAttempts:    config.EmbeddingMaxAttempts,
+			Quantile:       config.EmbeddingHedgeQuantile,
+		})
+		embeddingGenerator, upstream = hedged, hedged
+		logger.Printf("✅ Embedding hedging enabled (p%.0f, up to %d attempts)", config.EmbeddingHedgeQuantile*100, config.EmbeddingMaxAttempts)
+	}
+	var embeddingBatcher *api.BatchingEmbeddingGenerator
+	if config.EmbeddingBatchWindowMS > 0 {
+		embeddingBatcher = api.NewBatchingEmbeddingGenerator(upstream, api.BatchingConfig{
+			Window:    time.Duration(config.EmbeddingBatchWindowMS) * time.Millisecond,
+			MaxBatch:  config.EmbeddingBatchSize,
+			MaxTokens: config.EmbeddingBatchMaxTokens,
+		})
+		embeddingGenerator = embeddingBatcher
+		logger.Printf("✅ Embedding batching enabled (window %dms, up to %d texts)", config.EmbeddingBatchWindowMS, config.EmbeddingBatchSize)
+	}
+	var embeddingCache *api.CachedEmbeddingGenerator
+	if config.EmbeddingCacheSize > 0 {
+		embeddingCache, err = api.NewCachedEmbeddingGenerator(embeddingGenerator, config.EmbeddingModel, config.EmbeddingCacheSize, config.EmbeddingCachePath)
+		if err != nil {
+			logger.Printf("⚠️ Failed to open embedding cache at %s: %v. Using in-memory cache.", config.EmbeddingCachePath, err)
+			embeddingCache, err = api.NewCachedEmbeddingGenerator(embeddingGenerator, config.EmbeddingModel, config.EmbeddingCacheSize, "")
+		}
+		if err != nil {
+			logger.Printf("⚠️ Failed to create embedding cache: %v", err)
+		} else {
+			logger.Printf("✅ Embedding cache ready (%d entries, %d restored)", config.EmbeddingCacheSize, embeddingCache.Len())
+			embeddingGenerator = embeddingCache
+		}
+	}
+
 	// Initialize API handler
-	apiHandler := api.NewHandler(verseIndex, config.OpenAIAPIKey, config.EmbeddingModel, logger)
+	apiHandler := api.NewHandlerWithGenerator(verseIndex, embeddingGenerator, logger)
+	apiHandler.SetQueryTimeout(time.Duration(config.QueryTimeoutMS) * time.Millisecond)
+	apiHandler.SetContextVerses(config.ContextVerses)
+	apiHandler.SetEmbeddingBudget(time.Duration(config.EmbeddingBudgetMS) * time.Millisecond)
+	if err := apiHandler.SetSearchMode(config.SearchMode); err != nil {
+		logger.Fatalf("❌ Invalid SEARCH_MODE: %v", err)
+	}
+	if err := apiHandler.SetVectorSearch(config.VectorSearch, config.ProbeChapters); err != nil {
+		logger.Fatalf("❌ Invalid VECTOR_SEARCH: %v", err)
+	}
+	if err := apiHandler.SetDiversity(float32(config.MMRLambda), float32(config.ChapterPenalty)); err != nil {
+		logger.Fatalf("❌ Invalid MMR_LAMBDA or MMR_CHAPTER_PENALTY: %v", err)
+	}
+	if config.ResultCacheSize > 0 {
+		apiHandler.SetResultCache(api.NewSemanticResultCache(config.ResultCacheSize, float32(config.ResultCacheMaxDistance)))
+	}
+	if config.CursorCacheSize > 0 {
+		apiHandler.SetCursorCache(api.NewCursorCache(config.CursorCacheSize, config.CursorCacheMB<<20))
+	}
+	// Further translations load on first request and share everything above
+	var registry *api.CorpusRegistry
+	if len(config.Corpora) > 0 {
+		registry = api.NewCorpusRegistry(func(path string) (*index.VerseIndex, error) {
+			start := time.Now()
+			corpus, err := index.Load(path)
+			if err != nil {
+				return nil, err
+			}
+			buildPassages(corpus, config, logger)
+			placeEmbeddings(corpus, placement, logger)
+			logger.Printf("📚 Loaded %d verses from %s in %v", len(corpus.Verses), path, time.Since(start))
+			return corpus, nil
+		}, int64(config.CorpusMemoryBudgetMB)<<20)
+		for _, name := range sortedKeys(config.Corpora) {
+			if err := registry.Register(name, config.Corpora[name]); err != nil {
+				logger.Fatalf("❌ Invalid CORPORA: %v", err)
+			}
+		}
+		logger.Printf("✅ Serving corpora %v alongside %s (budget %d MB)", registry.Names(), config.DefaultCorpus, config.CorpusMemoryBudgetMB)
+	}
+	apiHandler.SetCorpusRegistry(registry, config.DefaultCorpus)
+	if len(config.Shards) > 0 {
+		coordinator, err := api.NewShardCoordinator(config.Shards, time.Duration(config.ShardTimeoutMS)*time.Millisecond, config.ShardAllowPartial)
+		if err != nil {
+			logger.Fatalf("❌ Invalid SHARDS: %v", err)
+		}
+		apiHandler.SetShardCoordinator(coordinator)
+		logger.Printf("🧩 Coordinating %d shards (timeout %dms, partial results %t)", coordinator.Shards(), config.ShardTimeoutMS, config.ShardAllowPartial)
+	} else if config.WritableIndex {
+		apiHandler.SetWriteToken(config.IndexWriteToken)
+		setWritableIndex(apiHandler, verseIndex, config, placement, logger)
+	}
 
 	// Setup HTTP server
 	mux := http.NewServeMux()
@@ -86,6 +197,15 @@ func main() {
 		http.ServeFile(w, r, "index.html")
 	})
 	mux.HandleFunc("/query", apiHandler.HandleQuery)
+	mux.HandleFunc("/similar", apiHandler.HandleSimilar)
+	mux.HandleFunc("/related", apiHandler.HandleRelated)
+	mux.HandleFunc("/verses", apiHandler.HandleVerses)
+	mux.HandleFunc("/suggest", apiHandler.HandleSuggest)
+	mux.HandleFunc("/chapters", apiHandler.HandleChapters)
+	mux.HandleFunc("/books", apiHandler.HandleBooks)
+	mux.HandleFunc("/corpora", apiHandler.HandleCorpora)
+	mux.HandleFunc("/shard/search", apiHandler.HandleShardSearch)
+	mux.HandleFunc("/index/verses", apiHandler.HandleIndexVerses)
 	mux.HandleFunc("/healthz", handleHealth)
 
 	// Middleware to add Permissions-Policy header
@@ -115,6 +235,46 @@ func main() {
 		}
 	}()
 
+	// Shards on the coordinator's machine can be reached over a unix socket
+	if config.ListenSocket != "" {
+		os.Remove(config.ListenSocket)
+		listener, err := net.Listen("unix", config.ListenSocket)
+		if err != nil {
+			logger.Fatalf("❌ Failed to listen on %s: %v", config.ListenSocket, err)
+		}
+		go func() {
+			logger.Printf("🌐 Server listening on %s", config.ListenSocket)
+			if err := server.Serve(listener); err != nil && err != http.ErrServerClosed {
+				logger.Fatalf("❌ Server failed on %s: %v", config.ListenSocket, err)
+			}
+		}()
+	}
+
+	// Reload the verse index on SIGHUP
+	reload := make(chan os.Signal, 1)
+	signal.Notify(reload, syscall.SIGHUP)
+	go func() {
+		for range reload {
+			if len(config.Shards) > 0 {
+				logger.Println("🔄 Coordinator holds no index; reload the shards instead")
+				continue
+			}
+			logger.Println("🔄 Reloading verse index...")
+			reloaded, err := index.Load(config.IndexPath)
+			if err != nil {
+				logger.Printf("⚠️ Failed to reload verse index: %v", err)
+				continue
+			}
+			buildPassages(reloaded, config, logger)
+			placeEmbeddings(reloaded, placement, logger)
+			apiHandler.ReloadIndex(reloaded)
+			if config.WritableIndex {
+				setWritableIndex(apiHandler, reloaded, config, placement, logger)
+			}
+			logger.Printf("✅ Reloaded %d verses from index", len(reloaded.Verses))
+		}
+	}()
+
 	// Wait for interrupt signal for graceful shutdown
 	quit := make(chan os.Signal, 1)
 	signal.Notify(quit, syscall.SIGINT, syscall.SIGTERM)
@@ -131,6 +291,17 @@ func main() {
 	} else {
 		logger.Println("✅ Server shutdown complete")
 	}
+
+	if embeddingBatcher != nil {
+		embeddingBatcher.Close()
+	}
+	if embeddingCache != nil {
+		hits, misses, skipped := embeddingCache.Stats()
+		logger.Printf("📊 Embedding cache: %d hits, %d misses, %d not cached", hits, misses, skipped)
+		if err := embeddingCache.Close(); err != nil {
+			logger.Printf("⚠️ Failed to flush embedding cache: %v", err)
+		}
+	}
 }
 
 type Config struct {
@@ -139,6 +310,56 @@ type Config struct {
 	OpenAIAPIKey       string `json:"openai_api_key"`
 	EmbeddingModel     string `json:"embedding_model"`
 	HNSWCheckpointPath string `json:"hnsw_checkpoint_path"`
+	EmbeddingCacheSize int    `json:"embedding_cache_size"`
+	EmbeddingCachePath string `json:"embedding_cache_path"`
+
+	EmbeddingBatchWindowMS  int `json:"embedding_batch_window_ms"`
+	EmbeddingBatchSize      int `json:"embedding_batch_size"`
+	EmbeddingBatchMaxTokens int `json:"embedding_batch_max_tokens"`
+
+	EmbeddingHedging          bool    `json:"embedding_hedging"`
+	EmbeddingAttemptTimeoutMS int     `json:"embedding_attempt_timeout_ms"`
+	EmbeddingMaxAttempts      int     `json:"embedding_max_attempts"`
+	EmbeddingHedgeQuantile    float64 `json:"embedding_hedge_quantile"`
+	EmbeddingMaxConns         int     `json:"embedding_max_conns"`
+	QueryTimeoutMS            int     `json:"query_timeout_ms"`
+
+	ContextVerses int `json:"context_verses"`
+
+	SearchMode        string `json:"search_mode"`
+	EmbeddingBudgetMS int    `json:"embedding_budget_ms"`
+
+	PassageWindows []int  `json:"passage_windows"`
+	PassagePooling string `json:"passage_pooling"`
+
+	VectorSearch  string `json:"vector_search"`
+	ProbeChapters int    `json:"probe_chapters"`
+
+	IndexHugePages string `json:"index_huge_pages"`
+	IndexNUMA      string `json:"index_numa"`
+
+	MMRLambda      float64 `json:"mmr_lambda"`
+	ChapterPenalty float64 `json:"chapter_penalty"`
+
+	ResultCacheSize        int     `json:"result_cache_size"`
+	ResultCacheMaxDistance float64 `json:"result_cache_max_distance"`
+
+	CursorCacheSize int `json:"cursor_cache_size"`
+	CursorCacheMB   int `json:"cursor_cache_mb"`
+
+	DefaultCorpus        string            `json:"default_corpus"`
+	Corpora              map[string]string `json:"corpora"`
+	CorpusMemoryBudgetMB int               `json:"corpus_memory_budget_mb"`
+
+	Shards            []string `json:"shards"`
+	ShardTimeoutMS    int      `json:"shard_timeout_ms"`
+	ShardAllowPartial bool     `json:"shard_allow_partial"`
+	ListenSocket      string   `json:"listen_socket"`
+
+	WritableIndex   bool   `json:"writable_index"`
+	IndexWriteToken string `json:"index_write_token"`
+	SegmentBuffer   int    `json:"segment_buffer"`
+	MaxSegments     int    `json:"max_segments"`
 }
 
 // loadConfig loads configuration from environment variables with defaults
@@ -149,11 +370,64 @@ func loadConfig() *Config {
 		OpenAIAPIKey:       getEnv("OPENAI_API_KEY", ""),
 		EmbeddingModel:     getEnv("EMBEDDING_MODEL", "text-embedding-3-small"),
 		HNSWCheckpointPath: getEnv("HNSW_CHECKPOINT_PATH", "data/hnsw_checkpoint.gob"),
+		EmbeddingCacheSize: getEnvInt("EMBEDDING_CACHE_SIZE", 4096),
+		EmbeddingCachePath: getEnv("EMBEDDING_CACHE_PATH", "data/embedding-cache.bin"),
+
+		EmbeddingBatchWindowMS:  getEnvInt("EMBEDDING_BATCH_WINDOW_MS", 5),
+		EmbeddingBatchSize:      getEnvInt("EMBEDDING_BATCH_SIZE", 64),
+		EmbeddingBatchMaxTokens: getEnvInt("EMBEDDING_BATCH_MAX_TOKENS", 32000),
+
+		EmbeddingHedging:          getEnvBool("EMBEDDING_HEDGING", true),
+		EmbeddingAttemptTimeoutMS: getEnvInt("EMBEDDING_ATTEMPT_TIMEOUT_MS", 5000),
+		EmbeddingMaxAttempts:      getEnvInt("EMBEDDING_MAX_ATTEMPTS", 3),
+		EmbeddingHedgeQuantile:    getEnvFloat("EMBEDDING_HEDGE_QUANTILE", 0.95),
+		EmbeddingMaxConns:         getEnvInt("EMBEDDING_MAX_CONNS", api.DefaultMaxConnsPerHost),
+		QueryTimeoutMS:            getEnvInt("QUERY_TIMEOUT_MS", 10000),
+
+		ContextVerses: getEnvInt("CONTEXT_VERSES", index.DefaultContextVerses),
+
+		SearchMode:        getEnv("SEARCH_MODE", api.SearchModeVector),
+		EmbeddingBudgetMS: getEnvInt("EMBEDDING_BUDGET_MS", 1000),
+
+		PassageWindows: getEnvInts("PASSAGE_WINDOWS", nil),
+		PassagePooling: getEnv("PASSAGE_POOLING", index.PoolMean),
+
+		VectorSearch:  getEnv("VECTOR_SEARCH", api.VectorSearchFlat),
+		ProbeChapters: getEnvInt("PROBE_CHAPTERS", index.DefaultProbeChapters),
+
+		IndexHugePages: getEnv("INDEX_HUGE_PAGES", hnsw.DefaultPlacement.HugePages),
+		IndexNUMA:      getEnv("INDEX_NUMA", hnsw.DefaultPlacement.NUMA),
+
+		MMRLambda:      getEnvFloat("MMR_LAMBDA", index.DefaultMMRLambda),
+		ChapterPenalty: getEnvFloat("MMR_CHAPTER_PENALTY", index.DefaultChapterPenalty),
+
+		ResultCacheSize:        getEnvInt("RESULT_CACHE_SIZE", 1024),
+		ResultCacheMaxDistance: getEnvFloat("RESULT_CACHE_MAX_DISTANCE", 0.02),
+
+		CursorCacheSize: getEnvInt("CURSOR_CACHE_SIZE", 256),
+		CursorCacheMB:   getEnvInt("CURSOR_CACHE_MB", api.DefaultCursorCacheBytes>>20),
+
+		DefaultCorpus:        getEnv("DEFAULT_CORPUS", "kjv"),
+		Corpora:              getEnvMap("CORPORA"),
+		CorpusMemoryBudgetMB: getEnvInt("CORPUS_MEMORY_BUDGET_MB", 0),
+
+		Shards:            getEnvList("SHARDS"),
+		ShardTimeoutMS:    getEnvInt("SHARD_TIMEOUT_MS", 2000),
+		ShardAllowPartial: getEnvBool("SHARD_ALLOW_PARTIAL", true),
+		ListenSocket:      getEnv("LISTEN_SOCKET", ""),
+
+		WritableIndex:   getEnvBool("WRITABLE_INDEX", false),
+		IndexWriteToken: getEnv("INDEX_WRITE_TOKEN", ""),
+		SegmentBuffer:   getEnvInt("SEGMENT_BUFFER", index.DefaultSegmentBuffer),
+		MaxSegments:     getEnvInt("MAX_SEGMENTS", index.DefaultMaxSegments),
 	}
 
 	if config.OpenAIAPIKey == "" {
 		log.Fatal("❌ OPENAI_API_KEY environment variable is required")
 	}
+	if config.WritableIndex && config.IndexWriteToken == "" {
+		log.Fatal("❌ INDEX_WRITE_TOKEN is required with WRITABLE_INDEX")
+	}
 
 	return config
 }
@@ -176,6 +450,123 @@ func getEnvInt(key string, defaultValue int) int {
 	return defaultValue
 }
 
+// getEnvFloat gets environment variable as float with default value
+func getEnvFloat(key string, defaultValue float64) float64 {
+	if value := os.Getenv(key); value != "" {
+		if floatValue, err := strconv.ParseFloat(value, 64); err == nil {
+			return floatValue
+		}
+	}
+	return defaultValue
+}
+
+// getEnvInts gets a comma-separated environment variable as integers with
+// default value; entries that are not integers are skipped
+func getEnvInts(key string, defaultValue []int) []int {
+	value := os.Getenv(key)
+	if value == "" {
+		return defaultValue
+	}
+	var ints []int
+	for _, field := range strings.Split(value, ",") {
+		if intValue, err := strconv.Atoi(strings.TrimSpace(field)); err == nil {
+			ints = append(ints, intValue)
+		}
+	}
+	return ints
+}
+
+// getEnvList gets a comma-separated environment variable, skipping empty
+// entries
+func getEnvList(key string) []string {
+	var list []string
+	for _, field := range strings.Split(os.Getenv(key), ",") {
+		if field = strings.TrimSpace(field); field != "" {
+			list = append(list, field)
+		}
+	}
+	return list
+}
+
+// getEnvMap gets a comma-separated list of name=value pairs; entries without
+// a name or value are skipped
+func getEnvMap(key string) map[string]string {
+	pairs := make(map[string]string)
+	for _, field := range strings.Split(os.Getenv(key), ",") {
+		name, value, ok := strings.Cut(strings.TrimSpace(field), "=")
+		if name, value = strings.TrimSpace(name), strings.TrimSpace(value); ok && name != "" && value != "" {
+			pairs[name] = value
+		}
+	}
+	return pairs
+}
+
+// sortedKeys returns a map's keys in order
+func sortedKeys(m map[string]string) []string {
+	keys := make([]string, 0, len(m))
+	for key := range m {
+		keys = append(keys, key)
+	}
+	sort.Strings(keys)
+	return keys
+}
+
+// getEnvBool gets environment variable as boolean with default value
+func getEnvBool(key string, defaultValue bool) bool {
+	if value := os.Getenv(key); value != "" {
+		if boolValue, err := strconv.ParseBool(value); err == nil {
+			return boolValue
+		}
+	}
+	return defaultValue
+}
+
+// buildPassages derives the configured passage window embeddings; without
+// them passage search is unavailable but single-verse search is unaffected
+func buildPassages(verseIndex *index.VerseIndex, config *Config, logger *log.Logger) {
+	if len(config.PassageWindows) == 0 {
+		return
+	}
+	start := time.Now()
+	if err := verseIndex.BuildPassages(config.PassageWindows, config.PassagePooling); err != nil {
+		logger.Printf("⚠️ Failed to build passage embeddings: %v", err)
+		return
+	}
+	logger.Printf("✅ Built %s-pooled passages of %v verses in %v", config.PassagePooling, config.PassageWindows, time.Since(start))
+}
+
+// placeEmbeddings maps the embedding matrix the searches scan and reports
+// the pages and NUMA placement it got
+func placeEmbeddings(verseIndex *index.VerseIndex, placement hnsw.Placement, logger *log.Logger) {
+	report, err := verseIndex.PlaceEmbeddings(placement)
+	if err != nil {
+		logger.Printf("⚠️ Failed to place embedding matrix: %v. Searches copy embeddings per query.", err)
+		return
+	}
+	// The embeddings now live in the matrix; return their Go copies to the
+	// OS now rather than whenever the scavenger gets to them
+	debug.FreeOSMemory()
+	logger.Printf("🧠 Embedding matrix: %s (asked for %s pages, NUMA %s)", report, placement.HugePages, placement.NUMA)
+}
+
+// setWritableIndex copies the verses into a segmented index that takes
+// writes through /index/verses, replacing the one set before and the writes
+// it held. Without it searches read the loaded index alone.
+func setWritableIndex(apiHandler *api.Handler, verseIndex *index.VerseIndex, config *Config, placement hnsw.Placement, logger *log.Logger) {
+	start := time.Now()
+	segmented := index.NewSegmentedIndex(config.SegmentBuffer, config.MaxSegments, placement)
+	if err := segmented.AddAll(verseIndex.Verses); err != nil {
+		segmented.Close()
+		apiHandler.SetWritableIndex(nil)
+		logger.Printf("⚠️ Failed to build the writable index: %v. Writes are disabled.", err)
+		return
+	}
+	segmented.Compact()
+	apiHandler.SetWritableIndex(segmented)
+	logger.Printf("✏️ Writable index ready with %d verses in %v (buffer %d, up to %d segments)",
+		len(verseIndex.Verses), time.Since(start), config.SegmentBuffer, config.MaxSegments)
+}
+
 // handleHealth provides a health check endpoint
 func handleHealth(w http.ResponseWriter, r *http.Request) {
 	if r.Method != http.MethodGet {